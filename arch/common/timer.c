@@ -43,12 +43,358 @@ calculateNextTime(UA_DateTime currentTime, UA_DateTime baseTime,
     return currentTime + interval - cycleDelay;
 }
 
+/* Compute the next execution time after the entry was executed */
+static void
+updateNextTime(UA_TimerEntry *te, UA_DateTime now) {
+    /* Set the time for the next regular execution */
+    te->nextTime += te->interval;
+
+    /* Handle the case where the execution "window" was missed. E.g. due to
+     * congestion of the application or if the clock was shifted.
+     *
+     * If the timer policy is "CurrentTime", then there is at least the
+     * interval between executions. This is used for Monitoreditems, for
+     * which the spec says: The sampling interval indicates the fastest rate
+     * at which the Server should sample its underlying source for data
+     * changes. (Part 4, 5.12.1.2).
+     *
+     * Otherwise calculate the next execution time based on the original base
+     * time. */
+    if(te->nextTime < now) {
+        te->nextTime = (te->timerPolicy == UA_TIMERPOLICY_CURRENTTIME) ?
+            now + te->interval :
+            calculateNextTime(now, te->nextTime, te->interval);
+    }
+}
+
+/****************/
+/* Timing Wheel */
+/****************/
+
+#define UA_TIMERWHEEL_TICK UA_DATETIME_MSEC
+#define UA_TIMERWHEEL_MASK (UA_TIMERWHEEL_SLOTS - 1)
+#define UA_TIMERWHEEL_OVERFLOW UA_TIMERWHEEL_LEVELS
+#define UA_TIMERWHEEL_PROCESSING 0xff
+
+static unsigned
+ctz64(UA_UInt64 x) {
+    UA_assert(x != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll(x);
+#else
+    unsigned n = 0;
+    while(!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static UA_UInt64
+toTick(UA_DateTime date) {
+    return (date <= 0) ? 0 : (UA_UInt64)date / UA_TIMERWHEEL_TICK;
+}
+
+/* Bitmask of the slots starting at (and including) pos */
+static UA_UInt64
+slotsFrom(unsigned pos) {
+    return (pos >= UA_TIMERWHEEL_SLOTS) ? 0 : (~(UA_UInt64)0) << pos;
+}
+
+static unsigned
+digit(UA_UInt64 tick, unsigned level) {
+    return (unsigned)(tick >> (UA_TIMERWHEEL_BITS * level)) & UA_TIMERWHEEL_MASK;
+}
+
+/* The entry goes into the level of the highest digit where the tick of the
+ * entry differs from the current tick. So all entries in a level are in later
+ * slots than the current tick. Except for level zero, where the slot of the
+ * current tick holds the entries that are (over)due. */
+static void
+wheelInsert(UA_TimerWheel *w, UA_TimerEntry *te) {
+    UA_UInt64 tick = toTick(te->nextTime);
+    if(tick < w->tick)
+        tick = w->tick;
+    UA_UInt64 diff = tick ^ w->tick;
+    unsigned level = 0;
+    while(level < UA_TIMERWHEEL_LEVELS &&
+          (diff >> (UA_TIMERWHEEL_BITS * (level + 1))) != 0)
+        level++;
+    w->count++;
+    te->wheelLevel = (UA_Byte)level;
+    if(level == UA_TIMERWHEEL_OVERFLOW) {
+        LIST_INSERT_HEAD(&w->overflow, te, wheelEntry);
+        return;
+    }
+    unsigned slot = digit(tick, level);
+    UA_UInt64 bit = (UA_UInt64)1 << slot;
+    te->wheelSlot = (UA_Byte)slot;
+    LIST_INSERT_HEAD(&w->slots[level][slot], te, wheelEntry);
+    if(!(w->occupied[level] & bit) || te->nextTime < w->slotMin[level][slot])
+        w->slotMin[level][slot] = te->nextTime;
+    w->occupied[level] |= bit;
+}
+
+static void
+wheelRemove(UA_TimerWheel *w, UA_TimerEntry *te) {
+    UA_assert(te->wheelLevel != UA_TIMERWHEEL_PROCESSING);
+    LIST_REMOVE(te, wheelEntry);
+    w->count--;
+    if(te->wheelLevel == UA_TIMERWHEEL_OVERFLOW)
+        return;
+
+    /* Clear the slot bit or rescan the slot minimum when it is needed */
+    unsigned level = te->wheelLevel;
+    UA_UInt64 bit = (UA_UInt64)1 << te->wheelSlot;
+    if(LIST_EMPTY(&w->slots[level][te->wheelSlot])) {
+        w->occupied[level] &= ~bit;
+        w->dirty[level] &= ~bit;
+    } else if(te->nextTime <= w->slotMin[level][te->wheelSlot]) {
+        w->dirty[level] |= bit;
+    }
+}
+
+/* Move the entries of a slot to the lower levels after the current tick has
+ * reached the slot */
+static void
+wheelCascade(UA_TimerWheel *w, UA_TimerSlot *slot) {
+    UA_TimerSlot tmp;
+    LIST_INIT(&tmp);
+    UA_TimerEntry *te;
+    while((te = LIST_FIRST(slot))) {
+        wheelRemove(w, te);
+        LIST_INSERT_HEAD(&tmp, te, wheelEntry);
+    }
+    while((te = LIST_FIRST(&tmp))) {
+        LIST_REMOVE(te, wheelEntry);
+        wheelInsert(w, te);
+    }
+}
+
+static UA_DateTime
+slotMin(UA_TimerSlot *slot) {
+    UA_DateTime next = UA_INT64_MAX;
+    UA_TimerEntry *te;
+    LIST_FOREACH(te, slot, wheelEntry) {
+        if(te->nextTime < next)
+            next = te->nextTime;
+    }
+    return next;
+}
+
+/* All entries in level n are later than the entries in level n-1. So the
+ * earliest entry is in the first occupied slot of the lowest occupied level.
+ * The minimum of each slot is cached. It is only rescanned after the entry with
+ * the minimum was removed from the slot. */
+static UA_DateTime
+wheelNext(UA_TimerWheel *w) {
+    if(w->count == 0)
+        return UA_INT64_MAX;
+    for(unsigned level = 0; level < UA_TIMERWHEEL_LEVELS; level++) {
+        UA_UInt64 occupied = w->occupied[level] & slotsFrom(digit(w->tick, level));
+        if(!occupied)
+            continue;
+        unsigned slot = ctz64(occupied);
+        UA_UInt64 bit = (UA_UInt64)1 << slot;
+        if(w->dirty[level] & bit) {
+            w->slotMin[level][slot] = slotMin(&w->slots[level][slot]);
+            w->dirty[level] &= ~bit;
+        }
+        return w->slotMin[level][slot];
+    }
+    return slotMin(&w->overflow);
+}
+
+/* Advance the current tick up to now and move the due entries to the
+ * processing list. Empty slots are skipped with the occupied-bitmaps. */
+static void
+wheelAdvance(UA_TimerWheel *w, UA_DateTime now, UA_TimerSlot *processing) {
+    UA_UInt64 nowTick = toTick(now);
+    UA_TimerEntry *last = NULL;
+    while(true) {
+        /* Take the due entries from the slot of the current tick. Entries that
+         * are not due remain only if the current tick is not yet over. */
+        unsigned pos = digit(w->tick, 0);
+        UA_TimerEntry *te, *te_tmp;
+        LIST_FOREACH_SAFE(te, &w->slots[0][pos], wheelEntry, te_tmp) {
+            if(te->nextTime > now)
+                continue;
+            wheelRemove(w, te);
+            te->wheelLevel = UA_TIMERWHEEL_PROCESSING;
+            if(last)
+                LIST_INSERT_AFTER(last, te, wheelEntry);
+            else
+                LIST_INSERT_HEAD(processing, te, wheelEntry);
+            last = te;
+        }
+
+        if(w->tick >= nowTick)
+            return;
+
+        /* Next occupied slot in the lowest level */
+        UA_UInt64 occupied = w->occupied[0] & slotsFrom(pos + 1);
+        if(occupied) {
+            UA_UInt64 next = (w->tick & ~(UA_UInt64)UA_TIMERWHEEL_MASK) |
+                ctz64(occupied);
+            w->tick = (next <= nowTick) ? next : nowTick;
+            continue;
+        }
+
+        /* Find the next occupied slot in the higher levels. Only this slot
+         * needs to be cascaded. All slots of the lower levels are empty. */
+        UA_UInt64 target = 0;
+        UA_TimerSlot *cascade = NULL;
+        for(unsigned level = 1; level < UA_TIMERWHEEL_LEVELS; level++) {
+            occupied = w->occupied[level] & slotsFrom(digit(w->tick, level) + 1);
+            if(!occupied)
+                continue;
+            unsigned slot = ctz64(occupied);
+            unsigned shift = UA_TIMERWHEEL_BITS * (level + 1);
+            target = ((w->tick >> shift) << shift) |
+                ((UA_UInt64)slot << (UA_TIMERWHEEL_BITS * level));
+            cascade = &w->slots[level][slot];
+            break;
+        }
+        if(!cascade && !LIST_EMPTY(&w->overflow)) {
+            unsigned shift = UA_TIMERWHEEL_BITS * UA_TIMERWHEEL_LEVELS;
+            target = ((w->tick >> shift) + 1) << shift;
+            cascade = &w->overflow;
+        }
+
+        /* Nothing more to do before now */
+        if(!cascade || target > nowTick) {
+            w->tick = nowTick;
+            return;
+        }
+
+        w->tick = target;
+        wheelCascade(w, cascade);
+    }
+}
+
+static UA_StatusCode
+wheelAddId(UA_TimerWheel *w, UA_TimerEntry *te) {
+    /* Grow the id array if the freelist is empty */
+    if(w->freeId == UA_UINT32_MAX) {
+        UA_UInt32 newSize = (w->idsSize == 0) ? 64 : w->idsSize * 2;
+        if(newSize <= w->idsSize)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_TimerWheelId *ids = (UA_TimerWheelId*)
+            UA_realloc(w->ids, sizeof(UA_TimerWheelId) * newSize);
+        if(!ids)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        w->ids = ids;
+        for(UA_UInt32 i = newSize; i > w->idsSize; i--) {
+            w->ids[i-1].te = NULL;
+            w->ids[i-1].generation = 1; /* Identifiers are always above zero */
+            w->ids[i-1].nextFree = w->freeId;
+            w->freeId = i-1;
+        }
+        w->idsSize = newSize;
+    }
+
+    UA_UInt32 index = w->freeId;
+    UA_TimerWheelId *id = &w->ids[index];
+    w->freeId = id->nextFree;
+    id->te = te;
+    te->id = ((UA_UInt64)id->generation << 32) | index;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_TimerEntry *
+wheelFindId(UA_TimerWheel *w, UA_UInt64 callbackId) {
+    UA_UInt32 index = (UA_UInt32)callbackId;
+    if(index >= w->idsSize)
+        return NULL;
+    UA_TimerWheelId *id = &w->ids[index];
+    if(!id->te || id->generation != (UA_UInt32)(callbackId >> 32))
+        return NULL;
+    return id->te;
+}
+
+static void
+wheelRemoveId(UA_TimerWheel *w, UA_TimerEntry *te) {
+    UA_UInt32 index = (UA_UInt32)te->id;
+    UA_TimerWheelId *id = &w->ids[index];
+    id->te = NULL;
+    id->generation++;
+    if(id->generation == 0)
+        id->generation = 1;
+    id->nextFree = w->freeId;
+    w->freeId = index;
+}
+
+static UA_DateTime
+wheelProcess(UA_Timer *t, UA_DateTime now) {
+    UA_TimerWheel *w = t->wheel;
+
+    /* Move all entries <= now to the processing list */
+    UA_TimerSlot processing;
+    LIST_INIT(&processing);
+    wheelAdvance(w, now, &processing);
+
+    /* Execute in the order of the slots. The entries stay in the processing
+     * list during their execution. So modify and remove can detect them. */
+    UA_TimerEntry *te;
+    while((te = LIST_FIRST(&processing))) {
+        if(te->callback)
+            te->callback(te->application, te->data);
+        LIST_REMOVE(te, wheelEntry);
+
+        /* Remove the entry if marked for deletion or a "once" policy */
+        if(!te->callback || te->timerPolicy == UA_TIMERPOLICY_ONCE) {
+            wheelRemoveId(w, te);
+            UA_free(te);
+            continue;
+        }
+
+        updateNextTime(te, now);
+        wheelInsert(w, te);
+    }
+
+    return wheelNext(w);
+}
+
+static void
+wheelClear(UA_Timer *t) {
+    UA_TimerWheel *w = t->wheel;
+    for(UA_UInt32 i = 0; i < w->idsSize; i++)
+        UA_free(w->ids[i].te);
+    UA_free(w->ids);
+    UA_free(w);
+    t->wheel = NULL;
+}
+
+/*******************/
+/* Timer Interface */
+/*******************/
+
 void
-UA_Timer_init(UA_Timer *t) {
+UA_Timer_initZipTree(UA_Timer *t) {
     memset(t, 0, sizeof(UA_Timer));
     UA_LOCK_INIT(&t->timerMutex);
 }
 
+void
+UA_Timer_initWheel(UA_Timer *t) {
+    UA_Timer_initZipTree(t);
+    UA_TimerWheel *w = (UA_TimerWheel*)UA_calloc(1, sizeof(UA_TimerWheel));
+    if(!w)
+        return;
+    w->freeId = UA_UINT32_MAX;
+    t->wheel = w;
+}
+
+void
+UA_Timer_init(UA_Timer *t) {
+#ifdef UA_ENABLE_TIMER_WHEEL
+    UA_Timer_initWheel(t);
+#else
+    UA_Timer_initZipTree(t);
+#endif
+}
+
 /* Adding repeated callbacks: Add an entry with the "nextTime" timestamp in the
  * future. This will be picked up in the next iteration and inserted at the
  * correct place. So that the next execution takes place ät "nextTime". */
@@ -94,6 +440,23 @@ UA_Timer_add(UA_Timer *t, UA_ApplicationCallback callback,
 
     /* Insert into the timer */
     UA_LOCK(&t->timerMutex);
+    if(t->wheel) {
+        UA_TimerWheel *w = t->wheel;
+        UA_StatusCode res = wheelAddId(w, te);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_UNLOCK(&t->timerMutex);
+            UA_free(te);
+            return res;
+        }
+        /* Skip the empty ticks if the wheel is empty */
+        if(w->count == 0 && toTick(now) > w->tick)
+            w->tick = toTick(now);
+        if(callbackId)
+            *callbackId = te->id;
+        wheelInsert(w, te);
+        UA_UNLOCK(&t->timerMutex);
+        return UA_STATUSCODE_GOOD;
+    }
     te->id = ++t->idCounter;
     if(callbackId)
         *callbackId = te->id;
@@ -125,7 +488,8 @@ UA_Timer_modify(UA_Timer *t, UA_UInt64 callbackId,
     UA_LOCK(&t->timerMutex);
 
     /* Find timer entry based on id */
-    UA_TimerEntry *te = ZIP_FIND(UA_TimerIdTree, &t->idTree, &callbackId);
+    UA_TimerEntry *te = (t->wheel) ? wheelFindId(t->wheel, callbackId) :
+        ZIP_FIND(UA_TimerIdTree, &t->idTree, &callbackId);
     if(!te) {
         UA_UNLOCK(&t->timerMutex);
         return UA_STATUSCODE_BADNOTFOUND;
@@ -133,7 +497,14 @@ UA_Timer_modify(UA_Timer *t, UA_UInt64 callbackId,
 
     /* The entry is either in the timer tree or current processed. If
      * in-process, the entry is re-added to the timer-tree right after. */
-    UA_Boolean processing = (ZIP_REMOVE(UA_TimerTree, &t->tree, te) == NULL);
+    UA_Boolean processing;
+    if(t->wheel) {
+        processing = (te->wheelLevel == UA_TIMERWHEEL_PROCESSING);
+        if(!processing)
+            wheelRemove(t->wheel, te);
+    } else {
+        processing = (ZIP_REMOVE(UA_TimerTree, &t->tree, te) == NULL);
+    }
 
     /* The nextTime must only be modified after ZIP_REMOVE. The logic is
      * identical to the creation of a new timer. */
@@ -144,6 +515,8 @@ UA_Timer_modify(UA_Timer *t, UA_UInt64 callbackId,
 
     if(processing)
         te->nextTime -= interval; /* adjust for re-adding after processing */
+    else if(t->wheel)
+        wheelInsert(t->wheel, te);
     else
         ZIP_INSERT(UA_TimerTree, &t->tree, te);
 
@@ -154,6 +527,20 @@ UA_Timer_modify(UA_Timer *t, UA_UInt64 callbackId,
 void
 UA_Timer_remove(UA_Timer *t, UA_UInt64 callbackId) {
     UA_LOCK(&t->timerMutex);
+    if(t->wheel) {
+        /* Leave a sentinel if the entry is currently processed */
+        UA_TimerEntry *te = wheelFindId(t->wheel, callbackId);
+        if(te && te->wheelLevel == UA_TIMERWHEEL_PROCESSING) {
+            te->callback = NULL;
+        } else if(te) {
+            wheelRemove(t->wheel, te);
+            wheelRemoveId(t->wheel, te);
+            UA_free(te);
+        }
+        UA_UNLOCK(&t->timerMutex);
+        return;
+    }
+
     UA_TimerEntry *te = ZIP_FIND(UA_TimerIdTree, &t->idTree, &callbackId);
     if(!te) {
         UA_UNLOCK(&t->timerMutex);
@@ -196,25 +583,8 @@ processEntryCallback(void *context, UA_TimerEntry *te) {
         return NULL;
     }
 
-    /* Set the time for the next regular execution */
-    te->nextTime += te->interval;
-
-    /* Handle the case where the execution "window" was missed. E.g. due to
-     * congestion of the application or if the clock was shifted.
-     *
-     * If the timer policy is "CurrentTime", then there is at least the
-     * interval between executions. This is used for Monitoreditems, for
-     * which the spec says: The sampling interval indicates the fastest rate
-     * at which the Server should sample its underlying source for data
-     * changes. (Part 4, 5.12.1.2).
-     *
-     * Otherwise calculate the next execution time based on the original base
-     * time. */
-    if(te->nextTime < tpc->now) {
-        te->nextTime = (te->timerPolicy == UA_TIMERPOLICY_CURRENTTIME) ?
-            tpc->now + te->interval :
-            calculateNextTime(tpc->now, te->nextTime, te->interval);
-    }
+    /* Set the time for the next execution */
+    updateNextTime(te, tpc->now);
 
     /* Insert back into the time-sorted tree */
     ZIP_INSERT(UA_TimerTree, &t->tree, te);
@@ -225,6 +595,12 @@ UA_DateTime
 UA_Timer_process(UA_Timer *t, UA_DateTime now) {
     UA_LOCK(&t->timerMutex);
 
+    if(t->wheel) {
+        UA_DateTime next = wheelProcess(t, now);
+        UA_UNLOCK(&t->timerMutex);
+        return next;
+    }
+
     /* Move all entries <= now to the processTree */
     UA_TimerTree processTree;
     ZIP_INIT(&processTree);
@@ -251,6 +627,11 @@ UA_Timer_process(UA_Timer *t, UA_DateTime now) {
 UA_DateTime
 UA_Timer_next(UA_Timer *t) {
     UA_LOCK(&t->timerMutex);
+    if(t->wheel) {
+        UA_DateTime next = wheelNext(t->wheel);
+        UA_UNLOCK(&t->timerMutex);
+        return next;
+    }
     UA_TimerEntry *first = ZIP_MIN(UA_TimerTree, &t->tree);
     UA_DateTime next = (first) ? first->nextTime : UA_INT64_MAX;
     UA_UNLOCK(&t->timerMutex);
@@ -267,6 +648,9 @@ void
 UA_Timer_clear(UA_Timer *t) {
     UA_LOCK(&t->timerMutex);
 
+    if(t->wheel)
+        wheelClear(t);
+
     ZIP_ITER(UA_TimerIdTree, &t->idTree, freeEntryCallback, NULL);
     t->tree.root = NULL;
     t->idTree.root = NULL;
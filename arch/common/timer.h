@@ -12,6 +12,7 @@
 #include <open62541/types.h>
 #include <open62541/plugin/eventloop.h>
 #include "ziptree.h"
+#include "../../deps/open62541_queue.h"
 
 _UA_BEGIN_DECLS
 
@@ -23,6 +24,25 @@ _UA_BEGIN_DECLS
  * Obviously, the timer must not be deleted from within one of its
  * callbacks. */
 
+/* Two implementations are available behind the same interface. They are
+ * selected when the timer is initialized.
+ *
+ * - ZipTree: The entries are kept in a tree sorted by the next execution time
+ *   and in a second tree sorted by their id. Adding, removing and executing an
+ *   entry is O(log n).
+ *
+ * - Timing wheel: The entries are hashed into a hierarchy of wheels with 64
+ *   slots each. The slots of the lowest wheel have a width of one millisecond.
+ *   Each higher wheel has 64 times the slot width of the wheel below. Entries
+ *   move down into the lower wheels when their slot is reached ("cascading").
+ *   The id indexes into an array of entries. Adding, modifying, removing and
+ *   executing an entry is O(1). The execution times keep the 100ns resolution
+ *   of UA_DateTime. Only the order of execution within one millisecond is not
+ *   sorted by the execution time.
+ *
+ * UA_Timer_init selects the timing wheel if the UA_ENABLE_TIMER_WHEEL build
+ * option is set. Otherwise the ZipTree. */
+
 /* Callback where the application is either a client or a server */
 typedef void (*UA_ApplicationCallback)(void *application, void *data);
 
@@ -42,16 +62,52 @@ typedef struct UA_TimerEntry {
 
     ZIP_ENTRY(UA_TimerEntry) idTreeEntry;
     UA_UInt64 id;                            /* Id of the entry */
+
+    LIST_ENTRY(UA_TimerEntry) wheelEntry;    /* Slot in the timing wheel */
+    UA_Byte wheelLevel;                      /* Position in the timing wheel */
+    UA_Byte wheelSlot;
 } UA_TimerEntry;
 
 typedef ZIP_HEAD(UA_TimerTree, UA_TimerEntry) UA_TimerTree;
 typedef ZIP_HEAD(UA_TimerIdTree, UA_TimerEntry) UA_TimerIdTree;
 
+#define UA_TIMERWHEEL_BITS 6
+#define UA_TIMERWHEEL_SLOTS (1 << UA_TIMERWHEEL_BITS)
+#define UA_TIMERWHEEL_LEVELS 6 /* Covers 2^36 ms (about 795 days) */
+
+typedef LIST_HEAD(UA_TimerSlot, UA_TimerEntry) UA_TimerSlot;
+
+/* Lookup of the entries by their id. The id is the index in the lower and a
+ * generation counter in the upper 32 bits. */
+typedef struct {
+    UA_TimerEntry *te;
+    UA_UInt32 generation;
+    UA_UInt32 nextFree;
+} UA_TimerWheelId;
+
+typedef struct {
+    UA_UInt64 tick;      /* Current position in milliseconds. The lowest wheel
+                          * is processed up to (and including) this tick. */
+    size_t count;        /* Number of entries in the slots */
+    UA_UInt64 occupied[UA_TIMERWHEEL_LEVELS]; /* Bitmap of non-empty slots */
+    UA_UInt64 dirty[UA_TIMERWHEEL_LEVELS];    /* Bitmap of slots where the
+                                               * minimum needs a rescan */
+    UA_TimerSlot slots[UA_TIMERWHEEL_LEVELS][UA_TIMERWHEEL_SLOTS];
+    UA_DateTime slotMin[UA_TIMERWHEEL_LEVELS][UA_TIMERWHEEL_SLOTS];
+    UA_TimerSlot overflow; /* Entries beyond the range of the highest wheel */
+
+    UA_TimerWheelId *ids;
+    UA_UInt32 idsSize;
+    UA_UInt32 freeId;    /* UA_UINT32_MAX if the freelist is empty */
+} UA_TimerWheel;
+
 typedef struct {
     UA_TimerTree tree;     /* The root of the time-sorted tree */
     UA_TimerIdTree idTree; /* The root of the id-sorted tree */
     UA_UInt64 idCounter;   /* Generate unique identifiers. Identifiers are
                             * always above zero. */
+    UA_TimerWheel *wheel;  /* Set if the timing wheel is used instead of the
+                            * trees */
 #if UA_MULTITHREADING >= 100
     UA_Lock timerMutex;
 #endif
@@ -60,6 +116,13 @@ typedef struct {
 void
 UA_Timer_init(UA_Timer *t);
 
+void
+UA_Timer_initZipTree(UA_Timer *t);
+
+/* Falls back to the ZipTree if the wheel cannot be allocated */
+void
+UA_Timer_initWheel(UA_Timer *t);
+
 UA_DateTime
 UA_Timer_next(UA_Timer *t);
 
@@ -896,6 +896,14 @@ ETH_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
         return UA_STATUSCODE_BADCONNECTIONREJECTED;
     }
 
+    /* Don't send frames without payload. Empty buffers are used to release
+     * buffers held back with the "more" parameter. (Which is ignored here.) */
+    if(buf->length == 0) {
+        UA_UNLOCK(&el->elMutex);
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+        return UA_STATUSCODE_GOOD;
+    }
+
     /* Uncover and set the Ethernet header */
     buf->data -= conn->headerSize;
     buf->length += conn->headerSize;
@@ -12,13 +12,21 @@
 #if defined(UA_ARCHITECTURE_POSIX) || defined(UA_ARCHITECTURE_WIN32)
 
 /* Configuration parameters */
-#define TCP_MANAGERPARAMS 2
+#define TCP_MANAGERPARAMS 5
 
 static UA_KeyValueRestriction tcpManagerParams[TCP_MANAGERPARAMS] = {
     {{0, UA_STRING_STATIC("recv-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
-    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
+    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("send-queue-high")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("send-queue-low")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("send-queue-max")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
 };
 
+/* Default limits for the send queue of a connection */
+#define TCP_SENDQUEUE_HIGH (1u << 20)  /* 1MB */
+#define TCP_SENDQUEUE_LOW (1u << 18)   /* 256kB */
+#define TCP_SENDQUEUE_MAX (1u << 26)   /* 64MB */
+
 #define TCP_PARAMETERSSIZE 5
 #define TCP_PARAMINDEX_ADDR 0
 #define TCP_PARAMINDEX_PORT 1
@@ -34,17 +42,88 @@ static UA_KeyValueRestriction tcpConnectionParams[TCP_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("reuse")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false}
 };
 
+/* Maximum number of buffers sent with a single (gathering) syscall */
+#define TCP_IOVECS 64
+
+#if defined(UA_ARCHITECTURE_WIN32)
+typedef WSABUF TCP_IOVec;
+#define TCP_IOVEC_SET(iov, data, length) do { \
+        (iov).buf = (char*)(data); (iov).len = (ULONG)(length); } while(0)
+#else
+#include <sys/uio.h>
+typedef struct iovec TCP_IOVec;
+#define TCP_IOVEC_SET(iov, data, length) do { \
+        (iov).iov_base = (void*)(data); (iov).iov_len = (length); } while(0)
+#endif
+
+typedef struct {
+    UA_POSIXConnectionManager pcm;
+
+    /* Limits for the send queue of the connections */
+    size_t sendQueueHigh;
+    size_t sendQueueLow;
+    size_t sendQueueMax;
+
+    UA_TCPStatistics stats;
+
+    /* Number of connections with queued or held-back data. Sending bypasses
+     * the EventLoop lock only while this is zero. */
+    volatile size_t pendingConnections;
+
+    /* TCP ConnectionManagers in other EventLoops that accept connections for
+     * the listen sockets opened in this ConnectionManager */
+    UA_ConnectionManager **shards;
+    size_t shardsSize;
+    UA_Boolean isShard;
+} TCP_ConnectionManager;
+
+/* Data that could not be sent right away */
+typedef struct TCP_SendBuffer {
+    TAILQ_ENTRY(TCP_SendBuffer) next;
+    UA_ByteString buf;
+    size_t offset; /* Number of bytes already sent */
+} TCP_SendBuffer;
+
+typedef TAILQ_HEAD(TCP_SendQueue, TCP_SendBuffer) TCP_SendQueue;
+
 typedef struct {
     UA_RegisteredFD rfd;
 
     UA_ConnectionManager_connectionCallback applicationCB;
     void *application;
     void *context;
+
+    /* The send queue is flushed when the socket becomes writable. Crossing the
+     * high/low watermark is signaled to the application (send-blocked). */
+    TCP_SendQueue sendQueue;
+    size_t sendQueueSize; /* Number of queued bytes */
+
+    /* Buffers sent with the "more" parameter are held back. They are sent
+     * together with the next buffer without the flag in a single syscall. */
+    TCP_SendQueue gatherQueue;
+    size_t gatherCount;
+
+    UA_Boolean pending; /* Counted in pendingConnections */
+    UA_Boolean sendBlocked;
+    UA_Boolean sendBlockedSignaled; /* The state last signaled */
+
+    /* The blocked state is signaled from a delayed callback. Not from within
+     * the send operation. If the connection is closed while the delayed
+     * callback is pending, the memory is freed in the delayed callback. */
+    UA_Boolean signalPending;
+    UA_Boolean closed;
+    UA_DelayedCallback signalDC;
 } TCP_FD;
 
 static void
 TCP_shutdown(UA_ConnectionManager *cm, TCP_FD *conn);
 
+static void
+TCP_flushSendQueue(UA_ConnectionManager *cm, TCP_FD *conn);
+
+static ssize_t
+TCP_sendQueue(TCP_ConnectionManager *tcm, UA_FD fd, TCP_SendQueue *queue);
+
 /* Do not merge packets on the socket (disable Nagle's algorithm) */
 static UA_StatusCode
 TCP_setNoNagle(UA_FD sockfd) {
@@ -55,6 +134,79 @@ TCP_setNoNagle(UA_FD sockfd) {
     return UA_STATUSCODE_GOOD;
 }
 
+static void
+TCP_clearQueue(TCP_SendQueue *queue) {
+    TCP_SendBuffer *sb, *sb_tmp;
+    TAILQ_FOREACH_SAFE(sb, queue, next, sb_tmp) {
+        TAILQ_REMOVE(queue, sb, next);
+        UA_ByteString_clear(&sb->buf);
+        UA_free(sb);
+    }
+}
+
+/* Update the count of connections with queued or held-back data. Call after
+ * the queues of the connection were modified. */
+static void
+TCP_updatePending(TCP_ConnectionManager *tcm, TCP_FD *conn) {
+    UA_Boolean pending = (!TAILQ_EMPTY(&conn->sendQueue) ||
+                          !TAILQ_EMPTY(&conn->gatherQueue));
+    if(pending == conn->pending)
+        return;
+    conn->pending = pending;
+    if(pending)
+        UA_atomic_addSize(&tcm->pendingConnections, 1);
+    else
+        UA_atomic_subSize(&tcm->pendingConnections, 1);
+}
+
+static void
+TCP_clearSendQueue(TCP_ConnectionManager *tcm, TCP_FD *conn) {
+    TCP_clearQueue(&conn->sendQueue);
+    TCP_clearQueue(&conn->gatherQueue);
+    conn->sendQueueSize = 0;
+    conn->gatherCount = 0;
+    TCP_updatePending(tcm, conn);
+}
+
+/* Signal the change of the send-blocked state to the application */
+static void
+TCP_signalSendBlocked(UA_ConnectionManager *cm, TCP_FD *conn) {
+    if(conn->sendBlocked == conn->sendBlockedSignaled)
+        return;
+    conn->sendBlockedSignaled = conn->sendBlocked;
+
+    UA_LOG_DEBUG(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
+                 "TCP %u\t| Sending is %s (%u bytes queued)",
+                 (unsigned)conn->rfd.fd, (conn->sendBlocked) ? "blocked" : "unblocked",
+                 (unsigned)conn->sendQueueSize);
+
+    UA_Boolean blocked = conn->sendBlocked;
+    UA_KeyValuePair kvp;
+    kvp.key = UA_QUALIFIEDNAME(0, "send-blocked");
+    UA_Variant_setScalar(&kvp.value, &blocked, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_KeyValueMap kvm = {1, &kvp};
+    conn->applicationCB(cm, (uintptr_t)conn->rfd.fd,
+                        conn->application, &conn->context,
+                        UA_CONNECTIONSTATE_ESTABLISHED,
+                        &kvm, UA_BYTESTRING_NULL);
+}
+
+static void
+TCP_delayedSignal(void *application, void *context) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)application;
+    (void)el;
+    TCP_FD *conn = (TCP_FD*)context;
+    UA_LOCK(&el->elMutex);
+    conn->signalPending = false;
+    if(conn->closed) {
+        /* The connection was closed in the meantime */
+        UA_free(conn);
+    } else if(!conn->rfd.dc.callback) {
+        TCP_signalSendBlocked((UA_ConnectionManager*)conn->rfd.es, conn);
+    }
+    UA_UNLOCK(&el->elMutex);
+}
+
 /* Test if the ConnectionManager can be stopped */
 static void
 TCP_checkStopped(UA_POSIXConnectionManager *pcm) {
@@ -112,7 +264,12 @@ TCP_delayedClose(void *application, void *context) {
                           (unsigned)conn->rfd.fd, errno_str));
     }
 
-    UA_free(conn);
+    /* Free the memory. Unless a delayed signal callback still points to it. */
+    TCP_clearSendQueue((TCP_ConnectionManager*)pcm, conn);
+    if(conn->signalPending)
+        conn->closed = true;
+    else
+        UA_free(conn);
 
     /* Check if this was the last connection for a closing ConnectionManager */
     TCP_checkStopped(pcm);
@@ -154,6 +311,12 @@ TCP_connectionSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn,
         return;
     }
 
+    /* Write-Event for an established connection with queued data */
+    if(event == UA_FDEVENT_OUT && !TAILQ_EMPTY(&conn->sendQueue)) {
+        TCP_flushSendQueue(cm, conn);
+        return;
+    }
+
     /* Write-Event, a new connection has opened. But some errors come as an
      * out-event. For example if the remote side could not be reached to
      * initiate the connection. So we check manually for error conditions on
@@ -184,6 +347,13 @@ TCP_connectionSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn,
         return;
     }
 
+    /* Don't wait for the write-event if data keeps arriving on the socket */
+    if(!TAILQ_EMPTY(&conn->sendQueue)) {
+        TCP_flushSendQueue(cm, conn);
+        if(conn->rfd.dc.callback)
+            return; /* Closing */
+    }
+
     UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                  "TCP %u\t| Allocate receive buffer",
                  (unsigned)conn->rfd.fd);
@@ -278,7 +448,9 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
 
     /* Configure the new socket */
     UA_StatusCode res = UA_STATUSCODE_GOOD;
-    /* res |= UA_EventLoopPOSIX_setNonBlocking(newsockfd); Inherited from the listen-socket */
+    /* Not inherited from the listen-socket on all platforms (e.g. Linux). The
+     * send operation must never block the EventLoop. */
+    res |= UA_EventLoopPOSIX_setNonBlocking(newsockfd);
     res |= UA_EventLoopPOSIX_setNoSigPipe(newsockfd); /* Supress interrupts from the socket */
     res |= TCP_setNoNagle(newsockfd);     /* Disable Nagle's algorithm */
     if(res != UA_STATUSCODE_GOOD) {
@@ -302,6 +474,8 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
     }
 
     newConn->rfd.fd = newsockfd;
+    TAILQ_INIT(&newConn->sendQueue);
+    TAILQ_INIT(&newConn->gatherQueue);
     newConn->rfd.listenEvents = UA_FDEVENT_IN;
     newConn->rfd.es = &cm->eventSource;
     newConn->rfd.eventSourceCB = (UA_FDCallback)TCP_connectionSocketCallback;
@@ -488,6 +662,8 @@ TCP_registerListenSocket(UA_POSIXConnectionManager *pcm, struct addrinfo *ai,
     }
 
     newConn->rfd.fd = listenSocket;
+    TAILQ_INIT(&newConn->sendQueue);
+    TAILQ_INIT(&newConn->gatherQueue);
     newConn->rfd.listenEvents = UA_FDEVENT_IN;
     newConn->rfd.es = &pcm->cm.eventSource;
     newConn->rfd.eventSourceCB = (UA_FDCallback)TCP_listenSocketCallback;
@@ -589,6 +765,10 @@ TCP_shutdown(UA_ConnectionManager *cm, TCP_FD *conn) {
         return;
     }
 
+    /* Try to send out the remaining queued data (best effort). Incomplete
+     * messages in the gather queue are dropped. */
+    TCP_sendQueue((TCP_ConnectionManager*)cm, conn->rfd.fd, &conn->sendQueue);
+
     /* Shutdown the socket to cancel the current select/epoll */
     UA_shutdown(conn->rfd.fd, UA_SHUT_RDWR);
 
@@ -629,62 +809,370 @@ TCP_shutdownConnection(UA_ConnectionManager *cm, uintptr_t connectionId) {
     return UA_STATUSCODE_GOOD;
 }
 
+/* Send without blocking. Returns the number of bytes sent or -1 for an error
+ * that closes the connection. */
+static ssize_t
+TCP_sendNonBlocking(TCP_ConnectionManager *tcm, UA_FD fd,
+                    const UA_Byte *data, size_t length) {
+    /* Prevent OS signals when sending to a closed socket */
+    int flags = MSG_NOSIGNAL;
+    size_t nWritten = 0;
+    while(nWritten < length) {
+        UA_atomic_addSize(&tcm->stats.sendCalls, 1);
+        ssize_t n = UA_send(fd, (const char*)data + nWritten,
+                            length - nWritten, flags);
+        if(n < 0) {
+            if(UA_ERRNO == UA_INTERRUPTED)
+                continue;
+            if(UA_ERRNO == UA_WOULDBLOCK || UA_ERRNO == UA_AGAIN)
+                break; /* The socket buffer is full */
+            return -1;
+        }
+        nWritten += (size_t)n;
+    }
+    UA_atomic_addSize(&tcm->stats.sendBytes, nWritten);
+    return (ssize_t)nWritten;
+}
+
+/* Gathering send with a single syscall. Returns the number of bytes sent (zero
+ * if the socket buffer is full) or -1 for an error that closes the
+ * connection. */
+static ssize_t
+TCP_sendVector(TCP_ConnectionManager *tcm, UA_FD fd,
+               TCP_IOVec *iov, size_t iovCount) {
+    ssize_t n;
+    do {
+        UA_atomic_addSize(&tcm->stats.sendCalls, 1);
+#if defined(UA_ARCHITECTURE_WIN32)
+        DWORD sent = 0;
+        n = (WSASend(fd, iov, (DWORD)iovCount, &sent, 0, NULL, NULL) == 0) ?
+            (ssize_t)sent : -1;
+#else
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(struct msghdr));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovCount;
+        n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+#endif
+    } while(n < 0 && UA_ERRNO == UA_INTERRUPTED);
+    if(n < 0)
+        return (UA_ERRNO == UA_WOULDBLOCK || UA_ERRNO == UA_AGAIN) ? 0 : -1;
+    UA_atomic_addSize(&tcm->stats.sendBytes, (size_t)n);
+    return n;
+}
+
+/* Send from the head of the queue until the socket buffer is full. Up to
+ * TCP_IOVECS buffers are sent with one syscall. Fully sent buffers are removed
+ * from the queue. Returns the number of bytes sent or -1 for an error that
+ * closes the connection. */
+static ssize_t
+TCP_sendQueue(TCP_ConnectionManager *tcm, UA_FD fd, TCP_SendQueue *queue) {
+    TCP_IOVec iov[TCP_IOVECS];
+    size_t total = 0;
+    while(!TAILQ_EMPTY(queue)) {
+        /* Collect the buffers */
+        size_t iovCount = 0;
+        size_t length = 0;
+        TCP_SendBuffer *sb;
+        TAILQ_FOREACH(sb, queue, next) {
+            if(iovCount == TCP_IOVECS)
+                break;
+            size_t remaining = sb->buf.length - sb->offset;
+            TCP_IOVEC_SET(iov[iovCount], sb->buf.data + sb->offset, remaining);
+            length += remaining;
+            iovCount++;
+        }
+
+        ssize_t n = TCP_sendVector(tcm, fd, iov, iovCount);
+        if(n < 0)
+            return -1;
+        total += (size_t)n;
+
+        /* Remove the buffers that were sent completely (including empty
+         * buffers) */
+        size_t sent = (size_t)n;
+        while((sb = TAILQ_FIRST(queue))) {
+            size_t remaining = sb->buf.length - sb->offset;
+            if(sent < remaining) {
+                sb->offset += sent;
+                break;
+            }
+            sent -= remaining;
+            TAILQ_REMOVE(queue, sb, next);
+            UA_ByteString_clear(&sb->buf);
+            UA_free(sb);
+        }
+        if((size_t)n < length)
+            break; /* The socket buffer is full */
+    }
+    return (ssize_t)total;
+}
+
+/* Send queued data until the socket buffer is full. Stop listening for the
+ * write-event once the queue is empty. */
+static void
+TCP_flushSendQueue(UA_ConnectionManager *cm, TCP_FD *conn) {
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    ssize_t n = TCP_sendQueue(tcm, conn->rfd.fd, &conn->sendQueue);
+    if(n < 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "TCP %u\t| Send failed with error %s",
+                        (unsigned)conn->rfd.fd, errno_str));
+        TCP_shutdown(cm, conn);
+        return;
+    }
+    conn->sendQueueSize -= (size_t)n;
+
+    /* The queue is empty. Only listen for incoming data. */
+    if(TAILQ_EMPTY(&conn->sendQueue)) {
+        conn->rfd.listenEvents = UA_FDEVENT_IN;
+        UA_EventLoopPOSIX_modifyFD(el, &conn->rfd);
+        TCP_updatePending(tcm, conn);
+    }
+
+    /* Below the low watermark. Signal if no delayed signal is pending. */
+    if(conn->sendBlocked && conn->sendQueueSize <= tcm->sendQueueLow) {
+        conn->sendBlocked = false;
+        if(!conn->signalPending)
+            TCP_signalSendBlocked(cm, conn);
+    }
+}
+
+/* Wrap the unsent remainder of the buffer for queueing. Takes ownership of the
+ * buffer if it was not taken from the static tx buffer. */
+static TCP_SendBuffer *
+TCP_newSendBuffer(TCP_ConnectionManager *tcm, UA_ByteString *buf, size_t offset) {
+    TCP_SendBuffer *sb = (TCP_SendBuffer*)UA_malloc(sizeof(TCP_SendBuffer));
+    if(!sb)
+        return NULL;
+    if(buf->data == tcm->pcm.txBuffer.data) {
+        /* Copy out of the static buffer */
+        UA_ByteString rest = {buf->length - offset, buf->data + offset};
+        if(UA_ByteString_copy(&rest, &sb->buf) != UA_STATUSCODE_GOOD) {
+            UA_free(sb);
+            return NULL;
+        }
+        sb->offset = 0;
+    } else {
+        sb->buf = *buf;
+        sb->offset = offset;
+        UA_ByteString_init(buf);
+    }
+    return sb;
+}
+
+/* Append to the send queue. The buffer is not freed if an error is
+ * returned. */
+static UA_StatusCode
+TCP_enqueueSend(UA_ConnectionManager *cm, TCP_FD *conn, TCP_SendBuffer *sb) {
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex);
+
+    /* The connection cannot keep up. Close instead of growing without bounds. */
+    size_t remaining = sb->buf.length - sb->offset;
+    if(tcm->sendQueueMax > 0 &&
+       conn->sendQueueSize + remaining > tcm->sendQueueMax) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP %u\t| The send queue exceeds the maximum of %u bytes",
+                       (unsigned)conn->rfd.fd, (unsigned)tcm->sendQueueMax);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+
+    /* Listen for the write-event when the first buffer is queued */
+    if(TAILQ_EMPTY(&conn->sendQueue)) {
+        conn->rfd.listenEvents = UA_FDEVENT_IN | UA_FDEVENT_OUT;
+        UA_EventLoopPOSIX_modifyFD(el, &conn->rfd);
+    }
+    TAILQ_INSERT_TAIL(&conn->sendQueue, sb, next);
+    conn->sendQueueSize += remaining;
+
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                 "TCP %u\t| Queued %u bytes for sending (%u bytes in the queue)",
+                 (unsigned)conn->rfd.fd, (unsigned)remaining,
+                 (unsigned)conn->sendQueueSize);
+
+    /* Above the high watermark. Signal from a delayed callback, not from
+     * within the send operation of the application. */
+    if(!conn->sendBlocked && conn->sendQueueSize >= tcm->sendQueueHigh) {
+        conn->sendBlocked = true;
+        if(!conn->signalPending) {
+            conn->signalPending = true;
+            conn->signalDC.callback = TCP_delayedSignal;
+            conn->signalDC.application = el;
+            conn->signalDC.context = conn;
+            UA_EventLoopPOSIX_addDelayedCallback((UA_EventLoop*)el, &conn->signalDC);
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Send the held-back buffers with a gathering syscall. Whatever does not fit
+ * into the socket buffer is moved to the send queue. */
+static UA_StatusCode
+TCP_sendGatherQueue(UA_ConnectionManager *cm, TCP_FD *conn) {
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    conn->gatherCount = 0;
+
+    /* Keep the order. Send directly only if nothing else is queued. */
+    if(TAILQ_EMPTY(&conn->sendQueue)) {
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP %u\t| Attempting to send (gathered)",
+                     (unsigned)conn->rfd.fd);
+        ssize_t n = TCP_sendQueue(tcm, conn->rfd.fd, &conn->gatherQueue);
+        if(n < 0) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                            "TCP %u\t| Send failed with error %s",
+                            (unsigned)conn->rfd.fd, errno_str));
+            return UA_STATUSCODE_BADCONNECTIONCLOSED;
+        }
+    }
+
+    /* Queue the remainder */
+    TCP_SendBuffer *sb;
+    while((sb = TAILQ_FIRST(&conn->gatherQueue))) {
+        TAILQ_REMOVE(&conn->gatherQueue, sb, next);
+        UA_StatusCode res = TCP_enqueueSend(cm, conn, sb);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_ByteString_clear(&sb->buf);
+            UA_free(sb);
+            return res;
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 TCP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
                        const UA_KeyValueMap *params, UA_ByteString *buf) {
-    /* We may not have a lock. But we need not take it. As the connectionId is
-     * the fd, no need to do a lookup and access internal data strucures. */
-
-    /* Prevent OS signals when sending to a closed socket */
-    int flags = MSG_NOSIGNAL;
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_FD fd = (UA_FD)connectionId;
 
-    struct pollfd tmp_poll_fd;
-    tmp_poll_fd.fd = (UA_FD)connectionId;
-    tmp_poll_fd.events = UA_POLLOUT;
+    UA_atomic_addSize(&tcm->stats.sendBuffers, 1);
+    const UA_Boolean *more = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params, UA_QUALIFIEDNAME(0, "more"),
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_Boolean gather = (more && *more);
 
-    /* Send the full buffer. This may require several calls to send */
+    /* Send right away without taking the lock. Never wait for the socket to
+     * become writable. That would block the EventLoop for all connections.
+     * Only possible if nothing is queued or held back. Otherwise the buffer is
+     * appended to the queue to keep the order. */
+    ssize_t n = 0;
     size_t nWritten = 0;
-    do {
-        ssize_t n = 0;
-        do {
-            UA_LOG_DEBUG(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
-                         "TCP %u\t| Attempting to send", (unsigned)connectionId);
-            size_t bytes_to_send = buf->length - nWritten;
-            n = UA_send((UA_FD)connectionId,
-                        (const char*)buf->data + nWritten,
-                        bytes_to_send, flags);
-            if(n < 0) {
-                /* An error we cannot recover from? */
-                if(UA_ERRNO != UA_INTERRUPTED && UA_ERRNO != UA_WOULDBLOCK &&
-                   UA_ERRNO != UA_AGAIN)
-                    goto shutdown;
-
-                /* Poll for the socket resources to become available and retry
-                 * (blocking) */
-                int poll_ret;
-                do {
-                    poll_ret = UA_poll(&tmp_poll_fd, 1, 100);
-                    if(poll_ret < 0 && UA_ERRNO != UA_INTERRUPTED)
-                        goto shutdown;
-                } while(poll_ret <= 0);
-            }
-        } while(n < 0);
-        nWritten += (size_t)n;
-    } while(nWritten < buf->length);
+    UA_Boolean attempted = false;
+    if(!gather && tcm->pendingConnections == 0) {
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP %u\t| Attempting to send", (unsigned)connectionId);
+        attempted = true;
+        n = TCP_sendNonBlocking(tcm, fd, buf->data, buf->length);
+        if(n < 0) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                            "TCP %u\t| Send failed with error %s",
+                            (unsigned)connectionId, errno_str));
+        } else if((size_t)n == buf->length) {
+            UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+            return UA_STATUSCODE_GOOD;
+        } else {
+            nWritten = (size_t)n;
+        }
+    }
+
+    /* Backpressure, held-back buffers or an error. Take the lock. */
+    UA_LOCK(&el->elMutex);
+
+    /* Look up the connection */
+    TCP_FD *conn = (TCP_FD*)ZIP_FIND(UA_FDTree, &tcm->pcm.fds, &fd);
+    if(!conn || conn->rfd.dc.callback) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP %u\t| Cannot send - the connection is closed",
+                       (unsigned)connectionId);
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
 
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(n < 0) {
+        res = UA_STATUSCODE_BADCONNECTIONCLOSED;
+        goto shutdown;
+    }
+
+    /* More buffers follow or buffers are held back -> gathering send */
+    TCP_SendBuffer *sb;
+    if(!attempted && (gather || conn->gatherCount > 0)) {
+        sb = TCP_newSendBuffer(tcm, buf, 0);
+        if(!sb) {
+            res = UA_STATUSCODE_BADOUTOFMEMORY;
+            goto shutdown;
+        }
+        TAILQ_INSERT_TAIL(&conn->gatherQueue, sb, next);
+        conn->gatherCount++;
+
+        /* Hold back until the last buffer or until the vector is full */
+        if(gather && conn->gatherCount < TCP_IOVECS)
+            goto finish;
+
+        res = TCP_sendGatherQueue(cm, conn);
+        if(res != UA_STATUSCODE_GOOD)
+            goto shutdown;
+        goto finish;
+    }
+
+    /* Other connections have queued data (so the lock-free send was skipped)
+     * but not this one. Send directly. */
+    if(!attempted && TAILQ_EMPTY(&conn->sendQueue)) {
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP %u\t| Attempting to send", (unsigned)connectionId);
+        n = TCP_sendNonBlocking(tcm, fd, buf->data, buf->length);
+        if(n < 0) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                            "TCP %u\t| Send failed with error %s",
+                            (unsigned)connectionId, errno_str));
+            res = UA_STATUSCODE_BADCONNECTIONCLOSED;
+            goto shutdown;
+        }
+        nWritten = (size_t)n;
+    }
+
+    /* Queue the remainder */
+    if(nWritten < buf->length) {
+        sb = TCP_newSendBuffer(tcm, buf, nWritten);
+        if(!sb) {
+            res = UA_STATUSCODE_BADOUTOFMEMORY;
+            goto shutdown;
+        }
+        res = TCP_enqueueSend(cm, conn, sb);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_ByteString_clear(&sb->buf);
+            UA_free(sb);
+            goto shutdown;
+        }
+    }
+
+ finish:
     /* Clean up and return */
+    TCP_updatePending(tcm, conn);
     UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+    UA_UNLOCK(&el->elMutex);
     return UA_STATUSCODE_GOOD;
 
  shutdown:
     /* Error -> shutdown the connection  */
-    UA_LOG_SOCKET_ERRNO_WRAP(
-       UA_LOG_ERROR(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
-                    "TCP %u\t| Send failed with error %s",
-                    (unsigned)connectionId, errno_str));
-    TCP_shutdownConnection(cm, connectionId);
+    TCP_shutdown(cm, conn);
+    TCP_updatePending(tcm, conn);
     UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
-    return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    UA_UNLOCK(&el->elMutex);
+    return res;
 }
 
 /* Create a listen-socket that waits for incoming connections */
@@ -722,6 +1210,11 @@ TCP_openPassiveConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *
     if(reuseaddrTmp)
         reuseaddr = *reuseaddrTmp;
 
+    /* The listen sockets of the shards share the port with SO_REUSEPORT */
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)pcm;
+    if(tcm->shardsSize > 0 || tcm->isShard)
+        reuseaddr = true;
+
     /* Undefined or empty addresses array -> listen on all interfaces */
     if(addrsSize == 0) {
         UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
@@ -858,6 +1351,8 @@ TCP_openActiveConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *p
     }
 
     newConn->rfd.fd = newSock;
+    TAILQ_INIT(&newConn->sendQueue);
+    TAILQ_INIT(&newConn->gatherQueue);
     newConn->rfd.es = &pcm->cm.eventSource;
     newConn->rfd.eventSourceCB = (UA_FDCallback)TCP_connectionSocketCallback;
     newConn->rfd.listenEvents = UA_FDEVENT_OUT; /* Switched to _IN once the
@@ -940,6 +1435,21 @@ TCP_openConnection(UA_ConnectionManager *cm, const UA_KeyValueMap *params,
     if(listen) {
         res = TCP_openPassiveConnection(pcm, params, application, context,
                                         connectionCallback, validate);
+
+        /* Open the listen sockets in the shards as well. The kernel
+         * distributes the incoming connections between them. */
+        TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)cm;
+        for(size_t i = 0; i < tcm->shardsSize && res == UA_STATUSCODE_GOOD; i++) {
+            UA_ConnectionManager *shard = tcm->shards[i];
+            if(shard->eventSource.state != UA_EVENTSOURCESTATE_STARTED) {
+                UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                               "TCP\t| The EventLoop of shard %u is not started",
+                               (unsigned)i);
+                continue;
+            }
+            res = shard->openConnection(shard, params, application,
+                                        context, connectionCallback);
+        }
     } else {
         res = TCP_openActiveConnection(pcm, params, application, context,
                                        connectionCallback, validate);
@@ -980,6 +1490,26 @@ TCP_eventSourceStart(UA_ConnectionManager *cm) {
     if(res != UA_STATUSCODE_GOOD)
         goto finish;
 
+    /* Set the limits for the send queue */
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)cm;
+    const UA_UInt32 *high = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 UA_QUALIFIEDNAME(0, "send-queue-high"),
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    const UA_UInt32 *low = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 UA_QUALIFIEDNAME(0, "send-queue-low"),
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    const UA_UInt32 *max = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 UA_QUALIFIEDNAME(0, "send-queue-max"),
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    tcm->sendQueueHigh = (high) ? *high : TCP_SENDQUEUE_HIGH;
+    tcm->sendQueueLow = (low) ? *low : TCP_SENDQUEUE_LOW;
+    tcm->sendQueueMax = (max) ? *max : TCP_SENDQUEUE_MAX;
+    if(tcm->sendQueueLow > tcm->sendQueueHigh)
+        tcm->sendQueueLow = tcm->sendQueueHigh;
+
     /* Set the EventSource to the started state */
     cm->eventSource.state = UA_EVENTSOURCESTATE_STARTED;
 
@@ -1027,6 +1557,9 @@ TCP_eventSourceDelete(UA_ConnectionManager *cm) {
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+    /* The shards are freed with their EventLoop */
+    UA_free(((TCP_ConnectionManager*)cm)->shards);
+
     UA_ByteString_clear(&pcm->rxBuffer);
     UA_ByteString_clear(&pcm->txBuffer);
     UA_KeyValueMap_clear(&cm->eventSource.params);
@@ -1041,7 +1574,7 @@ static const char *tcpName = "tcp";
 UA_ConnectionManager *
 UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName) {
     UA_POSIXConnectionManager *cm = (UA_POSIXConnectionManager*)
-        UA_calloc(1, sizeof(UA_POSIXConnectionManager));
+        UA_calloc(1, sizeof(TCP_ConnectionManager));
     if(!cm)
         return NULL;
 
@@ -1059,4 +1592,82 @@ UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName) {
     return &cm->cm;
 }
 
+UA_TCPStatistics
+UA_ConnectionManager_getStatistics_POSIX_TCP(UA_ConnectionManager *cm) {
+    UA_TCPStatistics stats;
+    memset(&stats, 0, sizeof(UA_TCPStatistics));
+    UA_String tcpProtocol = UA_STRING((char*)(uintptr_t)tcpName);
+    if(!cm || !UA_String_equal(&cm->protocol, &tcpProtocol))
+        return stats;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    if(!el)
+        return ((TCP_ConnectionManager*)cm)->stats;
+    UA_LOCK(&el->elMutex);
+    stats = ((TCP_ConnectionManager*)cm)->stats;
+    UA_UNLOCK(&el->elMutex);
+    return stats;
+}
+
+UA_ConnectionManager *
+UA_ConnectionManager_addShard_POSIX_TCP(UA_ConnectionManager *cm,
+                                        UA_EventLoop *shardEventLoop) {
+    UA_String tcpProtocol = UA_STRING((char*)(uintptr_t)tcpName);
+    if(!cm || !shardEventLoop || !UA_String_equal(&cm->protocol, &tcpProtocol) ||
+       ((TCP_ConnectionManager*)cm)->isShard)
+        return NULL;
+
+#if !defined(__linux__)
+    /* Only Linux distributes the connections between sockets with SO_REUSEPORT.
+     * Elsewhere the last bound socket gets all connections. */
+    UA_LOG_ERROR(shardEventLoop->logger, UA_LOGCATEGORY_NETWORK,
+                 "TCP\t| Shards are only supported on Linux");
+    return NULL;
+#else
+    TCP_ConnectionManager *tcm = (TCP_ConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    if(el) {
+        UA_LOCK(&el->elMutex);
+    }
+    UA_ConnectionManager **shards = (UA_ConnectionManager**)
+        UA_realloc(tcm->shards, sizeof(UA_ConnectionManager*) * (tcm->shardsSize + 1));
+    if(shards)
+        tcm->shards = shards;
+    if(el) {
+        UA_UNLOCK(&el->elMutex);
+    }
+    if(!shards)
+        return NULL;
+
+    /* Create the shard with the same configuration parameters */
+    UA_ConnectionManager *shard =
+        UA_ConnectionManager_new_POSIX_TCP(cm->eventSource.name);
+    if(!shard)
+        return NULL;
+    ((TCP_ConnectionManager*)shard)->isShard = true;
+    UA_StatusCode res = UA_KeyValueMap_copy(&cm->eventSource.params,
+                                            &shard->eventSource.params);
+    if(res != UA_STATUSCODE_GOOD) {
+        shard->eventSource.free(&shard->eventSource);
+        return NULL;
+    }
+
+    /* Registering fails only if the shard cannot be started. It is then
+     * already owned (and freed) by the shard EventLoop. */
+    res = shardEventLoop->registerEventSource(shardEventLoop, &shard->eventSource);
+    if(res != UA_STATUSCODE_GOOD)
+        return NULL;
+
+    /* Append to the shards. The list is used when listen sockets are opened. */
+    if(el) {
+        UA_LOCK(&el->elMutex);
+    }
+    tcm->shards[tcm->shardsSize] = shard;
+    tcm->shardsSize++;
+    if(el) {
+        UA_UNLOCK(&el->elMutex);
+    }
+    return shard;
+#endif
+}
+
 #endif
@@ -19,14 +19,22 @@
 
 /* Configuration parameters */
 
-#define UDP_MANAGERPARAMS 2
+#define UDP_MANAGERPARAMS 3
 
 static UA_KeyValueRestriction udpManagerParams[UDP_MANAGERPARAMS] = {
     {{0, UA_STRING_STATIC("recv-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
-    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
+    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("recv-batch")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
 };
 
-#define UDP_PARAMETERSSIZE 9
+/* Batched receiving (recvmmsg) and sending (sendmmsg) */
+#if defined(__linux__)
+# define UDP_HAVE_MMSG
+# define UDP_RECVBATCH 8  /* Default number of datagrams received at once */
+# define UDP_SENDBATCH 32 /* Maximum number of datagrams held back for sending */
+#endif
+
+#define UDP_PARAMETERSSIZE 10
 #define UDP_PARAMINDEX_LISTEN 0
 #define UDP_PARAMINDEX_ADDR 1
 #define UDP_PARAMINDEX_PORT 2
@@ -36,6 +44,7 @@ static UA_KeyValueRestriction udpManagerParams[UDP_MANAGERPARAMS] = {
 #define UDP_PARAMINDEX_REUSE 6
 #define UDP_PARAMINDEX_SOCKPRIO 7
 #define UDP_PARAMINDEX_VALIDATE 8
+#define UDP_PARAMINDEX_REPORTREMOTE 9
 
 static UA_KeyValueRestriction udpConnectionParams[UDP_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("listen")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
@@ -46,9 +55,24 @@ static UA_KeyValueRestriction udpConnectionParams[UDP_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("loopback")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
     {{0, UA_STRING_STATIC("reuse")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
     {{0, UA_STRING_STATIC("sockpriority")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
-    {{0, UA_STRING_STATIC("validate")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false}
+    {{0, UA_STRING_STATIC("validate")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
+    {{0, UA_STRING_STATIC("report-remote")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false}
 };
 
+typedef struct {
+    UA_POSIXConnectionManager pcm;
+
+#ifdef UDP_HAVE_MMSG
+    /* Ring of receive buffers for recvmmsg. The first slot is the static
+     * rxBuffer, the others are allocated in rxRing. */
+    size_t recvBatch;
+    UA_ByteString rxRing;
+    struct mmsghdr *rxMsgs;
+    struct iovec *rxIovs;
+    struct sockaddr_storage *rxSources;
+#endif
+} UDP_ConnectionManager;
+
 /* A registered file descriptor with an additional method pointer */
 typedef struct {
     UA_RegisteredFD rfd;
@@ -57,12 +81,22 @@ typedef struct {
     void *application;
     void *context;
 
+    /* Format the source address of received messages for the callback */
+    UA_Boolean reportRemote;
+
     struct sockaddr_storage sendAddr;
 #ifdef UA_ARCHITECTURE_WIN32
     size_t sendAddrLength;
 #else
     socklen_t sendAddrLength;
 #endif
+
+#ifdef UDP_HAVE_MMSG
+    /* Buffers sent with the "more" parameter. They are sent with a single
+     * sendmmsg together with the next buffer without the flag. */
+    UA_ByteString held[UDP_SENDBATCH];
+    size_t heldCount;
+#endif
 } UDP_FD;
 
 typedef enum {
@@ -623,6 +657,12 @@ UDP_close(UA_POSIXConnectionManager *pcm, UDP_FD *conn) {
                           (unsigned)conn->rfd.fd, errno_str));
     }
 
+#ifdef UDP_HAVE_MMSG
+    /* Drop the buffers that were held back for sending */
+    for(size_t i = 0; i < conn->heldCount; i++)
+        UA_ByteString_clear(&conn->held[i]);
+#endif
+
     UA_free(conn);
 
     /* Stop if the ucm is stopping and this was the last open socket */
@@ -642,6 +682,100 @@ UDP_delayedClose(void *application, void *context) {
     UA_UNLOCK(&el->elMutex);
 }
 
+/* Forward a received message to the application. The source address is only
+ * formatted if the application asked for it. */
+static void
+UDP_deliverMessage(UA_POSIXConnectionManager *pcm, UDP_FD *conn,
+                   const struct sockaddr_storage *source, UA_ByteString msg) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                 "UDP %u\t| Received message of size %u",
+                 (unsigned)conn->rfd.fd, (unsigned)msg.length);
+
+    if(!conn->reportRemote) {
+        conn->applicationCB(&pcm->cm, (uintptr_t)conn->rfd.fd,
+                            conn->application, &conn->context,
+                            UA_CONNECTIONSTATE_ESTABLISHED,
+                            &UA_KEYVALUEMAP_NULL, msg);
+        return;
+    }
+
+    /* Extract message source and port */
+    char sourceAddr[64];
+    UA_UInt16 sourcePort;
+    switch(source->ss_family) {
+        case AF_INET:
+            UA_inet_ntop(AF_INET, &((const struct sockaddr_in *)source)->sin_addr,
+                    sourceAddr, 64);
+            sourcePort = htons(((const struct sockaddr_in *)source)->sin_port);
+            break;
+        case AF_INET6:
+            UA_inet_ntop(AF_INET6, &(((const struct sockaddr_in6 *)source)->sin6_addr),
+                    sourceAddr, 64);
+            sourcePort = htons(((const struct sockaddr_in6 *)source)->sin6_port);
+            break;
+        default:
+            sourceAddr[0] = 0;
+            sourcePort = 0;
+    }
+
+    UA_String sourceAddrStr = UA_STRING(sourceAddr);
+    UA_KeyValuePair kvp[2];
+    kvp[0].key = UA_QUALIFIEDNAME(0, "remote-address");
+    UA_Variant_setScalar(&kvp[0].value, &sourceAddrStr, &UA_TYPES[UA_TYPES_STRING]);
+    kvp[1].key = UA_QUALIFIEDNAME(0, "remote-port");
+    UA_Variant_setScalar(&kvp[1].value, &sourcePort, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_KeyValueMap kvm = {2, kvp};
+
+    /* Callback to the application layer */
+    conn->applicationCB(&pcm->cm, (uintptr_t)conn->rfd.fd,
+                        conn->application, &conn->context,
+                        UA_CONNECTIONSTATE_ESTABLISHED,
+                        &kvm, msg);
+}
+
+#ifdef UDP_HAVE_MMSG
+/* Receive up to recvBatch datagrams with a single syscall */
+static void
+UDP_receiveBatch(UDP_ConnectionManager *ucm, UDP_FD *conn) {
+    UA_POSIXConnectionManager *pcm = &ucm->pcm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
+    size_t bufSize = pcm->rxBuffer.length;
+    for(size_t i = 0; i < ucm->recvBatch; i++) {
+        ucm->rxIovs[i].iov_base = (i == 0) ? pcm->rxBuffer.data :
+            &ucm->rxRing.data[(i - 1) * bufSize];
+        ucm->rxIovs[i].iov_len = bufSize;
+        memset(&ucm->rxMsgs[i], 0, sizeof(struct mmsghdr));
+        ucm->rxMsgs[i].msg_hdr.msg_name = &ucm->rxSources[i];
+        ucm->rxMsgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        ucm->rxMsgs[i].msg_hdr.msg_iov = &ucm->rxIovs[i];
+        ucm->rxMsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int ret = recvmmsg(conn->rfd.fd, ucm->rxMsgs, (unsigned int)ucm->recvBatch,
+                       MSG_DONTWAIT, NULL);
+    if(ret <= 0) {
+        if(ret < 0 && (UA_ERRNO == UA_INTERRUPTED ||
+                       UA_ERRNO == UA_WOULDBLOCK || UA_ERRNO == UA_AGAIN))
+            return;
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "UDP %u\t| recv signaled the socket was shutdown (%s)",
+                        (unsigned)conn->rfd.fd, errno_str));
+        UDP_close(pcm, conn);
+        return;
+    }
+
+    for(int i = 0; i < ret; i++) {
+        UA_ByteString msg = {ucm->rxMsgs[i].msg_len,
+                             (UA_Byte*)ucm->rxIovs[i].iov_base};
+        UDP_deliverMessage(pcm, conn, &ucm->rxSources[i], msg);
+        if(conn->rfd.dc.callback)
+            break; /* Closing */
+    }
+}
+#endif
+
 /* Gets called when a socket receives data or closes */
 static void
 UDP_connectionSocketCallback(UA_POSIXConnectionManager *pcm, UDP_FD *conn,
@@ -662,6 +796,14 @@ UDP_connectionSocketCallback(UA_POSIXConnectionManager *pcm, UDP_FD *conn,
         return;
     }
 
+#ifdef UDP_HAVE_MMSG
+    UDP_ConnectionManager *ucm = (UDP_ConnectionManager*)pcm;
+    if(ucm->recvBatch > 1) {
+        UDP_receiveBatch(ucm, conn);
+        return;
+    }
+#endif
+
     UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                  "UDP %u\t| Allocate receive buffer", (unsigned)conn->rfd.fd);
 
@@ -697,44 +839,7 @@ UDP_connectionSocketCallback(UA_POSIXConnectionManager *pcm, UDP_FD *conn,
     }
 
     response.length = (size_t)ret; /* Set the length of the received buffer */
-
-    /* Extract message source and port */
-    char sourceAddr[64];
-    UA_UInt16 sourcePort;
-    switch(source.ss_family) {
-        case AF_INET:
-            UA_inet_ntop(AF_INET, &((struct sockaddr_in *)&source)->sin_addr,
-                    sourceAddr, 64);
-            sourcePort = htons(((struct sockaddr_in *)&source)->sin_port);
-            break;
-        case AF_INET6:
-            UA_inet_ntop(AF_INET6, &(((struct sockaddr_in6 *)&source)->sin6_addr),
-                    sourceAddr, 64);
-            sourcePort = htons(((struct sockaddr_in6 *)&source)->sin6_port);
-            break;
-        default:
-            sourceAddr[0] = 0;
-            sourcePort = 0;
-    }
-
-    UA_String sourceAddrStr = UA_STRING(sourceAddr);
-    UA_KeyValuePair kvp[2];
-    kvp[0].key = UA_QUALIFIEDNAME(0, "remote-address");
-    UA_Variant_setScalar(&kvp[0].value, &sourceAddrStr, &UA_TYPES[UA_TYPES_STRING]);
-    kvp[1].key = UA_QUALIFIEDNAME(0, "remote-port");
-    UA_Variant_setScalar(&kvp[1].value, &sourcePort, &UA_TYPES[UA_TYPES_UINT16]);
-    UA_KeyValueMap kvm = {2, kvp};
-
-    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
-                 "UDP %u\t| Received message of size %u from %s on port %u",
-                 (unsigned)conn->rfd.fd, (unsigned)ret,
-                 sourceAddr, sourcePort);
-
-    /* Callback to the application layer */
-    conn->applicationCB(&pcm->cm, (uintptr_t)conn->rfd.fd,
-                        conn->application, &conn->context,
-                        UA_CONNECTIONSTATE_ESTABLISHED,
-                        &kvm, response);
+    UDP_deliverMessage(pcm, conn, &source, response);
 }
 
 static UA_StatusCode
@@ -883,6 +988,12 @@ UDP_registerListenSocket(UA_POSIXConnectionManager *pcm, UA_UInt16 port,
     newudpfd->application = application;
     newudpfd->context = context;
 
+    const UA_Boolean *reportRemote = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params,
+                                 udpConnectionParams[UDP_PARAMINDEX_REPORTREMOTE].name,
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    newudpfd->reportRemote = (reportRemote && *reportRemote);
+
     /* Register in the EventLoop */
     res = UA_EventLoopPOSIX_registerFD(el, &newudpfd->rfd);
     if(res != UA_STATUSCODE_GOOD) {
@@ -1008,6 +1119,97 @@ UDP_shutdownConnection(UA_ConnectionManager *cm, uintptr_t connectionId) {
     return UA_STATUSCODE_GOOD;
 }
 
+#ifdef UDP_HAVE_MMSG
+/* Take over the buffer until the batch is sent. The static tx buffer is reused
+ * for the next message and has to be copied. */
+static UA_StatusCode
+UDP_holdBuffer(UA_POSIXConnectionManager *pcm, UDP_FD *conn, UA_ByteString *buf) {
+    UA_ByteString *held = &conn->held[conn->heldCount];
+    if(buf->data == pcm->txBuffer.data) {
+        UA_StatusCode res = UA_ByteString_copy(buf, held);
+        UA_EventLoopPOSIX_freeNetworkBuffer(&pcm->cm, (uintptr_t)conn->rfd.fd, buf);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    } else {
+        *held = *buf;
+        UA_ByteString_init(buf);
+    }
+    conn->heldCount++;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Send all held buffers with as few sendmmsg calls as possible. Every buffer is
+ * a separate datagram. */
+static UA_StatusCode
+UDP_sendHeld(UA_POSIXConnectionManager *pcm, UDP_FD *conn) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
+    struct mmsghdr msgs[UDP_SENDBATCH];
+    struct iovec iovs[UDP_SENDBATCH];
+    memset(msgs, 0, sizeof(struct mmsghdr) * conn->heldCount);
+    for(size_t i = 0; i < conn->heldCount; i++) {
+        iovs[i].iov_base = conn->held[i].data;
+        iovs[i].iov_len = conn->held[i].length;
+        msgs[i].msg_hdr.msg_name = &conn->sendAddr;
+        msgs[i].msg_hdr.msg_namelen = conn->sendAddrLength;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    size_t sent = 0;
+    while(sent < conn->heldCount) {
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "UDP %u\t| Attempting to send %u messages",
+                     (unsigned)conn->rfd.fd, (unsigned)(conn->heldCount - sent));
+
+        /* Prevent OS signals when sending to a closed socket */
+        int n = sendmmsg(conn->rfd.fd, &msgs[sent],
+                         (unsigned int)(conn->heldCount - sent), MSG_NOSIGNAL);
+        if(n > 0) {
+            sent += (size_t)n;
+            continue;
+        }
+
+        /* An error we cannot recover from? */
+        if(n < 0 && UA_ERRNO != UA_INTERRUPTED &&
+           UA_ERRNO != UA_WOULDBLOCK && UA_ERRNO != UA_AGAIN) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                            "UDP %u\t| Send failed with error %s",
+                            (unsigned)conn->rfd.fd, errno_str));
+            res = UA_STATUSCODE_BADCONNECTIONCLOSED;
+            break;
+        }
+
+        /* Poll for the socket resources to become available and retry
+         * (blocking) */
+        int poll_ret;
+        struct pollfd tmp_poll_fd;
+        tmp_poll_fd.fd = conn->rfd.fd;
+        tmp_poll_fd.events = UA_POLLOUT;
+        do {
+            poll_ret = UA_poll(&tmp_poll_fd, 1, 100);
+        } while(poll_ret == 0 || (poll_ret < 0 && UA_ERRNO == UA_INTERRUPTED));
+        if(poll_ret < 0) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                            "UDP %u\t| Send failed with error %s",
+                            (unsigned)conn->rfd.fd, errno_str));
+            res = UA_STATUSCODE_BADCONNECTIONCLOSED;
+            break;
+        }
+    }
+
+    for(size_t i = 0; i < conn->heldCount; i++)
+        UA_ByteString_clear(&conn->held[i]);
+    conn->heldCount = 0;
+
+    if(res != UA_STATUSCODE_GOOD)
+        UDP_shutdown(&pcm->cm, &conn->rfd);
+    return res;
+}
+#endif
+
 static UA_StatusCode
 UDP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
                        const UA_KeyValueMap *params,
@@ -1026,6 +1228,40 @@ UDP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+#ifdef UDP_HAVE_MMSG
+    /* Hold the buffer back if more messages follow. Or send all held buffers
+     * together with this one. */
+    const UA_Boolean *more = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params, UA_QUALIFIEDNAME(0, "more"),
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if((more && *more) || conn->heldCount > 0) {
+        /* An empty buffer only releases the held buffers */
+        UA_StatusCode res = UA_STATUSCODE_GOOD;
+        if(buf->length > 0)
+            res = UDP_holdBuffer(pcm, conn, buf);
+        else
+            UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_UNLOCK(&el->elMutex);
+            return res;
+        }
+        if((more && *more) && conn->heldCount < UDP_SENDBATCH) {
+            UA_UNLOCK(&el->elMutex);
+            return UA_STATUSCODE_GOOD;
+        }
+        res = UDP_sendHeld(pcm, conn);
+        UA_UNLOCK(&el->elMutex);
+        return res;
+    }
+#endif
+
+    /* Nothing to send. Empty buffers are used to release held buffers. */
+    if(buf->length == 0) {
+        UA_UNLOCK(&el->elMutex);
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+        return UA_STATUSCODE_GOOD;
+    }
+
     /* Send the full buffer. This may require several calls to send */
     size_t nWritten = 0;
     do {
@@ -1325,6 +1561,55 @@ UDP_openConnection(UA_ConnectionManager *cm, const UA_KeyValueMap *params,
     return res;
 }
 
+#ifdef UDP_HAVE_MMSG
+static void
+UDP_freeReceiveRing(UDP_ConnectionManager *ucm) {
+    UA_ByteString_clear(&ucm->rxRing);
+    UA_free(ucm->rxMsgs);
+    UA_free(ucm->rxIovs);
+    UA_free(ucm->rxSources);
+    ucm->rxMsgs = NULL;
+    ucm->rxIovs = NULL;
+    ucm->rxSources = NULL;
+    ucm->recvBatch = 1;
+}
+
+/* The rx buffer is the first slot of the ring. The remaining slots have the
+ * same size. With a batch size of one, recvfrom is used instead of recvmmsg. */
+static UA_StatusCode
+UDP_allocateReceiveRing(UDP_ConnectionManager *ucm) {
+    UDP_freeReceiveRing(ucm);
+
+    UA_UInt32 recvBatch = UDP_RECVBATCH;
+    const UA_UInt32 *configRecvBatch = (const UA_UInt32 *)
+        UA_KeyValueMap_getScalar(&ucm->pcm.cm.eventSource.params,
+                                 udpManagerParams[2].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(configRecvBatch)
+        recvBatch = *configRecvBatch;
+    if(recvBatch <= 1)
+        return UA_STATUSCODE_GOOD;
+
+    UA_StatusCode res =
+        UA_ByteString_allocBuffer(&ucm->rxRing,
+                                  (recvBatch - 1) * ucm->pcm.rxBuffer.length);
+    ucm->rxMsgs = (struct mmsghdr*)
+        UA_calloc(recvBatch, sizeof(struct mmsghdr));
+    ucm->rxIovs = (struct iovec*)
+        UA_calloc(recvBatch, sizeof(struct iovec));
+    ucm->rxSources = (struct sockaddr_storage*)
+        UA_calloc(recvBatch, sizeof(struct sockaddr_storage));
+    if(res != UA_STATUSCODE_GOOD || !ucm->rxMsgs ||
+       !ucm->rxIovs || !ucm->rxSources) {
+        UDP_freeReceiveRing(ucm);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    ucm->recvBatch = recvBatch;
+    return UA_STATUSCODE_GOOD;
+}
+#endif
+
 static UA_StatusCode
 UDP_eventSourceStart(UA_ConnectionManager *cm) {
     UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
@@ -1356,6 +1641,13 @@ UDP_eventSourceStart(UA_ConnectionManager *cm) {
     if(res != UA_STATUSCODE_GOOD)
         goto finish;
 
+#ifdef UDP_HAVE_MMSG
+    /* Allocate the ring for batched receiving */
+    res = UDP_allocateReceiveRing((UDP_ConnectionManager*)pcm);
+    if(res != UA_STATUSCODE_GOOD)
+        goto finish;
+#endif
+
     /* Set the EventSource to the started state */
     cm->eventSource.state = UA_EVENTSOURCESTATE_STARTED;
 
@@ -1403,6 +1695,9 @@ UDP_eventSourceDelete(UA_ConnectionManager *cm) {
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+#ifdef UDP_HAVE_MMSG
+    UDP_freeReceiveRing((UDP_ConnectionManager*)pcm);
+#endif
     UA_ByteString_clear(&pcm->rxBuffer);
     UA_ByteString_clear(&pcm->txBuffer);
     UA_KeyValueMap_clear(&cm->eventSource.params);
@@ -1417,7 +1712,7 @@ static const char *udpName = "udp";
 UA_ConnectionManager *
 UA_ConnectionManager_new_POSIX_UDP(const UA_String eventSourceName) {
     UA_POSIXConnectionManager *cm = (UA_POSIXConnectionManager*)
-        UA_calloc(1, sizeof(UA_POSIXConnectionManager));
+        UA_calloc(1, sizeof(UDP_ConnectionManager));
     if(!cm)
         return NULL;
 
@@ -21,6 +21,15 @@ typedef struct UA_CertificateGroup UA_CertificateGroup;
  * CertificateGroup Plugin API
  * --------------------------- */
 
+/* Counters of the verification result cache. The default Memorystore and
+ * Filestore backends remember successfully verified certificates until the
+ * trust list changes or the verified chain expires. */
+typedef struct {
+    size_t cacheSize;      /* Current number of cached results */
+    UA_UInt64 cacheHits;   /* Verifications answered from the cache */
+    UA_UInt64 cacheMisses; /* Verifications that ran the full chain check */
+} UA_CertificateGroupStatistics;
+
 struct UA_CertificateGroup {
     /* The NodeId of the certificate group this pki store is associated with */
     UA_NodeId certificateGroupId;
@@ -56,6 +65,10 @@ struct UA_CertificateGroup {
     UA_StatusCode (*verifyCertificate)(UA_CertificateGroup *certGroup,
                                        const UA_ByteString *certificate);
 
+    /* Optional. Returns the counters of the verification cache. */
+    UA_StatusCode (*getStatistics)(UA_CertificateGroup *certGroup,
+                                   UA_CertificateGroupStatistics *stats);
+
     void (*clear)(UA_CertificateGroup *certGroup);
 };
 
@@ -503,6 +503,20 @@ UA_EventLoop_new_POSIX(const UA_Logger *logger);
  *    becomes an upper bound for the message size. If undefined a fresh buffer
  *    is allocated for every `allocNetworkBuffer` (default: no buffer).
  *
+ * 0:send-queue-high [uint32]
+ *    Sending never blocks the EventLoop. Data that does not fit into the socket
+ *    buffer is queued and sent once the socket becomes writable. When the queue
+ *    of a connection grows beyond this number of bytes, the connection is
+ *    signaled as send-blocked (default: 1MB).
+ *
+ * 0:send-queue-low [uint32]
+ *    A send-blocked connection is signaled as unblocked once the queue drains
+ *    below this number of bytes (default: 256kB).
+ *
+ * 0:send-queue-max [uint32]
+ *    The connection is closed if the queue would grow beyond this number of
+ *    bytes. Zero for no limit (default: 64MB).
+ *
  * **Open Connection Parameters:**
  *
  * 0:address [string | array of string]
@@ -535,13 +549,57 @@ UA_EventLoop_new_POSIX(const UA_Logger *logger);
  * 0:listen-port [uint16]
  *    Port on which the new connection listens.
  *
+ * **Established Connection Callback Parameters (without a message):**
+ *
+ * 0:send-blocked [boolean]
+ *    The send queue crossed the high (true) or low (false) watermark. The
+ *    application should stop producing new messages for the connection until
+ *    it is unblocked.
+ *
  * **Send Parameters:**
  *
- * No additional parameters for sending over an established TCP socket
- * defined. */
+ * 0:more [boolean]
+ *    More buffers follow that belong to the same message (e.g. the chunks of a
+ *    large response). The buffer is held back and sent together with the
+ *    following buffers in a single gathering syscall (writev/sendmsg) once a
+ *    buffer without this flag is sent (default: false). An empty buffer without
+ *    the flag only sends the held-back buffers. */
 UA_EXPORT UA_ConnectionManager *
 UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName);
 
+/* Counters of the TCP ConnectionManager, e.g. for benchmarking the number of
+ * syscalls required for sending. */
+typedef struct {
+    size_t sendBuffers; /* Buffers passed to sendWithConnection */
+    size_t sendCalls;   /* Syscalls for sending (send/sendmsg/WSASend) */
+    size_t sendBytes;   /* Bytes handed to the sockets */
+} UA_TCPStatistics;
+
+/* Returns all-zero counters if the ConnectionManager is not a TCP
+ * ConnectionManager */
+UA_EXPORT UA_TCPStatistics
+UA_ConnectionManager_getStatistics_POSIX_TCP(UA_ConnectionManager *cm);
+
+/* Accept connections of the TCP ConnectionManager also in another EventLoop
+ * (shard). A TCP ConnectionManager is created with the same configuration
+ * parameters and registered in the shard EventLoop. Every listen connection
+ * opened in ``cm`` afterwards is also opened in all shards with SO_REUSEPORT.
+ * The kernel then distributes the incoming connections between the listen
+ * sockets. Each shard has its own epoll instance, timers and connections and
+ * is run by a separate thread of the application.
+ *
+ * The callbacks of the accepted connections are made from the thread running
+ * the shard. They get the ConnectionManager of the shard as the argument. The
+ * shards must be started before listen connections are opened and keep running
+ * until all connections opened through ``cm`` are closed.
+ *
+ * Listen connections that are already open are not shared with a shard added
+ * later. Only available on Linux. Returns the ConnectionManager of the shard or
+ * NULL. */
+UA_EXPORT UA_ConnectionManager *
+UA_ConnectionManager_addShard_POSIX_TCP(UA_ConnectionManager *cm,
+                                        UA_EventLoop *shardEventLoop);
+
 /**
  * UDP Connection Manager
  * ~~~~~~~~~~~~~~~~~~~~~~
@@ -559,6 +617,11 @@ UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName);
  *    becomes an upper bound for the message size. If undefined a fresh buffer
  *    is allocated for every `allocNetworkBuffer` (default: no buffer).
  *
+ * 0:recv-batch [uint32]
+ *    Number of datagrams that are received with a single system call (Linux
+ *    only). Every datagram gets its own buffer of recv-bufsize. A value of one
+ *    receives one datagram per socket event (default: 8).
+ *
  * **Open Connection Parameters:**
  *
  * 0:listen [boolean]
@@ -600,8 +663,14 @@ UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName);
  *    creating any connection but solely validating the provided parameters
  *    (default: false)
  *
+ * 0:report-remote [boolean]
+ *    Report the source of received messages in the connection callback. Only
+ *    used for listening (default: false).
+ *
  * **Connection Callback Parameters:**
  *
+ * Only set for received messages if report-remote is enabled.
+ *
  * 0:remote-address [string]
  *    Contains the remote IP address.
  *
@@ -610,7 +679,13 @@ UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName);
  *
  * **Send Parameters:**
  *
- * No additional parameters for sending over an UDP connection defined. */
+ * 0:more [boolean]
+ *    More messages for the same connection follow immediately. The buffer is
+ *    held back and sent as a separate datagram together with the next buffer
+ *    that does not set the flag, using a single system call (Linux only,
+ *    ignored elsewhere). At most 32 datagrams are held back (default: false).
+ *    An empty buffer without the flag only sends the held-back datagrams.
+ *    Empty datagrams are never sent. */
 UA_EXPORT UA_ConnectionManager *
 UA_ConnectionManager_new_POSIX_UDP(const UA_String eventSourceName);
 
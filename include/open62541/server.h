@@ -178,6 +178,13 @@ struct UA_ServerConfig {
                               * (default: 0 -> unbounded) */
     UA_Boolean tcpReuseAddr;
 
+    /* Requests are decoded into a per-SecureChannel arena (bump allocator)
+     * with blocks of this size. The arena is reset in one step after the
+     * response was sent, instead of freeing the request recursively. Requests
+     * that don't fit into the block use additional heap blocks that are
+     * released with the reset. (default: 0 -> disabled) */
+    UA_UInt32 requestArenaSize;
+
     /**
      * Security and Encryption
      * ^^^^^^^^^^^^^^^^^^^^^^^ */
@@ -273,6 +280,28 @@ struct UA_ServerConfig {
     UA_Server_AsyncOperationNotifyCallback asyncOperationNotifyCallback;
 #endif
 
+    /**
+     * Service Workers
+     * ^^^^^^^^^^^^^^^
+     * See the section for :ref:`service workers<service-workers>`. */
+#if UA_MULTITHREADING >= 100
+    UA_Boolean serviceWorkers; /* Queue requests for the workers */
+    size_t maxServiceWorkerQueueSize; /* 0 => unlimited */
+    /* Notify workers when a request was enqueued */
+    UA_Server_AsyncOperationNotifyCallback serviceWorkerNotifyCallback;
+#endif
+
+    /**
+     * Handshake Workers
+     * ^^^^^^^^^^^^^^^^^
+     * See the section for :ref:`handshake workers<handshake-workers>`. */
+#if UA_MULTITHREADING >= 100
+    UA_Boolean handshakeWorkers; /* Queue the asymmetric cryptography */
+    size_t maxParallelHandshakes; /* 0 => unlimited */
+    /* Notify workers when a handshake job can be processed */
+    UA_Server_AsyncOperationNotifyCallback handshakeWorkerNotifyCallback;
+#endif
+
     /**
      * Discovery
      * ^^^^^^^^^ */
@@ -2052,6 +2081,90 @@ UA_Server_setAsyncOperationResult(UA_Server *server,
 
 #endif /* !UA_MULTITHREADING >= 100 */
 
+/**
+ * .. _service-workers:
+ *
+ * Service Workers
+ * ---------------
+ * By default, all requests are processed one after the other in the thread
+ * that runs the EventLoop. With the ``serviceWorkers`` option in the server
+ * config, requests for the read-only services (Read, Browse, BrowseNext,
+ * TranslateBrowsePathsToNodeIds and HistoryRead) are instead put into a queue.
+ * Worker threads take the requests from the queue, decode them and execute the
+ * service in parallel. During that time they hold a shared (reader) lock on
+ * the server. All other services and the public API methods take the server
+ * lock exclusively and wait until the workers are done.
+ *
+ * The worker threads are provided by the application. Each worker calls
+ * ``UA_Server_processQueuedRequest`` in a loop. The
+ * ``serviceWorkerNotifyCallback`` is called from the server thread whenever a
+ * request was queued and can be used to wake up the workers.
+ *
+ * Requests of the same session are processed one after the other and in the
+ * order they came in. Once a session has queued requests, all its requests are
+ * queued, also beyond the ``maxServiceWorkerQueueSize``. The workers process
+ * the requests for the other services with the exclusive server lock. Requests
+ * of different sessions are processed in parallel. The responses can be sent in a different order than the requests
+ * came in.
+ *
+ * Note that user-defined callbacks (e.g. value callbacks, DataSources and the
+ * AccessControl plugin) are called from several worker threads at the same
+ * time. If they call the public API methods of the server, then the worker
+ * releases the shared lock and waits for exclusive access. That is correct,
+ * but loses the parallelism. The worker threads must be stopped before the
+ * server is deleted. */
+
+#if UA_MULTITHREADING >= 100
+
+/* Process the next queued request in the current thread. This includes
+ * sending out the response. Returns false if no request was processed. */
+UA_Boolean UA_EXPORT
+UA_Server_processQueuedRequest(UA_Server *server);
+
+#endif /* UA_MULTITHREADING >= 100 */
+
+/**
+ * .. _handshake-workers:
+ *
+ * Handshake Workers
+ * -----------------
+ * Opening a secure connection requires asymmetric (public key) cryptography
+ * that is expensive compared to the normal message processing. When many
+ * clients (re)connect at the same time, the thread that runs the EventLoop
+ * would be busy with the handshakes and the subscriptions and PubSub are
+ * delayed. With the ``handshakeWorkers`` option in the server config, the
+ * following steps are put into a queue for worker threads instead:
+ *
+ * - Decrypting the initial OpenSecureChannel request and signing/encrypting the
+ *   response. Renewals of the SecurityToken are processed right away.
+ * - Signing the CreateSession response.
+ * - Verifying the client signature and decrypting (or verifying) the user
+ *   identity token for ActivateSession.
+ *
+ * The worker threads are provided by the application. Each worker calls
+ * ``UA_Server_processHandshakeJob`` in a loop. The workers never take the
+ * server lock. The handshake is continued in the server thread once the worker
+ * is done. Further messages of a SecureChannel are processed only after its
+ * OpenSecureChannel handshake has completed.
+ *
+ * At most ``maxParallelHandshakes`` jobs are handed to the workers at the same
+ * time. Further jobs wait until a slot becomes free. This keeps a reconnect
+ * storm from occupying all cores. The ``handshakeWorkerNotifyCallback`` is
+ * called from the server thread whenever a job is ready for the workers.
+ *
+ * The handshake workers are not used with the mbedTLS SecurityPolicies, as
+ * they share the random number generator between all SecureChannels. The
+ * worker threads must be stopped before the server is deleted. */
+
+#if UA_MULTITHREADING >= 100
+
+/* Process the asymmetric cryptography of the next handshake job in the current
+ * thread. Returns false if no job was processed. */
+UA_Boolean UA_EXPORT
+UA_Server_processHandshakeJob(UA_Server *server);
+
+#endif /* UA_MULTITHREADING >= 100 */
+
 /**
  * Statistics
  * ----------
@@ -443,6 +443,21 @@ typedef struct {
      * one NetworkMessage */
     UA_UInt16 maxEncapsulatedDataSetMessageCount;
 
+    /* non std. config parameter. Freeze the layout of the NetworkMessage when
+     * the WriterGroup becomes operational. The encoded message is then kept as
+     * a template and only the sequence numbers, timestamps and field values
+     * are written into it in every publish cycle. Requires the UADP encoding
+     * and writers without DeltaFrames and promoted fields. All DataSetMessages
+     * have to fit into a single NetworkMessage. Otherwise the regular publish
+     * path is used. If the encoded size of a field changes, the layout is
+     * computed again. */
+    UA_Boolean frozenNetworkMessage;
+
+    /* non std. config parameter. Publish from an application thread instead
+     * of the EventLoop if != 0. See the section on publisher threads below.
+     * Requires UA_MULTITHREADING >= 100. */
+    UA_UInt16 publisherThread;
+
     /* Security Configuration
      * Message are encrypted if a SecurityPolicy is configured and the
      * securityMode set accordingly. The symmetric key is a runtime information
@@ -480,6 +495,25 @@ UA_Server_getWriterGroupLastPublishTimestamp(UA_Server *server,
                                              const UA_NodeId wgId,
                                              UA_DateTime *timestamp);
 
+/* Timing of the publish cycles since the WriterGroup became operational. The
+ * jitter is the delay between the scheduled and the actual start of a cycle.
+ * The duration covers the sampling, encoding, signing and sending. A deadline
+ * is missed if a cycle is not sent before the next cycle is due, or if a cycle
+ * is skipped entirely. All durations are in milliseconds. */
+typedef struct {
+    UA_UInt64 publishCycles;
+    UA_UInt64 deadlineMisses;
+    UA_Duration lastJitter;
+    UA_Duration maxJitter;
+    UA_Duration lastDuration;
+    UA_Duration maxDuration;
+} UA_WriterGroupPublishStatistics;
+
+UA_EXPORT UA_StatusCode UA_THREADSAFE
+UA_Server_getWriterGroupPublishStatistics(UA_Server *server,
+                                          const UA_NodeId wgId,
+                                          UA_WriterGroupPublishStatistics *stats);
+
 UA_EXPORT UA_StatusCode UA_THREADSAFE
 UA_Server_removeWriterGroup(UA_Server *server, const UA_NodeId wgId);
 
@@ -509,6 +543,36 @@ UA_Server_setWriterGroupEncryptionKeys(UA_Server *server, const UA_NodeId wgId,
 #define UA_Server_WriterGroup_publish(server, wgId) \
     UA_Server_triggerWriterGroupPublish(server, wgId)
 
+/**
+ * Publisher Threads
+ * ^^^^^^^^^^^^^^^^^
+ * By default all WriterGroups are published from timers in the EventLoop. Then
+ * the publish cycles compete with the client/server communication for the
+ * thread running the EventLoop. With UA_MULTITHREADING >= 100, WriterGroups
+ * with a ``publisherThread`` number other than zero in their configuration are
+ * published from application threads instead. Each publisher thread calls
+ * ``UA_Server_publishIterate`` for its number in a loop and sleeps until the
+ * returned time. Several threads can serve the same number and form a pool.
+ * Then every publish cycle of a WriterGroup is executed by one of them.
+ *
+ * The server lock is only held during the sampling of the DataSetMessages.
+ * Values from external value backends are copied in that step. The encoding,
+ * signing and sending is done without the server lock. This requires a
+ * ConnectionManager that allows to allocate buffers and send from several
+ * threads (e.g. UDP if the EventLoop has no static send buffer configured).
+ * The publisher threads must be stopped before the server is deleted. */
+
+#if UA_MULTITHREADING >= 100
+
+/* Execute the due publish cycles of the WriterGroups assigned to the publisher
+ * thread. Returns the monotonic time (from the EventLoop clock) when the next
+ * cycle is due. The returned time is at most 100ms in the future so that newly
+ * enabled WriterGroups are picked up. */
+UA_DateTime UA_EXPORT UA_THREADSAFE
+UA_Server_publishIterate(UA_Server *server, UA_UInt16 publisherThread);
+
+#endif /* UA_MULTITHREADING >= 100 */
+
 /**
  * .. _dsw:
  *
@@ -20,6 +20,7 @@
 #include <mbedtls/sha256.h>
 
 #include "securitypolicy_common.h"
+#include "../ua_certificategroup_cache.h"
 
 #define REMOTECERTIFICATETRUSTED 1
 #define ISSUERKNOWN              2
@@ -28,9 +29,12 @@
 
 /* Configuration parameters */
 
-#define MEMORYCERTSTORE_PARAMETERSSIZE 2
+#define MEMORYCERTSTORE_PARAMETERSSIZE 3
 #define MEMORYCERTSTORE_PARAMINDEX_MAXTRUSTLISTSIZE 0
 #define MEMORYCERTSTORE_PARAMINDEX_MAXREJECTEDLISTSIZE 1
+#define MEMORYCERTSTORE_PARAMINDEX_VERIFICATIONCACHESIZE 2
+
+#define MEMORYCERTSTORE_DEFAULT_VERIFICATIONCACHESIZE 64
 
 static const struct {
     UA_QualifiedName name;
@@ -38,7 +42,8 @@ static const struct {
     UA_Boolean required;
 } MemoryCertStoreParameters[MEMORYCERTSTORE_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("max-trust-listsize")}, &UA_TYPES[UA_TYPES_UINT16], false},
-    {{0, UA_STRING_STATIC("max-rejected-listsize")}, &UA_TYPES[UA_TYPES_STRING], false}
+    {{0, UA_STRING_STATIC("max-rejected-listsize")}, &UA_TYPES[UA_TYPES_STRING], false},
+    {{0, UA_STRING_STATIC("verification-cache-size")}, &UA_TYPES[UA_TYPES_UINT32], false}
 };
 
 typedef struct {
@@ -55,6 +60,10 @@ typedef struct {
     mbedtls_x509_crt issuerCertificates;
     mbedtls_x509_crl trustedCrls;
     mbedtls_x509_crl issuerCrls;
+
+    /* Successfully verified certificates. Flushed when the certificates
+     * and CRLs are reloaded. */
+    UA_CertificateCache cache;
 } MemoryCertStore;
 
 static UA_Boolean mbedtlsCheckCA(mbedtls_x509_crt *cert);
@@ -273,6 +282,8 @@ MemoryCertStore_clear(UA_CertificateGroup *certGroup) {
         mbedtls_x509_crl_free(&context->trustedCrls);
         mbedtls_x509_crl_free(&context->issuerCrls);
 
+        UA_CertificateCache_flush(&context->cache);
+
         UA_free(context);
         certGroup->context = NULL;
     }
@@ -290,6 +301,9 @@ reloadCertificates(UA_CertificateGroup *certGroup) {
     UA_ByteString_init(&data);
     int err = 0;
 
+    /* Cached verification results are based on the previous trust list */
+    UA_CertificateCache_flush(&context->cache);
+
     mbedtls_x509_crt_free(&context->trustedCertificates);
     mbedtls_x509_crt_init(&context->trustedCertificates);
     for(size_t i = 0; i < context->trustList.trustedCertificatesSize; ++i) {
@@ -474,9 +488,27 @@ mbedtlsCheckSignature(const mbedtls_x509_crt *cert, mbedtls_x509_crt *issuer) {
                                   hash, hash_len, sig->p, sig->len) == 0);
 }
 
+static UA_DateTime
+mbedtlsGetNotAfter(const mbedtls_x509_crt *cert) {
+    UA_DateTimeStruct ts;
+    ts.year = (UA_Int16)cert->valid_to.year;
+    ts.month = (UA_UInt16)cert->valid_to.mon;
+    ts.day = (UA_UInt16)cert->valid_to.day;
+    ts.hour = (UA_UInt16)cert->valid_to.hour;
+    ts.min = (UA_UInt16)cert->valid_to.min;
+    ts.sec = (UA_UInt16)cert->valid_to.sec;
+    ts.milliSec = 0;
+    ts.microSec = 0;
+    ts.nanoSec = 0;
+    return UA_DateTime_fromStruct(ts);
+}
+
+/* If the chain is verified, validUntil is lowered to the earliest expiry date
+ * of the certificates in the chain */
 static UA_StatusCode
 mbedtlsVerifyChain(UA_CertificateGroup *cg, MemoryCertStore *ctx, mbedtls_x509_crt *stack,
-                   mbedtls_x509_crt **old_issuers, mbedtls_x509_crt *cert, int depth) {
+                   mbedtls_x509_crt **old_issuers, mbedtls_x509_crt *cert, int depth,
+                   UA_DateTime *validUntil) {
     /* Maxiumum chain length */
     if(depth == UA_MBEDTLS_MAX_CHAIN_LENGTH)
         return UA_STATUSCODE_BADCERTIFICATECHAININCOMPLETE;
@@ -545,18 +577,27 @@ mbedtlsVerifyChain(UA_CertificateGroup *cg, MemoryCertStore *ctx, mbedtls_x509_c
 
         /* We have found the issuer certificate used for the signature. Recurse
          * to the next certificate in the chain (verify the current issuer). */
-        ret = mbedtlsVerifyChain(cg, ctx, stack, old_issuers, issuer, depth + 1);
+        ret = mbedtlsVerifyChain(cg, ctx, stack, old_issuers, issuer,
+                                 depth + 1, validUntil);
     }
 
     /* The chain is complete, but we haven't yet identified a trusted
      * certificate "on the way down". Can we trust this certificate? */
     if(ret == UA_STATUSCODE_BADCERTIFICATEUNTRUSTED) {
         for(mbedtls_x509_crt *t = &ctx->trustedCertificates; t; t = t->next) {
-            if(mbedtlsSameBuf(&cert->tbs, &t->tbs))
-                return UA_STATUSCODE_GOOD;
+            if(mbedtlsSameBuf(&cert->tbs, &t->tbs)) {
+                ret = UA_STATUSCODE_GOOD;
+                break;
+            }
         }
     }
 
+    if(ret == UA_STATUSCODE_GOOD) {
+        UA_DateTime notAfter = mbedtlsGetNotAfter(cert);
+        if(notAfter < *validUntil)
+            *validUntil = notAfter;
+    }
+
     return ret;
 }
 
@@ -578,6 +619,10 @@ verifyCertificate(UA_CertificateGroup *certGroup, const UA_ByteString *certifica
         context->reloadRequired = false;
     }
 
+    /* The certificate was verified before with the same trust list */
+    if(UA_CertificateCache_lookup(&context->cache, certificate))
+        return UA_STATUSCODE_GOOD;
+
     /* Verification Step: Certificate Structure
      * This parses the entire certificate chain contained in the bytestring. */
     mbedtls_x509_crt cert;
@@ -605,8 +650,12 @@ verifyCertificate(UA_CertificateGroup *certGroup, const UA_ByteString *certifica
     /* Verification Step: Build Certificate Chain
      * We perform the checks for each certificate inside. */
     mbedtls_x509_crt *old_issuers[UA_MBEDTLS_MAX_CHAIN_LENGTH];
-    UA_StatusCode ret = mbedtlsVerifyChain(certGroup, context, &cert, old_issuers, &cert, 0);
+    UA_DateTime validUntil = UA_INT64_MAX;
+    UA_StatusCode ret = mbedtlsVerifyChain(certGroup, context, &cert, old_issuers,
+                                           &cert, 0, &validUntil);
     mbedtls_x509_crt_free(&cert);
+    if(ret == UA_STATUSCODE_GOOD)
+        UA_CertificateCache_add(&context->cache, certificate, validUntil);
     return ret;
 }
 
@@ -628,6 +677,19 @@ MemoryCertStore_verifyCertificate(UA_CertificateGroup *certGroup,
     return retval;
 }
 
+static UA_StatusCode
+MemoryCertStore_getStatistics(UA_CertificateGroup *certGroup,
+                              UA_CertificateGroupStatistics *stats) {
+    /* Check parameter */
+    if(certGroup == NULL || certGroup->context == NULL || stats == NULL) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    MemoryCertStore *context = (MemoryCertStore *)certGroup->context;
+    UA_CertificateCache_getStatistics(&context->cache, stats);
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
                                 UA_NodeId *certificateGroupId,
@@ -655,6 +717,7 @@ UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
     certGroup->getRejectedList = MemoryCertStore_getRejectedList;
     certGroup->getCertificateCrls = MemoryCertStore_getCertificateCrls;
     certGroup->verifyCertificate = MemoryCertStore_verifyCertificate;
+    certGroup->getStatistics = MemoryCertStore_getStatistics;
     certGroup->clear = MemoryCertStore_clear;
 
     /* Set PKI Store context data */
@@ -667,6 +730,7 @@ UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
     /* Default values */
     context->maxTrustListSize = 65535;
     context->maxRejectedListSize = 100;
+    UA_CertificateCache_init(&context->cache, MEMORYCERTSTORE_DEFAULT_VERIFICATIONCACHESIZE);
 
     if(params) {
         const UA_UInt32 *maxTrustListSize = (const UA_UInt32*)
@@ -684,6 +748,13 @@ UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
         if(maxRejectedListSize) {
             context->maxRejectedListSize = *maxRejectedListSize;
         }
+
+        const UA_UInt32 *verificationCacheSize = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(params, MemoryCertStoreParameters[MEMORYCERTSTORE_PARAMINDEX_VERIFICATIONCACHESIZE].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+        if(verificationCacheSize) {
+            context->cache.maxEntries = *verificationCacheSize;
+        }
     }
 
     UA_TrustListDataType_add(trustList, &context->trustList);
@@ -816,17 +887,7 @@ UA_CertificateUtils_getExpirationDate(UA_ByteString *certificate,
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
-    UA_DateTimeStruct ts;
-    ts.year = (UA_Int16)publicKey.valid_to.year;
-    ts.month = (UA_UInt16)publicKey.valid_to.mon;
-    ts.day = (UA_UInt16)publicKey.valid_to.day;
-    ts.hour = (UA_UInt16)publicKey.valid_to.hour;
-    ts.min = (UA_UInt16)publicKey.valid_to.min;
-    ts.sec = (UA_UInt16)publicKey.valid_to.sec;
-    ts.milliSec = 0;
-    ts.microSec = 0;
-    ts.nanoSec = 0;
-    *expiryDateTime = UA_DateTime_fromStruct(ts);
+    *expiryDateTime = mbedtlsGetNotAfter(&publicKey);
     mbedtls_x509_crt_free(&publicKey);
     return UA_STATUSCODE_GOOD;
 }
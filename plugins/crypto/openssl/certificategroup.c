@@ -18,14 +18,18 @@
 
 #include "libc_time.h"
 #include "securitypolicy_common.h"
+#include "../ua_certificategroup_cache.h"
 
 #define SHA1_DIGEST_LENGTH 20
 
 /* Configuration parameters */
 
-#define MEMORYCERTSTORE_PARAMETERSSIZE 2
+#define MEMORYCERTSTORE_PARAMETERSSIZE 3
 #define MEMORYCERTSTORE_PARAMINDEX_MAXTRUSTLISTSIZE 0
 #define MEMORYCERTSTORE_PARAMINDEX_MAXREJECTEDLISTSIZE 1
+#define MEMORYCERTSTORE_PARAMINDEX_VERIFICATIONCACHESIZE 2
+
+#define MEMORYCERTSTORE_DEFAULT_VERIFICATIONCACHESIZE 64
 
 static const struct {
     UA_QualifiedName name;
@@ -33,7 +37,8 @@ static const struct {
     UA_Boolean required;
 } MemoryCertStoreParameters[MEMORYCERTSTORE_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("maxTrustListSize")}, &UA_TYPES[UA_TYPES_UINT16], false},
-    {{0, UA_STRING_STATIC("maxRejectedListSize")}, &UA_TYPES[UA_TYPES_STRING], false}
+    {{0, UA_STRING_STATIC("maxRejectedListSize")}, &UA_TYPES[UA_TYPES_STRING], false},
+    {{0, UA_STRING_STATIC("verification-cache-size")}, &UA_TYPES[UA_TYPES_UINT32], false}
 };
 
 struct MemoryCertStore;
@@ -52,6 +57,10 @@ struct MemoryCertStore {
     STACK_OF(X509) *trustedCertificates;
     STACK_OF(X509) *issuerCertificates;
     STACK_OF(X509_CRL) *crls;
+
+    /* Successfully verified certificates. Flushed when the certificates
+     * and CRLs are reloaded. */
+    UA_CertificateCache cache;
 };
 
 static UA_Boolean
@@ -265,6 +274,8 @@ MemoryCertStore_clear(UA_CertificateGroup *certGroup) {
         sk_X509_pop_free (context->issuerCertificates, X509_free);
         sk_X509_CRL_pop_free (context->crls, X509_CRL_free);
 
+        UA_CertificateCache_flush(&context->cache);
+
         UA_free(context);
         certGroup->context = NULL;
     }
@@ -279,6 +290,9 @@ reloadCertificates(UA_CertificateGroup *certGroup) {
 
     MemoryCertStore *context = (MemoryCertStore *)certGroup->context;
 
+    /* Cached verification results are based on the previous trust list */
+    UA_CertificateCache_flush(&context->cache);
+
     sk_X509_pop_free(context->trustedCertificates, X509_free);
     context->trustedCertificates = sk_X509_new_null();
     if(context->trustedCertificates == NULL) {
@@ -533,9 +547,31 @@ openSSLCheckRevoked(UA_CertificateGroup *cg, MemoryCertStore *ctx, X509 *cert) {
 
 #define UA_OPENSSL_MAX_CHAIN_LENGTH 10
 
+static UA_DateTime
+openSSLGetNotAfter(X509 *cert) {
+    struct tm dtTime;
+    if(ASN1_TIME_to_tm(X509_get0_notAfter(cert), &dtTime) != 1)
+        return 0;
+
+    struct mytm dateTime;
+    memset(&dateTime, 0, sizeof(struct mytm));
+    dateTime.tm_year = dtTime.tm_year;
+    dateTime.tm_mon = dtTime.tm_mon;
+    dateTime.tm_mday = dtTime.tm_mday;
+    dateTime.tm_hour = dtTime.tm_hour;
+    dateTime.tm_min = dtTime.tm_min;
+    dateTime.tm_sec = dtTime.tm_sec;
+
+    long long sec_epoch = __tm_to_secs(&dateTime);
+    return UA_DATETIME_UNIX_EPOCH + sec_epoch * UA_DATETIME_SEC;
+}
+
+/* If the chain is verified, validUntil is lowered to the earliest expiry date
+ * of the certificates in the chain */
 static UA_StatusCode
 openSSL_verifyChain(UA_CertificateGroup *cg, MemoryCertStore *ctx, STACK_OF(X509) *stack,
-                    X509 **old_issuers, X509 *cert, int depth) {
+                    X509 **old_issuers, X509 *cert, int depth,
+                    UA_DateTime *validUntil) {
     /* Maxiumum chain length */
     if(depth == UA_OPENSSL_MAX_CHAIN_LENGTH)
         return UA_STATUSCODE_BADCERTIFICATECHAININCOMPLETE;
@@ -608,17 +644,26 @@ openSSL_verifyChain(UA_CertificateGroup *cg, MemoryCertStore *ctx, STACK_OF(X509
 
         /* We have found the issuer certificate used for the signature. Recurse
          * to the next certificate in the chain (verify the current issuer). */
-        ret = openSSL_verifyChain(cg, ctx, stack, old_issuers, issuer, depth + 1);
+        ret = openSSL_verifyChain(cg, ctx, stack, old_issuers, issuer,
+                                  depth + 1, validUntil);
     }
 
     /* Is the certificate in the trust list? If yes, then we are done. */
     if(ret == UA_STATUSCODE_BADCERTIFICATEUNTRUSTED) {
         for(int i = 0; i < sk_X509_num(ctx->trustedCertificates); i++) {
-            if(X509_cmp(cert, sk_X509_value(ctx->trustedCertificates, i)) == 0)
-                return UA_STATUSCODE_GOOD;
+            if(X509_cmp(cert, sk_X509_value(ctx->trustedCertificates, i)) == 0) {
+                ret = UA_STATUSCODE_GOOD;
+                break;
+            }
         }
     }
 
+    if(ret == UA_STATUSCODE_GOOD) {
+        UA_DateTime notAfter = openSSLGetNotAfter(cert);
+        if(notAfter < *validUntil)
+            *validUntil = notAfter;
+    }
+
     return ret;
 }
 
@@ -640,6 +685,10 @@ verifyCertificate(UA_CertificateGroup *certGroup, const UA_ByteString *certifica
         context->reloadRequired = false;
     }
 
+    /* The certificate was verified before with the same trust list */
+    if(UA_CertificateCache_lookup(&context->cache, certificate))
+        return UA_STATUSCODE_GOOD;
+
     /* Verification Step: Certificate Structure */
     STACK_OF(X509) *stack = openSSLLoadCertificateStack(*certificate);
     if(!stack || sk_X509_num(stack) < 1) {
@@ -666,8 +715,12 @@ verifyCertificate(UA_CertificateGroup *certGroup, const UA_ByteString *certifica
     /* Verification Step: Build Certificate Chain
      * We perform the checks for each certificate inside. */
     X509 *old_issuers[UA_OPENSSL_MAX_CHAIN_LENGTH];
-    ret = openSSL_verifyChain(certGroup, context, stack, old_issuers, leaf, 0);
+    UA_DateTime validUntil = UA_INT64_MAX;
+    ret = openSSL_verifyChain(certGroup, context, stack, old_issuers, leaf, 0,
+                              &validUntil);
     sk_X509_pop_free(stack, X509_free);
+    if(ret == UA_STATUSCODE_GOOD)
+        UA_CertificateCache_add(&context->cache, certificate, validUntil);
     return ret;
 }
 
@@ -689,6 +742,19 @@ MemoryCertStore_verifyCertificate(UA_CertificateGroup *certGroup,
     return retval;
 }
 
+static UA_StatusCode
+MemoryCertStore_getStatistics(UA_CertificateGroup *certGroup,
+                              UA_CertificateGroupStatistics *stats) {
+    /* Check parameter */
+    if(certGroup == NULL || certGroup->context == NULL || stats == NULL) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    MemoryCertStore *context = (MemoryCertStore *)certGroup->context;
+    UA_CertificateCache_getStatistics(&context->cache, stats);
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
                                 UA_NodeId *certificateGroupId,
@@ -716,6 +782,7 @@ UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
     certGroup->getRejectedList = MemoryCertStore_getRejectedList;
     certGroup->getCertificateCrls = MemoryCertStore_getCertificateCrls;
     certGroup->verifyCertificate = MemoryCertStore_verifyCertificate;
+    certGroup->getStatistics = MemoryCertStore_getStatistics;
     certGroup->clear = MemoryCertStore_clear;
 
     /* Set PKI Store context data */
@@ -728,6 +795,7 @@ UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
     /* Default values */
     context->maxTrustListSize = 65535;
     context->maxRejectedListSize = 100;
+    UA_CertificateCache_init(&context->cache, MEMORYCERTSTORE_DEFAULT_VERIFICATIONCACHESIZE);
 
     if(params) {
         const UA_UInt32 *maxTrustListSize = (const UA_UInt32*)
@@ -745,6 +813,13 @@ UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
         if(maxRejectedListSize) {
             context->maxRejectedListSize = *maxRejectedListSize;
         }
+
+        const UA_UInt32 *verificationCacheSize = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(params, MemoryCertStoreParameters[MEMORYCERTSTORE_PARAMINDEX_VERIFICATIONCACHESIZE].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+        if(verificationCacheSize) {
+            context->cache.maxEntries = *verificationCacheSize;
+        }
     }
 
     UA_TrustListDataType_add(trustList, &context->trustList);
@@ -834,24 +909,8 @@ UA_CertificateUtils_getExpirationDate(UA_ByteString *certificate,
         return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
 
     /* Get the certificate Expiry date */
-    ASN1_TIME *not_after = X509_get_notAfter(x509);
-
-    struct tm dtTime;
-    ASN1_TIME_to_tm(not_after, &dtTime);
+    *expiryDateTime = openSSLGetNotAfter(x509);
     X509_free(x509);
-
-    struct mytm dateTime;
-    memset(&dateTime, 0, sizeof(struct mytm));
-    dateTime.tm_year = dtTime.tm_year;
-    dateTime.tm_mon = dtTime.tm_mon;
-    dateTime.tm_mday = dtTime.tm_mday;
-    dateTime.tm_hour = dtTime.tm_hour;
-    dateTime.tm_min = dtTime.tm_min;
-    dateTime.tm_sec = dtTime.tm_sec;
-
-    long long sec_epoch = __tm_to_secs(&dateTime);
-    *expiryDateTime = UA_DATETIME_UNIX_EPOCH;
-    *expiryDateTime += sec_epoch * UA_DATETIME_SEC;
     return UA_STATUSCODE_GOOD;
 }
 
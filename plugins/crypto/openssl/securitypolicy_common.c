@@ -33,6 +33,8 @@ modification history
 #include <openssl/ecdsa.h>
 #include <openssl/kdf.h>
 
+#include <limits.h>
+
 #if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
 #include <openssl/core_names.h>
 #endif
@@ -641,199 +643,161 @@ UA_Openssl_RSA_PSS_SHA256_Sign (const UA_ByteString * message,
                                         RSA_PKCS1_PSS_PADDING, outSignature);
 }
 
+/* The symmetric cipher and MAC contexts of a SecureChannel are created when the
+ * keys are set and reused for every message. Binding the key once saves the
+ * key schedule, the HMAC ipad/opad hashing and the allocation of the contexts
+ * per message. */
+
+void
+UA_OpenSSL_SymContext_clear(UA_OpenSSL_SymContext *ctx) {
+    if(ctx->cipherCtx)
+        EVP_CIPHER_CTX_free(ctx->cipherCtx);
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    if(ctx->macCtx)
+        EVP_MAC_CTX_free(ctx->macCtx);
+#else
+    if(ctx->macCtx)
+        HMAC_CTX_free(ctx->macCtx);
+#endif
+    memset(ctx, 0, sizeof(UA_OpenSSL_SymContext));
+}
+
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Verify (const UA_ByteString *     message,
-                               const UA_ByteString *     key,
-                               const UA_ByteString *     signature
-                              ) {
-    unsigned char buf[SHA256_DIGEST_LENGTH] = {0};
-    UA_ByteString mac = {SHA256_DIGEST_LENGTH, buf};
-
-    if (HMAC (EVP_sha256(), key->data, (int) key->length, message->data, message->length,
-              mac.data, (unsigned int *) &mac.length) == NULL) {
+UA_OpenSSL_SymContext_setSigningKey(UA_OpenSSL_SymContext *ctx, const EVP_MD *md,
+                                    const UA_ByteString *key) {
+    ctx->macLength = (size_t)EVP_MD_size(md);
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    if(!ctx->macCtx) {
+        EVP_MAC *mac = EVP_MAC_fetch(NULL, "HMAC", NULL);
+        if(!mac)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        ctx->macCtx = EVP_MAC_CTX_new(mac);
+        EVP_MAC_free(mac); /* The context holds a reference */
+        if(!ctx->macCtx)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    OSSL_PARAM params[2];
+    params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+                                                 (char*)(uintptr_t)EVP_MD_get0_name(md), 0);
+    params[1] = OSSL_PARAM_construct_end();
+    if(EVP_MAC_init(ctx->macCtx, key->data, key->length, params) != 1)
         return UA_STATUSCODE_BADINTERNALERROR;
+#else
+    if(!ctx->macCtx) {
+        ctx->macCtx = HMAC_CTX_new();
+        if(!ctx->macCtx)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
     }
-    if (UA_ByteString_equal (signature, &mac)) {
-        return UA_STATUSCODE_GOOD;
-    }
-    else {
+    if(HMAC_Init_ex(ctx->macCtx, key->data, (int)key->length, md, NULL) != 1)
         return UA_STATUSCODE_BADINTERNALERROR;
-    }
+#endif
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Sign (const UA_ByteString *     message,
-                             const UA_ByteString *     key,
-                             UA_ByteString *           signature
-                             ) {
-    if (HMAC (EVP_sha256(), key->data, (int) key->length, message->data,
-              message->length,
-              signature->data, (unsigned int *) &(signature->length)) == NULL) {
+UA_OpenSSL_SymContext_setEncryptingKey(UA_OpenSSL_SymContext *ctx,
+                                       const EVP_CIPHER *cipherAlg,
+                                       UA_Boolean encrypt,
+                                       const UA_ByteString *key) {
+    if(key->length != (size_t)EVP_CIPHER_key_length(cipherAlg))
+        return UA_STATUSCODE_BADINTERNALERROR;
+    if(!ctx->cipherCtx) {
+        ctx->cipherCtx = EVP_CIPHER_CTX_new();
+        if(!ctx->cipherCtx)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    /* The IV is set for every message */
+    if(EVP_CipherInit_ex(ctx->cipherCtx, cipherAlg, NULL, key->data,
+                         NULL, encrypt ? 1 : 0) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    /* Padding is done in the stack before calling encryption */
+    if(EVP_CIPHER_CTX_set_padding(ctx->cipherCtx, 0) != 1)
         return UA_STATUSCODE_BADINTERNALERROR;
-    }
     return UA_STATUSCODE_GOOD;
 }
 
 static UA_StatusCode
-UA_OpenSSL_Decrypt (const UA_ByteString * iv,
-                    const UA_ByteString * key,
-                    const EVP_CIPHER *    cipherAlg,
-                    UA_ByteString *       data  /* [in/out]*/) {
-    UA_ByteString    ivCopy    = {0, NULL};
-    UA_ByteString    cipherTxt = {0, NULL};
-    EVP_CIPHER_CTX * ctx       = NULL;
-    UA_StatusCode    ret;
-    int              opensslRet;
-    int              outLen;
-    int              tmpLen;
-
-    /* copy the IV because the AES_cbc_encrypt function overwrites it. */
-
-    ret = UA_ByteString_copy (iv, &ivCopy);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
-
-    ret = UA_ByteString_copy (data, &cipherTxt);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
-
-    ctx = EVP_CIPHER_CTX_new ();
-    if (ctx == NULL) {
-        ret = UA_STATUSCODE_BADOUTOFMEMORY;
-        goto errout;
-    }
-
-    /* call EVP_* to decrypt */
+UA_OpenSSL_SymContext_mac(UA_OpenSSL_SymContext *ctx, const UA_ByteString *message,
+                          unsigned char *out) {
+    if(!ctx->macCtx)
+        return UA_STATUSCODE_BADINTERNALERROR;
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    /* Re-initializing without a key reuses the key bound before */
+    size_t outLen = 0;
+    if(EVP_MAC_init(ctx->macCtx, NULL, 0, NULL) != 1 ||
+       EVP_MAC_update(ctx->macCtx, message->data, message->length) != 1 ||
+       EVP_MAC_final(ctx->macCtx, out, &outLen, ctx->macLength) != 1 ||
+       outLen != ctx->macLength)
+        return UA_STATUSCODE_BADINTERNALERROR;
+#else
+    unsigned int outLen = 0;
+    if(HMAC_Init_ex(ctx->macCtx, NULL, 0, NULL, NULL) != 1 ||
+       HMAC_Update(ctx->macCtx, message->data, message->length) != 1 ||
+       HMAC_Final(ctx->macCtx, out, &outLen) != 1 ||
+       outLen != ctx->macLength)
+        return UA_STATUSCODE_BADINTERNALERROR;
+#endif
+    return UA_STATUSCODE_GOOD;
+}
 
-    opensslRet = EVP_DecryptInit_ex (ctx, cipherAlg, NULL, key->data, ivCopy.data);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    /* EVP_DecryptFinal() will return an error code if padding is enabled
-     * and the final block is not correctly formatted.
-     */
-    EVP_CIPHER_CTX_set_padding (ctx, 0);
-    opensslRet = EVP_DecryptUpdate (ctx, data->data, &outLen,
-                                    cipherTxt.data, (int) cipherTxt.length);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    opensslRet = EVP_DecryptFinal_ex (ctx, data->data + outLen, &tmpLen);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    outLen += tmpLen;
-    data->length = (size_t) outLen;
-    ret = UA_STATUSCODE_GOOD;
+UA_StatusCode
+UA_OpenSSL_SymContext_sign(UA_OpenSSL_SymContext *ctx, const UA_ByteString *message,
+                           UA_ByteString *signature) {
+    if(signature->length != ctx->macLength)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_OpenSSL_SymContext_mac(ctx, message, signature->data);
+}
 
-errout:
-    UA_ByteString_clear (&ivCopy);
-    UA_ByteString_clear (&cipherTxt);
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
-    }
-    return ret;
+UA_StatusCode
+UA_OpenSSL_SymContext_verify(UA_OpenSSL_SymContext *ctx, const UA_ByteString *message,
+                             const UA_ByteString *signature) {
+    unsigned char buf[EVP_MAX_MD_SIZE];
+    if(signature->length != ctx->macLength)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    UA_StatusCode ret = UA_OpenSSL_SymContext_mac(ctx, message, buf);
+    if(ret != UA_STATUSCODE_GOOD)
+        return ret;
+    if(CRYPTO_memcmp(buf, signature->data, ctx->macLength) != 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
 }
 
+/* Runs AES-CBC in place. EVP copies the IV into the context, so neither the IV
+ * nor the data have to be copied before. */
 static UA_StatusCode
-UA_OpenSSL_Encrypt (const UA_ByteString * iv,
-                    const UA_ByteString * key,
-                    const EVP_CIPHER *    cipherAlg,
-                    UA_ByteString *       data  /* [in/out]*/
-                    ) {
-
-    UA_ByteString    ivCopy   = {0, NULL};
-    UA_ByteString    plainTxt = {0, NULL};
-    EVP_CIPHER_CTX * ctx      = NULL;
-    UA_StatusCode    ret;
-    int              opensslRet;
-    int              outLen;
-    int              tmpLen;
-
-    /* copy the IV because the AES_cbc_encrypt function overwrites it. */
-
-    ret = UA_ByteString_copy (iv, &ivCopy);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
-
-    ret = UA_ByteString_copy (data, &plainTxt);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
-
-    ctx = EVP_CIPHER_CTX_new ();
-    if (ctx == NULL) {
-        ret = UA_STATUSCODE_BADOUTOFMEMORY;
-        goto errout;
-    }
-
-    /* call EVP_* to encrypt */
-
-    opensslRet = EVP_EncryptInit_ex (ctx, cipherAlg, NULL, key->data, ivCopy.data);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-
-    /* Disable padding. Padding is done in the stack before calling encryption.
-     * Ensure that we have a multiple of the block size */
-    if(data->length % (size_t)EVP_CIPHER_CTX_block_size(ctx)) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    opensslRet = EVP_CIPHER_CTX_set_padding(ctx, 0);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-
-    /* Encrypt the data */
-    opensslRet = EVP_EncryptUpdate (ctx, data->data, &outLen,
-                                    plainTxt.data, (int) plainTxt.length);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
+UA_OpenSSL_SymContext_cipher(UA_OpenSSL_SymContext *ctx, const UA_ByteString *iv,
+                             UA_ByteString *data /* [in/out]*/) {
+    EVP_CIPHER_CTX *cctx = ctx->cipherCtx;
+    if(!cctx)
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-    /* Encrypt-final does nothing as padding is disabled */
-    opensslRet = EVP_EncryptFinal_ex(ctx, data->data + outLen, &tmpLen);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    outLen += tmpLen;
-    data->length = (size_t) outLen;
-    ret = UA_STATUSCODE_GOOD;
+    /* Ensure that we have a multiple of the block size */
+    if(iv->length < (size_t)EVP_CIPHER_CTX_iv_length(cctx) ||
+       data->length % (size_t)EVP_CIPHER_CTX_block_size(cctx) != 0 ||
+       data->length > INT_MAX)
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-errout:
-    UA_ByteString_clear (&ivCopy);
-    UA_ByteString_clear (&plainTxt);
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
-    }
-    return ret;
+    /* Only set the IV. The key schedule is kept from the initialization. */
+    int outLen = 0;
+    int tmpLen = 0;
+    if(EVP_CipherInit_ex(cctx, NULL, NULL, NULL, iv->data, -1) != 1 ||
+       EVP_CipherUpdate(cctx, data->data, &outLen, data->data, (int)data->length) != 1 ||
+       EVP_CipherFinal_ex(cctx, data->data + outLen, &tmpLen) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    data->length = (size_t)(outLen + tmpLen);
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Decrypt (const UA_ByteString * iv,
-                                const UA_ByteString * key,
-                                UA_ByteString *       data  /* [in/out]*/
-                                ) {
-    return UA_OpenSSL_Decrypt (iv, key, EVP_aes_256_cbc (), data);
+UA_OpenSSL_SymContext_encrypt(UA_OpenSSL_SymContext *ctx, const UA_ByteString *iv,
+                              UA_ByteString *data /* [in/out]*/) {
+    return UA_OpenSSL_SymContext_cipher(ctx, iv, data);
 }
 
 UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Encrypt (const UA_ByteString * iv,
-                            const UA_ByteString * key,
-                            UA_ByteString *       data  /* [in/out]*/
-                            ) {
-    return UA_OpenSSL_Encrypt (iv, key, EVP_aes_256_cbc (), data);
+UA_OpenSSL_SymContext_decrypt(UA_OpenSSL_SymContext *ctx, const UA_ByteString *iv,
+                              UA_ByteString *data /* [in/out]*/) {
+    return UA_OpenSSL_SymContext_cipher(ctx, iv, data);
 }
 
 UA_StatusCode
@@ -948,39 +912,6 @@ UA_Openssl_Random_Key_PSHA1_Derive (const UA_ByteString *     secret,
     return UA_STATUSCODE_GOOD;
 }
 
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Verify (const UA_ByteString *     message,
-                             const UA_ByteString *     key,
-                             const UA_ByteString *     signature
-                             ) {
-    unsigned char buf[SHA1_DIGEST_LENGTH] = {0};
-    UA_ByteString mac = {SHA1_DIGEST_LENGTH, buf};
-
-    if(HMAC (EVP_sha1(), key->data, (int) key->length, message->data, message->length,
-             mac.data, (unsigned int *) &mac.length) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    if (UA_ByteString_equal (signature, &mac)) {
-        return UA_STATUSCODE_GOOD;
-    }
-    else {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-}
-
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Sign (const UA_ByteString *     message,
-                           const UA_ByteString *     key,
-                           UA_ByteString *           signature
-                           ) {
-    if (HMAC (EVP_sha1(), key->data, (int) key->length, message->data,
-              message->length,
-              signature->data, (unsigned int *) &(signature->length)) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    return UA_STATUSCODE_GOOD;
-}
-
 UA_StatusCode
 UA_Openssl_RSA_PKCS1_V15_Decrypt (UA_ByteString *       data,
                                   EVP_PKEY * privateKey) {
@@ -1005,22 +936,6 @@ UA_Openssl_RSA_PKCS1_V15_Encrypt (UA_ByteString * data,
     return ret;
 }
 
-UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Decrypt (const UA_ByteString * iv,
-                                const UA_ByteString * key,
-                                UA_ByteString *       data  /* [in/out]*/
-                                ) {
-    return UA_OpenSSL_Decrypt (iv, key, EVP_aes_128_cbc (), data);
-}
-
-UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Encrypt (const UA_ByteString * iv,
-                                const UA_ByteString * key,
-                                UA_ByteString *       data  /* [in/out]*/
-                                ) {
-    return UA_OpenSSL_Encrypt (iv, key, EVP_aes_128_cbc (), data);
-}
-
 static UA_StatusCode
 UA_OpenSSL_X509_AddSubjectAttributes(const UA_String* subject, X509_NAME* name) {
     char *subj = (char *)UA_malloc(subject->length + 1);
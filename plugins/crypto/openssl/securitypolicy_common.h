@@ -18,6 +18,7 @@
 
 #include <openssl/x509.h>
 #include <openssl/evp.h>
+#include <openssl/hmac.h>
 
 #define UA_SHA1_LENGTH 20
 
@@ -132,25 +133,47 @@ UA_Openssl_ECDSA_SHA256_Verify (const UA_ByteString * message,
                                 X509 * publicKeyX509,
                                 const UA_ByteString * signature);
 
+/* Symmetric cipher and HMAC contexts for one direction of a SecureChannel. The
+ * keys are bound when they are set. Every message then only sets the IV and
+ * runs AES-CBC in place. */
+typedef struct {
+    EVP_CIPHER_CTX *cipherCtx;
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+    EVP_MAC_CTX *macCtx;
+#else
+    HMAC_CTX *macCtx;
+#endif
+    size_t macLength;
+} UA_OpenSSL_SymContext;
+
+void
+UA_OpenSSL_SymContext_clear(UA_OpenSSL_SymContext *ctx);
+
+UA_StatusCode
+UA_OpenSSL_SymContext_setSigningKey(UA_OpenSSL_SymContext *ctx, const EVP_MD *md,
+                                    const UA_ByteString *key);
+
+UA_StatusCode
+UA_OpenSSL_SymContext_setEncryptingKey(UA_OpenSSL_SymContext *ctx,
+                                       const EVP_CIPHER *cipherAlg,
+                                       UA_Boolean encrypt,
+                                       const UA_ByteString *key);
+
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Verify(const UA_ByteString *message,
-                              const UA_ByteString *key,
-                              const UA_ByteString *signature);
+UA_OpenSSL_SymContext_sign(UA_OpenSSL_SymContext *ctx, const UA_ByteString *message,
+                           UA_ByteString *signature);
 
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Sign(const UA_ByteString *message,
-                            const UA_ByteString *key,
-                            UA_ByteString *signature);
+UA_OpenSSL_SymContext_verify(UA_OpenSSL_SymContext *ctx, const UA_ByteString *message,
+                             const UA_ByteString *signature);
 
 UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Decrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
+UA_OpenSSL_SymContext_encrypt(UA_OpenSSL_SymContext *ctx, const UA_ByteString *iv,
+                              UA_ByteString *data  /* [in/out]*/);
 
 UA_StatusCode
-UA_OpenSSL_AES_256_CBC_Encrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
+UA_OpenSSL_SymContext_decrypt(UA_OpenSSL_SymContext *ctx, const UA_ByteString *iv,
+                              UA_ByteString *data  /* [in/out]*/);
 
 UA_StatusCode
 UA_OpenSSL_X509_compare(const UA_ByteString *cert, const X509 *b);
@@ -173,16 +196,6 @@ UA_Openssl_Random_Key_PSHA1_Derive(const UA_ByteString *secret,
                                    const UA_ByteString *seed,
                                    UA_ByteString *out);
 UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Verify(const UA_ByteString *message,
-                            const UA_ByteString *key,
-                            const UA_ByteString *signature);
-
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA1_Sign(const UA_ByteString *message,
-                          const UA_ByteString *key,
-                          UA_ByteString *signature);
-
-UA_StatusCode
 UA_Openssl_RSA_PKCS1_V15_Decrypt(UA_ByteString *data,
                                  EVP_PKEY *privateKey);
 
@@ -191,16 +204,6 @@ UA_Openssl_RSA_PKCS1_V15_Encrypt(UA_ByteString *data,
                                  size_t paddingSize,
                                  X509 *publicX509);
 
-UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Decrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
-
-UA_StatusCode
-UA_OpenSSL_AES_128_CBC_Encrypt(const UA_ByteString *iv,
-                               const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
-
 UA_StatusCode
 UA_OpenSSL_CreateSigningRequest(EVP_PKEY *localPrivateKey,
                                 EVP_PKEY **csrLocalPrivateKey,
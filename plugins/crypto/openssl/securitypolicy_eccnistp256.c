@@ -33,11 +33,9 @@ typedef struct {
 
 typedef struct _Channel_Context_EccNistP256 {
     EVP_PKEY *    localEphemeralKeyPair;
-    UA_ByteString localSymSigningKey;
-    UA_ByteString localSymEncryptingKey;
+    UA_OpenSSL_SymContext localSym;
     UA_ByteString localSymIv;
-    UA_ByteString remoteSymSigningKey;
-    UA_ByteString remoteSymEncryptingKey;
+    UA_OpenSSL_SymContext remoteSym;
     UA_ByteString remoteSymIv;
 
     Policy_Context_EccNistP256 *policyContext;
@@ -235,11 +233,9 @@ UA_ChannelModule_EccNistP256_Delete_Context(void *channelContext) {
             (Channel_Context_EccNistP256 *)channelContext;
         X509_free(cc->remoteCertificateX509);
         UA_ByteString_clear(&cc->remoteCertificate);
-        UA_ByteString_clear(&cc->localSymSigningKey);
-        UA_ByteString_clear(&cc->localSymEncryptingKey);
+        UA_OpenSSL_SymContext_clear(&cc->localSym);
         UA_ByteString_clear(&cc->localSymIv);
-        UA_ByteString_clear(&cc->remoteSymSigningKey);
-        UA_ByteString_clear(&cc->remoteSymEncryptingKey);
+        UA_OpenSSL_SymContext_clear(&cc->remoteSym);
         UA_ByteString_clear(&cc->remoteSymIv);
         EVP_PKEY_free(cc->localEphemeralKeyPair);
 
@@ -392,8 +388,7 @@ UA_ChannelModule_EccNistP256_setLocalSymSigningKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_EccNistP256 *cc =
         (Channel_Context_EccNistP256 *)channelContext;
-    UA_ByteString_clear(&cc->localSymSigningKey);
-    return UA_ByteString_copy(key, &cc->localSymSigningKey);
+    return UA_OpenSSL_SymContext_setSigningKey(&cc->localSym, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -403,8 +398,8 @@ UA_ChannelM_EccNistP256_setLocalSymEncryptingKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_EccNistP256 *cc =
         (Channel_Context_EccNistP256 *)channelContext;
-    UA_ByteString_clear(&cc->localSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->localSymEncryptingKey);
+    return UA_OpenSSL_SymContext_setEncryptingKey(&cc->localSym, EVP_aes_128_cbc(),
+                                                  true, key);
 }
 
 static UA_StatusCode
@@ -442,8 +437,7 @@ UA_ChannelM_EccNistP256_setRemoteSymSigningKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_EccNistP256 *cc =
         (Channel_Context_EccNistP256 *)channelContext;
-    UA_ByteString_clear(&cc->remoteSymSigningKey);
-    return UA_ByteString_copy(key, &cc->remoteSymSigningKey);
+    return UA_OpenSSL_SymContext_setSigningKey(&cc->remoteSym, EVP_sha256(), key);
 }
 
 static UA_StatusCode
@@ -453,8 +447,8 @@ UA_ChannelM_EccNistP256_setRemoteSymEncryptingKey(void *channelContext,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_EccNistP256 *cc =
         (Channel_Context_EccNistP256 *)channelContext;
-    UA_ByteString_clear(&cc->remoteSymEncryptingKey);
-    return UA_ByteString_copy(key, &cc->remoteSymEncryptingKey);
+    return UA_OpenSSL_SymContext_setEncryptingKey(&cc->remoteSym, EVP_aes_128_cbc(),
+                                                  false, key);
 }
 
 static UA_StatusCode
@@ -516,7 +510,7 @@ UA_SymSig_EccNistP256_verify(void *channelContext, const UA_ByteString *message,
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_EccNistP256 *cc =
         (Channel_Context_EccNistP256 *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature);
+    return UA_OpenSSL_SymContext_verify(&cc->remoteSym, message, signature);
 }
 
 static UA_StatusCode
@@ -528,7 +522,7 @@ UA_SymSig_EccNistP256_sign(void *channelContext, const UA_ByteString *message,
 
     Channel_Context_EccNistP256 *cc =
         (Channel_Context_EccNistP256 *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_SymContext_sign(&cc->localSym, message, signature);
 }
 
 static size_t
@@ -542,8 +536,7 @@ UA_SymEn_EccNistP256_decrypt(void *channelContext, UA_ByteString *data) {
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_EccNistP256 *cc =
         (Channel_Context_EccNistP256 *)channelContext;
-    return UA_OpenSSL_AES_128_CBC_Decrypt(&cc->remoteSymIv, &cc->remoteSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_SymContext_decrypt(&cc->remoteSym, &cc->remoteSymIv, data);
 }
 
 static UA_StatusCode
@@ -553,8 +546,7 @@ UA_SymEn_EccNistP256_encrypt(void *channelContext, UA_ByteString *data) {
 
     Channel_Context_EccNistP256 *cc =
         (Channel_Context_EccNistP256 *)channelContext;
-    return UA_OpenSSL_AES_128_CBC_Encrypt(&cc->localSymIv, &cc->localSymEncryptingKey,
-                                          data);
+    return UA_OpenSSL_SymContext_encrypt(&cc->localSym, &cc->localSymIv, data);
 }
 
 static UA_StatusCode
@@ -0,0 +1,95 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ua_certificategroup_cache.h"
+
+#ifdef UA_ENABLE_ENCRYPTION
+
+void
+UA_CertificateCache_init(UA_CertificateCache *cache, size_t maxEntries) {
+    memset(cache, 0, sizeof(UA_CertificateCache));
+    cache->maxEntries = maxEntries;
+}
+
+void
+UA_CertificateCache_flush(UA_CertificateCache *cache) {
+    for(size_t i = 0; i < cache->entriesSize; i++)
+        UA_ByteString_clear(&cache->entries[i].certificate);
+    UA_free(cache->entries);
+    cache->entries = NULL;
+    cache->entriesSize = 0;
+    cache->next = 0;
+}
+
+static void
+removeEntry(UA_CertificateCache *cache, size_t pos) {
+    UA_ByteString_clear(&cache->entries[pos].certificate);
+    cache->entriesSize--;
+    cache->entries[pos] = cache->entries[cache->entriesSize];
+    if(cache->next > cache->entriesSize)
+        cache->next = 0;
+}
+
+UA_Boolean
+UA_CertificateCache_lookup(UA_CertificateCache *cache,
+                           const UA_ByteString *certificate) {
+    if(cache->maxEntries == 0)
+        return false;
+    UA_UInt32 hash = UA_ByteString_hash(0, certificate->data, certificate->length);
+    for(size_t i = 0; i < cache->entriesSize; i++) {
+        UA_CertificateCacheEntry *e = &cache->entries[i];
+        if(e->hash != hash || !UA_ByteString_equal(&e->certificate, certificate))
+            continue;
+        if(UA_DateTime_now() >= e->validUntil) {
+            removeEntry(cache, i); /* Expired */
+            break;
+        }
+        cache->hits++;
+        return true;
+    }
+    cache->misses++;
+    return false;
+}
+
+void
+UA_CertificateCache_add(UA_CertificateCache *cache,
+                        const UA_ByteString *certificate,
+                        UA_DateTime validUntil) {
+    if(cache->maxEntries == 0)
+        return;
+
+    /* Allocate the entries array on first use */
+    if(!cache->entries) {
+        cache->entries = (UA_CertificateCacheEntry*)
+            UA_calloc(cache->maxEntries, sizeof(UA_CertificateCacheEntry));
+        if(!cache->entries)
+            return;
+    }
+
+    /* Append or replace the oldest entry */
+    size_t pos = cache->entriesSize;
+    if(pos == cache->maxEntries) {
+        pos = cache->next;
+        cache->next = (cache->next + 1) % cache->maxEntries;
+        removeEntry(cache, pos);
+        pos = cache->entriesSize;
+    }
+    UA_CertificateCacheEntry *e = &cache->entries[pos];
+    if(UA_ByteString_copy(certificate, &e->certificate) != UA_STATUSCODE_GOOD)
+        return;
+    e->hash = UA_ByteString_hash(0, certificate->data, certificate->length);
+    e->validUntil = validUntil;
+    cache->entriesSize++;
+}
+
+void
+UA_CertificateCache_getStatistics(const UA_CertificateCache *cache,
+                                  UA_CertificateGroupStatistics *stats) {
+    stats->cacheSize = cache->entriesSize;
+    stats->cacheHits = cache->hits;
+    stats->cacheMisses = cache->misses;
+}
+
+#endif /* UA_ENABLE_ENCRYPTION */
@@ -0,0 +1,64 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_CERTIFICATEGROUP_CACHE_H_
+#define UA_CERTIFICATEGROUP_CACHE_H_
+
+#include <open62541/plugin/certificategroup.h>
+
+#ifdef UA_ENABLE_ENCRYPTION
+
+_UA_BEGIN_DECLS
+
+/* Bounded cache of successfully verified certificates (or certificate chains)
+ * for the Memorystore backends. Entries are keyed by a hash of the DER bytes
+ * and compared byte-wise, so hash collisions cannot lead to false positives.
+ * An entry is dropped once the chain it was verified with expires. The owner
+ * flushes the cache whenever the trust list, issuer list or CRLs change.
+ * When the cache is full, the entries are replaced round-robin. */
+
+typedef struct {
+    UA_UInt32 hash;
+    UA_DateTime validUntil;
+    UA_ByteString certificate;
+} UA_CertificateCacheEntry;
+
+typedef struct {
+    UA_CertificateCacheEntry *entries;
+    size_t entriesSize;
+    size_t maxEntries; /* 0 disables the cache */
+    size_t next;       /* Next entry to replace when the cache is full */
+    UA_UInt64 hits;
+    UA_UInt64 misses;
+} UA_CertificateCache;
+
+void
+UA_CertificateCache_init(UA_CertificateCache *cache, size_t maxEntries);
+
+/* Removes all entries and frees the memory. The counters are kept. */
+void
+UA_CertificateCache_flush(UA_CertificateCache *cache);
+
+/* Returns true if the certificate was verified before and the result is still
+ * valid. Updates the hit/miss counters. */
+UA_Boolean
+UA_CertificateCache_lookup(UA_CertificateCache *cache,
+                           const UA_ByteString *certificate);
+
+/* Remember a successful verification until the given time */
+void
+UA_CertificateCache_add(UA_CertificateCache *cache,
+                        const UA_ByteString *certificate,
+                        UA_DateTime validUntil);
+
+void
+UA_CertificateCache_getStatistics(const UA_CertificateCache *cache,
+                                  UA_CertificateGroupStatistics *stats);
+
+_UA_END_DECLS
+
+#endif /* UA_ENABLE_ENCRYPTION */
+
+#endif /* UA_CERTIFICATEGROUP_CACHE_H_ */
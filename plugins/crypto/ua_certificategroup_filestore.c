@@ -20,6 +20,10 @@
 #ifdef __linux__
 #define EVENT_SIZE (sizeof(struct inotify_event))
 #define BUF_LEN (1024 * ( EVENT_SIZE + 16 ))
+/* Only changes to the folder content trigger a reload. Reading the trust store
+ * must not generate events, otherwise every verification reloads it. */
+#define INOTIFY_WATCH_MASK (IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | \
+                            IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB)
 #endif /* __linux__ */
 
 typedef struct {
@@ -262,10 +266,20 @@ reloadTrustStore(UA_CertificateGroup *certGroup) {
  #ifdef __linux__
     FileCertStore *context = (FileCertStore *)certGroup->context;
 
+    /* Drain all pending events so that a single change is reloaded once */
     char buffer[BUF_LEN];
-    const int length = read(context->inotifyFd, buffer, BUF_LEN );
-    if(length == -1 && errno != EAGAIN)
-        return UA_STATUSCODE_BADINTERNALERROR;
+    int length = 0;
+    while(true) {
+        const int res = (int)read(context->inotifyFd, buffer, BUF_LEN);
+        if(res == -1) {
+            if(errno != EAGAIN)
+                return UA_STATUSCODE_BADINTERNALERROR;
+            break;
+        }
+        if(res == 0)
+            break;
+        length += res;
+    }
 #else
     /* TODO: Implement a way to check for changes in the pki folder */
     const int length = 0;
@@ -465,7 +479,7 @@ FileCertStore_createInotifyEvent(UA_CertificateGroup *certGroup) {
     char folder[UA_PATH_MAX] = {0};
     mp_snprintf(folder, UA_PATH_MAX, "%.*s",
                 (int)context->rootFolder.length, (char*)context->rootFolder.data);
-    int wd = inotify_add_watch(context->inotifyFd, folder, IN_ALL_EVENTS);
+    int wd = inotify_add_watch(context->inotifyFd, folder, INOTIFY_WATCH_MASK);
     if(wd == -1) {
         close(context->inotifyFd);
         context->inotifyFd = -1;
@@ -474,7 +488,7 @@ FileCertStore_createInotifyEvent(UA_CertificateGroup *certGroup) {
 
     mp_snprintf(folder, UA_PATH_MAX, "%.*s",
                 (int)context->trustedCertFolder.length, (char*)context->trustedCertFolder.data);
-    wd = inotify_add_watch(context->inotifyFd, folder, IN_ALL_EVENTS);
+    wd = inotify_add_watch(context->inotifyFd, folder, INOTIFY_WATCH_MASK);
     if(wd == -1) {
         close(context->inotifyFd);
         context->inotifyFd = -1;
@@ -614,6 +628,17 @@ FileCertStore_verifyCertificate(UA_CertificateGroup *certGroup, const UA_ByteStr
     return retval;
 }
 
+static UA_StatusCode
+FileCertStore_getStatistics(UA_CertificateGroup *certGroup,
+                            UA_CertificateGroupStatistics *stats) {
+    /* Check parameter */
+    if(certGroup == NULL || stats == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    FileCertStore *context = (FileCertStore *)certGroup->context;
+    return context->store->getStatistics(context->store, stats);
+}
+
 static void
 FileCertStore_clear(UA_CertificateGroup *certGroup) {
     /* check parameter */
@@ -672,6 +697,7 @@ UA_CertificateGroup_Filestore(UA_CertificateGroup *certGroup,
     certGroup->getRejectedList = FileCertStore_getRejectedList;
     certGroup->getCertificateCrls = FileCertStore_getCertificateCrls;
     certGroup->verifyCertificate = FileCertStore_verifyCertificate;
+    certGroup->getStatistics = FileCertStore_getStatistics;
     certGroup->clear = FileCertStore_clear;
 
     /* Set PKI Store context data */
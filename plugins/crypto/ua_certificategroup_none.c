@@ -34,6 +34,7 @@ void UA_CertificateGroup_AcceptAll(UA_CertificateGroup *certGroup) {
     certGroup->removeFromTrustList = NULL;
     certGroup->getRejectedList = NULL;
     certGroup->getCertificateCrls = NULL;
+    certGroup->getStatistics = NULL;
 }
 
 #ifndef UA_ENABLE_ENCRYPTION
@@ -31,6 +31,11 @@ UA_CertificateGroup_AcceptAll(UA_CertificateGroup *certGroup);
  * 0:max-rejected-listsize [uint32]
  *    The maximum number of certificate files that can be stored in the rejected list.
  *    (default: 100).
+ *
+ * 0:verification-cache-size [uint32]
+ *    The maximum number of successfully verified certificates that are
+ *    remembered until the trust list changes or the certificate chain
+ *    expires. 0 disables the cache. (default: 64).
  */
 UA_EXPORT UA_StatusCode
 UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
@@ -57,6 +62,11 @@ UA_CertificateGroup_Memorystore(UA_CertificateGroup *certGroup,
  *    The maximum number of certificate files that can be stored in the rejected list.
  *    (default: 100).
  *
+ * 0:verification-cache-size [uint32]
+ *    The maximum number of successfully verified certificates that are
+ *    remembered until the trust list changes or the certificate chain
+ *    expires. 0 disables the cache. (default: 64).
+ *
  * **PKI folder structure**
  *
  * pki
@@ -27,6 +27,57 @@ UA_Nodestore_HashMap(UA_Nodestore *ns);
 UA_EXPORT UA_StatusCode
 UA_Nodestore_ZipTree(UA_Nodestore *ns);
 
+/* The SwissTable Nodestore is an open-addressing hash-map with power-of-two
+ * capacity. The lookup compares a 7-bit hash tag for a group of 16 slots at
+ * once (with SIMD instructions where available). Numeric NodeIds are stored
+ * inline in the slots. So most lookups do not touch the node memory before
+ * the node is returned. This is intended for large information models with
+ * millions of nodes. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_SwissTable(UA_Nodestore *ns);
+
+/* The Frozen Nodestore is a layer on top of another Nodestore. Namespaces that
+ * are no longer modified after the initialization (e.g. generated information
+ * models) can be frozen. Then the nodes of the namespace, including their
+ * references and strings, are packed into a single contiguous memory region.
+ * This saves the per-allocation overhead and places the nodes close to each
+ * other in memory. Frozen nodes are read-only. Editing, replacing or removing
+ * a frozen node first copies it back into the underlying Nodestore
+ * (copy-on-write). ReferenceTypeNodes are never frozen.
+ *
+ * The current content of ns becomes the underlying Nodestore. If ns is not
+ * initialized (context == NULL), the HashMap Nodestore is used. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_Frozen(UA_Nodestore *ns);
+
+/* Freeze the nodes of a namespace. The nodestore has to be a Frozen Nodestore.
+ * Nodes added to the namespace later on are not frozen until this is called
+ * again. Must not run in parallel to other operations on the nodestore. For a
+ * server, call this before the server is started. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_Frozen_freeze(UA_Nodestore *ns, UA_UInt16 namespaceIndex);
+
+/* Write the nodes of all frozen namespaces (including the ReferenceTypes) into
+ * an image file. The namespace array is stored alongside. The image can only
+ * be loaded by the same build of the library on the same architecture.
+ * Node contexts, DataSources, method callbacks and lifecycle callbacks are not
+ * stored. Values of the DataSource variables are empty in the image. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_Frozen_writeImage(UA_Nodestore *ns, const char *path,
+                               const UA_String *namespaceUris,
+                               size_t namespaceUrisSize);
+
+/* Load an image into a new Frozen Nodestore (before it is used by a server).
+ * The nodes are mapped read-only from the file where possible and are not
+ * copied. The namespace array of the image is returned and has to be freed
+ * by the caller. When a server is created with a nodestore that already
+ * contains the namespace zero, the generation of the namespace zero is
+ * skipped. The callbacks of the namespace zero are attached as usual. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_Frozen_loadImage(UA_Nodestore *ns, const char *path,
+                              UA_String **namespaceUris,
+                              size_t *namespaceUrisSize);
+
 _UA_END_DECLS
 
 #endif /* UA_NODESTORE_DEFAULT_H_ */
@@ -543,6 +543,8 @@ PARSE_JSON(TcpConfigurationField) {
                 parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](ctx, &config->tcpMaxMsgSize, NULL);
             else if(strcmp(field_str, "tcpMaxChunks") == 0)
                 parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](ctx, &config->tcpMaxChunks, NULL);
+            else if(strcmp(field_str, "requestArenaSize") == 0)
+                parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](ctx, &config->requestArenaSize, NULL);
             else {
                 UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "Unknown field name.");
             }
@@ -971,6 +973,14 @@ parseJSONConfig(UA_ServerConfig *config, UA_ByteString json_config) {
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_DOUBLE](&ctx, &config->asyncOperationTimeout, NULL);
                 else if(strcmp(field, "maxAsyncOperationQueueSize") == 0)
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT64](&ctx, &config->maxAsyncOperationQueueSize, NULL);
+                else if(strcmp(field, "serviceWorkers") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_BOOLEAN](&ctx, &config->serviceWorkers, NULL);
+                else if(strcmp(field, "maxServiceWorkerQueueSize") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT64](&ctx, &config->maxServiceWorkerQueueSize, NULL);
+                else if(strcmp(field, "handshakeWorkers") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_BOOLEAN](&ctx, &config->handshakeWorkers, NULL);
+                else if(strcmp(field, "maxParallelHandshakes") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT64](&ctx, &config->maxParallelHandshakes, NULL);
 #endif
 
 #ifdef UA_ENABLE_DISCOVERY
@@ -0,0 +1,1774 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#include <open62541/util.h>
+#include <open62541/plugin/nodestore_default.h>
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef UA_ARCHITECTURE_POSIX
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+/* The Frozen Nodestore is a layer on top of a mutable "backend" Nodestore.
+ * Freezing a namespace moves all its nodes out of the backend and packs them
+ * into a single memory region. The NodeIds, strings, LocalizedText lists,
+ * reference targets (including the reference trees) and the values of
+ * VariableNodes are all placed in that region. The packed nodes are found via
+ * a read-only hash index that is rebuilt only when a namespace is frozen.
+ *
+ * Frozen nodes are never modified and never freed before the nodestore is
+ * cleared. So they need no reference counting. A frozen node that is edited,
+ * replaced or removed is "shadowed". That is, it is copied into the backend
+ * (copy-on-write) and all further lookups go to the backend. Pointers to the
+ * frozen version that were retrieved before remain valid.
+ *
+ * ReferenceTypeNodes are never frozen. The backend assigns the
+ * ReferenceTypeIndex upon insertion. Moving them back and forth between the
+ * backend and the frozen region would change the index. */
+
+/* The lowest two bits of a UA_NodePointer are a tag for the content. See the
+ * definition of UA_NodePointer. */
+#define FROZEN_NODEPOINTER_MASK 0x03
+#define FROZEN_NODEPOINTER_TAG_NODEID 0x01
+#define FROZEN_NODEPOINTER_TAG_EXPANDEDNODEID 0x02
+#define FROZEN_NODEPOINTER_TAG_NODE 0x03
+
+/* Alignment of all allocations in the packed region */
+#define FROZEN_ALIGN (2 * sizeof(void*))
+
+typedef struct {
+    const UA_Node *node;
+    UA_UInt32 hash;
+    UA_Boolean shadowed; /* Lookups go to the backend */
+} FrozenSlot;
+
+typedef struct {
+    UA_Byte *mem;
+    size_t size;
+    UA_Boolean mapped; /* Memory-mapped from an image file */
+} FrozenRegion;
+
+typedef struct {
+    UA_Nodestore backend;
+
+    /* Hash index for the frozen nodes (power-of-two size, linear probing) */
+    FrozenSlot *slots;
+    size_t slotsSize;
+    size_t count;
+
+    /* Packed memory regions. One for every call to freeze and for every
+     * loaded image. */
+    FrozenRegion *regions;
+    size_t regionsSize;
+
+    /* The namespaces that were frozen */
+    UA_UInt16 *namespaces;
+    size_t namespacesSize;
+
+    /* Values that could not be packed into a region (e.g. values with a
+     * DataType not known to the nodestore) are kept as heap copies */
+    UA_DataValue **heapValues;
+    size_t heapValuesSize;
+} FrozenContext;
+
+/**************/
+/* Hash Index */
+/**************/
+
+static FrozenSlot *
+findFrozenSlot(const FrozenContext *ns, const UA_NodeId *nodeId) {
+    if(ns->slotsSize == 0)
+        return NULL;
+    UA_UInt32 h = UA_NodeId_hash(nodeId);
+    size_t mask = ns->slotsSize - 1;
+    for(size_t idx = h & mask; ns->slots[idx].node; idx = (idx + 1) & mask) {
+        FrozenSlot *slot = &ns->slots[idx];
+        if(slot->hash == h && UA_NodeId_equal(&slot->node->head.nodeId, nodeId))
+            return slot;
+    }
+    return NULL;
+}
+
+/* Returns the frozen node if it is not shadowed */
+static const UA_Node *
+findFrozenNode(const FrozenContext *ns, const UA_NodeId *nodeId) {
+    FrozenSlot *slot = findFrozenSlot(ns, nodeId);
+    if(!slot || slot->shadowed)
+        return NULL;
+    return slot->node;
+}
+
+static void
+insertFrozenSlot(FrozenSlot *slots, size_t slotsSize, const UA_Node *node) {
+    UA_UInt32 h = UA_NodeId_hash(&node->head.nodeId);
+    size_t mask = slotsSize - 1;
+    size_t idx = h & mask;
+    while(slots[idx].node)
+        idx = (idx + 1) & mask;
+    slots[idx].node = node;
+    slots[idx].hash = h;
+}
+
+/* Rebuild the index with the additional nodes. Shadowed slots are dropped. */
+static UA_StatusCode
+rebuildIndex(FrozenContext *ns, UA_Node **nodes, size_t nodesSize) {
+    size_t count = nodesSize;
+    for(size_t i = 0; i < ns->slotsSize; i++) {
+        if(ns->slots[i].node && !ns->slots[i].shadowed)
+            count++;
+    }
+
+    /* Keep the load factor below 50% */
+    size_t slotsSize = 64;
+    while(slotsSize < count * 2)
+        slotsSize <<= 1;
+    FrozenSlot *slots = (FrozenSlot*)UA_calloc(slotsSize, sizeof(FrozenSlot));
+    if(!slots)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    for(size_t i = 0; i < ns->slotsSize; i++) {
+        if(ns->slots[i].node && !ns->slots[i].shadowed)
+            insertFrozenSlot(slots, slotsSize, ns->slots[i].node);
+    }
+    for(size_t i = 0; i < nodesSize; i++)
+        insertFrozenSlot(slots, slotsSize, nodes[i]);
+
+    UA_free(ns->slots);
+    ns->slots = slots;
+    ns->slotsSize = slotsSize;
+    ns->count = count;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_Boolean
+isFrozenNamespace(const FrozenContext *ns, UA_UInt16 namespaceIndex) {
+    for(size_t i = 0; i < ns->namespacesSize; i++) {
+        if(ns->namespaces[i] == namespaceIndex)
+            return true;
+    }
+    return false;
+}
+
+static UA_StatusCode
+addFrozenNamespace(FrozenContext *ns, UA_UInt16 namespaceIndex) {
+    if(isFrozenNamespace(ns, namespaceIndex))
+        return UA_STATUSCODE_GOOD;
+    UA_UInt16 *namespaces = (UA_UInt16*)
+        UA_realloc(ns->namespaces, (ns->namespacesSize + 1) * sizeof(UA_UInt16));
+    if(!namespaces)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    ns->namespaces = namespaces;
+    ns->namespaces[ns->namespacesSize++] = namespaceIndex;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_Boolean
+isFrozenNode(const FrozenContext *ns, const UA_Node *node) {
+    for(size_t i = 0; i < ns->regionsSize; i++) {
+        const UA_Byte *mem = ns->regions[i].mem;
+        if((const UA_Byte*)node >= mem &&
+           (const UA_Byte*)node < mem + ns->regions[i].size)
+            return true;
+    }
+    return false;
+}
+
+/*****************/
+/* Packing Nodes */
+/*****************/
+
+/* Nodes are packed in two passes with the same functions. The first pass only
+ * measures the required size (pos == NULL). The second pass writes into the
+ * allocated region. In the first pass, the written content goes to scratch
+ * memory that is not used afterwards. */
+
+typedef struct {
+    UA_Byte *pos; /* NULL while measuring */
+    size_t size;  /* Bytes used so far */
+    UA_StatusCode res;
+
+    /* Whether the n-th DataValue is packed into the region. Decided during
+     * the measuring pass. */
+    UA_Boolean *valuePacked;
+    size_t valuesSize;
+    size_t valuesPos;
+
+    /* Allocations of the measuring pass that are freed afterwards */
+    void **scratch;
+    size_t scratchSize;
+
+    /* Packing for an image file. Pointers to callbacks and contexts are
+     * removed. All values must be packed into the region. */
+    UA_Boolean image;
+
+    FrozenContext *ns;
+} FrozenPacker;
+
+static void *
+packAlloc(FrozenPacker *p, size_t size) {
+    size = (size + FROZEN_ALIGN - 1) & ~(size_t)(FROZEN_ALIGN - 1);
+    p->size += size;
+    if(!p->pos)
+        return NULL;
+    void *mem = p->pos;
+    p->pos += size;
+    return mem;
+}
+
+/* Allocation callback for decoding into the packed region */
+static void *
+packCalloc(void *context, size_t nelem, size_t elsize) {
+    FrozenPacker *p = (FrozenPacker*)context;
+    if(elsize > 0 && nelem > SIZE_MAX / elsize)
+        return NULL;
+    return packAlloc(p, nelem * elsize); /* The region is zeroed */
+}
+
+/* Allocation callback for the measuring pass. Counts the packed size and
+ * allocates on the heap. */
+static void *
+measureCalloc(void *context, size_t nelem, size_t elsize) {
+    FrozenPacker *p = (FrozenPacker*)context;
+    if(elsize > 0 && nelem > SIZE_MAX / elsize)
+        return NULL;
+    void **scratch = (void**)
+        UA_realloc(p->scratch, (p->scratchSize + 1) * sizeof(void*));
+    if(!scratch)
+        return NULL;
+    p->scratch = scratch;
+    void *mem = UA_calloc(1, nelem * elsize + 1);
+    if(!mem)
+        return NULL;
+    p->scratch[p->scratchSize++] = mem;
+    packAlloc(p, nelem * elsize);
+    return mem;
+}
+
+static void
+freeScratch(FrozenPacker *p) {
+    for(size_t i = 0; i < p->scratchSize; i++)
+        UA_free(p->scratch[i]);
+    UA_free(p->scratch);
+    p->scratch = NULL;
+    p->scratchSize = 0;
+}
+
+static void
+packString(FrozenPacker *p, UA_String *dst, const UA_String *src) {
+    *dst = *src;
+    if(src->length == 0) {
+        /* Keep NULL or use the empty-array sentinel */
+        if(src->data)
+            dst->data = (UA_Byte*)UA_EMPTY_ARRAY_SENTINEL;
+        return;
+    }
+    dst->data = (UA_Byte*)packAlloc(p, src->length);
+    if(dst->data)
+        memcpy(dst->data, src->data, src->length);
+}
+
+static void
+packNodeId(FrozenPacker *p, UA_NodeId *dst, const UA_NodeId *src) {
+    *dst = *src;
+    if(src->identifierType == UA_NODEIDTYPE_STRING ||
+       src->identifierType == UA_NODEIDTYPE_BYTESTRING)
+        packString(p, &dst->identifier.string, &src->identifier.string);
+}
+
+static void
+packExpandedNodeId(FrozenPacker *p, UA_ExpandedNodeId *dst,
+                   const UA_ExpandedNodeId *src) {
+    packNodeId(p, &dst->nodeId, &src->nodeId);
+    packString(p, &dst->namespaceUri, &src->namespaceUri);
+    dst->serverIndex = src->serverIndex;
+}
+
+static void
+packLocalizedText(FrozenPacker *p, UA_LocalizedText *dst,
+                  const UA_LocalizedText *src) {
+    packString(p, &dst->locale, &src->locale);
+    packString(p, &dst->text, &src->text);
+}
+
+static UA_LocalizedTextListEntry *
+packLocalizedTextList(FrozenPacker *p, const UA_LocalizedTextListEntry *src) {
+    UA_LocalizedTextListEntry *first = NULL, *last = NULL, scratch;
+    for(; src; src = src->next) {
+        UA_LocalizedTextListEntry *lt = (UA_LocalizedTextListEntry*)
+            packAlloc(p, sizeof(UA_LocalizedTextListEntry));
+        UA_LocalizedTextListEntry *dst = (lt) ? lt : &scratch;
+        packLocalizedText(p, &dst->localizedText, &src->localizedText);
+        dst->next = NULL;
+        if(last)
+            last->next = lt;
+        else
+            first = lt;
+        last = lt;
+    }
+    return first;
+}
+
+static void
+packNodePointer(FrozenPacker *p, UA_NodePointer *dst, UA_NodePointer src) {
+    uintptr_t tag = src.immediate & FROZEN_NODEPOINTER_MASK;
+    uintptr_t ptr = src.immediate & ~(uintptr_t)FROZEN_NODEPOINTER_MASK;
+    if(tag == FROZEN_NODEPOINTER_TAG_NODEID) {
+        UA_NodeId scratch;
+        UA_NodeId *id = (UA_NodeId*)packAlloc(p, sizeof(UA_NodeId));
+        packNodeId(p, (id) ? id : &scratch, (const UA_NodeId*)ptr);
+        dst->immediate = (uintptr_t)id | FROZEN_NODEPOINTER_TAG_NODEID;
+    } else if(tag == FROZEN_NODEPOINTER_TAG_EXPANDEDNODEID) {
+        UA_ExpandedNodeId scratch;
+        UA_ExpandedNodeId *id = (UA_ExpandedNodeId*)
+            packAlloc(p, sizeof(UA_ExpandedNodeId));
+        packExpandedNodeId(p, (id) ? id : &scratch,
+                           (const UA_ExpandedNodeId*)ptr);
+        dst->immediate = (uintptr_t)id | FROZEN_NODEPOINTER_TAG_EXPANDEDNODEID;
+    } else if(tag == FROZEN_NODEPOINTER_TAG_NODE) {
+        /* The node might not remain at that address. Store the NodeId. */
+        UA_NodeId scratch;
+        UA_NodeId *id = (UA_NodeId*)packAlloc(p, sizeof(UA_NodeId));
+        packNodeId(p, (id) ? id : &scratch, &((const UA_NodeHead*)ptr)->nodeId);
+        dst->immediate = (uintptr_t)id | FROZEN_NODEPOINTER_TAG_NODEID;
+    } else {
+        *dst = src; /* Immediate NodeId */
+    }
+}
+
+typedef struct {
+    UA_ReferenceTargetTreeElem *orig;
+    size_t index;
+} FrozenTreeMapEntry;
+
+static int
+compareTreeMapEntry(const void *a, const void *b) {
+    uintptr_t pa = (uintptr_t)((const FrozenTreeMapEntry*)a)->orig;
+    uintptr_t pb = (uintptr_t)((const FrozenTreeMapEntry*)b)->orig;
+    return (pa < pb) ? -1 : (pa > pb);
+}
+
+static UA_ReferenceTargetTreeElem *
+remapTreeElem(const FrozenTreeMapEntry *map, size_t mapSize,
+              UA_ReferenceTargetTreeElem *elems,
+              UA_ReferenceTargetTreeElem *orig) {
+    if(!orig)
+        return NULL;
+    FrozenTreeMapEntry key = {orig, 0};
+    const FrozenTreeMapEntry *e = (const FrozenTreeMapEntry*)
+        bsearch(&key, map, mapSize, sizeof(FrozenTreeMapEntry), compareTreeMapEntry);
+    UA_assert(e != NULL);
+    return &elems[e->index];
+}
+
+typedef struct {
+    FrozenPacker *p;
+    FrozenTreeMapEntry *map; /* NULL while measuring */
+    UA_ReferenceTargetTreeElem *elems;
+    size_t pos;
+} FrozenTreeCtx;
+
+static void *
+packTreeTarget(void *context, UA_ReferenceTarget *t) {
+    FrozenTreeCtx *tc = (FrozenTreeCtx*)context;
+    UA_ReferenceTargetTreeElem *orig = (UA_ReferenceTargetTreeElem*)t;
+    UA_ReferenceTargetTreeElem scratch;
+    UA_ReferenceTargetTreeElem *dst = (tc->map) ? &tc->elems[tc->pos] : &scratch;
+    *dst = *orig;
+    packNodePointer(tc->p, &dst->target.targetId, orig->target.targetId);
+    if(tc->map) {
+        tc->map[tc->pos].orig = orig;
+        tc->map[tc->pos].index = tc->pos;
+    }
+    tc->pos++;
+    return NULL;
+}
+
+/* The tree elements are packed into an array in iteration order. Then the
+ * child pointers are translated to the packed elements. */
+static void
+packReferenceTree(FrozenPacker *p, UA_NodeReferenceKind *dst,
+                  const UA_NodeReferenceKind *src) {
+    UA_NodeReferenceKind *rk = (UA_NodeReferenceKind*)(uintptr_t)src;
+    FrozenTreeCtx tc;
+    memset(&tc, 0, sizeof(FrozenTreeCtx));
+    tc.p = p;
+    tc.elems = (UA_ReferenceTargetTreeElem*)
+        packAlloc(p, src->targetsSize * sizeof(UA_ReferenceTargetTreeElem));
+    if(tc.elems) {
+        tc.map = (FrozenTreeMapEntry*)
+            UA_malloc(src->targetsSize * sizeof(FrozenTreeMapEntry));
+        if(!tc.map) {
+            p->res = UA_STATUSCODE_BADOUTOFMEMORY;
+            return;
+        }
+    }
+    UA_NodeReferenceKind_iterate(rk, packTreeTarget, &tc);
+    UA_assert(tc.pos == src->targetsSize);
+    if(!tc.map)
+        return;
+
+    /* Translate the tree pointers */
+    qsort(tc.map, tc.pos, sizeof(FrozenTreeMapEntry), compareTreeMapEntry);
+    for(size_t i = 0; i < tc.pos; i++) {
+        UA_ReferenceTargetTreeElem *e = &tc.elems[i];
+        e->idTreeEntry.left = remapTreeElem(tc.map, tc.pos, tc.elems, e->idTreeEntry.left);
+        e->idTreeEntry.right = remapTreeElem(tc.map, tc.pos, tc.elems, e->idTreeEntry.right);
+        e->nameTreeEntry.left = remapTreeElem(tc.map, tc.pos, tc.elems, e->nameTreeEntry.left);
+        e->nameTreeEntry.right = remapTreeElem(tc.map, tc.pos, tc.elems, e->nameTreeEntry.right);
+    }
+    dst->targets.tree.idRoot =
+        remapTreeElem(tc.map, tc.pos, tc.elems, src->targets.tree.idRoot);
+    dst->targets.tree.nameRoot =
+        remapTreeElem(tc.map, tc.pos, tc.elems, src->targets.tree.nameRoot);
+    UA_free(tc.map);
+}
+
+static void
+packReferenceKind(FrozenPacker *p, UA_NodeReferenceKind *dst,
+                  const UA_NodeReferenceKind *src) {
+    *dst = *src;
+    if(src->hasRefTree) {
+        packReferenceTree(p, dst, src);
+        return;
+    }
+    UA_ReferenceTarget scratch;
+    UA_ReferenceTarget *targets = (UA_ReferenceTarget*)
+        packAlloc(p, src->targetsSize * sizeof(UA_ReferenceTarget));
+    for(size_t i = 0; i < src->targetsSize; i++) {
+        UA_ReferenceTarget *t = (targets) ? &targets[i] : &scratch;
+        t->targetNameHash = src->targets.array[i].targetNameHash;
+        packNodePointer(p, &t->targetId, src->targets.array[i].targetId);
+    }
+    dst->targets.array = targets;
+}
+
+static void
+restoreValueType(UA_DataValue *decoded, const UA_DataValue *src) {
+    /* Enumerations and subtypes of builtin types (e.g. LocaleId) are decoded
+     * with the type of their binary encoding */
+    const UA_DataType *dt = decoded->value.type;
+    const UA_DataType *st = src->value.type;
+    if(!dt || !st || dt == st || dt->memSize != st->memSize)
+        return;
+    if(dt->typeKind == st->typeKind ||
+       (st->typeKind == UA_DATATYPEKIND_ENUM && dt->typeKind == UA_DATATYPEKIND_INT32))
+        decoded->value.type = st;
+}
+
+/* Values are deep-copied into the region by encoding them and decoding with
+ * the region as the allocator. This is used only if the decoded value is
+ * identical to the original. For example, values with a DataType unknown to
+ * the decoder would come back as an encoded ExtensionObject. Such values are
+ * kept as a heap copy. */
+static void
+packDataValue(FrozenPacker *p, UA_DataValue *dst, const UA_DataValue *src) {
+    UA_ByteString encoded = UA_BYTESTRING_NULL;
+    UA_StatusCode res = UA_encodeBinary(src, &UA_TYPES[UA_TYPES_DATAVALUE], &encoded, NULL);
+    UA_DecodeBinaryOptions opts;
+    memset(&opts, 0, sizeof(UA_DecodeBinaryOptions));
+    opts.callocContext = p;
+
+    if(!p->pos) {
+        /* Measure and decide whether the value can be packed */
+        UA_Boolean packed = false;
+        if(res == UA_STATUSCODE_GOOD) {
+            size_t before = p->size;
+            opts.calloc = measureCalloc;
+            UA_DataValue tmp;
+            res = UA_decodeBinary(&encoded, &tmp, &UA_TYPES[UA_TYPES_DATAVALUE], &opts);
+            restoreValueType(&tmp, src);
+            packed = (res == UA_STATUSCODE_GOOD && tmp.value.type == src->value.type &&
+                      UA_order(&tmp, src, &UA_TYPES[UA_TYPES_DATAVALUE]) == UA_ORDER_EQ);
+            freeScratch(p);
+            if(!packed)
+                p->size = before;
+        }
+        UA_Boolean *valuePacked = (UA_Boolean*)
+            UA_realloc(p->valuePacked, (p->valuesSize + 1) * sizeof(UA_Boolean));
+        if(!valuePacked) {
+            p->res = UA_STATUSCODE_BADOUTOFMEMORY;
+        } else {
+            p->valuePacked = valuePacked;
+            p->valuePacked[p->valuesSize++] = packed;
+        }
+        UA_ByteString_clear(&encoded);
+        return;
+    }
+
+    /* Pack into the region or keep a heap copy. Images cannot point to heap
+     * memory. */
+    UA_assert(p->valuesPos < p->valuesSize);
+    if(p->valuePacked[p->valuesPos++]) {
+        opts.calloc = packCalloc;
+        res |= UA_decodeBinary(&encoded, dst, &UA_TYPES[UA_TYPES_DATAVALUE], &opts);
+        restoreValueType(dst, src);
+    } else if(p->image) {
+        res = UA_STATUSCODE_BADNOTSUPPORTED;
+    } else {
+        FrozenContext *ns = p->ns;
+        UA_DataValue **heapValues = (UA_DataValue**)
+            UA_realloc(ns->heapValues, (ns->heapValuesSize + 1) * sizeof(UA_DataValue*));
+        if(heapValues) {
+            ns->heapValues = heapValues;
+            res = UA_DataValue_copy(src, dst);
+            if(res == UA_STATUSCODE_GOOD)
+                ns->heapValues[ns->heapValuesSize++] = dst;
+        } else {
+            res = UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+    }
+    if(res != UA_STATUSCODE_GOOD)
+        p->res = res;
+    UA_ByteString_clear(&encoded);
+}
+
+static size_t
+nodeSize(UA_NodeClass nodeClass) {
+    switch(nodeClass) {
+    case UA_NODECLASS_OBJECT: return sizeof(UA_ObjectNode);
+    case UA_NODECLASS_VARIABLE: return sizeof(UA_VariableNode);
+    case UA_NODECLASS_METHOD: return sizeof(UA_MethodNode);
+    case UA_NODECLASS_OBJECTTYPE: return sizeof(UA_ObjectTypeNode);
+    case UA_NODECLASS_VARIABLETYPE: return sizeof(UA_VariableTypeNode);
+    case UA_NODECLASS_REFERENCETYPE: return sizeof(UA_ReferenceTypeNode);
+    case UA_NODECLASS_DATATYPE: return sizeof(UA_DataTypeNode);
+    case UA_NODECLASS_VIEW: return sizeof(UA_ViewNode);
+    default: return 0;
+    }
+}
+
+static UA_Node *
+packNode(FrozenPacker *p, const UA_Node *src) {
+    size_t size = nodeSize(src->head.nodeClass);
+    UA_Node *node = (UA_Node*)packAlloc(p, size);
+    UA_Node scratch;
+    UA_Node *dst = (node) ? node : &scratch;
+
+    /* Shallow copy of the scalar attributes and callbacks */
+    memcpy(dst, src, size);
+
+    UA_NodeHead *head = &dst->head;
+    const UA_NodeHead *srcHead = &src->head;
+    packNodeId(p, &head->nodeId, &srcHead->nodeId);
+    packString(p, &head->browseName.name, &srcHead->browseName.name);
+    head->displayName = packLocalizedTextList(p, srcHead->displayName);
+    head->description = packLocalizedTextList(p, srcHead->description);
+
+    UA_NodeReferenceKind scratchRk;
+    UA_NodeReferenceKind *refs = (UA_NodeReferenceKind*)
+        packAlloc(p, srcHead->referencesSize * sizeof(UA_NodeReferenceKind));
+    for(size_t i = 0; i < srcHead->referencesSize; i++)
+        packReferenceKind(p, (refs) ? &refs[i] : &scratchRk, &srcHead->references[i]);
+    head->references = refs;
+
+    /* The process that loads an image has to set the callbacks and contexts
+     * again */
+    if(p->image) {
+        head->context = NULL;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        head->monitoredItems = NULL;
+#endif
+    }
+
+    switch(srcHead->nodeClass) {
+    case UA_NODECLASS_VARIABLE:
+    case UA_NODECLASS_VARIABLETYPE: {
+        /* The VariableTypeNode has the same layout for the common part */
+        UA_VariableNode *dv = &dst->variableNode;
+        const UA_VariableNode *sv = &src->variableNode;
+        packNodeId(p, &dv->dataType, &sv->dataType);
+        dv->arrayDimensions = (sv->arrayDimensions) ?
+            (UA_UInt32*)UA_EMPTY_ARRAY_SENTINEL : NULL;
+        if(sv->arrayDimensionsSize > 0) {
+            dv->arrayDimensions = (UA_UInt32*)
+                packAlloc(p, sv->arrayDimensionsSize * sizeof(UA_UInt32));
+            if(dv->arrayDimensions)
+                memcpy(dv->arrayDimensions, sv->arrayDimensions,
+                       sv->arrayDimensionsSize * sizeof(UA_UInt32));
+        }
+        if(p->image) {
+            /* DataSources become (empty) values */
+            memset(&dv->valueBackend, 0, sizeof(UA_ValueBackend));
+            memset(&dv->value, 0, sizeof(dv->value));
+            dv->valueSource = UA_VALUESOURCE_DATA;
+        }
+        if(sv->valueSource == UA_VALUESOURCE_DATA)
+            packDataValue(p, &dv->value.data.value, &sv->value.data.value);
+        if(p->image && dst->head.nodeClass == UA_NODECLASS_VARIABLETYPE)
+            memset(&dst->variableTypeNode.lifecycle, 0, sizeof(UA_NodeTypeLifecycle));
+        break;
+    }
+    case UA_NODECLASS_REFERENCETYPE:
+        packLocalizedText(p, &dst->referenceTypeNode.inverseName,
+                          &src->referenceTypeNode.inverseName);
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        if(p->image)
+            memset(&dst->objectTypeNode.lifecycle, 0, sizeof(UA_NodeTypeLifecycle));
+        break;
+    case UA_NODECLASS_METHOD:
+        if(p->image) {
+            dst->methodNode.method = NULL;
+#if UA_MULTITHREADING >= 100
+            dst->methodNode.async = false;
+#endif
+        }
+        break;
+    default:
+        break;
+    }
+    return node;
+}
+
+/***********************/
+/* Interface functions */
+/***********************/
+
+static UA_Node *
+frozenNsNewNode(void *nsCtx, UA_NodeClass nodeClass) {
+    FrozenContext *ns = (FrozenContext*)nsCtx;
+    return ns->backend.newNode(ns->backend.context, nodeClass);
+}
+
+static void
+frozenNsDeleteNode(void *nsCtx, UA_Node *node) {
+    FrozenContext *ns = (FrozenContext*)nsCtx;
+    UA_assert(!isFrozenNode(ns, node));
+    ns->backend.deleteNode(ns->backend.context, node);
+}
+
+static const UA_Node *
+frozenNsGetNode(void *nsCtx, const UA_NodeId *nodeId,
+                UA_UInt32 attributeMask,
+                UA_ReferenceTypeSet references,
+                UA_BrowseDirection referenceDirections) {
+    FrozenContext *ns = (FrozenContext*)nsCtx;
+    const UA_Node *node = findFrozenNode(ns, nodeId);
+    if(node)
+        return node;
+    return ns->backend.getNode(ns->backend.context, nodeId, attributeMask,
+                               references, referenceDirections);
+}
+
+static const UA_Node *
+frozenNsGetNodeFromPtr(void *nsCtx, UA_NodePointer ptr,
+                       UA_UInt32 attributeMask,
+                       UA_ReferenceTypeSet references,
+                       UA_BrowseDirection referenceDirections) {
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+    return frozenNsGetNode(nsCtx, &id, attributeMask,
+                           references, referenceDirections);
+}
+
+/* Copy the frozen node into the backend. Afterwards the lookups for the NodeId
+ * go to the backend. */
+static UA_StatusCode
+shadowNode(FrozenContext *ns, FrozenSlot *slot) {
+    UA_Node *copy = ns->backend.newNode(ns->backend.context,
+                                        slot->node->head.nodeClass);
+    if(!copy)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = UA_Node_copy(slot->node, copy);
+    if(res != UA_STATUSCODE_GOOD) {
+        ns->backend.deleteNode(ns->backend.context, copy);
+        return res;
+    }
+    res = ns->backend.insertNode(ns->backend.context, copy, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    slot->shadowed = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_Node *
+frozenNsGetEditNode(void *nsCtx, const UA_NodeId *nodeId,
+                    UA_UInt32 attributeMask,
+                    UA_ReferenceTypeSet references,
+                    UA_BrowseDirection referenceDirections) {
+    FrozenContext *ns = (FrozenContext*)nsCtx;
+    FrozenSlot *slot = findFrozenSlot(ns, nodeId);
+    if(slot && !slot->shadowed && shadowNode(ns, slot) != UA_STATUSCODE_GOOD)
+        return NULL;
+    return ns->backend.getEditNode(ns->backend.context, nodeId, attributeMask,
+                                   references, referenceDirections);
+}
+
+static UA_Node *
+frozenNsGetEditNodeFromPtr(void *nsCtx, UA_NodePointer ptr,
+                           UA_UInt32 attributeMask,
+                           UA_ReferenceTypeSet references,
+                           UA_BrowseDirection referenceDirections) {
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+    return frozenNsGetEditNode(nsCtx, &id, attributeMask,
+                               references, referenceDirections);
+}
+
+static void
+frozenNsReleaseNode(void *nsCtx, const UA_Node *node) {
+    if(!node)
+        return;
+    FrozenContext *ns = (FrozenContext*)nsCtx;
+    if(isFrozenNode(ns, node))
+        return; /* Frozen nodes are not reference-counted */
+    ns->backend.releaseNode(ns->backend.context, node);
+}
+
+static UA_StatusCode
+frozenNsGetNodeCopy(void *nsCtx, const UA_NodeId *nodeId,
+                    UA_Node **outNode) {
+    /* The copy is later used for replaceNode in the backend */
+    FrozenContext *ns = (FrozenContext*)nsCtx;
+    FrozenSlot *slot = findFrozenSlot(ns, nodeId);
+    if(slot && !slot->shadowed) {
+        UA_StatusCode res = shadowNode(ns, slot);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return ns->backend.getNodeCopy(ns->backend.context, nodeId, outNode);
+}
+
+static UA_StatusCode
+frozenNsRemoveNode(void *nsCtx, const UA_NodeId *nodeId) {
+    FrozenContext *ns = (FrozenContext*)nsCtx;
+    FrozenSlot *slot = findFrozenSlot(ns, nodeId);
+    if(slot && !slot->shadowed) {
+        slot->shadowed = true; /* Nothing in the backend */
+        return UA_STATUSCODE_GOOD;
+    }
+    return ns->backend.removeNode(ns->backend.context, nodeId);
+}
+
+static UA_Boolean
+inBackend(FrozenContext *ns, const UA_NodeId *nodeId) {
+    const UA_Node *node =
+        ns->backend.getNode(ns->backend.context, nodeId, 0,
+                            UA_REFERENCETYPESET_NONE, UA_BROWSEDIRECTION_INVALID);
+    if(!node)
+        return false;
+    ns->backend.releaseNode(ns->backend.context, node);
+    return true;
+}
+
+/* If this function fails in any way, the node parameter is deleted here, so
+ * the caller function does not need to take care of it anymore */
+static UA_StatusCode
+frozenNsInsertNode(void *nsCtx, UA_Node *node, UA_NodeId *addedNodeId) {
+    FrozenContext *ns = (FrozenContext*)nsCtx;
+    UA_NodeId *id = &node->head.nodeId;
+    if(id->identifierType == UA_NODEIDTYPE_NUMERIC && id->identifier.numeric == 0) {
+        /* Create a random nodeid that is not frozen. The backend checks for
+         * duplicates on its side. */
+        do {
+            UA_UInt32 numId = UA_UInt32_random();
+#if SIZE_MAX <= UA_UINT32_MAX
+            /* The compressed "immediate" representation of nodes does not
+             * support the full range on 32bit systems. Generate smaller
+             * identifiers as they can be stored more compactly. */
+            if(numId >= (0x01 << 24))
+                numId = numId % (0x01 << 24);
+#endif
+            id->identifier.numeric = numId;
+        } while(id->identifier.numeric == 0 || findFrozenNode(ns, id) ||
+                inBackend(ns, id));
+    } else if(findFrozenNode(ns, id)) {
+        ns->backend.deleteNode(ns->backend.context, node);
+        return UA_STATUSCODE_BADNODEIDEXISTS;
+    }
+    return ns->backend.insertNode(ns->backend.context, node, addedNodeId);
+}
+
+static UA_StatusCode
+frozenNsReplaceNode(void *nsCtx, UA_Node *node) {
+    FrozenContext *ns = (FrozenContext*)nsCtx;
+    return ns->backend.replaceNode(ns->backend.context, node);
+}
+
+static const UA_NodeId *
+frozenNsGetReferenceTypeId(void *nsCtx, UA_Byte refTypeIndex) {
+    FrozenContext *ns = (FrozenContext*)nsCtx;
+    return ns->backend.getReferenceTypeId(ns->backend.context, refTypeIndex);
+}
+
+static void
+frozenNsIterate(void *nsCtx, UA_NodestoreVisitor visitor,
+                void *visitorCtx) {
+    FrozenContext *ns = (FrozenContext*)nsCtx;
+    /* The visitor can remove nodes. This only sets the shadowed flag. */
+    for(size_t i = 0; i < ns->slotsSize; i++) {
+        if(ns->slots[i].node && !ns->slots[i].shadowed)
+            visitor(visitorCtx, ns->slots[i].node);
+    }
+    ns->backend.iterate(ns->backend.context, visitor, visitorCtx);
+}
+
+/***********************/
+/* Nodestore Lifecycle */
+/***********************/
+
+static void
+frozenNsClear(void *nsCtx) {
+    if(!nsCtx)
+        return;
+    FrozenContext *ns = (FrozenContext*)nsCtx;
+    for(size_t i = 0; i < ns->heapValuesSize; i++)
+        UA_DataValue_clear(ns->heapValues[i]);
+    UA_free(ns->heapValues);
+    for(size_t i = 0; i < ns->regionsSize; i++) {
+#ifdef UA_ARCHITECTURE_POSIX
+        if(ns->regions[i].mapped) {
+            munmap(ns->regions[i].mem, ns->regions[i].size);
+            continue;
+        }
+#endif
+        UA_free(ns->regions[i].mem);
+    }
+    UA_free(ns->regions);
+    UA_free(ns->namespaces);
+    UA_free(ns->slots);
+    ns->backend.clear(ns->backend.context);
+    UA_free(ns);
+}
+
+UA_StatusCode
+UA_Nodestore_Frozen(UA_Nodestore *ns) {
+    FrozenContext *ctx = (FrozenContext*)UA_calloc(1, sizeof(FrozenContext));
+    if(!ctx)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Take over the existing nodestore as the backend */
+    if(ns->context) {
+        ctx->backend = *ns;
+    } else {
+        UA_StatusCode res = UA_Nodestore_HashMap(&ctx->backend);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(ctx);
+            return res;
+        }
+    }
+
+    /* Populate the nodestore */
+    ns->context = (void*)ctx;
+    ns->clear = frozenNsClear;
+    ns->newNode = frozenNsNewNode;
+    ns->deleteNode = frozenNsDeleteNode;
+    ns->getNode = frozenNsGetNode;
+    ns->getNodeFromPtr = frozenNsGetNodeFromPtr;
+    ns->getEditNode = frozenNsGetEditNode;
+    ns->getEditNodeFromPtr = frozenNsGetEditNodeFromPtr;
+    ns->releaseNode = frozenNsReleaseNode;
+    ns->getNodeCopy = frozenNsGetNodeCopy;
+    ns->insertNode = frozenNsInsertNode;
+    ns->replaceNode = frozenNsReplaceNode;
+    ns->removeNode = frozenNsRemoveNode;
+    ns->getReferenceTypeId = frozenNsGetReferenceTypeId;
+    ns->iterate = frozenNsIterate;
+    return UA_STATUSCODE_GOOD;
+}
+
+/**********/
+/* Freeze */
+/**********/
+
+typedef struct {
+    UA_UInt16 namespaceIndex;
+    UA_NodeId *ids;
+    size_t idsSize;
+    UA_StatusCode res;
+} FrozenCollect;
+
+static void
+collectNodeIds(void *visitorCtx, const UA_Node *node) {
+    FrozenCollect *fc = (FrozenCollect*)visitorCtx;
+    if(fc->res != UA_STATUSCODE_GOOD ||
+       node->head.nodeId.namespaceIndex != fc->namespaceIndex ||
+       node->head.nodeClass == UA_NODECLASS_REFERENCETYPE)
+        return;
+    UA_NodeId *ids = (UA_NodeId*)
+        UA_realloc(fc->ids, (fc->idsSize + 1) * sizeof(UA_NodeId));
+    if(!ids) {
+        fc->res = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    fc->ids = ids;
+    fc->res = UA_NodeId_copy(&node->head.nodeId, &fc->ids[fc->idsSize]);
+    if(fc->res == UA_STATUSCODE_GOOD)
+        fc->idsSize++;
+}
+
+static UA_StatusCode
+packNodes(FrozenPacker *p, UA_Nodestore *store,
+          const UA_NodeId *ids, size_t idsSize, UA_Node **nodes) {
+    for(size_t i = 0; i < idsSize && p->res == UA_STATUSCODE_GOOD; i++) {
+        const UA_Node *node =
+            store->getNode(store->context, &ids[i], UA_NODEATTRIBUTESMASK_ALL,
+                           UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+        if(!node)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        UA_Node *packed = packNode(p, node);
+        if(nodes)
+            nodes[i] = packed;
+        store->releaseNode(store->context, node);
+    }
+    return p->res;
+}
+
+UA_StatusCode
+UA_Nodestore_Frozen_freeze(UA_Nodestore *ns, UA_UInt16 namespaceIndex) {
+    if(ns->clear != frozenNsClear)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    FrozenContext *ctx = (FrozenContext*)ns->context;
+    UA_Nodestore *backend = &ctx->backend;
+    FrozenRegion region;
+    FrozenRegion *regions;
+    UA_Node **nodes = NULL;
+    FrozenPacker p;
+    memset(&p, 0, sizeof(FrozenPacker));
+    p.ns = ctx;
+
+    /* Collect the NodeIds of the namespace from the backend */
+    FrozenCollect fc;
+    memset(&fc, 0, sizeof(FrozenCollect));
+    fc.namespaceIndex = namespaceIndex;
+    backend->iterate(backend->context, collectNodeIds, &fc);
+    UA_StatusCode res = fc.res;
+    if(res == UA_STATUSCODE_GOOD)
+        res = addFrozenNamespace(ctx, namespaceIndex);
+    if(res != UA_STATUSCODE_GOOD || fc.idsSize == 0)
+        goto cleanup;
+
+    /* Measure the region size */
+    res = packNodes(&p, backend, fc.ids, fc.idsSize, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+
+    /* Allocate the region and the table of the packed nodes */
+    region.size = p.size;
+    region.mapped = false;
+    region.mem = (UA_Byte*)UA_calloc(1, region.size);
+    nodes = (UA_Node**)UA_calloc(fc.idsSize, sizeof(UA_Node*));
+    regions = (FrozenRegion*)
+        UA_realloc(ctx->regions, (ctx->regionsSize + 1) * sizeof(FrozenRegion));
+    if(regions)
+        ctx->regions = regions;
+    if(!region.mem || !nodes || !regions) {
+        UA_free(region.mem);
+        res = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto cleanup;
+    }
+
+    /* Pack the nodes. From here on the region is registered, as heap copies
+     * of values might point into it. */
+    ctx->regions[ctx->regionsSize++] = region;
+    p.pos = region.mem;
+    p.size = 0;
+    res = packNodes(&p, backend, fc.ids, fc.idsSize, nodes);
+    UA_assert(res != UA_STATUSCODE_GOOD || p.size == region.size);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup; /* The region is freed with the nodestore */
+
+    /* Add to the index and remove from the backend */
+    res = rebuildIndex(ctx, nodes, fc.idsSize);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+    for(size_t i = 0; i < fc.idsSize; i++)
+        backend->removeNode(backend->context, &fc.ids[i]);
+
+ cleanup:
+    UA_free(nodes);
+    UA_free(p.valuePacked);
+    UA_Array_delete(fc.ids, fc.idsSize, &UA_TYPES[UA_TYPES_NODEID]);
+    return res;
+}
+
+/**********/
+/* Images */
+/**********/
+
+/* An image file contains packed nodes together with a relocation table. The
+ * pointers in the packed region are stored as if the region was mapped at a
+ * preferred base address. If the image is mapped at that address, only the
+ * pointers to DataTypes (UA_TYPES has a different address in every process)
+ * and to the empty-array sentinel are patched. The other pages of the mapping
+ * are not written and remain shared with the page cache. Otherwise, the
+ * internal pointers are relocated as well.
+ *
+ * The image contains the in-memory layout of the nodes. So it can only be
+ * loaded by the same build of the library. This is checked with a fingerprint
+ * of the structure sizes and the library version. Callbacks and node contexts
+ * are not part of the image. DataSources become empty values. */
+
+#define FROZEN_IMAGE_MAGIC "UANSIMG"
+#define FROZEN_IMAGE_VERSION 1
+#define FROZEN_IMAGE_ALIGN 65536 /* Alignment of the region in the file */
+
+#if SIZE_MAX > UA_UINT32_MAX
+# define FROZEN_IMAGE_BASE ((UA_UInt64)0x200000000000)
+#else
+# define FROZEN_IMAGE_BASE ((UA_UInt64)0) /* No preferred address */
+#endif
+
+#define FROZEN_RELOC_INTERNAL 0 /* value is the offset in the region */
+#define FROZEN_RELOC_SENTINEL 1 /* UA_EMPTY_ARRAY_SENTINEL */
+#define FROZEN_RELOC_TYPE 2     /* value is the index in UA_TYPES */
+
+#define FROZEN_FINGERPRINT_SIZE 9
+
+typedef struct {
+    char magic[8];
+    UA_UInt32 version;
+    UA_UInt32 fingerprint[FROZEN_FINGERPRINT_SIZE];
+    UA_UInt64 preferredBase;
+    UA_UInt64 regionOffset;
+    UA_UInt64 regionSize;
+    UA_UInt64 nodesOffset; /* Array of FrozenImageNode */
+    UA_UInt64 nodesSize;
+    UA_UInt64 relocsOffset; /* Array of FrozenImageReloc */
+    UA_UInt64 relocsSize;
+    UA_UInt64 namespacesOffset; /* Binary-encoded Variant with the URIs */
+    UA_UInt64 namespacesLength;
+} FrozenImageHeader;
+
+typedef struct {
+    UA_UInt64 offset;
+    UA_UInt32 nodeClass;
+    UA_UInt32 reserved;
+} FrozenImageNode;
+
+typedef struct {
+    UA_UInt64 offset; /* Position of the pointer in the region */
+    UA_UInt64 value;
+    UA_UInt32 kind;
+    UA_UInt32 reserved;
+} FrozenImageReloc;
+
+static void
+imageFingerprint(UA_UInt32 *fp) {
+    fp[0] = 0x01020304; /* Endianness */
+    fp[1] = (UA_UInt32)sizeof(void*);
+    fp[2] = (UA_UInt32)sizeof(UA_NodeHead);
+    fp[3] = (UA_UInt32)sizeof(UA_Node);
+    fp[4] = (UA_UInt32)sizeof(UA_NodeReferenceKind);
+    fp[5] = (UA_UInt32)sizeof(UA_ReferenceTargetTreeElem);
+    fp[6] = (UA_UInt32)sizeof(UA_DataValue);
+    fp[7] = (UA_UInt32)UA_TYPES_COUNT;
+    fp[8] = (UA_UInt32)((UA_OPEN62541_VER_MAJOR << 16) |
+                        (UA_OPEN62541_VER_MINOR << 8) | UA_OPEN62541_VER_PATCH);
+}
+
+/* Relocation */
+
+typedef struct {
+    UA_Byte *region;
+    size_t regionSize;
+    FrozenImageReloc *relocs;
+    size_t relocsSize;
+    size_t relocsCapacity;
+    UA_StatusCode res;
+} FrozenRelocator;
+
+static void
+addReloc(FrozenRelocator *r, void *slot, UA_UInt32 kind, UA_UInt64 value) {
+    if(r->relocsSize == r->relocsCapacity) {
+        size_t capacity = (r->relocsCapacity == 0) ? 1024 : r->relocsCapacity * 2;
+        FrozenImageReloc *relocs = (FrozenImageReloc*)
+            UA_realloc(r->relocs, capacity * sizeof(FrozenImageReloc));
+        if(!relocs) {
+            r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+            return;
+        }
+        r->relocs = relocs;
+        r->relocsCapacity = capacity;
+    }
+    FrozenImageReloc *rel = &r->relocs[r->relocsSize++];
+    rel->offset = (UA_UInt64)((UA_Byte*)slot - r->region);
+    rel->value = value;
+    rel->kind = kind;
+    rel->reserved = 0;
+}
+
+/* Record the pointer and rewrite it relative to the preferred base. The lower
+ * bits can contain the tag of a UA_NodePointer. */
+static void
+relocPointer(FrozenRelocator *r, void *slot) {
+    uintptr_t v;
+    memcpy(&v, slot, sizeof(uintptr_t));
+    if(v == 0)
+        return;
+    if(v == (uintptr_t)UA_EMPTY_ARRAY_SENTINEL) {
+        addReloc(r, slot, FROZEN_RELOC_SENTINEL, 0);
+        v = 0;
+    } else {
+        uintptr_t untagged = v & ~(uintptr_t)FROZEN_NODEPOINTER_MASK;
+        if(untagged < (uintptr_t)r->region ||
+           untagged >= (uintptr_t)r->region + r->regionSize) {
+            r->res = UA_STATUSCODE_BADNOTSUPPORTED; /* Points outside */
+            return;
+        }
+        UA_UInt64 offset = (UA_UInt64)(v - (uintptr_t)r->region);
+        addReloc(r, slot, FROZEN_RELOC_INTERNAL, offset);
+        v = (uintptr_t)(FROZEN_IMAGE_BASE + offset);
+    }
+    memcpy(slot, &v, sizeof(uintptr_t));
+}
+
+static void
+relocTypePointer(FrozenRelocator *r, const UA_DataType **slot) {
+    uintptr_t type = (uintptr_t)*slot;
+    if(!type)
+        return;
+    if(type < (uintptr_t)UA_TYPES ||
+       type >= (uintptr_t)&UA_TYPES[UA_TYPES_COUNT]) {
+        r->res = UA_STATUSCODE_BADNOTSUPPORTED; /* Custom DataType */
+        return;
+    }
+    addReloc(r, (void*)slot, FROZEN_RELOC_TYPE,
+             (UA_UInt64)(*slot - UA_TYPES));
+    *slot = NULL;
+}
+
+static void
+relocType(FrozenRelocator *r, void *p, const UA_DataType *type);
+
+static void
+relocArray(FrozenRelocator *r, void *slot, size_t length,
+           const UA_DataType *type) {
+    uintptr_t array;
+    memcpy(&array, slot, sizeof(uintptr_t));
+    relocPointer(r, slot);
+    if(array <= (uintptr_t)UA_EMPTY_ARRAY_SENTINEL || type->pointerFree)
+        return;
+    for(size_t i = 0; i < length; i++)
+        relocType(r, (void*)(array + i * type->memSize), type);
+}
+
+static void
+relocStructure(FrozenRelocator *r, void *p, const UA_DataType *type) {
+    uintptr_t ptr = (uintptr_t)p;
+    for(size_t i = 0; i < type->membersSize; i++) {
+        const UA_DataTypeMember *m = &type->members[i];
+        const UA_DataType *mt = m->memberType;
+        ptr += m->padding;
+        if(m->isArray) {
+            size_t length = *(size_t*)ptr;
+            ptr += sizeof(size_t);
+            relocArray(r, (void*)ptr, length, mt);
+            ptr += sizeof(void*);
+        } else if(m->isOptional) {
+            relocArray(r, (void*)ptr, 1, mt);
+            ptr += sizeof(void*);
+        } else {
+            relocType(r, (void*)ptr, mt);
+            ptr += mt->memSize;
+        }
+    }
+}
+
+static void
+relocUnion(FrozenRelocator *r, void *p, const UA_DataType *type) {
+    UA_UInt32 selection = *(UA_UInt32*)p;
+    if(selection == 0 || selection > type->membersSize)
+        return;
+    const UA_DataTypeMember *m = &type->members[selection - 1];
+    uintptr_t ptr = (uintptr_t)p + m->padding;
+    if(m->isArray) {
+        size_t length = *(size_t*)ptr;
+        relocArray(r, (void*)(ptr + sizeof(size_t)), length, m->memberType);
+    } else {
+        relocType(r, (void*)ptr, m->memberType);
+    }
+}
+
+static void
+relocType(FrozenRelocator *r, void *p, const UA_DataType *type) {
+    switch(type->typeKind) {
+    case UA_DATATYPEKIND_STRING:
+    case UA_DATATYPEKIND_BYTESTRING:
+    case UA_DATATYPEKIND_XMLELEMENT:
+        relocPointer(r, &((UA_String*)p)->data);
+        break;
+    case UA_DATATYPEKIND_NODEID: {
+        UA_NodeId *id = (UA_NodeId*)p;
+        if(id->identifierType == UA_NODEIDTYPE_STRING ||
+           id->identifierType == UA_NODEIDTYPE_BYTESTRING)
+            relocPointer(r, &id->identifier.string.data);
+        break;
+    }
+    case UA_DATATYPEKIND_EXPANDEDNODEID: {
+        UA_ExpandedNodeId *id = (UA_ExpandedNodeId*)p;
+        relocType(r, &id->nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+        relocPointer(r, &id->namespaceUri.data);
+        break;
+    }
+    case UA_DATATYPEKIND_QUALIFIEDNAME:
+        relocPointer(r, &((UA_QualifiedName*)p)->name.data);
+        break;
+    case UA_DATATYPEKIND_LOCALIZEDTEXT:
+        relocPointer(r, &((UA_LocalizedText*)p)->locale.data);
+        relocPointer(r, &((UA_LocalizedText*)p)->text.data);
+        break;
+    case UA_DATATYPEKIND_EXTENSIONOBJECT: {
+        UA_ExtensionObject *eo = (UA_ExtensionObject*)p;
+        if(eo->encoding >= UA_EXTENSIONOBJECT_DECODED) {
+            const UA_DataType *contentType = eo->content.decoded.type;
+            relocTypePointer(r, &eo->content.decoded.type);
+            if(contentType)
+                relocArray(r, &eo->content.decoded.data, 1, contentType);
+        } else {
+            relocType(r, &eo->content.encoded.typeId, &UA_TYPES[UA_TYPES_NODEID]);
+            relocPointer(r, &eo->content.encoded.body.data);
+        }
+        break;
+    }
+    case UA_DATATYPEKIND_DATAVALUE:
+        relocType(r, &((UA_DataValue*)p)->value, &UA_TYPES[UA_TYPES_VARIANT]);
+        break;
+    case UA_DATATYPEKIND_VARIANT: {
+        UA_Variant *v = (UA_Variant*)p;
+        const UA_DataType *contentType = v->type;
+        size_t length = (UA_Variant_isScalar(v)) ? 1 : v->arrayLength;
+        relocTypePointer(r, &v->type);
+        relocPointer(r, &v->arrayDimensions);
+        if(contentType)
+            relocArray(r, &v->data, length, contentType);
+        else
+            relocPointer(r, &v->data);
+        break;
+    }
+    case UA_DATATYPEKIND_DIAGNOSTICINFO: {
+        UA_DiagnosticInfo *di = (UA_DiagnosticInfo*)p;
+        relocPointer(r, &di->additionalInfo.data);
+        relocArray(r, &di->innerDiagnosticInfo, 1, type);
+        break;
+    }
+    case UA_DATATYPEKIND_STRUCTURE:
+    case UA_DATATYPEKIND_OPTSTRUCT:
+        relocStructure(r, p, type);
+        break;
+    case UA_DATATYPEKIND_UNION:
+        relocUnion(r, p, type);
+        break;
+    default:
+        break; /* No pointers */
+    }
+}
+
+static void
+relocNodePointer(FrozenRelocator *r, UA_NodePointer *np) {
+    uintptr_t tag = np->immediate & FROZEN_NODEPOINTER_MASK;
+    void *ptr = (void*)(np->immediate & ~(uintptr_t)FROZEN_NODEPOINTER_MASK);
+    if(tag == FROZEN_NODEPOINTER_TAG_NODEID) {
+        relocType(r, ptr, &UA_TYPES[UA_TYPES_NODEID]);
+    } else if(tag == FROZEN_NODEPOINTER_TAG_EXPANDEDNODEID) {
+        relocType(r, ptr, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    } else if(tag == FROZEN_NODEPOINTER_TAG_NODE) {
+        r->res = UA_STATUSCODE_BADNOTSUPPORTED; /* Replaced during packing */
+        return;
+    } else {
+        return; /* Immediate */
+    }
+    relocPointer(r, &np->immediate);
+}
+
+static void
+relocTreeElem(FrozenRelocator *r, UA_ReferenceTargetTreeElem *e) {
+    if(!e)
+        return;
+    UA_ReferenceTargetTreeElem *left = e->idTreeEntry.left;
+    UA_ReferenceTargetTreeElem *right = e->idTreeEntry.right;
+    relocNodePointer(r, &e->target.targetId);
+    relocPointer(r, &e->idTreeEntry.left);
+    relocPointer(r, &e->idTreeEntry.right);
+    relocPointer(r, &e->nameTreeEntry.left);
+    relocPointer(r, &e->nameTreeEntry.right);
+    relocTreeElem(r, left);
+    relocTreeElem(r, right);
+}
+
+static void
+relocNode(FrozenRelocator *r, UA_Node *node) {
+    UA_NodeHead *head = &node->head;
+    relocType(r, &head->nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+    relocType(r, &head->browseName, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+    UA_LocalizedTextListEntry **lists[2] = {&head->displayName, &head->description};
+    for(size_t i = 0; i < 2; i++) {
+        for(UA_LocalizedTextListEntry **slot = lists[i]; *slot;) {
+            UA_LocalizedTextListEntry *lt = *slot;
+            relocPointer(r, slot);
+            relocType(r, &lt->localizedText, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+            slot = &lt->next;
+        }
+    }
+
+    UA_NodeReferenceKind *refs = head->references;
+    relocPointer(r, &head->references);
+    for(size_t i = 0; i < head->referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &refs[i];
+        if(rk->hasRefTree) {
+            UA_ReferenceTargetTreeElem *root = rk->targets.tree.idRoot;
+            relocPointer(r, &rk->targets.tree.idRoot);
+            relocPointer(r, &rk->targets.tree.nameRoot);
+            relocTreeElem(r, root);
+        } else {
+            UA_ReferenceTarget *targets = rk->targets.array;
+            relocPointer(r, &rk->targets.array);
+            for(size_t j = 0; j < rk->targetsSize; j++)
+                relocNodePointer(r, &targets[j].targetId);
+        }
+    }
+
+    switch(head->nodeClass) {
+    case UA_NODECLASS_VARIABLE:
+    case UA_NODECLASS_VARIABLETYPE: {
+        UA_VariableNode *vn = &node->variableNode;
+        relocType(r, &vn->dataType, &UA_TYPES[UA_TYPES_NODEID]);
+        relocPointer(r, &vn->arrayDimensions);
+        relocType(r, &vn->value.data.value, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        break;
+    }
+    case UA_NODECLASS_REFERENCETYPE:
+        relocType(r, &node->referenceTypeNode.inverseName,
+                  &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Write Image */
+
+typedef struct {
+    const FrozenContext *ns;
+    UA_NodeId *ids;
+    size_t idsSize;
+    UA_StatusCode res;
+} FrozenImageCollect;
+
+static UA_StatusCode
+addImageNodeId(FrozenImageCollect *ic, const UA_NodeId *id) {
+    UA_NodeId *ids = (UA_NodeId*)
+        UA_realloc(ic->ids, (ic->idsSize + 1) * sizeof(UA_NodeId));
+    if(!ids)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    ic->ids = ids;
+    UA_StatusCode res = UA_NodeId_copy(id, &ic->ids[ic->idsSize]);
+    if(res == UA_STATUSCODE_GOOD)
+        ic->idsSize++;
+    return res;
+}
+
+static void
+collectImageNodeIds(void *visitorCtx, const UA_Node *node) {
+    FrozenImageCollect *ic = (FrozenImageCollect*)visitorCtx;
+    if(ic->res != UA_STATUSCODE_GOOD ||
+       node->head.nodeClass == UA_NODECLASS_REFERENCETYPE ||
+       !isFrozenNamespace(ic->ns, node->head.nodeId.namespaceIndex))
+        return;
+    ic->res = addImageNodeId(ic, &node->head.nodeId);
+}
+
+static UA_StatusCode
+writeImageFile(const char *path, FrozenImageHeader *header,
+               const FrozenImageNode *nodes, const FrozenRelocator *r,
+               const UA_ByteString *namespaces) {
+    FILE *f = fopen(path, "wb");
+    if(!f)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    UA_Byte zero[256];
+    memset(zero, 0, sizeof(zero));
+    size_t pos = sizeof(FrozenImageHeader);
+    size_t nodesLen = (size_t)header->nodesSize * sizeof(FrozenImageNode);
+    size_t relocsLen = r->relocsSize * sizeof(FrozenImageReloc);
+    UA_Boolean ok =
+        fwrite(header, sizeof(FrozenImageHeader), 1, f) == 1 &&
+        fwrite(nodes, 1, nodesLen, f) == nodesLen &&
+        fwrite(r->relocs, 1, relocsLen, f) == relocsLen &&
+        fwrite(namespaces->data, 1, namespaces->length, f) == namespaces->length;
+    pos += nodesLen + relocsLen + namespaces->length;
+    while(ok && pos < header->regionOffset) {
+        size_t len = (size_t)header->regionOffset - pos;
+        if(len > sizeof(zero))
+            len = sizeof(zero);
+        ok = fwrite(zero, 1, len, f) == len;
+        pos += len;
+    }
+    ok = ok && fwrite(r->region, 1, r->regionSize, f) == r->regionSize;
+    ok = (fclose(f) == 0) && ok;
+    return (ok) ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADINTERNALERROR;
+}
+
+UA_StatusCode
+UA_Nodestore_Frozen_writeImage(UA_Nodestore *ns, const char *path,
+                               const UA_String *namespaceUris,
+                               size_t namespaceUrisSize) {
+    if(ns->clear != frozenNsClear)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    FrozenContext *ctx = (FrozenContext*)ns->context;
+    FrozenImageCollect ic;
+    memset(&ic, 0, sizeof(FrozenImageCollect));
+    ic.ns = ctx;
+    FrozenPacker p;
+    memset(&p, 0, sizeof(FrozenPacker));
+    p.ns = ctx;
+    p.image = true;
+    FrozenRelocator r;
+    memset(&r, 0, sizeof(FrozenRelocator));
+    UA_Node **nodes = NULL;
+    FrozenImageNode *imageNodes = NULL;
+    UA_ByteString namespaces = UA_BYTESTRING_NULL;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+
+    /* The ReferenceTypes come first in the order of their index. When the
+     * image is loaded, they are inserted into the empty backend and get the
+     * same index again. */
+    UA_Boolean gap = false;
+    for(size_t i = 0; i < UA_REFERENCETYPESET_MAX; i++) {
+        const UA_NodeId *id = ns->getReferenceTypeId(ns->context, (UA_Byte)i);
+        if(!id)
+            break;
+        if(!isFrozenNamespace(ctx, id->namespaceIndex)) {
+            gap = true;
+            continue;
+        }
+        if(gap) {
+            res = UA_STATUSCODE_BADNOTSUPPORTED;
+            goto cleanup;
+        }
+        res = addImageNodeId(&ic, id);
+        if(res != UA_STATUSCODE_GOOD)
+            goto cleanup;
+    }
+
+    /* Collect the other nodes of the frozen namespaces */
+    ns->iterate(ns->context, collectImageNodeIds, &ic);
+    res = ic.res;
+    if(res != UA_STATUSCODE_GOOD || ic.idsSize == 0)
+        goto cleanup;
+
+    /* Measure and pack into a temporary region */
+    res = packNodes(&p, ns, ic.ids, ic.idsSize, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+    r.regionSize = p.size;
+    r.region = (UA_Byte*)UA_calloc(1, r.regionSize);
+    nodes = (UA_Node**)UA_calloc(ic.idsSize, sizeof(UA_Node*));
+    imageNodes = (FrozenImageNode*)UA_calloc(ic.idsSize, sizeof(FrozenImageNode));
+    if(!r.region || !nodes || !imageNodes) {
+        res = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto cleanup;
+    }
+    p.pos = r.region;
+    p.size = 0;
+    res = packNodes(&p, ns, ic.ids, ic.idsSize, nodes);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+
+    /* Relocate relative to the preferred base address */
+    for(size_t i = 0; i < ic.idsSize && r.res == UA_STATUSCODE_GOOD; i++) {
+        imageNodes[i].offset = (UA_UInt64)((UA_Byte*)nodes[i] - r.region);
+        imageNodes[i].nodeClass = (UA_UInt32)nodes[i]->head.nodeClass;
+        relocNode(&r, nodes[i]);
+    }
+    res = r.res;
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+
+    /* Encode the namespace array */
+    UA_Variant nsVariant;
+    UA_Variant_setArray(&nsVariant, (void*)(uintptr_t)namespaceUris,
+                        namespaceUrisSize, &UA_TYPES[UA_TYPES_STRING]);
+    res = UA_encodeBinary(&nsVariant, &UA_TYPES[UA_TYPES_VARIANT], &namespaces, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+
+    /* Write the file */
+    FrozenImageHeader header;
+    memset(&header, 0, sizeof(FrozenImageHeader));
+    memcpy(header.magic, FROZEN_IMAGE_MAGIC, sizeof(FROZEN_IMAGE_MAGIC));
+    header.version = FROZEN_IMAGE_VERSION;
+    imageFingerprint(header.fingerprint);
+    header.preferredBase = FROZEN_IMAGE_BASE;
+    header.nodesOffset = sizeof(FrozenImageHeader);
+    header.nodesSize = ic.idsSize;
+    header.relocsOffset = header.nodesOffset + ic.idsSize * sizeof(FrozenImageNode);
+    header.relocsSize = r.relocsSize;
+    header.namespacesOffset = header.relocsOffset + r.relocsSize * sizeof(FrozenImageReloc);
+    header.namespacesLength = namespaces.length;
+    header.regionOffset = header.namespacesOffset + namespaces.length;
+    header.regionOffset = (header.regionOffset + FROZEN_IMAGE_ALIGN - 1) &
+        ~(UA_UInt64)(FROZEN_IMAGE_ALIGN - 1);
+    header.regionSize = r.regionSize;
+    res = writeImageFile(path, &header, imageNodes, &r, &namespaces);
+
+ cleanup:
+    UA_ByteString_clear(&namespaces);
+    UA_free(imageNodes);
+    UA_free(nodes);
+    UA_free(r.region);
+    UA_free(r.relocs);
+    UA_free(p.valuePacked);
+    UA_Array_delete(ic.ids, ic.idsSize, &UA_TYPES[UA_TYPES_NODEID]);
+    return res;
+}
+
+/* Load Image */
+
+static UA_StatusCode
+readImageSection(FILE *f, UA_UInt64 offset, void *buf, size_t len) {
+    if(len == 0)
+        return UA_STATUSCODE_GOOD;
+    if(offset > (UA_UInt64)LONG_MAX || fseek(f, (long)offset, SEEK_SET) != 0 ||
+       fread(buf, 1, len, f) != len)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+mapImageRegion(const char *path, FILE *f, const FrozenImageHeader *header,
+               FrozenRegion *region) {
+    size_t size = (size_t)header->regionSize;
+#ifdef UA_ARCHITECTURE_POSIX
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    /* Try the preferred address first. Without MAP_FIXED_NOREPLACE the
+     * address is a hint that can be ignored. */
+    int flags = MAP_PRIVATE;
+# ifdef MAP_FIXED_NOREPLACE
+    if(header->preferredBase != 0)
+        flags |= MAP_FIXED_NOREPLACE;
+# endif
+    void *mem = mmap((void*)(uintptr_t)header->preferredBase, size,
+                     PROT_READ | PROT_WRITE, flags, fd, (off_t)header->regionOffset);
+    if(mem == MAP_FAILED && flags != MAP_PRIVATE)
+        mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                   fd, (off_t)header->regionOffset);
+    close(fd);
+    if(mem == MAP_FAILED)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    region->mem = (UA_Byte*)mem;
+    region->size = size;
+    region->mapped = true;
+    return UA_STATUSCODE_GOOD;
+#else
+    region->mem = (UA_Byte*)UA_malloc(size);
+    if(!region->mem)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    region->size = size;
+    region->mapped = false;
+    UA_StatusCode res = readImageSection(f, header->regionOffset, region->mem, size);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_free(region->mem);
+    return res;
+#endif
+}
+
+static UA_StatusCode
+relocateRegion(const FrozenImageHeader *header, const FrozenImageReloc *relocs,
+               FrozenRegion *region) {
+    uintptr_t base = (uintptr_t)region->mem;
+    for(size_t i = 0; i < header->relocsSize; i++) {
+        const FrozenImageReloc *rel = &relocs[i];
+        if(rel->offset > region->size - sizeof(uintptr_t))
+            return UA_STATUSCODE_BADDECODINGERROR;
+        uintptr_t v;
+        switch(rel->kind) {
+        case FROZEN_RELOC_INTERNAL:
+            if(rel->value >= region->size)
+                return UA_STATUSCODE_BADDECODINGERROR;
+            if(base == header->preferredBase)
+                continue; /* Don't touch the page */
+            v = base + (uintptr_t)rel->value;
+            break;
+        case FROZEN_RELOC_SENTINEL:
+            v = (uintptr_t)UA_EMPTY_ARRAY_SENTINEL;
+            break;
+        case FROZEN_RELOC_TYPE:
+            if(rel->value >= UA_TYPES_COUNT)
+                return UA_STATUSCODE_BADDECODINGERROR;
+            v = (uintptr_t)&UA_TYPES[rel->value];
+            break;
+        default:
+            return UA_STATUSCODE_BADDECODINGERROR;
+        }
+        memcpy(region->mem + rel->offset, &v, sizeof(uintptr_t));
+    }
+#ifdef UA_ARCHITECTURE_POSIX
+    mprotect(region->mem, region->size, PROT_READ);
+#endif
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Insert a copy of the ReferenceTypeNode into the backend. It has to get the
+ * same ReferenceTypeIndex as in the image. */
+static UA_StatusCode
+insertImageReferenceType(FrozenContext *ctx, const UA_Node *node) {
+    UA_Nodestore *backend = &ctx->backend;
+    UA_Node *copy = backend->newNode(backend->context, UA_NODECLASS_REFERENCETYPE);
+    if(!copy)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = UA_Node_copy(node, copy);
+    if(res != UA_STATUSCODE_GOOD) {
+        backend->deleteNode(backend->context, copy);
+        return res;
+    }
+    res = backend->insertNode(backend->context, copy, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_Byte index = node->referenceTypeNode.referenceTypeIndex;
+    const UA_NodeId *id = backend->getReferenceTypeId(backend->context, index);
+    if(!id || !UA_NodeId_equal(id, &node->head.nodeId))
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* The insertion resets the set of subtypes */
+    UA_Node *edit =
+        backend->getEditNode(backend->context, &node->head.nodeId,
+                             UA_NODEATTRIBUTESMASK_ALL, UA_REFERENCETYPESET_ALL,
+                             UA_BROWSEDIRECTION_BOTH);
+    if(!edit)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    edit->referenceTypeNode.subTypes = node->referenceTypeNode.subTypes;
+    backend->releaseNode(backend->context, edit);
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Nodestore_Frozen_loadImage(UA_Nodestore *ns, const char *path,
+                              UA_String **namespaceUris,
+                              size_t *namespaceUrisSize) {
+    if(ns->clear != frozenNsClear)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    FrozenContext *ctx = (FrozenContext*)ns->context;
+
+    /* The ReferenceTypeIndex has to be assigned from zero */
+    if(ctx->backend.getReferenceTypeId(ctx->backend.context, 0) != NULL)
+        return UA_STATUSCODE_BADINVALIDSTATE;
+
+    FILE *f = fopen(path, "rb");
+    if(!f)
+        return UA_STATUSCODE_BADNOTFOUND;
+    FrozenImageNode *imageNodes = NULL;
+    FrozenImageReloc *relocs = NULL;
+    UA_Node **nodes = NULL;
+    UA_ByteString namespaces = UA_BYTESTRING_NULL;
+    FrozenRegion *regions;
+    FrozenRegion region;
+    size_t nodesSize = 0;
+
+    /* Read and check the header */
+    FrozenImageHeader header;
+    UA_StatusCode res = readImageSection(f, 0, &header, sizeof(FrozenImageHeader));
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+    UA_UInt32 fingerprint[FROZEN_FINGERPRINT_SIZE];
+    imageFingerprint(fingerprint);
+    if(memcmp(header.magic, FROZEN_IMAGE_MAGIC, sizeof(FROZEN_IMAGE_MAGIC)) != 0 ||
+       header.version != FROZEN_IMAGE_VERSION ||
+       memcmp(header.fingerprint, fingerprint, sizeof(fingerprint)) != 0 ||
+       header.regionSize == 0 || header.regionSize > SIZE_MAX ||
+       header.nodesSize > SIZE_MAX / sizeof(FrozenImageNode) ||
+       header.relocsSize > SIZE_MAX / sizeof(FrozenImageReloc) ||
+       header.namespacesLength > SIZE_MAX) {
+        res = UA_STATUSCODE_BADDECODINGERROR;
+        goto cleanup;
+    }
+
+    /* Read the tables */
+    nodesSize = (size_t)header.nodesSize;
+    imageNodes = (FrozenImageNode*)UA_malloc(nodesSize * sizeof(FrozenImageNode) + 1);
+    relocs = (FrozenImageReloc*)
+        UA_malloc((size_t)header.relocsSize * sizeof(FrozenImageReloc) + 1);
+    nodes = (UA_Node**)UA_calloc(nodesSize + 1, sizeof(UA_Node*));
+    res = UA_ByteString_allocBuffer(&namespaces, (size_t)header.namespacesLength);
+    if(!imageNodes || !relocs || !nodes || res != UA_STATUSCODE_GOOD) {
+        res = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto cleanup;
+    }
+    res = readImageSection(f, header.nodesOffset, imageNodes,
+                           nodesSize * sizeof(FrozenImageNode));
+    res |= readImageSection(f, header.relocsOffset, relocs,
+                            (size_t)header.relocsSize * sizeof(FrozenImageReloc));
+    res |= readImageSection(f, header.namespacesOffset, namespaces.data,
+                            namespaces.length);
+    if(res != UA_STATUSCODE_GOOD) {
+        res = UA_STATUSCODE_BADDECODINGERROR;
+        goto cleanup;
+    }
+
+    /* Map and relocate the region. Registered right away, so that it is
+     * unmapped with the nodestore. */
+    regions = (FrozenRegion*)
+        UA_realloc(ctx->regions, (ctx->regionsSize + 1) * sizeof(FrozenRegion));
+    if(!regions) {
+        res = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto cleanup;
+    }
+    ctx->regions = regions;
+    res = mapImageRegion(path, f, &header, &region);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+    ctx->regions[ctx->regionsSize++] = region;
+    res = relocateRegion(&header, relocs, &region);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+
+    /* Insert the ReferenceTypes into the backend. Index the other nodes. */
+    size_t frozenSize = 0;
+    for(size_t i = 0; i < nodesSize; i++) {
+        /* The entire node of the given NodeClass is within the region */
+        size_t size = nodeSize((UA_NodeClass)imageNodes[i].nodeClass);
+        if(size == 0 || size > region.size ||
+           imageNodes[i].offset > region.size - size) {
+            res = UA_STATUSCODE_BADDECODINGERROR;
+            goto cleanup;
+        }
+        UA_Node *node = (UA_Node*)(region.mem + imageNodes[i].offset);
+        if((UA_UInt32)node->head.nodeClass != imageNodes[i].nodeClass) {
+            res = UA_STATUSCODE_BADDECODINGERROR;
+            goto cleanup;
+        }
+        res = addFrozenNamespace(ctx, node->head.nodeId.namespaceIndex);
+        if(node->head.nodeClass == UA_NODECLASS_REFERENCETYPE)
+            res |= insertImageReferenceType(ctx, node);
+        else
+            nodes[frozenSize++] = node;
+        if(res != UA_STATUSCODE_GOOD)
+            goto cleanup;
+    }
+    res = rebuildIndex(ctx, nodes, frozenSize);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+
+    /* Return the namespace array */
+    if(namespaceUris && namespaceUrisSize) {
+        UA_Variant nsVariant;
+        res = UA_decodeBinary(&namespaces, &nsVariant, &UA_TYPES[UA_TYPES_VARIANT], NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            goto cleanup;
+        if(nsVariant.type != &UA_TYPES[UA_TYPES_STRING]) {
+            UA_Variant_clear(&nsVariant);
+            res = UA_STATUSCODE_BADDECODINGERROR;
+            goto cleanup;
+        }
+        *namespaceUris = (UA_String*)nsVariant.data;
+        *namespaceUrisSize = nsVariant.arrayLength;
+    }
+
+ cleanup:
+    fclose(f);
+    UA_ByteString_clear(&namespaces);
+    UA_free(nodes);
+    UA_free(relocs);
+    UA_free(imageNodes);
+    return res;
+}
@@ -19,12 +19,24 @@
  *
  * - Tombstone or non-matching NodeId: continue searching
  * - Matching NodeId: Return the entry
- * - NULL: Abort the search */
+ * - NULL: Abort the search
+ *
+ * Lookups (getNode, releaseNode, iterate) take no lock and can run in parallel
+ * to each other and to a writer. Modifications of the hash-map (insert,
+ * replace, remove) must be serialized by the caller. Writers publish new
+ * entries and resized slot tables with an atomic pointer swap. Unlinked entries
+ * and slot tables are freed with epoch-based reclamation once no reader can
+ * still see them. In-situ edits via getEditNode are not visible atomically and
+ * require that no reader accesses the node in parallel (the server ensures this
+ * with its service lock). */
 
 typedef struct UA_NodeMapEntry {
     struct UA_NodeMapEntry *orig; /* the version this is a copy from (or NULL) */
-    UA_UInt16 refCount; /* How many consumers have a reference to the node? */
-    UA_Boolean deleted; /* Node was marked as deleted and can be deleted when refCount == 0 */
+    struct UA_NodeMapEntry *retiredNext; /* List of entries waiting for reclamation */
+    size_t refCount; /* How many consumers have a reference to the node? The
+                      * nodemap holds one reference while the entry is linked
+                      * or waits for reclamation. Changed atomically. */
+    UA_Boolean edited; /* The node was retrieved with getEditNode */
     UA_Node node;
 } UA_NodeMapEntry;
 
@@ -32,15 +44,29 @@ typedef struct UA_NodeMapEntry {
 #define UA_NODEMAP_TOMBSTONE ((UA_NodeMapEntry*)0x01)
 
 typedef struct {
-    UA_NodeMapEntry *entry;
+    UA_NodeMapEntry *entry; /* Changed atomically */
     UA_UInt32 nodeIdHash;
 } UA_NodeMapSlot;
 
-typedef struct {
+typedef struct UA_NodeMapTable {
+    struct UA_NodeMapTable *retiredNext;
     UA_NodeMapSlot *slots;
     UA_UInt32 size;
-    UA_UInt32 count;
     UA_UInt32 sizePrimeIndex;
+} UA_NodeMapTable;
+
+typedef struct {
+    UA_NodeMapTable *table; /* Swapped atomically when resizing */
+    UA_UInt32 count;
+
+    /* Epoch-based reclamation. Readers register in the counter of the current
+     * epoch (mod 2). Entries and tables unlinked in epoch E are freed when the
+     * readers of epoch E have left. The retire lists are only accessed by the
+     * (serialized) writers. */
+    size_t epoch;
+    size_t readers[2];
+    UA_NodeMapEntry *retiredEntries[2];
+    UA_NodeMapTable *retiredTables[2];
 
     /* Maps ReferenceTypeIndex to the NodeId of the ReferenceType */
     UA_NodeId referenceTypeIds[UA_REFERENCETYPESET_MAX];
@@ -80,16 +106,16 @@ higher_prime_index(UA_UInt32 n) {
 
 /* Returns an empty slot or null if the nodeid exists or if no empty slot is found. */
 static UA_NodeMapSlot *
-findFreeSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
+findFreeSlot(const UA_NodeMapTable *t, const UA_NodeId *nodeid) {
     UA_UInt32 h = UA_NodeId_hash(nodeid);
-    UA_UInt32 size = ns->size;
+    UA_UInt32 size = t->size;
     UA_UInt64 idx = mod(h, size); /* Use 64bit container to avoid overflow  */
     UA_UInt32 startIdx = (UA_UInt32)idx;
     UA_UInt32 hash2 = mod2(h, size);
 
     UA_NodeMapSlot *candidate = NULL;
     do {
-        UA_NodeMapSlot *slot = &ns->slots[(UA_UInt32)idx];
+        UA_NodeMapSlot *slot = &t->slots[(UA_UInt32)idx];
 
         if(slot->entry > UA_NODEMAP_TOMBSTONE) {
             /* A Node with the NodeId does already exist */
@@ -113,38 +139,148 @@ findFreeSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
     return candidate;
 }
 
-/* The occupancy of the table after the call will be about 50% */
+/***************************/
+/* Epoch-Based Reclamation */
+/***************************/
+
+static size_t
+atomicLoadSize(size_t *addr) {
+    return UA_atomic_addSize(addr, 0);
+}
+
+/* Returns the epoch in which the reader was registered */
+static size_t
+enterReader(UA_NodeMap *ns) {
+    while(true) {
+        size_t epoch = atomicLoadSize(&ns->epoch);
+        UA_atomic_addSize(&ns->readers[epoch & 1], 1);
+        /* The epoch was not advanced in the meantime */
+        if(atomicLoadSize(&ns->epoch) == epoch)
+            return epoch;
+        UA_atomic_subSize(&ns->readers[epoch & 1], 1);
+    }
+}
+
+static void
+leaveReader(UA_NodeMap *ns, size_t epoch) {
+    UA_atomic_subSize(&ns->readers[epoch & 1], 1);
+}
+
+static void deleteNodeMapEntry(UA_NodeMapEntry *entry);
+
+static void
+freeTable(UA_NodeMapTable *t) {
+    UA_free(t->slots);
+    UA_free(t);
+}
+
+/* Drop the reference of the nodemap. The entry is deleted if no consumer holds
+ * a reference anymore. Otherwise the last releaseNode deletes it. */
+static void
+unrefEntry(UA_NodeMapEntry *entry) {
+    if(UA_atomic_subSize(&entry->refCount, 1) == 0)
+        deleteNodeMapEntry(entry);
+}
+
+static void
+freeRetired(UA_NodeMap *ns, size_t idx) {
+    UA_NodeMapEntry *entry = ns->retiredEntries[idx];
+    ns->retiredEntries[idx] = NULL;
+    while(entry) {
+        UA_NodeMapEntry *next = entry->retiredNext;
+        unrefEntry(entry);
+        entry = next;
+    }
+    UA_NodeMapTable *t = ns->retiredTables[idx];
+    ns->retiredTables[idx] = NULL;
+    while(t) {
+        UA_NodeMapTable *next = t->retiredNext;
+        freeTable(t);
+        t = next;
+    }
+}
+
+/* Advance the epoch when all readers of the previous epoch have left. Then the
+ * elements retired in the previous epoch are no longer visible and can be
+ * freed. Advance up to two times to free the elements of the current epoch
+ * right away if there are no readers. */
+static void
+reclaim(UA_NodeMap *ns) {
+    for(size_t i = 0; i < 2; i++) {
+        size_t epoch = atomicLoadSize(&ns->epoch);
+        size_t prev = (epoch + 1) & 1;
+        if(atomicLoadSize(&ns->readers[prev]) > 0)
+            return;
+        freeRetired(ns, prev);
+        UA_atomic_addSize(&ns->epoch, 1);
+    }
+}
+
+static void
+retireEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    size_t idx = atomicLoadSize(&ns->epoch) & 1;
+    entry->retiredNext = ns->retiredEntries[idx];
+    ns->retiredEntries[idx] = entry;
+}
+
+static void
+retireTable(UA_NodeMap *ns, UA_NodeMapTable *t) {
+    size_t idx = atomicLoadSize(&ns->epoch) & 1;
+    t->retiredNext = ns->retiredTables[idx];
+    ns->retiredTables[idx] = t;
+}
+
+static UA_NodeMapTable *
+loadTable(UA_NodeMap *ns) {
+    return (UA_NodeMapTable*)UA_atomic_load((void**)&ns->table);
+}
+
+static UA_NodeMapTable *
+createTable(UA_UInt32 sizePrimeIndex) {
+    UA_NodeMapTable *t = (UA_NodeMapTable*)UA_calloc(1, sizeof(UA_NodeMapTable));
+    if(!t)
+        return NULL;
+    t->sizePrimeIndex = sizePrimeIndex;
+    t->size = primes[sizePrimeIndex];
+    t->slots = (UA_NodeMapSlot*)UA_calloc(t->size, sizeof(UA_NodeMapSlot));
+    if(!t->slots) {
+        UA_free(t);
+        return NULL;
+    }
+    return t;
+}
+
+/* The occupancy of the table after the call will be about 50%. The entries are
+ * moved to a new table that is published atomically. Readers can continue to
+ * use the old table until they leave. */
 static UA_StatusCode
 expand(UA_NodeMap *ns) {
-    UA_UInt32 osize = ns->size;
+    UA_NodeMapTable *ot = ns->table;
+    UA_UInt32 osize = ot->size;
     UA_UInt32 count = ns->count;
     /* Resize only when table after removal of unused elements is either too
        full or too empty */
     if(count * 2 < osize && (count * 8 > osize || osize <= UA_NODEMAP_MINSIZE))
         return UA_STATUSCODE_GOOD;
 
-    UA_NodeMapSlot *oslots = ns->slots;
-    UA_UInt32 nindex = higher_prime_index(count * 2);
-    UA_UInt32 nsize = primes[nindex];
-    UA_NodeMapSlot *nslots= (UA_NodeMapSlot*)UA_calloc(nsize, sizeof(UA_NodeMapSlot));
-    if(!nslots)
+    UA_NodeMapTable *nt = createTable(higher_prime_index(count * 2));
+    if(!nt)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
-    ns->slots = nslots;
-    ns->size = nsize;
-    ns->sizePrimeIndex = nindex;
-
     /* recompute the position of every entry and insert the pointer */
+    UA_NodeMapSlot *oslots = ot->slots;
     for(size_t i = 0, j = 0; i < osize && j < count; ++i) {
         if(oslots[i].entry <= UA_NODEMAP_TOMBSTONE)
             continue;
-        UA_NodeMapSlot *s = findFreeSlot(ns, &oslots[i].entry->node.head.nodeId);
+        UA_NodeMapSlot *s = findFreeSlot(nt, &oslots[i].entry->node.head.nodeId);
         UA_assert(s);
         *s = oslots[i];
         ++j;
     }
 
-    UA_free(oslots);
+    /* Publish the new table */
+    UA_atomic_xchg((void**)&ns->table, nt);
+    retireTable(ns, ot);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -192,14 +328,11 @@ deleteNodeMapEntry(UA_NodeMapEntry *entry) {
     UA_free(entry);
 }
 
+/* Switch to the tree-representation for nodes with many references. This
+ * modifies the node. So it is only done when the node is not yet visible in the
+ * nodemap or when it was edited and is no longer used. */
 static void
-cleanupNodeMapEntry(UA_NodeMapEntry *entry) {
-    if(entry->refCount > 0)
-        return;
-    if(entry->deleted) {
-        deleteNodeMapEntry(entry);
-        return;
-    }
+optimizeNodeMapEntry(UA_NodeMapEntry *entry) {
     for(size_t i = 0; i < entry->node.head.referencesSize; i++) {
         UA_NodeReferenceKind *rk = &entry->node.head.references[i];
         if(rk->targetsSize > 16 && !rk->hasRefTree)
@@ -207,22 +340,30 @@ cleanupNodeMapEntry(UA_NodeMapEntry *entry) {
     }
 }
 
+/* The entry of the slot is loaded atomically and returned in the out-argument.
+ * It might have been replaced in the slot already when it is used by a
+ * reader. */
 static UA_NodeMapSlot *
-findOccupiedSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
+findOccupiedSlot(const UA_NodeMapTable *t, const UA_NodeId *nodeid,
+                 UA_NodeMapEntry **outEntry) {
     UA_UInt32 h = UA_NodeId_hash(nodeid);
-    UA_UInt32 size = ns->size;
+    UA_UInt32 size = t->size;
     UA_UInt64 idx = mod(h, size); /* Use 64bit container to avoid overflow */
     UA_UInt32 hash2 = mod2(h, size);
     UA_UInt32 startIdx = (UA_UInt32)idx;
 
     do {
-        UA_NodeMapSlot *slot= &ns->slots[(UA_UInt32)idx];
-        if(slot->entry > UA_NODEMAP_TOMBSTONE) {
+        UA_NodeMapSlot *slot= &t->slots[(UA_UInt32)idx];
+        UA_NodeMapEntry *entry = (UA_NodeMapEntry*)
+            UA_atomic_load((void**)&slot->entry);
+        if(entry > UA_NODEMAP_TOMBSTONE) {
             if(slot->nodeIdHash == h &&
-               UA_NodeId_equal(&slot->entry->node.head.nodeId, nodeid))
+               UA_NodeId_equal(&entry->node.head.nodeId, nodeid)) {
+                *outEntry = entry;
                 return slot;
+            }
         } else {
-            if(slot->entry == NULL)
+            if(entry == NULL)
                 return NULL; /* No further entry possible */
         }
 
@@ -259,11 +400,13 @@ UA_NodeMap_getNode(void *context, const UA_NodeId *nodeid,
                    UA_ReferenceTypeSet references,
                    UA_BrowseDirection referenceDirections) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
-    if(!slot)
-        return NULL;
-    ++slot->entry->refCount;
-    return &slot->entry->node;
+    UA_NodeMapEntry *entry = NULL;
+    size_t epoch = enterReader(ns);
+    UA_NodeMapSlot *slot = findOccupiedSlot(loadTable(ns), nodeid, &entry);
+    if(slot)
+        UA_atomic_addSize(&entry->refCount, 1);
+    leaveReader(ns, epoch);
+    return (slot) ? &entry->node : NULL;
 }
 
 static const UA_Node *
@@ -277,6 +420,33 @@ UA_NodeMap_getNodeFromPtr(void *context, UA_NodePointer ptr,
     return UA_NodeMap_getNode(context, &id, attributeMask, references, referenceDirections);
 }
 
+static UA_Node *
+UA_NodeMap_getEditNode(void *context, const UA_NodeId *nodeid,
+                       UA_UInt32 attributeMask,
+                       UA_ReferenceTypeSet references,
+                       UA_BrowseDirection referenceDirections) {
+    UA_Node *node = (UA_Node*)(uintptr_t)
+        UA_NodeMap_getNode(context, nodeid, attributeMask,
+                           references, referenceDirections);
+    if(node) {
+        UA_NodeMapEntry *entry = container_of(node, UA_NodeMapEntry, node);
+        entry->edited = true;
+    }
+    return node;
+}
+
+static UA_Node *
+UA_NodeMap_getEditNodeFromPtr(void *context, UA_NodePointer ptr,
+                              UA_UInt32 attributeMask,
+                              UA_ReferenceTypeSet references,
+                              UA_BrowseDirection referenceDirections) {
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+    return UA_NodeMap_getEditNode(context, &id, attributeMask,
+                                  references, referenceDirections);
+}
+
 static void
 UA_NodeMap_releaseNode(void *context, const UA_Node *node) {
     if (!node)
@@ -284,21 +454,39 @@ UA_NodeMap_releaseNode(void *context, const UA_Node *node) {
     UA_NodeMapEntry *entry = container_of(node, UA_NodeMapEntry, node);
     UA_assert(&entry->node == node);
     UA_assert(entry->refCount > 0);
-    --entry->refCount;
-    cleanupNodeMapEntry(entry);
+
+    /* Edits are only made with exclusive access to the nodestore. Reset the
+     * flag right away. Concurrent readers only see edited == false. */
+    UA_Boolean edited = entry->edited;
+    if(edited)
+        entry->edited = false;
+
+    /* The last reference was released after the entry was unlinked */
+    size_t refCount = UA_atomic_subSize(&entry->refCount, 1);
+    if(refCount == 0) {
+        deleteNodeMapEntry(entry);
+        return;
+    }
+
+    /* Only the nodemap holds a reference to the edited node */
+    if(edited && refCount == 1)
+        optimizeNodeMapEntry(entry);
 }
 
 static UA_StatusCode
 UA_NodeMap_getNodeCopy(void *context, const UA_NodeId *nodeid,
                        UA_Node **outNode) {
-    UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
-    if(!slot)
+    const UA_Node *node =
+        UA_NodeMap_getNode(context, nodeid, UA_NODEATTRIBUTESMASK_ALL,
+                           UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    if(!node)
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
-    UA_NodeMapEntry *entry = slot->entry;
+    UA_NodeMapEntry *entry = container_of(node, UA_NodeMapEntry, node);
     UA_NodeMapEntry *newItem = createEntry(entry->node.head.nodeClass);
-    if(!newItem)
+    if(!newItem) {
+        UA_NodeMap_releaseNode(context, node);
         return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
     UA_StatusCode retval = UA_Node_copy(&entry->node, &newItem->node);
     if(retval == UA_STATUSCODE_GOOD) {
         newItem->orig = entry; /* Store the pointer to the original */
@@ -306,24 +494,26 @@ UA_NodeMap_getNodeCopy(void *context, const UA_NodeId *nodeid,
     } else {
         deleteNodeMapEntry(newItem);
     }
+    UA_NodeMap_releaseNode(context, node);
     return retval;
 }
 
 static UA_StatusCode
 UA_NodeMap_removeNode(void *context, const UA_NodeId *nodeid) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
+    UA_NodeMapEntry *entry = NULL;
+    UA_NodeMapSlot *slot = findOccupiedSlot(ns->table, nodeid, &entry);
     if(!slot)
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
 
-    UA_NodeMapEntry *entry = slot->entry;
-    slot->entry = UA_NODEMAP_TOMBSTONE;
-    entry->deleted = true;
-    cleanupNodeMapEntry(entry);
+    /* Unlink the entry. It is freed when no reader can see it anymore. */
+    UA_atomic_xchg((void**)&slot->entry, UA_NODEMAP_TOMBSTONE);
+    retireEntry(ns, entry);
     --ns->count;
     /* Downsize the hashmap if it is very empty */
-    if(ns->count * 8 < ns->size && ns->size > UA_NODEMAP_MINSIZE)
+    if(ns->count * 8 < ns->table->size && ns->table->size > UA_NODEMAP_MINSIZE)
         expand(ns); /* Can fail. Just continue with the bigger hashmap. */
+    reclaim(ns);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -335,7 +525,7 @@ static UA_StatusCode
 UA_NodeMap_insertNode(void *context, UA_Node *node,
                       UA_NodeId *addedNodeId) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    if(ns->size * 3 <= ns->count * 4) {
+    if(ns->table->size * 3 <= ns->count * 4) {
         if(expand(ns) != UA_STATUSCODE_GOOD){
             deleteNodeMapEntry(container_of(node, UA_NodeMapEntry, node));
             return UA_STATUSCODE_BADINTERNALERROR;
@@ -352,7 +542,7 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
          * val, we will reach the starting id again. E.g. adding a nodeset will
          * create children while there are still other nodes which need to be
          * created. Thus the node ids may collide. */
-        UA_UInt32 size = ns->size;
+        UA_UInt32 size = ns->table->size;
         UA_UInt64 identifier = mod(50000 + size+1, UA_UINT32_MAX); /* Use 64bit to
                                                                     * avoid overflow */
         UA_UInt32 increase = mod2(ns->count+1, size);
@@ -361,7 +551,7 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
 
         do {
             node->head.nodeId.identifier.numeric = (UA_UInt32)identifier;
-            slot = findFreeSlot(ns, &node->head.nodeId);
+            slot = findFreeSlot(ns->table, &node->head.nodeId);
             if(slot)
                 break;
             identifier += increase;
@@ -376,7 +566,7 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
 #endif
         } while((UA_UInt32)identifier != startId);
     } else {
-        slot = findFreeSlot(ns, &node->head.nodeId);
+        slot = findFreeSlot(ns->table, &node->head.nodeId);
     }
 
     if(!slot) {
@@ -415,10 +605,12 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
         ns->referenceTypeCounter++;
     }
 
-    /* Insert the node */
+    /* Insert the node. The nodemap holds a reference. */
     UA_NodeMapEntry *newEntry = container_of(node, UA_NodeMapEntry, node);
+    optimizeNodeMapEntry(newEntry);
+    newEntry->refCount = 1;
     slot->nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
-    slot->entry = newEntry;
+    UA_atomic_xchg((void**)&slot->entry, newEntry);
     ++ns->count;
     return retval;
 }
@@ -429,23 +621,26 @@ UA_NodeMap_replaceNode(void *context, UA_Node *node) {
     UA_NodeMapEntry *newEntry = container_of(node, UA_NodeMapEntry, node);
 
     /* Find the node */
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, &node->head.nodeId);
+    UA_NodeMapEntry *oldEntry = NULL;
+    UA_NodeMapSlot *slot = findOccupiedSlot(ns->table, &node->head.nodeId, &oldEntry);
     if(!slot) {
         deleteNodeMapEntry(newEntry);
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
     }
 
     /* The node was already updated since the copy was made? */
-    UA_NodeMapEntry *oldEntry = slot->entry;
     if(oldEntry != newEntry->orig) {
         deleteNodeMapEntry(newEntry);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
-    /* Replace the entry */
-    slot->entry = newEntry;
-    oldEntry->deleted = true;
-    cleanupNodeMapEntry(oldEntry);
+    /* Publish the new version. Readers see either the old or the new
+     * version. The old version is freed when no reader can see it anymore. */
+    optimizeNodeMapEntry(newEntry);
+    newEntry->refCount = 1;
+    UA_atomic_xchg((void**)&slot->entry, newEntry);
+    retireEntry(ns, oldEntry);
+    reclaim(ns);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -460,17 +655,22 @@ UA_NodeMap_getReferenceTypeId(void *nsCtx, UA_Byte refTypeIndex) {
 static void
 UA_NodeMap_iterate(void *context, UA_NodestoreVisitor visitor,
                    void *visitorContext) {
+    /* The table is kept alive until the reader leaves. Even if the visitor
+     * modifies the nodemap. */
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    for(UA_UInt32 i = 0; i < ns->size; ++i) {
-        UA_NodeMapSlot *slot = &ns->slots[i];
-        if(slot->entry > UA_NODEMAP_TOMBSTONE) {
+    size_t epoch = enterReader(ns);
+    UA_NodeMapTable *t = loadTable(ns);
+    for(UA_UInt32 i = 0; i < t->size; ++i) {
+        UA_NodeMapEntry *entry = (UA_NodeMapEntry*)
+            UA_atomic_load((void**)&t->slots[i].entry);
+        if(entry > UA_NODEMAP_TOMBSTONE) {
             /* The visitor can delete the node. So refcount here. */
-            slot->entry->refCount++;
-            visitor(visitorContext, &slot->entry->node);
-            slot->entry->refCount--;
-            cleanupNodeMapEntry(slot->entry);
+            UA_atomic_addSize(&entry->refCount, 1);
+            visitor(visitorContext, &entry->node);
+            UA_NodeMap_releaseNode(context, &entry->node);
         }
     }
+    leaveReader(ns, epoch);
 }
 
 static void
@@ -480,17 +680,21 @@ UA_NodeMap_delete(void *context) {
         return;
 
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_UInt32 size = ns->size;
-    UA_NodeMapSlot *slots = ns->slots;
+    UA_UInt32 size = ns->table->size;
+    UA_NodeMapSlot *slots = ns->table->slots;
     for(UA_UInt32 i = 0; i < size; ++i) {
         if(slots[i].entry > UA_NODEMAP_TOMBSTONE) {
             /* On debugging builds, check that all nodes were release */
-            UA_assert(slots[i].entry->refCount == 0);
+            UA_assert(slots[i].entry->refCount == 1);
             /* Delete the node */
             deleteNodeMapEntry(slots[i].entry);
         }
     }
-    UA_free(ns->slots);
+    freeTable(ns->table);
+
+    /* No more readers. Free the retired entries and tables. */
+    freeRetired(ns, 0);
+    freeRetired(ns, 1);
 
     /* Clean up the ReferenceTypes index array */
     for(size_t i = 0; i < ns->referenceTypeCounter; i++)
@@ -502,21 +706,15 @@ UA_NodeMap_delete(void *context) {
 UA_StatusCode
 UA_Nodestore_HashMap(UA_Nodestore *ns) {
     /* Allocate and initialize the nodemap */
-    UA_NodeMap *nodemap = (UA_NodeMap*)UA_malloc(sizeof(UA_NodeMap));
+    UA_NodeMap *nodemap = (UA_NodeMap*)UA_calloc(1, sizeof(UA_NodeMap));
     if(!nodemap)
         return UA_STATUSCODE_BADOUTOFMEMORY;
-    nodemap->sizePrimeIndex = higher_prime_index(UA_NODEMAP_MINSIZE);
-    nodemap->size = primes[nodemap->sizePrimeIndex];
-    nodemap->count = 0;
-    nodemap->slots = (UA_NodeMapSlot*)
-        UA_calloc(nodemap->size, sizeof(UA_NodeMapSlot));
-    if(!nodemap->slots) {
+    nodemap->table = createTable(higher_prime_index(UA_NODEMAP_MINSIZE));
+    if(!nodemap->table) {
         UA_free(nodemap);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    nodemap->referenceTypeCounter = 0;
-
     /* Populate the nodestore */
     ns->context = nodemap;
     ns->clear = UA_NodeMap_delete;
@@ -533,17 +731,10 @@ UA_Nodestore_HashMap(UA_Nodestore *ns) {
     ns->iterate = UA_NodeMap_iterate;
 
     /* All nodes are stored in RAM. Changes are made in-situ. GetEditNode is
-     * identical to GetNode -- but the Node pointer is non-const. */
-    ns->getEditNode =
-        (UA_Node * (*)(void *nsCtx, const UA_NodeId *nodeId,
-                       UA_UInt32 attributeMask,
-                       UA_ReferenceTypeSet references,
-                       UA_BrowseDirection referenceDirections))UA_NodeMap_getNode;
-    ns->getEditNodeFromPtr =
-        (UA_Node * (*)(void *nsCtx, UA_NodePointer ptr,
-                       UA_UInt32 attributeMask,
-                       UA_ReferenceTypeSet references,
-                       UA_BrowseDirection referenceDirections))UA_NodeMap_getNodeFromPtr;
+     * identical to GetNode -- but the Node pointer is non-const and the entry
+     * is marked as edited. */
+    ns->getEditNode = UA_NodeMap_getEditNode;
+    ns->getEditNodeFromPtr = UA_NodeMap_getEditNodeFromPtr;
 
     return UA_STATUSCODE_GOOD;
 }
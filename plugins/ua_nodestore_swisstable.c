@@ -0,0 +1,641 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#include <open62541/util.h>
+#include <open62541/plugin/nodestore_default.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define UA_SWISSTABLE_SSE2
+# include <emmintrin.h>
+#endif
+
+#ifndef container_of
+#define container_of(ptr, type, member) \
+    (type *)((uintptr_t)ptr - offsetof(type,member))
+#endif
+
+/* The SwissTable Nodestore is an open-addressing hash-map with power-of-two
+ * capacity. The slots are organized in groups of 16. Every slot has a control
+ * byte that is either EMPTY, DELETED or contains the lower 7 bits of the
+ * NodeId hash (H2). The upper bits of the hash (H1) select the first group to
+ * probe. A probe compares the H2 with all control bytes of a group at once
+ * (with SSE2 where available). Only for matching control bytes the slot is
+ * looked at. The slot stores the full hash and numeric NodeIds inline. So most
+ * lookups do not dereference the node entry before it is returned.
+ *
+ * Groups are probed with a triangular sequence that visits every group once.
+ * The search ends in a group that contains an EMPTY control byte. */
+
+typedef struct SwissEntry {
+    struct SwissEntry *orig; /* the version this is a copy from (or NULL) */
+    size_t refCount; /* How many consumers have a reference to the node? Changed
+                      * atomically, as readers can run in parallel threads. */
+    UA_Boolean deleted; /* Node was marked as deleted and can be deleted when refCount == 0 */
+    UA_Boolean edited; /* The node was retrieved with getEditNode */
+    UA_Node node;
+} SwissEntry;
+
+typedef struct {
+    SwissEntry *entry;
+    UA_UInt32 hash;
+    UA_UInt32 numeric; /* Inline identifier for numeric NodeIds */
+    UA_UInt16 nsIndex;
+    UA_Boolean isNumeric;
+} SwissSlot;
+
+#define SWISS_GROUPSIZE 16
+#define SWISS_MINCAPACITY 64
+#define SWISS_CTRL_EMPTY ((UA_Byte)0x80)
+#define SWISS_CTRL_DELETED ((UA_Byte)0xFE)
+
+typedef struct {
+    UA_Byte *ctrl; /* One control byte per slot */
+    SwissSlot *slots;
+    size_t capacity; /* Power of two and multiple of the group size */
+    size_t count;
+    size_t tombstones;
+    size_t iterating; /* Don't shrink while iterating. Changed atomically. */
+
+    /* Maps ReferenceTypeIndex to the NodeId of the ReferenceType */
+    UA_NodeId referenceTypeIds[UA_REFERENCETYPESET_MAX];
+    UA_Byte referenceTypeCounter;
+} SwissContext;
+
+/****************/
+/* Group Access */
+/****************/
+
+/* Bitmask with the group positions where the control byte equals b */
+static UA_UInt32
+matchByte(const UA_Byte *group, UA_Byte b) {
+#ifdef UA_SWISSTABLE_SSE2
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)(uintptr_t)group);
+    return (UA_UInt32)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)b)));
+#else
+    UA_UInt32 mask = 0;
+    for(UA_UInt32 i = 0; i < SWISS_GROUPSIZE; i++) {
+        if(group[i] == b)
+            mask |= (UA_UInt32)1 << i;
+    }
+    return mask;
+#endif
+}
+
+/* EMPTY and DELETED have the high bit set. Full slots don't. */
+static UA_UInt32
+matchEmptyOrDeleted(const UA_Byte *group) {
+#ifdef UA_SWISSTABLE_SSE2
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)(uintptr_t)group);
+    return (UA_UInt32)_mm_movemask_epi8(ctrl);
+#else
+    UA_UInt32 mask = 0;
+    for(UA_UInt32 i = 0; i < SWISS_GROUPSIZE; i++) {
+        if(group[i] & 0x80)
+            mask |= (UA_UInt32)1 << i;
+    }
+    return mask;
+#endif
+}
+
+static UA_UInt32
+lowestBit(UA_UInt32 mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (UA_UInt32)__builtin_ctz(mask);
+#else
+    UA_UInt32 i = 0;
+    while(!(mask & 0x01)) {
+        mask >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+static UA_Byte hashH2(UA_UInt32 h) { return (UA_Byte)(h & 0x7F); }
+static size_t hashH1(UA_UInt32 h) { return (size_t)(h >> 7); }
+
+static UA_Boolean
+slotMatches(const SwissSlot *slot, UA_UInt32 h, const UA_NodeId *nodeId) {
+    if(slot->hash != h)
+        return false;
+    if(nodeId->identifierType == UA_NODEIDTYPE_NUMERIC)
+        return (slot->isNumeric && slot->numeric == nodeId->identifier.numeric &&
+                slot->nsIndex == nodeId->namespaceIndex);
+    if(slot->isNumeric)
+        return false;
+    return UA_NodeId_equal(&slot->entry->node.head.nodeId, nodeId);
+}
+
+/* Returns the slot index or capacity if not found */
+static size_t
+findSlot(const SwissContext *ns, const UA_NodeId *nodeId, UA_UInt32 h) {
+    size_t groupMask = (ns->capacity / SWISS_GROUPSIZE) - 1;
+    size_t group = hashH1(h) & groupMask;
+    UA_Byte h2 = hashH2(h);
+    for(size_t i = 0; i <= groupMask; i++) {
+        const UA_Byte *ctrl = &ns->ctrl[group * SWISS_GROUPSIZE];
+        UA_UInt32 mask = matchByte(ctrl, h2);
+        while(mask) {
+            size_t idx = group * SWISS_GROUPSIZE + lowestBit(mask);
+            if(slotMatches(&ns->slots[idx], h, nodeId))
+                return idx;
+            mask &= mask - 1;
+        }
+        if(matchByte(ctrl, SWISS_CTRL_EMPTY))
+            return ns->capacity; /* No further entry possible */
+        group = (group + i + 1) & groupMask;
+    }
+    return ns->capacity;
+}
+
+/* Returns the first EMPTY or DELETED slot in the probe sequence. There is
+ * always one as the load factor is bounded. */
+static size_t
+findFreeSlot(const SwissContext *ns, UA_UInt32 h) {
+    size_t groupMask = (ns->capacity / SWISS_GROUPSIZE) - 1;
+    size_t group = hashH1(h) & groupMask;
+    for(size_t i = 0; ; i++) {
+        UA_UInt32 mask = matchEmptyOrDeleted(&ns->ctrl[group * SWISS_GROUPSIZE]);
+        if(mask)
+            return group * SWISS_GROUPSIZE + lowestBit(mask);
+        group = (group + i + 1) & groupMask;
+    }
+}
+
+static void
+setSlot(SwissContext *ns, size_t idx, SwissEntry *entry, UA_UInt32 h) {
+    const UA_NodeId *nodeId = &entry->node.head.nodeId;
+    SwissSlot *slot = &ns->slots[idx];
+    slot->entry = entry;
+    slot->hash = h;
+    slot->isNumeric = (nodeId->identifierType == UA_NODEIDTYPE_NUMERIC);
+    slot->numeric = (slot->isNumeric) ? nodeId->identifier.numeric : 0;
+    slot->nsIndex = nodeId->namespaceIndex;
+    if(ns->ctrl[idx] == SWISS_CTRL_DELETED)
+        ns->tombstones--;
+    ns->ctrl[idx] = hashH2(h);
+}
+
+/* Rehash all entries into a table with the new capacity */
+static UA_StatusCode
+resize(SwissContext *ns, size_t capacity) {
+    UA_Byte *nctrl = (UA_Byte*)UA_malloc(capacity);
+    SwissSlot *nslots = (SwissSlot*)UA_malloc(capacity * sizeof(SwissSlot));
+    if(!nctrl || !nslots) {
+        UA_free(nctrl);
+        UA_free(nslots);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    memset(nctrl, SWISS_CTRL_EMPTY, capacity);
+
+    UA_Byte *octrl = ns->ctrl;
+    SwissSlot *oslots = ns->slots;
+    size_t ocapacity = ns->capacity;
+    ns->ctrl = nctrl;
+    ns->slots = nslots;
+    ns->capacity = capacity;
+    ns->tombstones = 0;
+    for(size_t i = 0; i < ocapacity; i++) {
+        if(octrl[i] & 0x80)
+            continue;
+        size_t idx = findFreeSlot(ns, oslots[i].hash);
+        ns->slots[idx] = oslots[i];
+        ns->ctrl[idx] = octrl[i];
+    }
+
+    UA_free(octrl);
+    UA_free(oslots);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Capacity for a load factor of about 50% */
+static size_t
+targetCapacity(size_t count) {
+    size_t capacity = SWISS_MINCAPACITY;
+    while(capacity < count * 2)
+        capacity <<= 1;
+    return capacity;
+}
+
+/****************/
+/* Node Entries */
+/****************/
+
+static SwissEntry *
+createEntry(UA_NodeClass nodeClass) {
+    size_t size = sizeof(SwissEntry) - sizeof(UA_Node);
+    switch(nodeClass) {
+    case UA_NODECLASS_OBJECT:
+        size += sizeof(UA_ObjectNode);
+        break;
+    case UA_NODECLASS_VARIABLE:
+        size += sizeof(UA_VariableNode);
+        break;
+    case UA_NODECLASS_METHOD:
+        size += sizeof(UA_MethodNode);
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        size += sizeof(UA_ObjectTypeNode);
+        break;
+    case UA_NODECLASS_VARIABLETYPE:
+        size += sizeof(UA_VariableTypeNode);
+        break;
+    case UA_NODECLASS_REFERENCETYPE:
+        size += sizeof(UA_ReferenceTypeNode);
+        break;
+    case UA_NODECLASS_DATATYPE:
+        size += sizeof(UA_DataTypeNode);
+        break;
+    case UA_NODECLASS_VIEW:
+        size += sizeof(UA_ViewNode);
+        break;
+    default:
+        return NULL;
+    }
+    SwissEntry *entry = (SwissEntry*)UA_calloc(1, size);
+    if(!entry)
+        return NULL;
+    entry->node.head.nodeClass = nodeClass;
+    return entry;
+}
+
+static void
+deleteSwissEntry(SwissEntry *entry) {
+    UA_Node_clear(&entry->node);
+    UA_free(entry);
+}
+
+/* Switch to the tree-representation for nodes with many references. This
+ * modifies the node. So it is only done when the node is not yet visible in the
+ * table or when it was edited and is no longer used. */
+static void
+optimizeSwissEntry(SwissEntry *entry) {
+    for(size_t i = 0; i < entry->node.head.referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &entry->node.head.references[i];
+        if(rk->targetsSize > 16 && !rk->hasRefTree)
+            UA_NodeReferenceKind_switch(rk);
+    }
+}
+
+static void
+cleanupSwissEntry(SwissEntry *entry) {
+    if(entry->refCount > 0)
+        return;
+    if(entry->deleted)
+        deleteSwissEntry(entry);
+}
+
+/* Remove the slot. If the group has an EMPTY control byte, no probe sequence
+ * continues beyond the group. Then the slot can become EMPTY as well. */
+static void
+clearSlot(SwissContext *ns, size_t idx) {
+    const UA_Byte *group = &ns->ctrl[(idx / SWISS_GROUPSIZE) * SWISS_GROUPSIZE];
+    if(matchByte(group, SWISS_CTRL_EMPTY)) {
+        ns->ctrl[idx] = SWISS_CTRL_EMPTY;
+    } else {
+        ns->ctrl[idx] = SWISS_CTRL_DELETED;
+        ns->tombstones++;
+    }
+    ns->slots[idx].entry = NULL;
+    ns->count--;
+}
+
+/***********************/
+/* Interface functions */
+/***********************/
+
+static UA_Node *
+swissNsNewNode(void *nsCtx, UA_NodeClass nodeClass) {
+    SwissEntry *entry = createEntry(nodeClass);
+    if(!entry)
+        return NULL;
+    return &entry->node;
+}
+
+static void
+swissNsDeleteNode(void *nsCtx, UA_Node *node) {
+    SwissEntry *entry = container_of(node, SwissEntry, node);
+    UA_assert(&entry->node == node);
+    deleteSwissEntry(entry);
+}
+
+static const UA_Node *
+swissNsGetNode(void *nsCtx, const UA_NodeId *nodeId,
+               UA_UInt32 attributeMask,
+               UA_ReferenceTypeSet references,
+               UA_BrowseDirection referenceDirections) {
+    SwissContext *ns = (SwissContext*)nsCtx;
+    size_t idx = findSlot(ns, nodeId, UA_NodeId_hash(nodeId));
+    if(idx == ns->capacity)
+        return NULL;
+    SwissEntry *entry = ns->slots[idx].entry;
+    UA_atomic_addSize(&entry->refCount, 1);
+    return &entry->node;
+}
+
+static const UA_Node *
+swissNsGetNodeFromPtr(void *nsCtx, UA_NodePointer ptr,
+                      UA_UInt32 attributeMask,
+                      UA_ReferenceTypeSet references,
+                      UA_BrowseDirection referenceDirections) {
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+    return swissNsGetNode(nsCtx, &id, attributeMask,
+                          references, referenceDirections);
+}
+
+static UA_Node *
+swissNsGetEditNode(void *nsCtx, const UA_NodeId *nodeId,
+                   UA_UInt32 attributeMask,
+                   UA_ReferenceTypeSet references,
+                   UA_BrowseDirection referenceDirections) {
+    UA_Node *node = (UA_Node*)(uintptr_t)
+        swissNsGetNode(nsCtx, nodeId, attributeMask,
+                       references, referenceDirections);
+    if(node) {
+        SwissEntry *entry = container_of(node, SwissEntry, node);
+        entry->edited = true;
+    }
+    return node;
+}
+
+static UA_Node *
+swissNsGetEditNodeFromPtr(void *nsCtx, UA_NodePointer ptr,
+                          UA_UInt32 attributeMask,
+                          UA_ReferenceTypeSet references,
+                          UA_BrowseDirection referenceDirections) {
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+    return swissNsGetEditNode(nsCtx, &id, attributeMask,
+                              references, referenceDirections);
+}
+
+static void
+swissNsReleaseNode(void *nsCtx, const UA_Node *node) {
+    if(!node)
+        return;
+    SwissEntry *entry = container_of(node, SwissEntry, node);
+    UA_assert(&entry->node == node);
+    UA_assert(entry->refCount > 0);
+
+    /* Edits are only made with exclusive access to the nodestore. Reset the
+     * flag right away. Concurrent readers only see edited == false. */
+    UA_Boolean edited = entry->edited;
+    if(edited)
+        entry->edited = false;
+
+    if(UA_atomic_subSize(&entry->refCount, 1) > 0)
+        return;
+    if(entry->deleted) {
+        deleteSwissEntry(entry);
+        return;
+    }
+    if(edited)
+        optimizeSwissEntry(entry);
+}
+
+static UA_StatusCode
+swissNsGetNodeCopy(void *nsCtx, const UA_NodeId *nodeId,
+                   UA_Node **outNode) {
+    const UA_Node *node =
+        swissNsGetNode(nsCtx, nodeId, UA_NODEATTRIBUTESMASK_ALL,
+                       UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    if(!node)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+
+    SwissEntry *newItem = createEntry(node->head.nodeClass);
+    if(!newItem) {
+        swissNsReleaseNode(nsCtx, node);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    UA_StatusCode retval = UA_Node_copy(node, &newItem->node);
+    if(retval == UA_STATUSCODE_GOOD) {
+        newItem->orig = container_of(node, SwissEntry, node);
+        *outNode = &newItem->node;
+    } else {
+        deleteSwissEntry(newItem);
+    }
+    swissNsReleaseNode(nsCtx, node);
+    return retval;
+}
+
+static UA_StatusCode
+swissNsRemoveNode(void *nsCtx, const UA_NodeId *nodeId) {
+    SwissContext *ns = (SwissContext*)nsCtx;
+    size_t idx = findSlot(ns, nodeId, UA_NodeId_hash(nodeId));
+    if(idx == ns->capacity)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+
+    SwissEntry *entry = ns->slots[idx].entry;
+    clearSlot(ns, idx);
+    entry->deleted = true;
+    cleanupSwissEntry(entry);
+
+    /* Downsize the table if it is very empty */
+    if(ns->count * 8 < ns->capacity && ns->capacity > SWISS_MINCAPACITY &&
+       UA_atomic_addSize(&ns->iterating, 0) == 0)
+        resize(ns, targetCapacity(ns->count)); /* Can fail. Just continue. */
+    return UA_STATUSCODE_GOOD;
+}
+
+/* If this function fails in any way, the node parameter is deleted here, so
+ * the caller function does not need to take care of it anymore */
+static UA_StatusCode
+swissNsInsertNode(void *nsCtx, UA_Node *node, UA_NodeId *addedNodeId) {
+    SwissContext *ns = (SwissContext*)nsCtx;
+    SwissEntry *entry = container_of(node, SwissEntry, node);
+
+    /* Keep the maximum load factor (including tombstones) at 7/8. Rehash in
+     * place if there are many tombstones. Otherwise grow. */
+    if((ns->count + ns->tombstones + 1) * 8 > ns->capacity * 7) {
+        size_t capacity = targetCapacity(ns->count + 1);
+        if(capacity < ns->capacity)
+            capacity = ns->capacity;
+        if(resize(ns, capacity) != UA_STATUSCODE_GOOD) {
+            deleteSwissEntry(entry);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+    }
+
+    /* Ensure that the NodeId is unique */
+    UA_UInt32 h;
+    if(node->head.nodeId.identifierType == UA_NODEIDTYPE_NUMERIC &&
+       node->head.nodeId.identifier.numeric == 0) {
+        do { /* Create a random nodeid until we find an unoccupied id */
+            UA_UInt32 numId = UA_UInt32_random();
+#if SIZE_MAX <= UA_UINT32_MAX
+            /* The compressed "immediate" representation of nodes does not
+             * support the full range on 32bit systems. Generate smaller
+             * identifiers as they can be stored more compactly. */
+            if(numId >= (0x01 << 24))
+                numId = numId % (0x01 << 24);
+#endif
+            node->head.nodeId.identifier.numeric = numId;
+            h = UA_NodeId_hash(&node->head.nodeId);
+        } while(node->head.nodeId.identifier.numeric == 0 ||
+                findSlot(ns, &node->head.nodeId, h) != ns->capacity);
+    } else {
+        h = UA_NodeId_hash(&node->head.nodeId);
+        if(findSlot(ns, &node->head.nodeId, h) != ns->capacity) {
+            deleteSwissEntry(entry);
+            return UA_STATUSCODE_BADNODEIDEXISTS;
+        }
+    }
+
+    /* Copy the NodeId */
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    if(addedNodeId) {
+        retval = UA_NodeId_copy(&node->head.nodeId, addedNodeId);
+        if(retval != UA_STATUSCODE_GOOD) {
+            deleteSwissEntry(entry);
+            return retval;
+        }
+    }
+
+    /* For new ReferencetypeNodes add to the index map */
+    if(node->head.nodeClass == UA_NODECLASS_REFERENCETYPE) {
+        UA_ReferenceTypeNode *refNode = &node->referenceTypeNode;
+        if(ns->referenceTypeCounter >= UA_REFERENCETYPESET_MAX) {
+            deleteSwissEntry(entry);
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+
+        retval = UA_NodeId_copy(&node->head.nodeId,
+                                &ns->referenceTypeIds[ns->referenceTypeCounter]);
+        if(retval != UA_STATUSCODE_GOOD) {
+            deleteSwissEntry(entry);
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+
+        /* Assign the ReferenceTypeIndex to the new ReferenceTypeNode */
+        refNode->referenceTypeIndex = ns->referenceTypeCounter;
+        refNode->subTypes = UA_REFTYPESET(ns->referenceTypeCounter);
+
+        ns->referenceTypeCounter++;
+    }
+
+    /* Insert the node */
+    optimizeSwissEntry(entry);
+    setSlot(ns, findFreeSlot(ns, h), entry, h);
+    ns->count++;
+    return retval;
+}
+
+static UA_StatusCode
+swissNsReplaceNode(void *nsCtx, UA_Node *node) {
+    SwissContext *ns = (SwissContext*)nsCtx;
+    SwissEntry *entry = container_of(node, SwissEntry, node);
+
+    /* Find the node */
+    UA_UInt32 h = UA_NodeId_hash(&node->head.nodeId);
+    size_t idx = findSlot(ns, &node->head.nodeId, h);
+    if(idx == ns->capacity) {
+        deleteSwissEntry(entry);
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    }
+
+    /* The node was already updated since the copy was made? */
+    SwissEntry *oldEntry = ns->slots[idx].entry;
+    if(oldEntry != entry->orig) {
+        deleteSwissEntry(entry);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Replace the entry. The NodeId and hash are unchanged. */
+    optimizeSwissEntry(entry);
+    ns->slots[idx].entry = entry;
+    oldEntry->deleted = true;
+    cleanupSwissEntry(oldEntry);
+    return UA_STATUSCODE_GOOD;
+}
+
+static const UA_NodeId *
+swissNsGetReferenceTypeId(void *nsCtx, UA_Byte refTypeIndex) {
+    SwissContext *ns = (SwissContext*)nsCtx;
+    if(refTypeIndex >= ns->referenceTypeCounter)
+        return NULL;
+    return &ns->referenceTypeIds[refTypeIndex];
+}
+
+static void
+swissNsIterate(void *nsCtx, UA_NodestoreVisitor visitor,
+               void *visitorCtx) {
+    SwissContext *ns = (SwissContext*)nsCtx;
+    UA_atomic_addSize(&ns->iterating, 1);
+    for(size_t i = 0; i < ns->capacity; i++) {
+        if(ns->ctrl[i] & 0x80)
+            continue;
+        /* The visitor can delete the node. So refcount here. */
+        SwissEntry *entry = ns->slots[i].entry;
+        UA_atomic_addSize(&entry->refCount, 1);
+        visitor(visitorCtx, &entry->node);
+        swissNsReleaseNode(nsCtx, &entry->node);
+    }
+    UA_atomic_subSize(&ns->iterating, 1);
+}
+
+/***********************/
+/* Nodestore Lifecycle */
+/***********************/
+
+static void
+swissNsClear(void *nsCtx) {
+    if(!nsCtx)
+        return;
+    SwissContext *ns = (SwissContext*)nsCtx;
+    for(size_t i = 0; i < ns->capacity; i++) {
+        if(ns->ctrl[i] & 0x80)
+            continue;
+        /* On debugging builds, check that all nodes were release */
+        UA_assert(ns->slots[i].entry->refCount == 0);
+        deleteSwissEntry(ns->slots[i].entry);
+    }
+    UA_free(ns->ctrl);
+    UA_free(ns->slots);
+
+    /* Clean up the ReferenceTypes index array */
+    for(size_t i = 0; i < ns->referenceTypeCounter; i++)
+        UA_NodeId_clear(&ns->referenceTypeIds[i]);
+
+    UA_free(ns);
+}
+
+UA_StatusCode
+UA_Nodestore_SwissTable(UA_Nodestore *ns) {
+    /* Allocate and initialize the context */
+    SwissContext *ctx = (SwissContext*)UA_calloc(1, sizeof(SwissContext));
+    if(!ctx)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = resize(ctx, SWISS_MINCAPACITY);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(ctx);
+        return res;
+    }
+
+    /* Populate the nodestore */
+    ns->context = (void*)ctx;
+    ns->clear = swissNsClear;
+    ns->newNode = swissNsNewNode;
+    ns->deleteNode = swissNsDeleteNode;
+    ns->getNode = swissNsGetNode;
+    ns->getNodeFromPtr = swissNsGetNodeFromPtr;
+    ns->releaseNode = swissNsReleaseNode;
+    ns->getNodeCopy = swissNsGetNodeCopy;
+    ns->insertNode = swissNsInsertNode;
+    ns->replaceNode = swissNsReplaceNode;
+    ns->removeNode = swissNsRemoveNode;
+    ns->getReferenceTypeId = swissNsGetReferenceTypeId;
+    ns->iterate = swissNsIterate;
+
+    /* All nodes are stored in RAM. Changes are made in-situ. GetEditNode is
+     * identical to GetNode -- but the Node pointer is non-const and the entry
+     * is marked as edited. */
+    ns->getEditNode = swissNsGetEditNode;
+    ns->getEditNodeFromPtr = swissNsGetEditNodeFromPtr;
+
+    return UA_STATUSCODE_GOOD;
+}
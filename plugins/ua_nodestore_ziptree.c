@@ -21,8 +21,11 @@ typedef struct NodeEntry NodeEntry;
 struct NodeEntry {
     ZIP_ENTRY(NodeEntry) zipfields;
     UA_UInt32 nodeIdHash;
-    UA_UInt16 refCount; /* How many consumers have a reference to the node? */
+    size_t refCount;    /* How many consumers have a reference to the node?
+                         * Changed atomically, as readers can run in parallel
+                         * threads. */
     UA_Boolean deleted; /* Node was marked as deleted and can be deleted when refCount == 0 */
+    UA_Boolean edited;  /* The node was retrieved with getEditNode */
     NodeEntry *orig;    /* If a copy is made to replace a node, track that we
                          * replace only the node from which the copy was made.
                          * Important for concurrent operations. */
@@ -103,14 +106,11 @@ deleteEntry(NodeEntry *entry) {
     UA_free(entry);
 }
 
+/* Switch to the tree-representation for nodes with many references. This
+ * modifies the node. So it is only done when the node is not yet visible in the
+ * tree or when it was edited and is no longer used. */
 static void
-cleanupEntry(NodeEntry *entry) {
-    if(entry->refCount > 0)
-        return;
-    if(entry->deleted) {
-        deleteEntry(entry);
-        return;
-    }
+optimizeEntry(NodeEntry *entry) {
     UA_NodeHead *head = (UA_NodeHead*)&entry->nodeId;
     for(size_t i = 0; i < head->referencesSize; i++) {
         UA_NodeReferenceKind *rk = &head->references[i];
@@ -119,6 +119,14 @@ cleanupEntry(NodeEntry *entry) {
     }
 }
 
+static void
+cleanupEntry(NodeEntry *entry) {
+    if(entry->refCount > 0)
+        return;
+    if(entry->deleted)
+        deleteEntry(entry);
+}
+
 /***********************/
 /* Interface functions */
 /***********************/
@@ -150,7 +158,7 @@ zipNsGetNode(void *nsCtx, const UA_NodeId *nodeId,
     NodeEntry *entry = ZIP_FIND(NodeTree, &ns->root, &dummy);
     if(!entry)
         return NULL;
-    ++entry->refCount;
+    UA_atomic_addSize(&entry->refCount, 1);
     return (const UA_Node*)&entry->nodeId;
 }
 
@@ -166,14 +174,54 @@ zipNsGetNodeFromPtr(void *nsCtx, UA_NodePointer ptr,
                         references, referenceDirections);
 }
 
+static UA_Node *
+zipNsGetEditNode(void *nsCtx, const UA_NodeId *nodeId,
+                 UA_UInt32 attributeMask,
+                 UA_ReferenceTypeSet references,
+                 UA_BrowseDirection referenceDirections) {
+    UA_Node *node = (UA_Node*)(uintptr_t)
+        zipNsGetNode(nsCtx, nodeId, attributeMask,
+                     references, referenceDirections);
+    if(node) {
+        NodeEntry *entry = container_of(node, NodeEntry, nodeId);
+        entry->edited = true;
+    }
+    return node;
+}
+
+static UA_Node *
+zipNsGetEditNodeFromPtr(void *nsCtx, UA_NodePointer ptr,
+                        UA_UInt32 attributeMask,
+                        UA_ReferenceTypeSet references,
+                        UA_BrowseDirection referenceDirections) {
+    if(!UA_NodePointer_isLocal(ptr))
+        return NULL;
+    UA_NodeId id = UA_NodePointer_toNodeId(ptr);
+    return zipNsGetEditNode(nsCtx, &id, attributeMask,
+                            references, referenceDirections);
+}
+
 static void
 zipNsReleaseNode(void *nsCtx, const UA_Node *node) {
     if(!node)
         return;
     NodeEntry *entry = container_of(node, NodeEntry, nodeId);
     UA_assert(entry->refCount > 0);
-    --entry->refCount;
-    cleanupEntry(entry);
+
+    /* Edits are only made with exclusive access to the nodestore. Reset the
+     * flag right away. Concurrent readers only see edited == false. */
+    UA_Boolean edited = entry->edited;
+    if(edited)
+        entry->edited = false;
+
+    if(UA_atomic_subSize(&entry->refCount, 1) > 0)
+        return;
+    if(entry->deleted) {
+        deleteEntry(entry);
+        return;
+    }
+    if(edited)
+        optimizeEntry(entry);
 }
 
 static UA_StatusCode
@@ -272,6 +320,7 @@ zipNsInsertNode(void *nsCtx, UA_Node *node, UA_NodeId *addedNodeId) {
     }
 
     /* Insert the node */
+    optimizeEntry(entry);
     entry->nodeIdHash = dummy.nodeIdHash;
     ZIP_INSERT(NodeTree, &ns->root, entry);
     return UA_STATUSCODE_GOOD;
@@ -301,6 +350,7 @@ zipNsReplaceNode(void *nsCtx, UA_Node *node) {
     /* Replace */
     ZipContext *ns = (ZipContext*)nsCtx;
     ZIP_REMOVE(NodeTree, &ns->root, oldEntry);
+    optimizeEntry(entry);
     entry->nodeIdHash = oldEntry->nodeIdHash;
     ZIP_INSERT(NodeTree, &ns->root, entry);
     oldEntry->deleted = true;
@@ -404,17 +454,10 @@ UA_Nodestore_ZipTree(UA_Nodestore *ns) {
     ns->iterate = zipNsIterate;
 
     /* All nodes are stored in RAM. Changes are made in-situ. GetEditNode is
-     * identical to GetNode -- but the Node pointer is non-const. */
-    ns->getEditNode =
-        (UA_Node * (*)(void *nsCtx, const UA_NodeId *nodeId,
-                       UA_UInt32 attributeMask,
-                       UA_ReferenceTypeSet references,
-                       UA_BrowseDirection referenceDirections))zipNsGetNode;
-    ns->getEditNodeFromPtr =
-        (UA_Node * (*)(void *nsCtx, UA_NodePointer ptr,
-                       UA_UInt32 attributeMask,
-                       UA_ReferenceTypeSet references,
-                       UA_BrowseDirection referenceDirections))zipNsGetNodeFromPtr;
+     * identical to GetNode -- but the Node pointer is non-const and the entry
+     * is marked as edited. */
+    ns->getEditNode = zipNsGetEditNode;
+    ns->getEditNodeFromPtr = zipNsGetEditNodeFromPtr;
 
     return UA_STATUSCODE_GOOD;
 }
@@ -1666,6 +1666,21 @@ __Client_networkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
         *connectionContext = &client->channel;
     }
 
+    /* The send queue of the connection crossed the high (or low) watermark */
+    const UA_Boolean *sendBlocked = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params, UA_QUALIFIEDNAME(0, "send-blocked"),
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if(sendBlocked && state == UA_CONNECTIONSTATE_ESTABLISHED) {
+        client->channel.sendBlocked = *sendBlocked;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        /* Resume sending the PublishRequests held back while blocked */
+        if(!*sendBlocked)
+            __Client_Subscriptions_backgroundPublish(client);
+#endif
+        unlockClient(client);
+        return;
+    }
+
     /* The connection is closing in the EventLoop. This is the last callback
      * from that connection. Clean up the SecureChannel in the client. */
     if(state == UA_CONNECTIONSTATE_CLOSING) {
@@ -1735,7 +1750,7 @@ __Client_networkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
         /* Abort after synchronous processing of a message.
          * Add a delayed callback to process the remaining buffer ASAP. */
         if(res == UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY) {
-            if(client->channel.unprocessed.length > client->channel.unprocessedOffset &&
+            if(UA_SecureChannel_hasUnprocessed(&client->channel) &&
                client->channel.unprocessedDelayed.callback == NULL) {
                 client->channel.unprocessedDelayed.callback = delayedNetworkCallback;
                 client->channel.unprocessedDelayed.application = client;
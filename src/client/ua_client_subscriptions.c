@@ -1482,6 +1482,11 @@ __Client_Subscriptions_backgroundPublish(UA_Client *client) {
     if(!LIST_FIRST(&client->subscriptions))
         return;
 
+    /* Don't grow the send queue of the connection while it is blocked. The
+     * PublishRequests are sent once the queue has drained. */
+    if(client->channel.sendBlocked)
+        return;
+
     while(client->currentlyOutStandingPublishRequests < client->config.outStandingPublishRequests) {
         UA_PublishRequest *request = UA_PublishRequest_new();
         if(!request)
@@ -21,10 +21,6 @@ static UA_StatusCode
 UA_PubSubConnection_connect(UA_PubSubManager *psm, UA_PubSubConnection *c,
                             UA_Boolean validate);
 
-static void
-UA_PubSubConnection_process(UA_PubSubManager *psm, UA_PubSubConnection *c,
-                            const UA_ByteString msg);
-
 static void
 UA_PubSubConnection_disconnect(UA_PubSubConnection *c);
 
@@ -55,9 +51,29 @@ UA_PubSubConnection_decodeNetworkMessage(UA_PubSubManager *psm,
     }
 
     /* Choose a correct readergroup for decrypt/verify this message
-     * (there could be multiple) */
+     * (there could be multiple). Use the reader index if possible. */
     UA_Boolean processed = false;
     UA_ReaderGroup *rg;
+    if(UA_ReaderIndex_canLookup(connection, nm)) {
+        UA_DataSetMessage *dsms = nm->payload.dataSetPayload.dataSetMessages;
+        for(size_t i = 0; i < nm->payload.dataSetPayload.dataSetMessagesSize; i++) {
+            size_t iter = 0;
+            UA_DataSetReader *reader =
+                UA_ReaderIndex_next(connection, nm, dsms[i].dataSetWriterId, &iter);
+            if(!reader)
+                continue;
+            processed = true;
+            rv = verifyAndDecryptNetworkMessage(psm->logging, buffer, &ctx, nm,
+                                                reader->linkedReaderGroup);
+            if(rv != UA_STATUSCODE_GOOD) {
+                UA_NetworkMessage_clear(nm);
+                return rv;
+            }
+            break;
+        }
+        goto loops_exit;
+    }
+
     LIST_FOREACH(rg, &connection->readerGroups, listEntry) {
         UA_DataSetReader *reader;
         LIST_FOREACH(reader, &rg->readers, listEntry) {
@@ -269,12 +285,13 @@ UA_PubSubConnection_delete(UA_PubSubManager *psm, UA_PubSubConnection *c) {
 
     UA_LOG_INFO_PUBSUB(psm->logging, c, "Connection deleted");
 
+    UA_ReaderIndex_clear(&c->readerIndex);
     UA_PubSubConnectionConfig_clear(&c->config);
     UA_PubSubComponentHead_clear(&c->head);
     UA_free(c);
 }
 
-static void
+void
 UA_PubSubConnection_process(UA_PubSubManager *psm, UA_PubSubConnection *c,
                             const UA_ByteString msg) {
     UA_LOG_TRACE_PUBSUB(psm->logging, c, "Processing a received buffer");
@@ -309,6 +326,13 @@ UA_PubSubConnection_process(UA_PubSubManager *psm, UA_PubSubConnection *c,
     if(res != UA_STATUSCODE_GOOD)
         return;
 
+    /* Dispatch with the reader index */
+    if(UA_ReaderIndex_canLookup(c, &nm)) {
+        processed = UA_ReaderGroup_processIndexed(psm, c, NULL, &nm);
+        UA_NetworkMessage_clear(&nm);
+        goto finish;
+    }
+
     /* Process the received message for the non-RT ReaderGroups */
     LIST_FOREACH(rg, &c->readerGroups, listEntry) {
         if(rg->head.state != UA_PUBSUBSTATE_OPERATIONAL &&
@@ -465,6 +465,19 @@ UA_PubSubDataSetField_sampleValue(UA_PubSubManager *psm, UA_DataSetField *field,
                                   UA_DataValue *value) {
     UA_PublishedVariableDataType *params = &field->config.field.variable.publishParameters;
 
+    /* Sample from the application memory */
+    if(field->externalValue.value) {
+        UA_StatusCode res =
+            UA_PubSubExternalValue_read(psm->sc.server, &field->externalValue,
+                                        &params->publishedVariable, value);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_DataValue_init(value);
+            value->hasStatus = true;
+            value->status = res;
+        }
+        return;
+    }
+
     UA_ReadValueId rvid;
     UA_ReadValueId_init(&rvid);
     rvid.nodeId = params->publishedVariable;
@@ -172,6 +172,43 @@ typedef struct {
 void
 UA_PubSubComponentHead_clear(UA_PubSubComponentHead *psch);
 
+/* Direct access to an application-owned value. If the VariableNode of a
+ * DataSetField or a TargetVariable has an external value backend
+ * (UA_VALUEBACKENDTYPE_EXTERNAL), the binding is resolved when the component
+ * is enabled. The value is then sampled and written without the Read/Write
+ * service and the nodestore. Read and Subscriptions on the node see the same
+ * value through the value backend. */
+typedef struct {
+    UA_DataValue **value; /* NULL if not bound */
+    UA_ExternalValueCallback callback;
+    void *nodeContext;
+    UA_Boolean isDynamic; /* Keep the source timestamp when writing */
+} UA_PubSubExternalValue;
+
+/* Only the value attribute without an IndexRange can be bound. For a
+ * TargetVariable, the FieldMetaData of the received field must match the
+ * DataType and ValueRank of the node. A node with a userWrite callback or a
+ * server with a history database is not bound for writing. */
+void
+UA_PubSubExternalValue_bind(UA_Server *server, UA_PubSubExternalValue *ev,
+                            const UA_NodeId *nodeId, UA_UInt32 attributeId,
+                            const UA_String *indexRange,
+                            const UA_FieldMetaData *writeField);
+
+/* The variant content is borrowed from the application (storage type
+ * UA_VARIANT_DATA_NODELETE). Copy before keeping it beyond the current
+ * publish cycle. */
+UA_StatusCode
+UA_PubSubExternalValue_read(UA_Server *server, const UA_PubSubExternalValue *ev,
+                            const UA_NodeId *nodeId, UA_DataValue *value);
+
+/* Overwrite the application value in-place if it has the same fixed-size type
+ * and length. Returns false if the value has to be written with the
+ * Write-Service instead. */
+UA_Boolean
+UA_PubSubExternalValue_write(const UA_PubSubExternalValue *ev,
+                             const UA_DataValue *value);
+
 /**********************************************/
 /*            PublishedDataSet                */
 /**********************************************/
@@ -236,6 +273,23 @@ UA_SubscribedDataSet_remove(UA_PubSubManager *psm, UA_SubscribedDataSet *sds);
 /*               Connection                   */
 /**********************************************/
 
+/* Index of the enabled DataSetReaders (in UADP ReaderGroups) of a
+ * PubSubConnection. The key is the combination of PublisherId, WriterGroupId
+ * and DataSetWriterId. Open addressing with linear probing. The index is marked
+ * dirty when readers are enabled or disabled and rebuilt before the next
+ * lookup. Removed readers are replaced by a tombstone right away. */
+typedef struct {
+    UA_UInt32 hash;
+    UA_Boolean removed;
+    UA_DataSetReader *dsr; /* NULL for empty entries */
+} UA_ReaderIndexEntry;
+
+typedef struct {
+    UA_ReaderIndexEntry *entries;
+    size_t entriesSize; /* Power of two */
+    UA_Boolean dirty;
+} UA_ReaderIndex;
+
 typedef struct UA_PubSubConnection {
     UA_PubSubComponentHead head;
     TAILQ_ENTRY(UA_PubSubConnection) listEntry;
@@ -262,6 +316,7 @@ typedef struct UA_PubSubConnection {
 
     size_t readerGroupsSize;
     LIST_HEAD(, UA_ReaderGroup) readerGroups;
+    UA_ReaderIndex readerIndex;
 
     UA_DateTime silenceErrorUntil; /* Avoid generating too many logs */
 
@@ -298,6 +353,11 @@ UA_PubSubConnection_decodeNetworkMessage(UA_PubSubManager *psm,
                                          UA_ByteString buffer,
                                          UA_NetworkMessage *nm);
 
+/* Decode and process a received buffer */
+void
+UA_PubSubConnection_process(UA_PubSubManager *psm, UA_PubSubConnection *c,
+                            const UA_ByteString msg);
+
 /**********************************************/
 /*              DataSetWriter                 */
 /**********************************************/
@@ -324,6 +384,7 @@ typedef struct UA_DataSetWriter {
     UA_UInt16 actualDataSetMessageSequenceCount;
     UA_Boolean configurationFrozen;
     UA_UInt64 pubSubStateTimerId;
+    UA_Boolean deleteFlag; /* Removed while the WriterGroup is publishing */
 } UA_DataSetWriter;
 
 UA_StatusCode
@@ -342,6 +403,12 @@ UA_DataSetWriter_generateDataSetMessage(UA_PubSubManager *psm,
                                         UA_DataSetWriter *dsw,
                                         UA_DataSetMessage *dsm);
 
+/* Sample the value of a field and apply the DataSetFieldContentMask of the
+ * writer */
+void
+UA_DataSetWriter_sampleField(UA_PubSubManager *psm, UA_DataSetWriter *dsw,
+                             struct UA_DataSetField *dsf, UA_DataValue *dfv);
+
 UA_StatusCode
 UA_DataSetWriter_create(UA_PubSubManager *psm,
                         const UA_NodeId writerGroup, const UA_NodeId dataSet,
@@ -355,6 +422,29 @@ UA_DataSetWriter_remove(UA_PubSubManager *psm, UA_DataSetWriter *dsw);
 /*               WriterGroup                  */
 /**********************************************/
 
+/* Frozen NetworkMessage. The encoded message is kept as a template (before
+ * encryption and signing). The offsets point to the parts that change in every
+ * publish cycle. */
+typedef struct {
+    UA_PubSubOffsetType offsetType;
+    size_t offset;
+    size_t size;                   /* Encoded size of a field */
+    UA_DataSetWriter *dsw;         /* DataSetMessage offsets */
+    struct UA_DataSetField *field; /* DataSetField offsets */
+    const UA_DataType *rawType;    /* RawData fields and scalar Variants */
+    size_t rawElements;
+    UA_Boolean rawArray;
+} UA_FrozenOffset;
+
+typedef struct {
+    UA_ByteString message;
+    size_t payloadOffset; /* Start of the encrypted part */
+    size_t nonceOffset;
+    UA_FrozenOffset *offsets;
+    size_t offsetsSize;
+    UA_Boolean failed; /* Not supported, retry after a state change */
+} UA_FrozenNetworkMessage;
+
 struct UA_WriterGroup {
     UA_PubSubComponentHead head;
     LIST_ENTRY(UA_WriterGroup) listEntry;
@@ -368,6 +458,8 @@ struct UA_WriterGroup {
     UA_UInt16 sequenceNumber; /* Increased after every sent message */
     UA_DateTime lastPublishTimeStamp;
 
+    UA_FrozenNetworkMessage frozen; /* Only with config.frozenNetworkMessage */
+
     /* The ConnectionManager pointer is stored in the Connection. The channels
      * are either stored here or in the Connection, but never both. */
     UA_PubSubConnection *linkedConnection;
@@ -380,6 +472,19 @@ struct UA_WriterGroup {
 #ifdef UA_ENABLE_PUBSUB_SKS
     UA_PubSubKeyStorage *keyStorage; /* non-owning pointer to keyStorage*/
 #endif
+
+    UA_WriterGroupPublishStatistics statistics;
+    UA_DateTime lastCycleStart; /* Monotonic. For the jitter in the EventLoop. */
+
+#if UA_MULTITHREADING >= 100
+    /* Publishing from a publisher thread (config.publisherThread != 0) */
+    UA_DateTime nextPublish; /* Monotonic. Scheduled if != 0. */
+    UA_Boolean publishing;   /* Encoding and sending without the server lock.
+                              * The removal is completed afterwards. */
+    UA_UInt32 stateGeneration; /* Incremented with every state change */
+    UA_Lock securityLock;    /* Protects the securityPolicyContext while the
+                              * message security is applied */
+#endif
 };
 
 UA_StatusCode
@@ -418,6 +523,11 @@ UA_WriterGroup_setPubSubState(UA_PubSubManager *psm, UA_WriterGroup *wg,
 void
 UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg);
 
+/* Drop the frozen NetworkMessage. It is created again in the next publish
+ * cycle (unless freezing has failed before). */
+void
+UA_WriterGroup_thawNetworkMessage(UA_WriterGroup *wg);
+
 /**********************************************/
 /*               DataSetField                 */
 /**********************************************/
@@ -430,6 +540,7 @@ typedef struct UA_DataSetField {
     UA_FieldMetaData fieldMetaData; /* contains the dataSetFieldId */
     UA_UInt64 sampleCallbackId;
     UA_Boolean sampleCallbackIsRegistered;
+    UA_PubSubExternalValue externalValue; /* Bound while the PDS is frozen */
 } UA_DataSetField;
 
 UA_StatusCode
@@ -456,6 +567,24 @@ UA_PubSubDataSetField_sampleValue(UA_PubSubManager *psm,
 /*               DataSetReader                */
 /**********************************************/
 
+/* Precompiled decoding of RAW-encoded DataSetMessages. The DataTypes are
+ * resolved once when the reader is enabled. */
+typedef struct {
+    const UA_DataType *type;
+    UA_Int32 valueRank;        /* Number of encoded array dimensions */
+    UA_UInt32 *arrayDimensions;
+    size_t elementCount;       /* 1 for scalars */
+    size_t encodedSize;        /* Size of the encoded elements if overlayable */
+    UA_UInt32 maxStringLength; /* Padding of strings */
+} UA_RawDecodeField;
+
+typedef struct {
+    UA_StatusCode res; /* Why the plan could not be compiled */
+    size_t fieldsSize;
+    UA_RawDecodeField *fields;
+    UA_Byte *buffer;   /* Decoding target, sized for the largest field */
+} UA_RawDecodePlan;
+
 struct UA_DataSetReader {
     UA_PubSubComponentHead head;
     LIST_ENTRY(UA_DataSetReader) listEntry;
@@ -463,6 +592,12 @@ struct UA_DataSetReader {
     UA_DataSetReaderConfig config;
     UA_ReaderGroup *linkedReaderGroup;
 
+    /* Bound while the reader is enabled. One entry per TargetVariable. */
+    UA_PubSubExternalValue *externalValues;
+
+    /* Compiled while the reader is enabled */
+    UA_RawDecodePlan rawDecodePlan;
+
     /* MessageReceiveTimeout handling */
     UA_UInt64 msgRcvTimeoutTimerId;
 };
@@ -480,6 +615,19 @@ UA_StatusCode
 UA_DataSetReader_checkIdentifier(UA_PubSubManager *psm, UA_DataSetReader *dsr,
                                  UA_NetworkMessage *msg);
 
+/* The reader index can be used if the NetworkMessage contains all identifiers */
+UA_Boolean
+UA_ReaderIndex_canLookup(UA_PubSubConnection *c, const UA_NetworkMessage *nm);
+
+/* Returns the next enabled reader of the connection that matches the
+ * identifiers. Start the iteration with *iter = 0. */
+UA_DataSetReader *
+UA_ReaderIndex_next(UA_PubSubConnection *c, const UA_NetworkMessage *nm,
+                    UA_UInt16 dataSetWriterId, size_t *iter);
+
+void
+UA_ReaderIndex_clear(UA_ReaderIndex *ri);
+
 UA_StatusCode
 UA_DataSetReader_create(UA_PubSubManager *psm, UA_NodeId readerGroupIdentifier,
                         const UA_DataSetReaderConfig *dataSetReaderConfig,
@@ -567,6 +715,12 @@ UA_Boolean
 UA_ReaderGroup_process(UA_PubSubManager *psm, UA_ReaderGroup *rg,
                        UA_NetworkMessage *nm);
 
+/* Dispatch the DataSetMessages to the matching readers with the reader index
+ * of the connection. If rg is set, only its readers are considered. */
+UA_Boolean
+UA_ReaderGroup_processIndexed(UA_PubSubManager *psm, UA_PubSubConnection *c,
+                              UA_ReaderGroup *rg, UA_NetworkMessage *nm);
+
 /* The buffer is the entire message. The ctx->pos points after the decoded
  * header. The ctx->end is modified to remove padding, etc. */
 UA_StatusCode
@@ -102,6 +102,91 @@ UA_PublisherId_toVariant(const UA_PublisherId *p, UA_Variant *dst) {
     }
 }
 
+void
+UA_PubSubExternalValue_bind(UA_Server *server, UA_PubSubExternalValue *ev,
+                            const UA_NodeId *nodeId, UA_UInt32 attributeId,
+                            const UA_String *indexRange,
+                            const UA_FieldMetaData *writeField) {
+    memset(ev, 0, sizeof(UA_PubSubExternalValue));
+    if(attributeId != UA_ATTRIBUTEID_VALUE || indexRange->length > 0)
+        return;
+#ifdef UA_ENABLE_HISTORIZING
+    /* Every write has to reach the history database */
+    if(writeField && server->config.historyDatabase.setValue)
+        return;
+#endif
+    const UA_Node *node = UA_NODESTORE_GET(server, nodeId);
+    if(!node)
+        return;
+    const UA_VariableNode *vn = &node->variableNode;
+    if(node->head.nodeClass != UA_NODECLASS_VARIABLE ||
+       vn->valueBackend.backendType != UA_VALUEBACKENDTYPE_EXTERNAL)
+        goto release;
+
+    /* The type checks of the Write-Service are only done once here. The
+     * userWrite callback expects the value after the checks of the
+     * Write-Service. */
+    if(writeField &&
+       (vn->valueBackend.backend.external.callback.userWrite ||
+        !UA_NodeId_equal(&writeField->dataType, &vn->dataType) ||
+        !compatibleValueRanks(writeField->valueRank, vn->valueRank)))
+        goto release;
+
+    ev->value = vn->valueBackend.backend.external.value;
+    ev->callback = vn->valueBackend.backend.external.callback;
+    ev->nodeContext = node->head.context;
+    ev->isDynamic = vn->isDynamic;
+
+ release:
+    UA_NODESTORE_RELEASE(server, node);
+}
+
+UA_StatusCode
+UA_PubSubExternalValue_read(UA_Server *server, const UA_PubSubExternalValue *ev,
+                            const UA_NodeId *nodeId, UA_DataValue *value) {
+    UA_assert(ev->value);
+    UA_Session *session = &server->adminSession;
+    if(ev->callback.notificationRead) {
+        UA_StatusCode res =
+            ev->callback.notificationRead(server, &session->sessionId,
+                                          session->context, nodeId,
+                                          ev->nodeContext, NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+
+    /* Borrow the variant content */
+    *value = **ev->value;
+    value->value.storageType = UA_VARIANT_DATA_NODELETE;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_Boolean
+UA_PubSubExternalValue_write(const UA_PubSubExternalValue *ev,
+                             const UA_DataValue *value) {
+    UA_assert(ev->value);
+    UA_DataValue *dst = *ev->value;
+    const UA_Variant *src = &value->value;
+    if(!dst || dst->value.type != src->type || !src->type ||
+       !src->type->pointerFree || dst->value.arrayLength != src->arrayLength ||
+       UA_Variant_isScalar(&dst->value) != UA_Variant_isScalar(src) ||
+       dst->value.data <= UA_EMPTY_ARRAY_SENTINEL)
+        return false;
+
+    size_t length = UA_Variant_isScalar(src) ? 1 : src->arrayLength;
+    memcpy(dst->value.data, src->data, length * src->type->memSize);
+    UA_Variant v = dst->value;
+    *dst = *value;
+    dst->value = v;
+
+    /* As in the Write-Service */
+    if(!ev->isDynamic) {
+        dst->hasSourceTimestamp = false;
+        dst->hasSourcePicoseconds = false;
+    }
+    return true;
+}
+
 UA_ConnectionManager *
 getCM(UA_EventLoop *el, UA_String protocol) {
     for(UA_EventSource *es = el->eventSources; es != NULL; es = es->next) {
@@ -17,10 +17,10 @@
 #include "ua_pubsub_networkmessage.h"
 
 static UA_Boolean
-publisherIdIsMatching(UA_NetworkMessage *msg, UA_PublisherId *idB) {
+publisherIdIsMatching(const UA_NetworkMessage *msg, const UA_PublisherId *idB) {
     if(!msg->publisherIdEnabled)
         return true;
-    UA_PublisherId *idA = &msg->publisherId;
+    const UA_PublisherId *idA = &msg->publisherId;
     if(idA->idType != idB->idType)
         return false;
     switch(idA->idType) {
@@ -101,6 +101,137 @@ UA_DataSetReader_checkIdentifier(UA_PubSubManager *psm, UA_DataSetReader *dsr,
     return UA_STATUSCODE_GOOD;
 }
 
+/****************/
+/* Reader Index */
+/****************/
+
+static UA_UInt32
+readerIndexHash(const UA_PublisherId *p, UA_UInt16 writerGroupId,
+                UA_UInt16 dataSetWriterId) {
+    UA_UInt32 h = (UA_UInt32)p->idType;
+    switch(p->idType) {
+    case UA_PUBLISHERIDTYPE_BYTE:
+        h = UA_ByteString_hash(h, &p->id.byte, 1); break;
+    case UA_PUBLISHERIDTYPE_UINT16:
+        h = UA_ByteString_hash(h, (const UA_Byte*)&p->id.uint16, 2); break;
+    case UA_PUBLISHERIDTYPE_UINT32:
+        h = UA_ByteString_hash(h, (const UA_Byte*)&p->id.uint32, 4); break;
+    case UA_PUBLISHERIDTYPE_UINT64:
+        h = UA_ByteString_hash(h, (const UA_Byte*)&p->id.uint64, 8); break;
+    case UA_PUBLISHERIDTYPE_STRING:
+        h = UA_ByteString_hash(h, p->id.string.data, p->id.string.length); break;
+    default: break;
+    }
+    h = UA_ByteString_hash(h, (const UA_Byte*)&writerGroupId, 2);
+    return UA_ByteString_hash(h, (const UA_Byte*)&dataSetWriterId, 2);
+}
+
+static void
+readerIndexRebuild(UA_PubSubConnection *c) {
+    UA_ReaderIndex *ri = &c->readerIndex;
+    ri->dirty = false;
+
+    /* Count the enabled readers */
+    size_t count = 0;
+    UA_ReaderGroup *rg;
+    UA_DataSetReader *dsr;
+    LIST_FOREACH(rg, &c->readerGroups, listEntry) {
+        if(rg->config.encodingMimeType != UA_PUBSUB_ENCODING_UADP)
+            continue;
+        LIST_FOREACH(dsr, &rg->readers, listEntry) {
+            if(UA_PubSubState_isEnabled(dsr->head.state))
+                count++;
+        }
+    }
+
+    /* Keep the table at most half full */
+    size_t size = 8;
+    while(size < 2 * count)
+        size <<= 1;
+    if(size != ri->entriesSize) {
+        UA_free(ri->entries);
+        ri->entries = (UA_ReaderIndexEntry*)
+            UA_calloc(size, sizeof(UA_ReaderIndexEntry));
+        ri->entriesSize = (ri->entries) ? size : 0;
+        if(!ri->entries)
+            return; /* Fall back to the linear search */
+    } else {
+        memset(ri->entries, 0, size * sizeof(UA_ReaderIndexEntry));
+    }
+
+    /* Insert */
+    size_t mask = size - 1;
+    LIST_FOREACH(rg, &c->readerGroups, listEntry) {
+        if(rg->config.encodingMimeType != UA_PUBSUB_ENCODING_UADP)
+            continue;
+        LIST_FOREACH(dsr, &rg->readers, listEntry) {
+            if(!UA_PubSubState_isEnabled(dsr->head.state))
+                continue;
+            UA_UInt32 hash = readerIndexHash(&dsr->config.publisherId,
+                                             dsr->config.writerGroupId,
+                                             dsr->config.dataSetWriterId);
+            size_t pos = hash & mask;
+            while(ri->entries[pos].dsr)
+                pos = (pos + 1) & mask;
+            ri->entries[pos].hash = hash;
+            ri->entries[pos].dsr = dsr;
+        }
+    }
+}
+
+/* Replace with a tombstone. So the entry is never accessed before the next
+ * rebuild of the index. */
+static void
+readerIndexRemove(UA_ReaderIndex *ri, UA_DataSetReader *dsr) {
+    for(size_t i = 0; i < ri->entriesSize; i++) {
+        if(ri->entries[i].dsr == dsr)
+            ri->entries[i].removed = true;
+    }
+    ri->dirty = true;
+}
+
+UA_Boolean
+UA_ReaderIndex_canLookup(UA_PubSubConnection *c, const UA_NetworkMessage *nm) {
+    if(!nm->publisherIdEnabled || !nm->groupHeaderEnabled ||
+       !nm->groupHeader.writerGroupIdEnabled || !nm->payloadHeaderEnabled)
+        return false;
+    if(c->readerIndex.dirty || !c->readerIndex.entries)
+        readerIndexRebuild(c);
+    return (c->readerIndex.entries != NULL);
+}
+
+UA_DataSetReader *
+UA_ReaderIndex_next(UA_PubSubConnection *c, const UA_NetworkMessage *nm,
+                    UA_UInt16 dataSetWriterId, size_t *iter) {
+    UA_ReaderIndex *ri = &c->readerIndex;
+    UA_UInt16 writerGroupId = nm->groupHeader.writerGroupId;
+    UA_UInt32 hash = readerIndexHash(&nm->publisherId, writerGroupId,
+                                     dataSetWriterId);
+    size_t mask = ri->entriesSize - 1;
+    for(size_t i = *iter; i < ri->entriesSize; i++) {
+        UA_ReaderIndexEntry *e = &ri->entries[(hash + i) & mask];
+        if(!e->dsr)
+            break; /* Empty entry -> end of the probing sequence */
+        if(e->removed || e->hash != hash)
+            continue;
+        UA_DataSetReader *dsr = e->dsr;
+        if(dsr->config.writerGroupId != writerGroupId ||
+           dsr->config.dataSetWriterId != dataSetWriterId ||
+           !publisherIdIsMatching(nm, &dsr->config.publisherId))
+            continue;
+        *iter = i + 1;
+        return dsr;
+    }
+    *iter = ri->entriesSize;
+    return NULL;
+}
+
+void
+UA_ReaderIndex_clear(UA_ReaderIndex *ri) {
+    UA_free(ri->entries);
+    memset(ri, 0, sizeof(UA_ReaderIndex));
+}
+
 UA_DataSetReader *
 UA_DataSetReader_find(UA_PubSubManager *psm, const UA_NodeId id) {
     if(!psm)
@@ -281,6 +412,7 @@ UA_DataSetReader_remove(UA_PubSubManager *psm, UA_DataSetReader *dsr) {
         sds->connectedReader = NULL;
 
     /* Remove DataSetReader from group */
+    readerIndexRemove(&rg->linkedConnection->readerIndex, dsr);
     LIST_REMOVE(dsr, listEntry);
     rg->readersCount--;
 
@@ -335,6 +467,86 @@ UA_DataSetReaderConfig_clear(UA_DataSetReaderConfig *cfg) {
     }
 }
 
+static void
+DataSetReader_bindExternalValues(UA_PubSubManager *psm, UA_DataSetReader *dsr) {
+    UA_TargetVariablesDataType *tvs = &dsr->config.subscribedDataSet.target;
+    if(tvs->targetVariablesSize == 0)
+        return;
+    dsr->externalValues = (UA_PubSubExternalValue*)
+        UA_calloc(tvs->targetVariablesSize, sizeof(UA_PubSubExternalValue));
+    if(!dsr->externalValues)
+        return; /* Fall back to the Write-Service */
+    UA_DataSetMetaDataType *md = &dsr->config.dataSetMetaData;
+    for(size_t i = 0; i < tvs->targetVariablesSize && i < md->fieldsSize; i++) {
+        UA_FieldTargetDataType *tv = &tvs->targetVariables[i];
+        UA_PubSubExternalValue_bind(psm->sc.server, &dsr->externalValues[i],
+                                    &tv->targetNodeId, tv->attributeId,
+                                    &tv->receiverIndexRange, &md->fields[i]);
+    }
+}
+
+static void
+DataSetReader_clearRawDecodePlan(UA_DataSetReader *dsr) {
+    UA_free(dsr->rawDecodePlan.fields);
+    UA_free(dsr->rawDecodePlan.buffer);
+    memset(&dsr->rawDecodePlan, 0, sizeof(UA_RawDecodePlan));
+}
+
+/* Resolve the DataTypes and sizes of the fields for the decoding of RAW
+ * DataSetMessages. The DataSetMetaData does not change while the reader is
+ * enabled. */
+static UA_StatusCode
+DataSetReader_compileRawDecodePlan(UA_PubSubManager *psm, UA_DataSetReader *dsr) {
+    const UA_DataSetMetaDataType *md = &dsr->config.dataSetMetaData;
+    UA_RawDecodePlan *plan = &dsr->rawDecodePlan;
+    if(md->fieldsSize != dsr->config.subscribedDataSet.target.targetVariablesSize)
+        return UA_STATUSCODE_BADCONFIGURATIONERROR;
+    if(md->fieldsSize == 0)
+        return UA_STATUSCODE_GOOD;
+
+    plan->fields = (UA_RawDecodeField*)
+        UA_calloc(md->fieldsSize, sizeof(UA_RawDecodeField));
+    if(!plan->fields)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    plan->fieldsSize = md->fieldsSize;
+
+    size_t bufferSize = 0;
+    for(size_t i = 0; i < md->fieldsSize; i++) {
+        const UA_FieldMetaData *fmd = &md->fields[i];
+        UA_RawDecodeField *f = &plan->fields[i];
+        f->type = UA_findDataTypeWithCustom(&fmd->dataType,
+                                            psm->sc.server->config.customDataTypes);
+        if(!f->type)
+            return UA_STATUSCODE_BADDATATYPEIDUNKNOWN;
+
+        /* Every array dimension is encoded before the actual data */
+        f->valueRank = (fmd->valueRank > 0) ? fmd->valueRank : 0;
+        if(f->valueRank > 0 && fmd->arrayDimensionsSize != (size_t)f->valueRank)
+            return UA_STATUSCODE_BADCONFIGURATIONERROR;
+        f->arrayDimensions = fmd->arrayDimensions;
+        f->elementCount = 1;
+        for(UA_Int32 d = 0; d < f->valueRank; d++) {
+            if(fmd->arrayDimensions[d] > 0 &&
+               f->elementCount > SIZE_MAX / f->type->memSize / fmd->arrayDimensions[d])
+                return UA_STATUSCODE_BADCONFIGURATIONERROR;
+            f->elementCount *= fmd->arrayDimensions[d];
+        }
+
+        /* Overlayable values are copied from the buffer with a single memcpy */
+        if(f->type->overlayable)
+            f->encodedSize = f->elementCount * f->type->memSize;
+        f->maxStringLength = fmd->maxStringLength;
+
+        size_t fieldSize = f->elementCount * f->type->memSize;
+        if(fieldSize > bufferSize)
+            bufferSize = fieldSize;
+    }
+
+    /* Reuse the buffer for all fields. The values are copied on write. */
+    plan->buffer = (UA_Byte*)UA_calloc(1, (bufferSize > 0) ? bufferSize : 1);
+    return (plan->buffer) ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADOUTOFMEMORY;
+}
+
 void
 UA_DataSetReader_setPubSubState(UA_PubSubManager *psm, UA_DataSetReader *dsr,
                                 UA_PubSubState targetState,
@@ -390,6 +602,29 @@ UA_DataSetReader_setPubSubState(UA_PubSubManager *psm, UA_DataSetReader *dsr,
 
  finalize_state_machine:
 
+    /* The reader index contains the enabled readers */
+    if(UA_PubSubState_isEnabled(dsr->head.state) != UA_PubSubState_isEnabled(oldState))
+        rg->linkedConnection->readerIndex.dirty = true;
+
+    /* Bind the TargetVariables to application-owned values while enabled. The
+     * TargetVariables cannot change in that time. */
+    if(UA_PubSubState_isEnabled(dsr->head.state)) {
+        if(!dsr->externalValues)
+            DataSetReader_bindExternalValues(psm, dsr);
+        if(!UA_PubSubState_isEnabled(oldState) || !dsr->rawDecodePlan.fields) {
+            DataSetReader_clearRawDecodePlan(dsr);
+            UA_StatusCode planRes = DataSetReader_compileRawDecodePlan(psm, dsr);
+            if(planRes != UA_STATUSCODE_GOOD) {
+                DataSetReader_clearRawDecodePlan(dsr);
+                dsr->rawDecodePlan.res = planRes;
+            }
+        }
+    } else {
+        UA_free(dsr->externalValues);
+        dsr->externalValues = NULL;
+        DataSetReader_clearRawDecodePlan(dsr);
+    }
+
     /* Inform application about state change */
     if(dsr->head.state != oldState) {
         UA_LOG_INFO_PUBSUB(psm->logging, dsr, "%s -> %s",
@@ -429,78 +664,92 @@ DataSetReader_createTargetVariables(UA_PubSubManager *psm, UA_DataSetReader *dsr
     return UA_STATUSCODE_GOOD;
 }
 
+static void
+clearDecodedValues(UA_Byte *values, size_t count, const UA_DataType *type) {
+    if(type->pointerFree)
+        return;
+    for(size_t i = 0; i < count; i++) {
+        UA_clear(values, type);
+        values += type->memSize;
+    }
+}
+
 static void
 DataSetReader_processRaw(UA_PubSubManager *psm, UA_DataSetReader *dsr,
                          UA_DataSetMessage* msg) {
     UA_LOG_TRACE_PUBSUB(psm->logging, dsr, "Received RAW Frame");
 
-    if(dsr->config.dataSetMetaData.fieldsSize !=
-       dsr->config.subscribedDataSet.target.targetVariablesSize) {
-        UA_LOG_ERROR_PUBSUB(psm->logging, dsr, "Inconsistent number of fields configured");
+    const UA_RawDecodePlan *plan = &dsr->rawDecodePlan;
+    if(plan->res != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR_PUBSUB(psm->logging, dsr, "Cannot decode RAW DataSetMessages "
+                            "with the configured DataSetMetaData: %s",
+                            UA_StatusCode_name(plan->res));
         return;
     }
 
-    msg->data.keyFrameData.fieldCount = (UA_UInt16)
-        dsr->config.dataSetMetaData.fieldsSize;
+    msg->data.keyFrameData.fieldCount = (UA_UInt16)plan->fieldsSize;
 
-    /* Start iteration from beginning of rawFields buffer */
+    /* Unpack the fields in a single pass over the rawFields buffer */
     size_t offset = 0;
+    const UA_ByteString *raw = &msg->data.keyFrameData.rawFields;
     UA_TargetVariablesDataType *tvs = &dsr->config.subscribedDataSet.target;
-    for(size_t i = 0; i < tvs->targetVariablesSize ; i++) {
+    for(size_t i = 0; i < plan->fieldsSize; i++) {
+        const UA_RawDecodeField *f = &plan->fields[i];
         UA_FieldTargetDataType *tv = &tvs->targetVariables[i];
 
-        /* TODO The datatype reference should be part of the internal
-         * pubsub configuration to avoid the time-expensive lookup */
-        const UA_DataType *type =
-            UA_findDataTypeWithCustom(&dsr->config.dataSetMetaData.fields[i].dataType,
-                                      psm->sc.server->config.customDataTypes);
-        if(!type) {
-            UA_LOG_ERROR_PUBSUB(psm->logging, dsr, "Type not found");
-            return;
-        }
-
         /* For arrays the length of the array is encoded before the actual data */
-        size_t elementCount = 1;
-        for(int cnt = 0; cnt < dsr->config.dataSetMetaData.fields[i].valueRank; cnt++) {
-            UA_UInt32 dimSize =
-                *(UA_UInt32 *)&msg->data.keyFrameData.rawFields.data[offset];
-            if(dimSize != dsr->config.dataSetMetaData.fields[i].arrayDimensions[cnt]) {
+        UA_StatusCode res = UA_STATUSCODE_GOOD;
+        for(UA_Int32 cnt = 0; cnt < f->valueRank; cnt++) {
+            UA_UInt32 dimSize = 0;
+            res = UA_decodeBinaryInternal(raw, &offset, &dimSize,
+                                          &UA_TYPES[UA_TYPES_UINT32], NULL);
+            if(res != UA_STATUSCODE_GOOD || dimSize != f->arrayDimensions[cnt]) {
                 UA_LOG_INFO_PUBSUB(psm->logging, dsr,
                                    "Error during Raw-decode KeyFrame field %u: "
                                    "Dimension size in received data doesn't match the dataSetMetaData",
                                    (unsigned)i);
                 return;
             }
-            offset += sizeof(UA_UInt32);
-            elementCount *= dimSize;
         }
 
         /* Decode the value */
-        UA_STACKARRAY(UA_Byte, value, elementCount * type->memSize);
-        memset(value, 0, elementCount * type->memSize);
-        UA_Byte *valPtr = value;
-        UA_StatusCode res = UA_STATUSCODE_GOOD;
-        for(size_t cnt = 0; cnt < elementCount; cnt++) {
-            res = UA_decodeBinaryInternal(&msg->data.keyFrameData.rawFields,
-                                          &offset, valPtr, type, NULL);
-            if(dsr->config.dataSetMetaData.fields[i].maxStringLength != 0) {
-                if(type->typeKind == UA_DATATYPEKIND_STRING ||
-                   type->typeKind == UA_DATATYPEKIND_BYTESTRING) {
-                    UA_ByteString *bs = (UA_ByteString *)valPtr;
-                    /* Check if length < maxStringLength, The types ByteString and
-                     * String are equal in their base definition */
-                    size_t lengthDifference =
-                        dsr->config.dataSetMetaData.fields[i].maxStringLength - bs->length;
-                    offset += lengthDifference;
-                }
-            }
-            if(res != UA_STATUSCODE_GOOD) {
+        UA_Byte *valPtr = plan->buffer;
+        if(f->encodedSize > 0) {
+            /* Fast path for overlayable types */
+            if(offset + f->encodedSize > raw->length) {
                 UA_LOG_INFO_PUBSUB(psm->logging, dsr,
                                    "Error during Raw-decode KeyFrame field %u: %s",
-                                   (unsigned)i, UA_StatusCode_name(res));
+                                   (unsigned)i,
+                                   UA_StatusCode_name(UA_STATUSCODE_BADDECODINGERROR));
                 return;
             }
-            valPtr += type->memSize;
+            memcpy(valPtr, &raw->data[offset], f->encodedSize);
+            offset += f->encodedSize;
+        } else {
+            memset(valPtr, 0, f->elementCount * f->type->memSize);
+            for(size_t cnt = 0; cnt < f->elementCount; cnt++) {
+                res = UA_decodeBinaryInternal(raw, &offset, valPtr, f->type, NULL);
+                if(res == UA_STATUSCODE_GOOD && f->maxStringLength != 0 &&
+                   (f->type->typeKind == UA_DATATYPEKIND_STRING ||
+                    f->type->typeKind == UA_DATATYPEKIND_BYTESTRING)) {
+                    /* Skip the padding up to maxStringLength. The types
+                     * ByteString and String are equal in their base
+                     * definition. */
+                    UA_ByteString *bs = (UA_ByteString *)valPtr;
+                    if(bs->length <= f->maxStringLength)
+                        offset += f->maxStringLength - bs->length;
+                    else
+                        res = UA_STATUSCODE_BADDECODINGERROR;
+                }
+                valPtr += f->type->memSize;
+                if(res != UA_STATUSCODE_GOOD) {
+                    UA_LOG_INFO_PUBSUB(psm->logging, dsr,
+                                       "Error during Raw-decode KeyFrame field %u: %s",
+                                       (unsigned)i, UA_StatusCode_name(res));
+                    clearDecodedValues(plan->buffer, cnt + 1, f->type);
+                    return;
+                }
+            }
         }
 
         /* Write the value */
@@ -509,13 +758,18 @@ DataSetReader_processRaw(UA_PubSubManager *psm, UA_DataSetReader *dsr,
         writeVal.attributeId = tv->attributeId;
         writeVal.indexRange = tv->receiverIndexRange;
         writeVal.nodeId = tv->targetNodeId;
-        if(dsr->config.dataSetMetaData.fields[i].valueRank > 0) {
-            UA_Variant_setArray(&writeVal.value.value, value, elementCount, type);
+        if(f->valueRank > 0) {
+            UA_Variant_setArray(&writeVal.value.value, plan->buffer,
+                                f->elementCount, f->type);
         } else {
-            UA_Variant_setScalar(&writeVal.value.value, value, type);
+            UA_Variant_setScalar(&writeVal.value.value, plan->buffer, f->type);
         }
         writeVal.value.hasValue = true;
-        Operation_Write(psm->sc.server, &psm->sc.server->adminSession, NULL, &writeVal, &res);
+        res = UA_STATUSCODE_GOOD;
+        if(!dsr->externalValues || !dsr->externalValues[i].value ||
+           !UA_PubSubExternalValue_write(&dsr->externalValues[i], &writeVal.value))
+            Operation_Write(psm->sc.server, &psm->sc.server->adminSession,
+                            NULL, &writeVal, &res);
         if(res != UA_STATUSCODE_GOOD) {
             UA_LOG_WARNING_PUBSUB(psm->logging, dsr,
                                   "Error writing KeyFrame field %u: %s",
@@ -523,13 +777,7 @@ DataSetReader_processRaw(UA_PubSubManager *psm, UA_DataSetReader *dsr,
         }
 
         /* Clean up if string-type (with mallocs) was used */
-        if(!type->pointerFree) {
-            valPtr = value;
-            for(size_t cnt = 0; cnt < elementCount; cnt++) {
-                UA_clear(value, type);
-                valPtr += type->memSize;
-            }
-        }
+        clearDecodedValues(plan->buffer, f->elementCount, f->type);
     }
 }
 
@@ -645,6 +893,11 @@ UA_DataSetReader_process(UA_PubSubManager *psm, UA_DataSetReader *dsr,
         if(!field->hasValue)
             continue;
 
+        /* Write directly into the application memory */
+        if(dsr->externalValues && dsr->externalValues[i].value &&
+           UA_PubSubExternalValue_write(&dsr->externalValues[i], field))
+            continue;
+
         /* Write via the Write-Service */
         UA_WriteValue writeVal;
         UA_WriteValue_init(&writeVal);
@@ -361,6 +361,40 @@ UA_ReaderGroup_setEncryptionKeys(UA_PubSubManager *psm, UA_ReaderGroup *rg,
                         &encryptingKey, &keyNonce);
 }
 
+UA_Boolean
+UA_ReaderGroup_processIndexed(UA_PubSubManager *psm, UA_PubSubConnection *c,
+                              UA_ReaderGroup *rg, UA_NetworkMessage *nm) {
+    UA_Boolean processed = false;
+    for(size_t i = 0; i < nm->payload.dataSetPayload.dataSetMessagesSize; i++) {
+        UA_DataSetMessage *dsm = &nm->payload.dataSetPayload.dataSetMessages[i];
+        size_t iter = 0;
+        UA_DataSetReader *reader;
+        while((reader = UA_ReaderIndex_next(c, nm, dsm->dataSetWriterId, &iter))) {
+            UA_ReaderGroup *readerRg = reader->linkedReaderGroup;
+            if(rg && readerRg != rg)
+                continue;
+
+            /* Check if the ReaderGroup and the Reader are enabled */
+            if(readerRg->head.state != UA_PUBSUBSTATE_OPERATIONAL &&
+               readerRg->head.state != UA_PUBSUBSTATE_PREOPERATIONAL)
+                continue;
+            if(reader->head.state != UA_PUBSUBSTATE_OPERATIONAL &&
+               reader->head.state != UA_PUBSUBSTATE_PREOPERATIONAL)
+                continue;
+
+            /* Update the ReaderGroup state if this is the first received message */
+            if(!readerRg->hasReceived) {
+                readerRg->hasReceived = true;
+                UA_ReaderGroup_setPubSubState(psm, readerRg, readerRg->head.state);
+            }
+
+            processed = true;
+            UA_DataSetReader_process(psm, reader, dsm);
+        }
+    }
+    return processed;
+}
+
 UA_Boolean
 UA_ReaderGroup_process(UA_PubSubManager *psm, UA_ReaderGroup *rg,
                        UA_NetworkMessage *nm) {
@@ -369,6 +403,10 @@ UA_ReaderGroup_process(UA_PubSubManager *psm, UA_ReaderGroup *rg,
        rg->head.state != UA_PUBSUBSTATE_PREOPERATIONAL)
         return false;
 
+    /* Dispatch with the reader index */
+    if(UA_ReaderIndex_canLookup(rg->linkedConnection, nm))
+        return UA_ReaderGroup_processIndexed(psm, rg->linkedConnection, rg, nm);
+
     /* Set to operational if required */
     rg->hasReceived = true;
     UA_ReaderGroup_setPubSubState(psm, rg, rg->head.state);
@@ -58,14 +58,27 @@ UA_DataSetWriterConfig_clear(UA_DataSetWriterConfig *pdsConfig) {
 }
 
 static void
-UA_DataSetWriter_freezeConfiguration(UA_DataSetWriter *dsw) {
+UA_DataSetWriter_freezeConfiguration(UA_PubSubManager *psm, UA_DataSetWriter *dsw) {
     if(dsw->configurationFrozen)
         return;
     dsw->configurationFrozen = true;
     UA_PublishedDataSet *pds = dsw->connectedDataSet;
     if(!pds) /* Skip for heartbeat writers */
         return;
-    pds->configurationFreezeCounter++;
+    if(pds->configurationFreezeCounter++ > 0)
+        return;
+
+    /* Bind the fields to application-owned values. The fields cannot change
+     * while the PDS is frozen. */
+    UA_DataSetField *dsf;
+    TAILQ_FOREACH(dsf, &pds->fields, listEntry) {
+        UA_PublishedVariableDataType *params =
+            &dsf->config.field.variable.publishParameters;
+        UA_PubSubExternalValue_bind(psm->sc.server, &dsf->externalValue,
+                                    &params->publishedVariable,
+                                    params->attributeId, &params->indexRange,
+                                    NULL);
+    }
 }
 
 static void
@@ -76,7 +89,13 @@ UA_DataSetWriter_unfreezeConfiguration(UA_DataSetWriter *dsw) {
     UA_PublishedDataSet *pds = dsw->connectedDataSet;
     if(!pds) /* Skip for heartbeat writers */
         return;
-    pds->configurationFreezeCounter--;
+    if(--pds->configurationFreezeCounter > 0)
+        return;
+
+    UA_DataSetField *dsf;
+    TAILQ_FOREACH(dsf, &pds->fields, listEntry) {
+        memset(&dsf->externalValue, 0, sizeof(UA_PubSubExternalValue));
+    }
 }
 
 UA_StatusCode
@@ -88,6 +107,12 @@ UA_DataSetWriter_setPubSubState(UA_PubSubManager *psm, UA_DataSetWriter *dsw,
     UA_WriterGroup *wg = dsw->linkedWriterGroup;
     UA_assert(wg);
 
+    if(dsw->deleteFlag && targetState != UA_PUBSUBSTATE_DISABLED) {
+        UA_LOG_WARNING_PUBSUB(psm->logging, dsw,
+                              "The DataSetWriter is being deleted. Can only be disabled.");
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
     /* Custom state machine */
     if(dsw->config.customStateMachine) {
         res = dsw->config.customStateMachine(server, dsw->head.identifier, dsw->config.context,
@@ -96,7 +121,7 @@ UA_DataSetWriter_setPubSubState(UA_PubSubManager *psm, UA_DataSetWriter *dsw,
            dsw->head.state == UA_PUBSUBSTATE_ERROR)
             UA_DataSetWriter_unfreezeConfiguration(dsw);
         else
-            UA_DataSetWriter_freezeConfiguration(dsw);
+            UA_DataSetWriter_freezeConfiguration(psm, dsw);
         goto finalize_state_machine;
     }
 
@@ -120,7 +145,7 @@ UA_DataSetWriter_setPubSubState(UA_PubSubManager *psm, UA_DataSetWriter *dsw,
         } else {
             dsw->head.state = wg->head.state; /* WG is enabled -> same state */
         }
-        UA_DataSetWriter_freezeConfiguration(dsw);
+        UA_DataSetWriter_freezeConfiguration(psm, dsw);
         break;
 
     default:
@@ -134,6 +159,9 @@ UA_DataSetWriter_setPubSubState(UA_PubSubManager *psm, UA_DataSetWriter *dsw,
 
     /* Inform application about state change */
     if(dsw->head.state != oldState) {
+        /* The frozen NetworkMessage depends on the set of operational writers */
+        UA_WriterGroup_thawNetworkMessage(wg);
+        wg->frozen.failed = false;
         UA_LOG_INFO_PUBSUB(psm->logging, dsw, "%s -> %s",
                            UA_PubSubState_name(oldState),
                            UA_PubSubState_name(dsw->head.state));
@@ -262,8 +290,10 @@ UA_DataSetWriter_remove(UA_PubSubManager *psm, UA_DataSetWriter *dsw) {
     UA_WriterGroup *wg = dsw->linkedWriterGroup;
     UA_assert(wg);
 
-    /* Check if the WriterGroup is enabled. Disallow removal in that case. */
-    if(UA_PubSubState_isEnabled(wg->head.state)) {
+    /* Check if the WriterGroup is enabled. Disallow removal in that case. A
+     * deferred removal is completed even if the WriterGroup was re-enabled in
+     * the meantime. */
+    if(UA_PubSubState_isEnabled(wg->head.state) && !dsw->deleteFlag) {
         UA_LOG_WARNING_PUBSUB(psm->logging, dsw,
                               "Removal of DataSetWriter not possible while "
                               "the WriterGroup with realtime options is enabled");
@@ -273,6 +303,17 @@ UA_DataSetWriter_remove(UA_PubSubManager *psm, UA_DataSetWriter *dsw) {
     /* Disable and signal to the application */
     UA_DataSetWriter_setPubSubState(psm, dsw, UA_PUBSUBSTATE_DISABLED);
 
+#if UA_MULTITHREADING >= 100
+    /* A publisher thread still sends the last cycle of the WriterGroup. The
+     * removal is completed by the publisher thread afterwards. The
+     * PublishedDataSet might be removed before that. */
+    if(wg->publishing) {
+        dsw->deleteFlag = true;
+        dsw->connectedDataSet = NULL;
+        return UA_STATUSCODE_GOOD;
+    }
+#endif
+
     /* Remove from information model */
 #ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
     deleteNode(psm->sc.server, dsw->head.identifier, true);
@@ -358,6 +399,31 @@ valueChangedVariant(UA_Variant *oldValue, UA_Variant *newValue) {
     return compareResult;
 }
 
+void
+UA_DataSetWriter_sampleField(UA_PubSubManager *psm, UA_DataSetWriter *dsw,
+                             UA_DataSetField *dsf, UA_DataValue *dfv) {
+    UA_PubSubDataSetField_sampleValue(psm, dsf, dfv);
+
+    /* Deactivate statuscode? */
+    if(((u64)dsw->config.dataSetFieldContentMask &
+        (u64)UA_DATASETFIELDCONTENTMASK_STATUSCODE) == 0)
+        dfv->hasStatus = false;
+
+    /* Deactivate timestamps */
+    if(((u64)dsw->config.dataSetFieldContentMask &
+        (u64)UA_DATASETFIELDCONTENTMASK_SOURCETIMESTAMP) == 0)
+        dfv->hasSourceTimestamp = false;
+    if(((u64)dsw->config.dataSetFieldContentMask &
+        (u64)UA_DATASETFIELDCONTENTMASK_SOURCEPICOSECONDS) == 0)
+        dfv->hasSourcePicoseconds = false;
+    if(((u64)dsw->config.dataSetFieldContentMask &
+        (u64)UA_DATASETFIELDCONTENTMASK_SERVERTIMESTAMP) == 0)
+        dfv->hasServerTimestamp = false;
+    if(((u64)dsw->config.dataSetFieldContentMask &
+        (u64)UA_DATASETFIELDCONTENTMASK_SERVERPICOSECONDS) == 0)
+        dfv->hasServerPicoseconds = false;
+}
+
 static UA_StatusCode
 UA_PubSubDataSetWriter_generateKeyFrameMessage(UA_PubSubManager *psm,
                                                UA_DataSetMessage *dataSetMessage,
@@ -397,26 +463,7 @@ UA_PubSubDataSetWriter_generateKeyFrameMessage(UA_PubSubManager *psm,
 
         /* Sample the value */
         UA_DataValue *dfv = &dataSetMessage->data.keyFrameData.dataSetFields[counter];
-        UA_PubSubDataSetField_sampleValue(psm, dsf, dfv);
-
-        /* Deactivate statuscode? */
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_STATUSCODE) == 0)
-            dfv->hasStatus = false;
-
-        /* Deactivate timestamps */
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_SOURCETIMESTAMP) == 0)
-            dfv->hasSourceTimestamp = false;
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_SOURCEPICOSECONDS) == 0)
-            dfv->hasSourcePicoseconds = false;
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_SERVERTIMESTAMP) == 0)
-            dfv->hasServerTimestamp = false;
-        if(((u64)dsw->config.dataSetFieldContentMask &
-            (u64)UA_DATASETFIELDCONTENTMASK_SERVERPICOSECONDS) == 0)
-            dfv->hasServerPicoseconds = false;
+        UA_DataSetWriter_sampleField(psm, dsw, dsf, dfv);
 
         if(psm->sc.server->config.pubSubConfig.enableDeltaFrames) {
             /* Update lastValue store */
@@ -459,9 +506,13 @@ UA_PubSubDataSetWriter_generateDeltaFrameMessage(UA_PubSubManager *psm,
             dsm->data.deltaFrameData.fieldCount++;
             ls->valueChanged = true;
 
-            /* Update last stored sample */
+            /* Update last stored sample. Copy if the value is borrowed from
+             * the application memory. */
             UA_DataValue_clear(&ls->value);
-            ls->value = value;
+            if(value.value.storageType == UA_VARIANT_DATA_NODELETE)
+                UA_DataValue_copy(&value, &ls->value);
+            else
+                ls->value = value;
         } else {
             UA_DataValue_clear(&value);
             ls->valueChanged = false;
@@ -35,6 +35,9 @@ generateNetworkMessage(UA_PubSubConnection *connection, UA_WriterGroup *wg,
                        UA_ExtensionObject *transportSettings,
                        UA_NetworkMessage *networkMessage);
 
+static UA_StatusCode
+freezeNetworkMessage(UA_PubSubManager *psm, UA_WriterGroup *wg);
+
 static void
 UA_WriterGroup_disconnect(UA_WriterGroup *wg);
 
@@ -60,12 +63,29 @@ UA_StatusCode
 UA_WriterGroup_addPublishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
     UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
 
+    UA_EventLoop *el = psm->sc.server->config.eventLoop;
+
+#if UA_MULTITHREADING >= 100
+    /* Scheduled for a publisher thread of the application */
+    if(wg->config.publisherThread != 0) {
+        if(wg->config.publishingInterval <= 0.0)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        if(wg->nextPublish == 0) {
+            memset(&wg->statistics, 0, sizeof(UA_WriterGroupPublishStatistics));
+            wg->nextPublish = el->dateTime_nowMonotonic(el) + (UA_DateTime)
+                (wg->config.publishingInterval * UA_DATETIME_MSEC);
+        }
+        return UA_STATUSCODE_GOOD;
+    }
+#endif
+
     /* Already registered */
     if(wg->publishCallbackId != 0)
         return UA_STATUSCODE_GOOD;
 
     /* Use EventLoop for cyclic callbacks */
-    UA_EventLoop *el = psm->sc.server->config.eventLoop;
+    memset(&wg->statistics, 0, sizeof(UA_WriterGroupPublishStatistics));
+    wg->lastCycleStart = 0;
     return el->addTimer(el, (UA_Callback)UA_WriterGroup_publishCallback,
                         psm, wg, wg->config.publishingInterval,
                         NULL /* TODO: use basetime */,
@@ -75,6 +95,9 @@ UA_WriterGroup_addPublishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
 
 void
 UA_WriterGroup_removePublishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
+#if UA_MULTITHREADING >= 100
+    wg->nextPublish = 0;
+#endif
     if(wg->publishCallbackId == 0)
         return;
     UA_EventLoop *el = psm->sc.server->config.eventLoop;
@@ -119,11 +142,13 @@ UA_WriterGroup_create(UA_PubSubManager *psm, const UA_NodeId connection,
 
     newWriterGroup->head.componentType = UA_PUBSUBCOMPONENT_WRITERGROUP;
     newWriterGroup->linkedConnection = c;
+    UA_LOCK_INIT(&newWriterGroup->securityLock);
 
     /* Deep copy of the config */
     UA_WriterGroupConfig *newConfig = &newWriterGroup->config;
     UA_StatusCode res = UA_WriterGroupConfig_copy(writerGroupConfig, newConfig);
     if(res != UA_STATUSCODE_GOOD) {
+        UA_LOCK_DESTROY(&newWriterGroup->securityLock);
         UA_free(newWriterGroup);
         return res;
     }
@@ -227,6 +252,13 @@ UA_WriterGroup_remove(UA_PubSubManager *psm, UA_WriterGroup *wg) {
     wg->deleteFlag = true;
     UA_WriterGroup_setPubSubState(psm, wg, UA_PUBSUBSTATE_DISABLED);
 
+#if UA_MULTITHREADING >= 100
+    /* A publisher thread still encodes and sends without the server lock. The
+     * removal is completed by the publisher thread afterwards. */
+    if(wg->publishing)
+        return;
+#endif
+
     UA_DataSetWriter *dsw, *dsw_tmp;
     LIST_FOREACH_SAFE(dsw, &wg->writers, listEntry, dsw_tmp) {
         UA_DataSetWriter_remove(psm, dsw);
@@ -257,8 +289,10 @@ UA_WriterGroup_remove(UA_PubSubManager *psm, UA_WriterGroup *wg) {
 
         UA_LOG_INFO_PUBSUB(psm->logging, wg, "WriterGroup deleted");
 
+        UA_WriterGroup_thawNetworkMessage(wg);
         UA_WriterGroupConfig_clear(&wg->config);
         UA_PubSubComponentHead_clear(&wg->head);
+        UA_LOCK_DESTROY(&wg->securityLock);
         UA_free(wg);
     }
 
@@ -320,6 +354,11 @@ UA_WriterGroup_setEncryptionKeys(UA_PubSubManager *psm, UA_WriterGroup *wg,
         wg->nonceSequenceNumber = 1;
     }
 
+    /* The SecurityTokenId is part of the frozen NetworkMessage */
+    UA_WriterGroup_thawNetworkMessage(wg);
+
+    /* A publisher thread might be applying the message security */
+    UA_LOCK(&wg->securityLock);
     UA_StatusCode res = UA_STATUSCODE_BAD;
     if(!wg->securityPolicyContext) {
         /* Create a new context */
@@ -333,6 +372,7 @@ UA_WriterGroup_setEncryptionKeys(UA_PubSubManager *psm, UA_WriterGroup *wg,
             setSecurityKeys(wg->securityPolicyContext, &signingKey,
                             &encryptingKey, &keyNonce);
     }
+    UA_UNLOCK(&wg->securityLock);
 
     return (res == UA_STATUSCODE_GOOD) ?
         UA_WriterGroup_setPubSubState(psm, wg, wg->head.state) : res;
@@ -444,6 +484,12 @@ UA_WriterGroup_setPubSubState(UA_PubSubManager *psm, UA_WriterGroup *wg,
 
  finalize_state_machine:
 
+#if UA_MULTITHREADING >= 100
+    /* Detected by the publisher thread after sending without the lock */
+    if(wg->head.state != oldState)
+        wg->stateGeneration++;
+#endif
+
     /* Only the top-level state update (if recursive calls are happening)
      * notifies the application and updates Reader and WriterGroups */
     wg->head.transientState = isTransient;
@@ -452,6 +498,9 @@ UA_WriterGroup_setPubSubState(UA_PubSubManager *psm, UA_WriterGroup *wg,
 
     /* Inform the application about state change */
     if(wg->head.state != oldState) {
+        /* The frozen NetworkMessage is recreated for the new state */
+        UA_WriterGroup_thawNetworkMessage(wg);
+        wg->frozen.failed = false;
         UA_LOG_INFO_PUBSUB(psm->logging, wg, "%s -> %s",
                            UA_PubSubState_name(oldState),
                            UA_PubSubState_name(wg->head.state));
@@ -467,6 +516,12 @@ UA_WriterGroup_setPubSubState(UA_PubSubManager *psm, UA_WriterGroup *wg,
         UA_DataSetWriter_setPubSubState(psm, writer, writer->head.state);
     }
 
+    /* Freeze the NetworkMessage right away, so that this is not done in the
+     * first publish cycle */
+    if(wg->config.frozenNetworkMessage &&
+       wg->head.state == UA_PUBSUBSTATE_OPERATIONAL)
+        freezeNetworkMessage(psm, wg);
+
     /* Update the PubSubManager state. It will go from STOPPING to STOPPED when
      * the last socket has closed. */
     UA_PubSubManager_setState(psm, psm->sc.state);
@@ -535,82 +590,123 @@ encodeNetworkMessage(UA_WriterGroup *wg, UA_NetworkMessage *nm,
     return encryptAndSign(wg, nm, networkMessageStart, payloadStart, footerEnd);
 }
 
-static void
-sendNetworkMessageBuffer(UA_PubSubManager *psm, UA_WriterGroup *wg, 
-                         UA_PubSubConnection *connection, uintptr_t connectionId,
-                         UA_ByteString *buffer) {
-    UA_StatusCode res = connection->cm->
-        sendWithConnection(connection->cm, connectionId,
-                           &UA_KEYVALUEMAP_NULL, buffer);
+/* A NetworkMessage prepared with the server lock held. The encoding, the
+ * message security and the sending can then be done without the server lock.
+ * For the frozen NetworkMessage the buffer is already filled and only the
+ * message security remains. */
+typedef struct {
+    UA_NetworkMessage nm; /* References the DataSetMessages */
+    UA_ByteString buf;    /* Filled copy of the frozen NetworkMessage */
+    size_t payloadOffset; /* Start of the encryption in the frozen buffer */
+    size_t footerOffset;  /* Start of the signature in the frozen buffer */
+    UA_ConnectionManager *cm;
+    uintptr_t sendChannel;
+    UA_Boolean more; /* More NetworkMessages follow in this cycle */
+} UA_PreparedNetworkMessage;
 
-    /* Failure, set the WriterGroup into an error mode */
-    if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_ERROR_PUBSUB(psm->logging, wg,
-                            "Sending NetworkMessage failed");
-        UA_WriterGroup_setPubSubState(psm, wg, UA_PUBSUBSTATE_ERROR);
-        UA_PubSubConnection_setPubSubState(psm, connection, UA_PUBSUBSTATE_ERROR);
-        return;
+static UA_StatusCode
+selectSendChannel(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                  UA_PubSubConnection *connection,
+                  UA_PreparedNetworkMessage *pm) {
+    pm->cm = connection->cm;
+    if(!pm->cm)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* Select the wg sendchannel if configured */
+    pm->sendChannel = connection->sendChannel;
+    if(wg->sendChannel != 0)
+        pm->sendChannel = wg->sendChannel;
+    if(pm->sendChannel == 0) {
+        UA_LOG_ERROR_PUBSUB(psm->logging, wg, "Cannot send, no open connection");
+        return UA_STATUSCODE_BADINTERNALERROR;
     }
+    return UA_STATUSCODE_GOOD;
+}
 
-    /* Sending successful - increase the sequence number */
-    wg->sequenceNumber++;
+/* If more is set, the ConnectionManager may hold the buffer back and send it
+ * together with the following NetworkMessages of the same publish cycle. The
+ * buffer is consumed also in case of an error. */
+static UA_StatusCode
+sendNetworkMessageBuffer(UA_PreparedNetworkMessage *pm, UA_ByteString *buffer) {
+    UA_KeyValuePair kvp;
+    UA_KeyValueMap kvm = UA_KEYVALUEMAP_NULL;
+    if(pm->more) {
+        kvp.key = UA_QUALIFIEDNAME(0, "more");
+        UA_Variant_setScalar(&kvp.value, &pm->more, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        kvm.map = &kvp;
+        kvm.mapSize = 1;
+    }
+    return pm->cm->sendWithConnection(pm->cm, pm->sendChannel, &kvm, buffer);
+}
+
+static void
+flushNetworkMessages(UA_PreparedNetworkMessage *pm) {
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    UA_StatusCode res = pm->cm->allocNetworkBuffer(pm->cm, pm->sendChannel, &buf, 0);
+    if(res != UA_STATUSCODE_GOOD)
+        return;
+    pm->more = false;
+    sendNetworkMessageBuffer(pm, &buf);
 }
 
 #ifdef UA_ENABLE_JSON_ENCODING
-static UA_StatusCode
-sendNetworkMessageJson(UA_PubSubManager *psm, UA_PubSubConnection *connection, UA_WriterGroup *wg,
-                       UA_DataSetMessage *dsm, UA_UInt16 *writerIds, UA_Byte dsmCount) {
-    /* Prepare the NetworkMessage */
-    UA_NetworkMessage nm;
-    memset(&nm, 0, sizeof(UA_NetworkMessage));
-    nm.version = 1;
-    nm.networkMessageType = UA_NETWORKMESSAGE_DATASET;
-    nm.payloadHeaderEnabled = true;
-    nm.payload.dataSetPayload.dataSetMessages = dsm;
-    nm.payload.dataSetPayload.dataSetMessagesSize = dsmCount;
-    nm.publisherIdEnabled = true;
-    nm.publisherId = connection->config.publisherId;
+static void
+prepareNetworkMessageJson(UA_PubSubConnection *connection, UA_DataSetMessage *dsm,
+                          UA_UInt16 *writerIds, UA_Byte dsmCount,
+                          UA_NetworkMessage *nm) {
+    nm->version = 1;
+    nm->networkMessageType = UA_NETWORKMESSAGE_DATASET;
+    nm->payloadHeaderEnabled = true;
+    nm->payload.dataSetPayload.dataSetMessages = dsm;
+    nm->payload.dataSetPayload.dataSetMessagesSize = dsmCount;
+    nm->publisherIdEnabled = true;
+    nm->publisherId = connection->config.publisherId;
 
     for(size_t i = 0; i < dsmCount; i++)
-        nm.payload.dataSetPayload.dataSetMessages[i].dataSetWriterId = writerIds[i];
+        nm->payload.dataSetPayload.dataSetMessages[i].dataSetWriterId = writerIds[i];
+}
 
+static UA_StatusCode
+encodeNetworkMessageJson(UA_PreparedNetworkMessage *pm, UA_ByteString *buf) {
     /* Compute the message length */
-    size_t msgSize = UA_NetworkMessage_calcSizeJsonInternal(&nm, NULL, NULL, 0, true);
-
-    UA_ConnectionManager *cm = connection->cm;
-    if(!cm)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    /* Select the wg sendchannel if configured */
-    uintptr_t sendChannel = connection->sendChannel;
-    if(wg->sendChannel != 0)
-        sendChannel = wg->sendChannel;
-    if(sendChannel == 0) {
-        UA_LOG_ERROR_PUBSUB(psm->logging, wg, "Cannot send, no open connection");
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
+    size_t msgSize =
+        UA_NetworkMessage_calcSizeJsonInternal(&pm->nm, NULL, NULL, 0, true);
 
     /* Allocate the buffer */
-    UA_ByteString buf;
-    UA_StatusCode res = cm->allocNetworkBuffer(cm, sendChannel, &buf, msgSize);
+    UA_StatusCode res = pm->cm->allocNetworkBuffer(pm->cm, pm->sendChannel,
+                                                   buf, msgSize);
     UA_CHECK_STATUS(res, return res);
 
     /* Encode the message */
-    UA_Byte *bufPos = buf.data;
-    const UA_Byte *bufEnd = &buf.data[msgSize];
-    res = UA_NetworkMessage_encodeJsonInternal(&nm, &bufPos, &bufEnd, NULL, NULL, 0, true);
+    UA_Byte *bufPos = buf->data;
+    const UA_Byte *bufEnd = &buf->data[msgSize];
+    res = UA_NetworkMessage_encodeJsonInternal(&pm->nm, &bufPos, &bufEnd,
+                                               NULL, NULL, 0, true);
     if(res != UA_STATUSCODE_GOOD) {
-        cm->freeNetworkBuffer(cm, sendChannel, &buf);
+        pm->cm->freeNetworkBuffer(pm->cm, pm->sendChannel, buf);
         return res;
     }
     UA_assert(bufPos == bufEnd);
-
-    /* Send the prepared messages */
-    sendNetworkMessageBuffer(psm, wg, connection, sendChannel, &buf);
     return UA_STATUSCODE_GOOD;
 }
 #endif
 
+/* Generate the MessageNonce. Four random bytes followed by a four-byte
+ * sequence number */
+static UA_StatusCode
+generateMessageNonce(UA_WriterGroup *wg, UA_NetworkMessage *nm) {
+    UA_ByteString nonce = {4, nm->securityHeader.messageNonce};
+    UA_StatusCode rv = wg->config.securityPolicy->symmetricModule.
+        generateNonce(wg->config.securityPolicy->policyContext, &nonce);
+    if(rv != UA_STATUSCODE_GOOD)
+        return rv;
+    UA_Byte *pos = &nm->securityHeader.messageNonce[4];
+    const UA_Byte *end = &nm->securityHeader.messageNonce[8];
+    UA_UInt32_encodeBinary(&wg->nonceSequenceNumber, &pos, end);
+    nm->securityHeader.messageNonceSize = 8;
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 generateNetworkMessage(UA_PubSubConnection *connection, UA_WriterGroup *wg,
                        UA_DataSetMessage *dsm, UA_UInt16 *writerIds, UA_Byte dsmCount,
@@ -664,18 +760,9 @@ generateNetworkMessage(UA_PubSubConnection *connection, UA_WriterGroup *wg,
         if(wg->config.securityMode >= UA_MESSAGESECURITYMODE_SIGNANDENCRYPT)
             nm->securityHeader.networkMessageEncrypted = true;
         nm->securityHeader.securityTokenId = wg->securityTokenId;
-
-        /* Generate the MessageNonce. Four random bytes followed by a four-byte
-         * sequence number */
-        UA_ByteString nonce = {4, nm->securityHeader.messageNonce};
-        UA_StatusCode rv = wg->config.securityPolicy->symmetricModule.
-            generateNonce(wg->config.securityPolicy->policyContext, &nonce);
+        UA_StatusCode rv = generateMessageNonce(wg, nm);
         if(rv != UA_STATUSCODE_GOOD)
             return rv;
-        UA_Byte *pos = &nm->securityHeader.messageNonce[4];
-        const UA_Byte *end = &nm->securityHeader.messageNonce[8];
-        UA_UInt32_encodeBinary(&wg->nonceSequenceNumber, &pos, end);
-        nm->securityHeader.messageNonceSize = 8;
     }
 
     nm->version = 1;
@@ -704,95 +791,484 @@ generateNetworkMessage(UA_PubSubConnection *connection, UA_WriterGroup *wg,
 }
 
 static UA_StatusCode
-sendNetworkMessageBinary(UA_PubSubManager *psm, UA_PubSubConnection *connection,
-                         UA_WriterGroup *wg, UA_DataSetMessage *dsm, UA_UInt16 *writerIds,
-                         UA_Byte dsmCount) {
-    UA_NetworkMessage nm;
-    memset(&nm, 0, sizeof(UA_NetworkMessage));
-
-    /* Fill the message structure */
-    UA_StatusCode rv =
-        generateNetworkMessage(connection, wg, dsm, writerIds, dsmCount,
-                               &wg->config.messageSettings,
-                               &wg->config.transportSettings, &nm);
-    UA_CHECK_STATUS(rv, return rv);
-
+encodeNetworkMessageBinary(UA_WriterGroup *wg, UA_PreparedNetworkMessage *pm,
+                           UA_ByteString *buf) {
     /* Compute the message size. Add the overhead for the security signature.
      * There is no padding and the encryption incurs no size overhead. */
-    size_t msgSize = UA_NetworkMessage_calcSizeBinary(&nm);
+    size_t msgSize = UA_NetworkMessage_calcSizeBinary(&pm->nm);
     if(wg->config.securityMode > UA_MESSAGESECURITYMODE_NONE) {
         UA_PubSubSecurityPolicy *sp = wg->config.securityPolicy;
         msgSize += sp->symmetricModule.cryptoModule.
             signatureAlgorithm.getLocalSignatureSize(sp->policyContext);
     }
 
-    UA_ConnectionManager *cm = connection->cm;
-    if(!cm)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-    /* Select the wg sendchannel if configured */
-    uintptr_t sendChannel = connection->sendChannel;
-    if(wg->sendChannel != 0)
-        sendChannel = wg->sendChannel;
-    if(sendChannel == 0) {
-        UA_LOG_ERROR_PUBSUB(psm->logging, wg, "Cannot send, no open connection");
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-
-    /* Allocate the buffer. Allocate on the stack if the buffer is small. */
-    UA_ByteString buf = UA_BYTESTRING_NULL;
-    rv = cm->allocNetworkBuffer(cm, sendChannel, &buf, msgSize);
+    /* Allocate the buffer */
+    UA_ConnectionManager *cm = pm->cm;
+    UA_StatusCode rv = cm->allocNetworkBuffer(cm, pm->sendChannel, buf, msgSize);
     UA_CHECK_STATUS(rv, return rv);
 
     /* Encode and encrypt the message */
-    rv = encodeNetworkMessage(wg, &nm, &buf);
-    if(rv != UA_STATUSCODE_GOOD) {
-        cm->freeNetworkBuffer(cm, sendChannel, &buf);
-        return rv;
-    }
+    UA_LOCK(&wg->securityLock);
+    rv = encodeNetworkMessage(wg, &pm->nm, buf);
+    UA_UNLOCK(&wg->securityLock);
+    if(rv != UA_STATUSCODE_GOOD)
+        cm->freeNetworkBuffer(cm, pm->sendChannel, buf);
+    return rv;
+}
 
-    /* Send out the message */
-    sendNetworkMessageBuffer(psm, wg, connection, sendChannel, &buf);
-    return UA_STATUSCODE_GOOD;
+/* Apply the message security to the filled frozen NetworkMessage */
+static UA_StatusCode
+secureFrozenNetworkMessage(UA_WriterGroup *wg, UA_PreparedNetworkMessage *pm,
+                           UA_ByteString *buf) {
+    *buf = pm->buf;
+    UA_ByteString_init(&pm->buf);
+    if(wg->config.securityMode == UA_MESSAGESECURITYMODE_NONE)
+        return UA_STATUSCODE_GOOD;
+    UA_LOCK(&wg->securityLock);
+    UA_StatusCode rv = encryptAndSign(wg, &pm->nm, buf->data,
+                                      &buf->data[pm->payloadOffset],
+                                      &buf->data[pm->footerOffset]);
+    UA_UNLOCK(&wg->securityLock);
+    if(rv != UA_STATUSCODE_GOOD)
+        pm->cm->freeNetworkBuffer(pm->cm, pm->sendChannel, buf);
+    return rv;
 }
 
-static void
-sendNetworkMessage(UA_PubSubManager *psm, UA_WriterGroup *wg, UA_PubSubConnection *connection,
-                   UA_DataSetMessage *dsm, UA_UInt16 *writerIds, UA_Byte dsmCount) {
-    UA_StatusCode res = UA_STATUSCODE_GOOD;
+/* Prepare the NetworkMessage with the batched DataSetMessages. This assigns
+ * the next sequence number. */
+static UA_StatusCode
+prepareNetworkMessage(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                      UA_PubSubConnection *connection, UA_DataSetMessage *dsm,
+                      UA_UInt16 *writerIds, UA_Byte dsmCount, UA_Boolean more,
+                      UA_PreparedNetworkMessage *pm) {
+    memset(pm, 0, sizeof(UA_PreparedNetworkMessage));
+    pm->more = more;
+    UA_StatusCode res = selectSendChannel(psm, wg, connection, pm);
+    UA_CHECK_STATUS(res, return res);
+
     switch(wg->config.encodingMimeType) {
     case UA_PUBSUB_ENCODING_UADP:
-        res = sendNetworkMessageBinary(psm, connection, wg, dsm, writerIds, dsmCount);
+        res = generateNetworkMessage(connection, wg, dsm, writerIds, dsmCount,
+                                     &wg->config.messageSettings,
+                                     &wg->config.transportSettings, &pm->nm);
         break;
 #ifdef UA_ENABLE_JSON_ENCODING
     case UA_PUBSUB_ENCODING_JSON:
-        res = sendNetworkMessageJson(psm, connection, wg, dsm, writerIds, dsmCount);
+        prepareNetworkMessageJson(connection, dsm, writerIds, dsmCount, &pm->nm);
         break;
 #endif
     default:
         res = UA_STATUSCODE_BADNOTSUPPORTED;
         break;
     }
+    UA_CHECK_STATUS(res, return res);
 
-    /* If sending failed, disable all writer of the writergroup */
-    if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_ERROR_PUBSUB(psm->logging, wg,
-                            "PubSub Publish: Could not send a NetworkMessage "
-                            "with status code %s", UA_StatusCode_name(res));
-        UA_WriterGroup_setPubSubState(psm, wg, UA_PUBSUBSTATE_ERROR);
+    wg->sequenceNumber++;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Encode, secure and send the prepared NetworkMessages. Does not require the
+ * server lock. Stops at the first error. The connectionError flag is set if
+ * the encoding succeeded but sending failed. */
+static UA_StatusCode
+sendPreparedNetworkMessages(UA_WriterGroup *wg, UA_PreparedNetworkMessage *pms,
+                            size_t pmsSize, UA_Boolean *connectionError) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    size_t i = 0;
+    for(; i < pmsSize; i++) {
+        UA_PreparedNetworkMessage *pm = &pms[i];
+        UA_ByteString buf = UA_BYTESTRING_NULL;
+        if(pm->buf.length > 0) {
+            res = secureFrozenNetworkMessage(wg, pm, &buf);
+        } else if(wg->config.encodingMimeType == UA_PUBSUB_ENCODING_UADP) {
+            res = encodeNetworkMessageBinary(wg, pm, &buf);
+#ifdef UA_ENABLE_JSON_ENCODING
+        } else if(wg->config.encodingMimeType == UA_PUBSUB_ENCODING_JSON) {
+            res = encodeNetworkMessageJson(pm, &buf);
+#endif
+        } else {
+            res = UA_STATUSCODE_BADNOTSUPPORTED;
+        }
+        if(res != UA_STATUSCODE_GOOD) {
+            /* Release the NetworkMessages held back by the ConnectionManager
+             * with an empty buffer. Don't wait for the next cycle. */
+            if(i > 0 && pms[i-1].more)
+                flushNetworkMessages(&pms[i-1]);
+            break;
+        }
+
+        res = sendNetworkMessageBuffer(pm, &buf);
+        if(res != UA_STATUSCODE_GOOD) {
+            *connectionError = true;
+            break;
+        }
     }
+
+    /* Release the filled buffers that were not sent */
+    for(; i < pmsSize; i++) {
+        if(pms[i].buf.length > 0)
+            pms[i].cm->freeNetworkBuffer(pms[i].cm, pms[i].sendChannel, &pms[i].buf);
+    }
+    return res;
 }
 
-/* This callback triggers the collection and publish of NetworkMessages and the
- * contained DataSetMessages. */
+/*************************/
+/* Frozen NetworkMessage */
+/*************************/
+
 void
-UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
-    UA_assert(wg != NULL);
-    UA_assert(psm != NULL);
+UA_WriterGroup_thawNetworkMessage(UA_WriterGroup *wg) {
+    UA_ByteString_clear(&wg->frozen.message);
+    UA_free(wg->frozen.offsets);
+    wg->frozen.offsets = NULL;
+    wg->frozen.offsetsSize = 0;
+}
 
-    UA_LOG_DEBUG_PUBSUB(psm->logging, wg, "Publish Callback");
+/* Encode the NetworkMessage once and keep the offsets of the parts that change
+ * in every publish cycle. The sampled values only determine the layout. */
+static UA_StatusCode
+freezeNetworkMessage(UA_PubSubManager *psm, UA_WriterGroup *wg) {
+    UA_FrozenNetworkMessage *fm = &wg->frozen;
+    if(fm->message.length > 0 || fm->failed)
+        return UA_STATUSCODE_GOOD;
 
-    lockServer(psm->sc.server);
+    UA_PubSubConnection *connection = wg->linkedConnection;
+    if(!connection)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* Wait until the writers are operational */
+    size_t operational = 0;
+    UA_DataSetWriter *dsw;
+    LIST_FOREACH(dsw, &wg->writers, listEntry) {
+        if(dsw->head.state == UA_PUBSUBSTATE_OPERATIONAL)
+            operational++;
+    }
+    if(operational == 0)
+        return UA_STATUSCODE_BADNOTHINGTODO;
+
+    UA_Byte maxDSM = (UA_Byte)wg->config.maxEncapsulatedDataSetMessageCount;
+    if(wg->config.maxEncapsulatedDataSetMessageCount > UA_BYTE_MAX)
+        maxDSM = UA_BYTE_MAX;
+    if(maxDSM == 0)
+        maxDSM = 1;
+
+    /* Initialize variables so we can goto cleanup below */
+    size_t dsmCount = 0;
+    UA_NetworkMessage nm;
+    memset(&nm, 0, sizeof(UA_NetworkMessage));
+    UA_PubSubOffsetTable ot;
+    memset(&ot, 0, sizeof(UA_PubSubOffsetTable));
+    UA_STACKARRAY(UA_UInt16, dsWriterIds, operational);
+    UA_STACKARRAY(UA_DataSetWriter*, dsWriters, operational);
+    UA_STACKARRAY(UA_DataSetMessage, dsmStore, operational);
+
+    /* Only UADP has a static layout */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(wg->config.encodingMimeType != UA_PUBSUB_ENCODING_UADP) {
+        res = UA_STATUSCODE_BADNOTSUPPORTED;
+        goto cleanup;
+    }
+
+    /* Generate the DataSetMessages of the operational writers. They all have
+     * to fit into one NetworkMessage. Writers that send DeltaFrames or promoted
+     * fields are not supported. */
+    UA_Boolean deltaFrames = psm->sc.server->config.pubSubConfig.enableDeltaFrames;
+    LIST_FOREACH(dsw, &wg->writers, listEntry) {
+        if(dsw->head.state != UA_PUBSUBSTATE_OPERATIONAL)
+            continue;
+        UA_PublishedDataSet *pds = dsw->connectedDataSet;
+        if(dsmCount == (size_t)maxDSM ||
+           (pds && pds->promotedFieldsCount > 0) ||
+           (pds && deltaFrames && pds->fieldSize > 1 && dsw->config.keyFrameCount > 0)) {
+            res = UA_STATUSCODE_BADNOTSUPPORTED;
+            goto cleanup;
+        }
+
+        /* Don't consume a sequence number */
+        UA_UInt16 seqNr = dsw->actualDataSetMessageSequenceCount;
+        dsWriters[dsmCount] = dsw;
+        dsWriterIds[dsmCount] = dsw->config.dataSetWriterId;
+        res = UA_DataSetWriter_generateDataSetMessage(psm, dsw, &dsmStore[dsmCount]);
+        dsw->actualDataSetMessageSequenceCount = seqNr;
+        dsmCount++;
+        if(res != UA_STATUSCODE_GOOD)
+            goto cleanup;
+    }
+
+    /* Generate the NetworkMessage and compute the offset table */
+    res = generateNetworkMessage(connection, wg, dsmStore, dsWriterIds,
+                                 (UA_Byte)dsmCount, &wg->config.messageSettings,
+                                 &wg->config.transportSettings, &nm);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+    size_t msgSize = UA_NetworkMessage_calcSizeBinaryWithOffsetTable(&nm, &ot);
+    if(msgSize == 0) {
+        res = UA_STATUSCODE_BADNOTSUPPORTED;
+        goto cleanup;
+    }
+
+    /* Encode the template. Encryption and signing is done for every message
+     * after the template was copied. */
+    res = UA_ByteString_allocBuffer(&fm->message, msgSize);
+    if(res != UA_STATUSCODE_GOOD)
+        goto cleanup;
+    UA_Byte *pos = fm->message.data;
+    const UA_Byte *end = &fm->message.data[msgSize];
+    res = UA_NetworkMessage_encodeHeaders(&nm, &pos, end);
+    fm->payloadOffset = (uintptr_t)pos - (uintptr_t)fm->message.data;
+    res |= UA_NetworkMessage_encodePayload(&nm, &pos, end);
+    res |= UA_NetworkMessage_encodeFooters(&nm, &pos, end);
+    if(res != UA_STATUSCODE_GOOD || pos != end) {
+        res = UA_STATUSCODE_BADENCODINGERROR;
+        goto cleanup;
+    }
+
+    /* The MessageNonce is the last part of the SecurityHeader */
+    if(nm.securityEnabled)
+        fm->nonceOffset = fm->payloadOffset - nm.securityHeader.messageNonceSize;
+
+    /* Keep the offsets that are updated in every cycle. The other offsets
+     * point to content that is constant while the layout is frozen. */
+    fm->offsets = (UA_FrozenOffset*)UA_calloc(ot.offsetsSize, sizeof(UA_FrozenOffset));
+    if(!fm->offsets) {
+        res = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto cleanup;
+    }
+    dsw = NULL;
+    UA_DataSetMessage *dsm = NULL;
+    UA_DataSetField *dsf = NULL;
+    size_t fieldIndex = 0;
+    for(size_t i = 0; i < ot.offsetsSize; i++) {
+        UA_PubSubOffset *o = &ot.offsets[i];
+        UA_FrozenOffset *fo = &fm->offsets[fm->offsetsSize];
+        fo->offsetType = o->offsetType;
+        fo->offset = o->offset;
+        switch(o->offsetType) {
+        case UA_PUBSUBOFFSETTYPE_NETWORKMESSAGE_SEQUENCENUMBER:
+            break;
+        case UA_PUBSUBOFFSETTYPE_DATASETMESSAGE:
+            dsm = (dsm == NULL) ? dsmStore : dsm + 1;
+            dsw = dsWriters[dsm - dsmStore];
+            dsf = NULL;
+            fieldIndex = 0;
+            fo->dsw = dsw;
+            break;
+        case UA_PUBSUBOFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER:
+        case UA_PUBSUBOFFSETTYPE_DATASETMESSAGE_TIMESTAMP:
+            fo->dsw = dsw;
+            break;
+        case UA_PUBSUBOFFSETTYPE_DATASETFIELD_DATAVALUE:
+        case UA_PUBSUBOFFSETTYPE_DATASETFIELD_VARIANT:
+        case UA_PUBSUBOFFSETTYPE_DATASETFIELD_RAW: {
+            UA_assert(dsm && dsw && dsw->connectedDataSet);
+            dsf = (dsf == NULL) ?
+                TAILQ_FIRST(&dsw->connectedDataSet->fields) : TAILQ_NEXT(dsf, listEntry);
+            const UA_DataValue *v = &dsm->data.keyFrameData.dataSetFields[fieldIndex];
+            fo->dsw = dsw;
+            fo->field = dsf;
+            if(o->offsetType == UA_PUBSUBOFFSETTYPE_DATASETFIELD_DATAVALUE) {
+                fo->size = UA_calcSizeBinary(v, &UA_TYPES[UA_TYPES_DATAVALUE], NULL);
+            } else if(o->offsetType == UA_PUBSUBOFFSETTYPE_DATASETFIELD_VARIANT) {
+                fo->size = UA_calcSizeBinary(&v->value, &UA_TYPES[UA_TYPES_VARIANT], NULL);
+                /* Scalars of builtin overlayable types are copied behind the
+                 * encoding byte */
+                if(UA_Variant_isScalar(&v->value) && v->value.type->overlayable &&
+                   fo->size == 1u + v->value.type->memSize)
+                    fo->rawType = v->value.type;
+            } else {
+                const UA_FieldMetaData *fmd =
+                    &dsm->data.keyFrameData.dataSetMetaDataType->fields[fieldIndex];
+                fo->rawType = v->value.type;
+                fo->rawArray = (fmd->valueRank > 0);
+                fo->rawElements = 1;
+                for(size_t j = 0; j < fmd->arrayDimensionsSize; j++)
+                    fo->rawElements *= fmd->arrayDimensions[j];
+                fo->size = fo->rawElements *
+                    UA_calcSizeBinary(v->value.data, v->value.type, NULL);
+            }
+            fieldIndex++;
+            break;
+        }
+        default:
+            continue;
+        }
+        fm->offsetsSize++;
+    }
+
+    UA_LOG_DEBUG_PUBSUB(psm->logging, wg, "NetworkMessage frozen with %lu bytes",
+                        (unsigned long)msgSize);
+
+ cleanup:
+    for(size_t i = 0; i < dsmCount; i++)
+        UA_DataSetMessage_clear(&dsmStore[i]);
+    UA_PubSubOffsetTable_clear(&ot);
+
+    /* Don't try again before the next state change */
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING_PUBSUB(psm->logging, wg,
+                              "Cannot freeze the NetworkMessage (%s). "
+                              "Using the regular publish path.",
+                              UA_StatusCode_name(res));
+        UA_WriterGroup_thawNetworkMessage(wg);
+        fm->failed = true;
+    }
+    return res;
+}
+
+/* Encode a sampled value into the slot of the field. Fails if the encoding
+ * does not fit the frozen layout exactly. */
+static UA_StatusCode
+writeFrozenField(const UA_FrozenOffset *fo, const UA_DataValue *v, UA_Byte *pos) {
+    const UA_Byte *end = pos + fo->size;
+    UA_StatusCode rv = UA_STATUSCODE_GOOD;
+    if(fo->offsetType == UA_PUBSUBOFFSETTYPE_DATASETFIELD_DATAVALUE) {
+        rv = UA_DataValue_encodeBinary(v, &pos, end);
+    } else if(fo->offsetType == UA_PUBSUBOFFSETTYPE_DATASETFIELD_VARIANT) {
+        if(fo->rawType && v->value.type == fo->rawType &&
+           UA_Variant_isScalar(&v->value)) {
+            memcpy(pos + 1, v->value.data, fo->size - 1);
+            return UA_STATUSCODE_GOOD;
+        }
+        rv = UA_Variant_encodeBinary(&v->value, &pos, end);
+    } else {
+        /* RawData. The element count is fixed by the FieldMetaData. */
+        size_t available = (UA_Variant_isScalar(&v->value)) ? 1 : v->value.arrayLength;
+        if(v->value.type != fo->rawType || available < fo->rawElements ||
+           (fo->rawArray && available != fo->rawElements))
+            return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+        if(fo->rawType->overlayable) {
+            memcpy(pos, v->value.data, fo->size);
+            return UA_STATUSCODE_GOOD;
+        }
+        const UA_Byte *valuePtr = (const UA_Byte*)v->value.data;
+        for(size_t i = 0; i < fo->rawElements && rv == UA_STATUSCODE_GOOD; i++) {
+            rv = UA_encodeBinaryInternal(valuePtr, fo->rawType, &pos, &end,
+                                         NULL, NULL, NULL);
+            valuePtr += fo->rawType->memSize;
+        }
+    }
+    if(rv != UA_STATUSCODE_GOOD || pos != end)
+        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Copy the frozen NetworkMessage into the network buffer and update the
+ * sequence numbers, timestamps and field values. The security is applied on
+ * the copy when it is sent. */
+static UA_StatusCode
+prepareFrozenNetworkMessage(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                            UA_PubSubConnection *connection,
+                            UA_PreparedNetworkMessage *pm) {
+    memset(pm, 0, sizeof(UA_PreparedNetworkMessage));
+    UA_StatusCode rv = selectSendChannel(psm, wg, connection, pm);
+    UA_CHECK_STATUS(rv, return rv);
+
+    /* Add the overhead for the security signature */
+    UA_FrozenNetworkMessage *fm = &wg->frozen;
+    size_t msgSize = fm->message.length;
+    if(wg->config.securityMode > UA_MESSAGESECURITYMODE_NONE) {
+        UA_PubSubSecurityPolicy *sp = wg->config.securityPolicy;
+        msgSize += sp->symmetricModule.cryptoModule.
+            signatureAlgorithm.getLocalSignatureSize(sp->policyContext);
+    }
+
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    rv = pm->cm->allocNetworkBuffer(pm->cm, pm->sendChannel, &buf, msgSize);
+    UA_CHECK_STATUS(rv, return rv);
+    memcpy(buf.data, fm->message.data, fm->message.length);
+
+    /* Update the dynamic parts */
+    UA_EventLoop *el = psm->sc.server->config.eventLoop;
+    UA_DateTime now = el->dateTime_now(el);
+    const UA_Byte *end = &buf.data[fm->message.length];
+    for(size_t i = 0; i < fm->offsetsSize && rv == UA_STATUSCODE_GOOD; i++) {
+        const UA_FrozenOffset *fo = &fm->offsets[i];
+        UA_Byte *pos = &buf.data[fo->offset];
+        switch(fo->offsetType) {
+        case UA_PUBSUBOFFSETTYPE_NETWORKMESSAGE_SEQUENCENUMBER:
+            rv = UA_UInt16_encodeBinary(&wg->sequenceNumber, &pos, end);
+            break;
+        case UA_PUBSUBOFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER:
+            rv = UA_UInt16_encodeBinary(&fo->dsw->actualDataSetMessageSequenceCount,
+                                        &pos, end);
+            break;
+        case UA_PUBSUBOFFSETTYPE_DATASETMESSAGE_TIMESTAMP:
+            rv = UA_DateTime_encodeBinary(&now, &pos, end);
+            break;
+        case UA_PUBSUBOFFSETTYPE_DATASETFIELD_DATAVALUE:
+        case UA_PUBSUBOFFSETTYPE_DATASETFIELD_VARIANT:
+        case UA_PUBSUBOFFSETTYPE_DATASETFIELD_RAW: {
+            UA_DataValue v;
+            UA_DataValue_init(&v);
+            UA_DataSetWriter_sampleField(psm, fo->dsw, fo->field, &v);
+            rv = writeFrozenField(fo, &v, pos);
+            UA_DataValue_clear(&v);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    /* Insert a fresh MessageNonce. The message is encrypted and signed when
+     * it is sent. */
+    if(rv == UA_STATUSCODE_GOOD &&
+       wg->config.securityMode > UA_MESSAGESECURITYMODE_NONE) {
+        pm->nm.securityHeader.networkMessageSigned = true;
+        pm->nm.securityHeader.networkMessageEncrypted =
+            (wg->config.securityMode >= UA_MESSAGESECURITYMODE_SIGNANDENCRYPT);
+        rv = generateMessageNonce(wg, &pm->nm);
+        if(rv == UA_STATUSCODE_GOOD)
+            memcpy(&buf.data[fm->nonceOffset], pm->nm.securityHeader.messageNonce,
+                   pm->nm.securityHeader.messageNonceSize);
+    }
+
+    if(rv != UA_STATUSCODE_GOOD) {
+        pm->cm->freeNetworkBuffer(pm->cm, pm->sendChannel, &buf);
+        return rv;
+    }
+
+    /* Set the sequence counts */
+    for(size_t i = 0; i < fm->offsetsSize; i++) {
+        if(fm->offsets[i].offsetType == UA_PUBSUBOFFSETTYPE_DATASETMESSAGE)
+            fm->offsets[i].dsw->actualDataSetMessageSequenceCount++;
+    }
+    wg->sequenceNumber++;
+
+    pm->buf = buf;
+    pm->payloadOffset = fm->payloadOffset;
+    pm->footerOffset = fm->message.length;
+    return UA_STATUSCODE_GOOD;
+}
+
+#if UA_MULTITHREADING >= 100
+/* Replace values borrowed from external value backends with a copy. The
+ * application can modify its memory once the server lock is released. */
+static UA_StatusCode
+copyBorrowedValues(UA_DataSetMessage *dsm) {
+    if(dsm->header.dataSetMessageType != UA_DATASETMESSAGE_DATAKEYFRAME)
+        return UA_STATUSCODE_GOOD; /* DeltaFrames always contain copies */
+    for(size_t i = 0; i < dsm->data.keyFrameData.fieldCount; i++) {
+        UA_DataValue *v = &dsm->data.keyFrameData.dataSetFields[i];
+        if(v->value.storageType != UA_VARIANT_DATA_NODELETE)
+            continue;
+        UA_DataValue tmp;
+        UA_StatusCode res = UA_DataValue_copy(v, &tmp);
+        UA_CHECK_STATUS(res, return res);
+        *v = tmp;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+#endif
+
+/* Sample the DataSetMessages of a publish cycle and prepare the
+ * NetworkMessages. Requires the server lock. The dsms and pms arrays have space
+ * for writersCount and writersCount + 1 entries. */
+static void
+preparePublishCycle(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                    UA_DataSetMessage *dsms, size_t *dsmsSize,
+                    UA_PreparedNetworkMessage *pms, size_t *pmsSize) {
+    UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
 
     /* Find the connection associated with the writer */
     UA_PubSubConnection *connection = wg->linkedConnection;
@@ -800,10 +1276,29 @@ UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
         UA_LOG_ERROR_PUBSUB(psm->logging, wg,
                             "Publish failed. PubSubConnection invalid");
         UA_WriterGroup_setPubSubState(psm, wg, UA_PUBSUBSTATE_ERROR);
-        unlockServer(psm->sc.server);
         return;
     }
 
+    UA_EventLoop *el = psm->sc.server->config.eventLoop;
+
+    /* Publish from the frozen NetworkMessage. If the layout has changed, use
+     * the regular path and freeze again in the next cycle. */
+    if(wg->config.frozenNetworkMessage) {
+        freezeNetworkMessage(psm, wg);
+        if(wg->frozen.message.length > 0) {
+            UA_StatusCode res = prepareFrozenNetworkMessage(psm, wg, connection, pms);
+            if(res == UA_STATUSCODE_GOOD) {
+                wg->lastPublishTimeStamp = el->dateTime_nowMonotonic(el);
+                *pmsSize = 1;
+                return;
+            }
+            UA_LOG_DEBUG_PUBSUB(psm->logging, wg,
+                                "Cannot publish the frozen NetworkMessage (%s)",
+                                UA_StatusCode_name(res));
+            UA_WriterGroup_thawNetworkMessage(wg);
+        }
+    }
+
     /* How many DSM can be sent in one NM? */
     UA_Byte maxDSM = (UA_Byte)wg->config.maxEncapsulatedDataSetMessageCount;
     if(wg->config.maxEncapsulatedDataSetMessageCount > UA_BYTE_MAX)
@@ -813,16 +1308,16 @@ UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
 
     /* It is possible to put several DataSetMessages into one NetworkMessage.
      * But only if they do not contain promoted fields. NM with promoted fields
-     * are sent out right away. The others are kept in a buffer for
-     * "batching". */
+     * are sent out first. They are stored from the back of the dsms array. The
+     * others are batched from the front. */
     size_t dsmCount = 0;
+    size_t promotedCount = 0;
     UA_STACKARRAY(UA_UInt16, dsWriterIds, wg->writersCount);
-    UA_STACKARRAY(UA_DataSetMessage, dsmStore, wg->writersCount);
 
     size_t enabledWriters = 0;
 
     UA_DataSetWriter *dsw;
-    UA_EventLoop *el = psm->sc.server->config.eventLoop;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
     LIST_FOREACH(dsw, &wg->writers, listEntry) {
         if(dsw->head.state != UA_PUBSUBSTATE_OPERATIONAL)
             continue;
@@ -831,11 +1326,19 @@ UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
 
         /* PDS can be NULL -> Heartbeat */
         UA_PublishedDataSet *pds = dsw->connectedDataSet;
+        UA_Boolean promoted = (pds && pds->promotedFieldsCount > 0);
+        size_t pos = (promoted) ? wg->writersCount - 1 - promotedCount : dsmCount;
 
         /* Generate the DSM */
-        dsWriterIds[dsmCount] = dsw->config.dataSetWriterId;
-        UA_StatusCode res =
-            UA_DataSetWriter_generateDataSetMessage(psm, dsw, &dsmStore[dsmCount]);
+        dsWriterIds[pos] = dsw->config.dataSetWriterId;
+        res = UA_DataSetWriter_generateDataSetMessage(psm, dsw, &dsms[pos]);
+#if UA_MULTITHREADING >= 100
+        if(res == UA_STATUSCODE_GOOD && wg->config.publisherThread != 0) {
+            res = copyBorrowedValues(&dsms[pos]);
+            if(res != UA_STATUSCODE_GOOD)
+                UA_DataSetMessage_clear(&dsms[pos]);
+        }
+#endif
         if(res != UA_STATUSCODE_GOOD) {
             UA_LOG_ERROR_PUBSUB(psm->logging, dsw,
                                 "PubSub Publish: DataSetMessage creation failed");
@@ -843,46 +1346,270 @@ UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
             continue;
         }
 
-        /* There is no promoted field -> send right away */
-        if(pds && pds->promotedFieldsCount > 0) {
-            wg->lastPublishTimeStamp = el->dateTime_nowMonotonic(el);
-            sendNetworkMessage(psm, wg, connection, &dsmStore[dsmCount],
-                               &dsWriterIds[dsmCount], 1);
-
-            UA_DataSetMessage_clear(&dsmStore[dsmCount]);
-            continue; /* Don't increase the dsmCount, reuse the slot */
+        if(!promoted) {
+            dsmCount++;
+            continue;
         }
 
-        dsmCount++;
+        /* There is a promoted field -> send in a separate NetworkMessage */
+        promotedCount++;
+        res = prepareNetworkMessage(psm, wg, connection, &dsms[pos],
+                                    &dsWriterIds[pos], 1, false, &pms[*pmsSize]);
+        if(res != UA_STATUSCODE_GOOD)
+            goto error;
+        (*pmsSize)++;
     }
 
     /* No enabled Writers */
     if(enabledWriters == 0) {
         UA_LOG_WARNING_PUBSUB(psm->logging, wg,
                               "Cannot publish -- No Writers are enabled");
-        unlockServer(psm->sc.server);
-        return;
+        goto cleanup;
     }
 
-    /* Send the NetworkMessages with batched DataSetMessages */
+    /* Prepare the NetworkMessages with batched DataSetMessages */
     UA_Byte nmDsmCount = 0;
     for(size_t i = 0; i < dsmCount; i += nmDsmCount) {
-        /* How many dsm are batched in this iteration? */
+        /* How many dsm are batched in this iteration? Flag that more
+         * NetworkMessages follow in this cycle so they can leave with one
+         * system call. */
         nmDsmCount = (i + maxDSM > dsmCount) ? (UA_Byte)(dsmCount - i) : maxDSM;
+        res = prepareNetworkMessage(psm, wg, connection, &dsms[i], &dsWriterIds[i],
+                                    nmDsmCount, (i + nmDsmCount < dsmCount),
+                                    &pms[*pmsSize]);
+        if(res != UA_STATUSCODE_GOOD)
+            goto error;
+        (*pmsSize)++;
+    }
+
+    if(*pmsSize > 0)
         wg->lastPublishTimeStamp = el->dateTime_nowMonotonic(el);
-        /* Send the batched messages */
-        sendNetworkMessage(psm, wg, connection, &dsmStore[i],
-                           &dsWriterIds[i], nmDsmCount);
+
+ cleanup:
+    /* Move the DSM with promoted fields to the front */
+    if(promotedCount > 0)
+        memmove(&dsms[dsmCount], &dsms[wg->writersCount - promotedCount],
+                promotedCount * sizeof(UA_DataSetMessage));
+    *dsmsSize = dsmCount + promotedCount;
+    return;
+
+ error:
+    /* If preparing failed, disable all writer of the writergroup */
+    UA_LOG_ERROR_PUBSUB(psm->logging, wg,
+                        "PubSub Publish: Could not send a NetworkMessage "
+                        "with status code %s", UA_StatusCode_name(res));
+    UA_WriterGroup_setPubSubState(psm, wg, UA_PUBSUBSTATE_ERROR);
+    *pmsSize = 0;
+    goto cleanup;
+}
+
+/* Handle the result of sending and clean up. Requires the server lock. */
+static void
+finishPublishCycle(UA_PubSubManager *psm, UA_WriterGroup *wg,
+                   UA_StatusCode res, UA_Boolean connectionError,
+                   UA_Boolean stateChanged,
+                   UA_DataSetMessage *dsms, size_t dsmsSize,
+                   UA_DateTime scheduled, UA_DateTime start, UA_DateTime end) {
+    UA_LOCK_ASSERT(&psm->sc.server->serviceMutex);
+
+    /* The WriterGroup (or its connection) was disabled or removed while
+     * sending without the server lock. The channel might have been closed
+     * underneath. Keep the new state. */
+    if(res != UA_STATUSCODE_GOOD && (stateChanged || wg->deleteFlag)) {
+        UA_LOG_DEBUG_PUBSUB(psm->logging, wg,
+                            "Sending failed after a state change (%s)",
+                            UA_StatusCode_name(res));
+        res = UA_STATUSCODE_GOOD;
+    }
+
+    /* Failure, set the WriterGroup into an error mode */
+    if(res != UA_STATUSCODE_GOOD) {
+        if(connectionError) {
+            UA_LOG_ERROR_PUBSUB(psm->logging, wg, "Sending NetworkMessage failed");
+            UA_WriterGroup_setPubSubState(psm, wg, UA_PUBSUBSTATE_ERROR);
+            UA_PubSubConnection_setPubSubState(psm, wg->linkedConnection,
+                                               UA_PUBSUBSTATE_ERROR);
+        } else {
+            UA_LOG_ERROR_PUBSUB(psm->logging, wg,
+                                "PubSub Publish: Could not send a NetworkMessage "
+                                "with status code %s", UA_StatusCode_name(res));
+            UA_WriterGroup_setPubSubState(psm, wg, UA_PUBSUBSTATE_ERROR);
+        }
     }
 
     /* Clean up DSM */
-    for(size_t i = 0; i < dsmCount; i++) {
-        UA_DataSetMessage_clear(&dsmStore[i]);
+    for(size_t i = 0; i < dsmsSize; i++)
+        UA_DataSetMessage_clear(&dsms[i]);
+
+    /* Update the statistics */
+    UA_WriterGroupPublishStatistics *stats = &wg->statistics;
+    UA_DateTime interval =
+        (UA_DateTime)(wg->config.publishingInterval * UA_DATETIME_MSEC);
+    stats->publishCycles++;
+    if(end > scheduled + interval)
+        stats->deadlineMisses++;
+    stats->lastJitter = (UA_Duration)(start - scheduled) / UA_DATETIME_MSEC;
+    if(stats->lastJitter > stats->maxJitter)
+        stats->maxJitter = stats->lastJitter;
+    stats->lastDuration = (UA_Duration)(end - start) / UA_DATETIME_MSEC;
+    if(stats->lastDuration > stats->maxDuration)
+        stats->maxDuration = stats->lastDuration;
+}
+
+/* This callback triggers the collection and publish of NetworkMessages and the
+ * contained DataSetMessages. */
+void
+UA_WriterGroup_publishCallback(UA_PubSubManager *psm, UA_WriterGroup *wg) {
+    UA_assert(wg != NULL);
+    UA_assert(psm != NULL);
+
+    UA_LOG_DEBUG_PUBSUB(psm->logging, wg, "Publish Callback");
+
+    lockServer(psm->sc.server);
+
+#if UA_MULTITHREADING >= 100
+    /* A publisher thread is in the middle of a cycle */
+    if(wg->publishing) {
+        unlockServer(psm->sc.server);
+        return;
     }
+#endif
+
+    /* The timer is not aware of the scheduled time. Use the start of the last
+     * cycle to compute the jitter. */
+    UA_EventLoop *el = psm->sc.server->config.eventLoop;
+    UA_DateTime start = el->dateTime_nowMonotonic(el);
+    UA_DateTime scheduled = start;
+    if(wg->lastCycleStart != 0) {
+        scheduled = wg->lastCycleStart +
+            (UA_DateTime)(wg->config.publishingInterval * UA_DATETIME_MSEC);
+        if(scheduled > start)
+            scheduled = start;
+    }
+    wg->lastCycleStart = start;
+
+    size_t dsmsSize = 0, pmsSize = 0;
+    UA_STACKARRAY(UA_DataSetMessage, dsms, wg->writersCount);
+    UA_STACKARRAY(UA_PreparedNetworkMessage, pms, wg->writersCount + 1);
+    preparePublishCycle(psm, wg, dsms, &dsmsSize, pms, &pmsSize);
+
+    UA_Boolean connectionError = false;
+    UA_StatusCode res = sendPreparedNetworkMessages(wg, pms, pmsSize, &connectionError);
+
+    finishPublishCycle(psm, wg, res, connectionError, false, dsms, dsmsSize,
+                       scheduled, start, el->dateTime_nowMonotonic(el));
 
     unlockServer(psm->sc.server);
 }
 
+#if UA_MULTITHREADING >= 100
+
+#define UA_PUBLISHERTHREAD_MAXWAIT (100 * UA_DATETIME_MSEC)
+
+/* Find the due WriterGroup of the publisher thread with the earliest schedule.
+ * Reduces next to the earliest schedule of the WriterGroups not yet due. */
+static UA_WriterGroup *
+nextDueWriterGroup(UA_PubSubManager *psm, UA_UInt16 publisherThread,
+                   UA_DateTime now, UA_DateTime *next) {
+    UA_WriterGroup *due = NULL;
+    UA_PubSubConnection *c;
+    TAILQ_FOREACH(c, &psm->connections, listEntry) {
+        UA_WriterGroup *wg;
+        LIST_FOREACH(wg, &c->writerGroups, listEntry) {
+            if(wg->config.publisherThread != publisherThread ||
+               wg->nextPublish == 0 || wg->publishing)
+                continue;
+            if(wg->nextPublish > now) {
+                if(wg->nextPublish < *next)
+                    *next = wg->nextPublish;
+                continue;
+            }
+            if(!due || wg->nextPublish < due->nextPublish)
+                due = wg;
+        }
+    }
+    return due;
+}
+
+/* Execute a publish cycle. The server lock is released while the
+ * NetworkMessages are encoded, secured and sent. */
+static void
+publishFromThread(UA_PubSubManager *psm, UA_WriterGroup *wg, UA_DateTime now) {
+    UA_Server *server = psm->sc.server;
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    /* Advance the schedule. Cycles that can no longer be made up are
+     * skipped. */
+    UA_DateTime scheduled = wg->nextPublish;
+    UA_DateTime interval =
+        (UA_DateTime)(wg->config.publishingInterval * UA_DATETIME_MSEC);
+    wg->nextPublish = scheduled + interval;
+    if(wg->nextPublish <= now) {
+        UA_DateTime skipped = (now - wg->nextPublish) / interval + 1;
+        wg->statistics.deadlineMisses += (UA_UInt64)skipped;
+        wg->nextPublish += skipped * interval;
+    }
+
+    /* Sample with the server lock */
+    size_t dsmsSize = 0, pmsSize = 0;
+    UA_STACKARRAY(UA_DataSetMessage, dsms, wg->writersCount);
+    UA_STACKARRAY(UA_PreparedNetworkMessage, pms, wg->writersCount + 1);
+    preparePublishCycle(psm, wg, dsms, &dsmsSize, pms, &pmsSize);
+
+    /* Encode and send without the server lock */
+    UA_UInt32 generation = wg->stateGeneration;
+    wg->publishing = true;
+    unlockServer(server);
+    UA_Boolean connectionError = false;
+    UA_StatusCode res = sendPreparedNetworkMessages(wg, pms, pmsSize, &connectionError);
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime end = el->dateTime_nowMonotonic(el);
+    lockServer(server);
+    wg->publishing = false;
+
+    finishPublishCycle(psm, wg, res, connectionError,
+                       (wg->stateGeneration != generation),
+                       dsms, dsmsSize, scheduled, now, end);
+
+    /* Complete the removals that were requested in the meantime */
+    if(wg->deleteFlag) {
+        UA_WriterGroup_remove(psm, wg);
+        return;
+    }
+    UA_DataSetWriter *dsw, *dsw_tmp;
+    LIST_FOREACH_SAFE(dsw, &wg->writers, listEntry, dsw_tmp) {
+        if(dsw->deleteFlag)
+            UA_DataSetWriter_remove(psm, dsw);
+    }
+}
+
+UA_DateTime
+UA_Server_publishIterate(UA_Server *server, UA_UInt16 publisherThread) {
+    UA_EventLoop *el = server->config.eventLoop;
+    lockServer(server);
+    UA_PubSubManager *psm = getPSM(server);
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    UA_DateTime next = now + UA_PUBLISHERTHREAD_MAXWAIT;
+    if(!psm || publisherThread == 0) {
+        unlockServer(server);
+        return next;
+    }
+
+    /* Execute the due cycles in the order of their schedule. Other threads of
+     * the same pool can pick up the next WriterGroup in the meantime. */
+    UA_WriterGroup *wg;
+    while((wg = nextDueWriterGroup(psm, publisherThread, now, &next))) {
+        publishFromThread(psm, wg, now);
+        now = el->dateTime_nowMonotonic(el);
+        next = now + UA_PUBLISHERTHREAD_MAXWAIT;
+    }
+
+    unlockServer(server);
+    return next;
+}
+
+#endif /* UA_MULTITHREADING >= 100 */
+
 /***********************/
 /* Connection Handling */
 /***********************/
@@ -1326,6 +2053,23 @@ UA_Server_getWriterGroupLastPublishTimestamp(UA_Server *server,
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+UA_Server_getWriterGroupPublishStatistics(UA_Server *server,
+                                          const UA_NodeId wgId,
+                                          UA_WriterGroupPublishStatistics *stats) {
+    if(!server || !stats)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    lockServer(server);
+    UA_WriterGroup *wg = UA_WriterGroup_find(getPSM(server), wgId);
+    if(!wg) {
+        unlockServer(server);
+        return UA_STATUSCODE_BADNOTFOUND;
+    }
+    *stats = wg->statistics;
+    unlockServer(server);
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_Server_setWriterGroupEncryptionKeys(UA_Server *server, const UA_NodeId writerGroup,
                                        UA_UInt32 securityTokenId,
@@ -1002,14 +1002,15 @@ discovery_createMulticastSocket(UA_DiscoveryManager *dm) {
     }
 
     /* Set up the parameters */
-    UA_KeyValuePair params[6];
-    size_t paramsSize = 5;
+    UA_KeyValuePair params[7];
+    size_t paramsSize = 6;
 
     UA_UInt16 port = 5353;
     UA_String address = UA_STRING("224.0.0.251");
     UA_UInt32 ttl = 255;
     UA_Boolean reuse = true;
     UA_Boolean listen = true;
+    UA_Boolean reportRemote = true; /* The source is needed for the responses */
 
     params[0].key = UA_QUALIFIEDNAME(0, "port");
     UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
@@ -1021,9 +1022,11 @@ discovery_createMulticastSocket(UA_DiscoveryManager *dm) {
     UA_Variant_setScalar(&params[3].value, &reuse, &UA_TYPES[UA_TYPES_BOOLEAN]);
     params[4].key = UA_QUALIFIEDNAME(0, "ttl");
     UA_Variant_setScalar(&params[4].value, &ttl, &UA_TYPES[UA_TYPES_UINT32]);
+    params[5].key = UA_QUALIFIEDNAME(0, "report-remote");
+    UA_Variant_setScalar(&params[5].value, &reportRemote, &UA_TYPES[UA_TYPES_BOOLEAN]);
     if(dm->sc.server->config.mdnsInterfaceIP.length > 0) {
-        params[5].key = UA_QUALIFIEDNAME(0, "interface");
-        UA_Variant_setScalar(&params[5].value, &dm->sc.server->config.mdnsInterfaceIP,
+        params[6].key = UA_QUALIFIEDNAME(0, "interface");
+        UA_Variant_setScalar(&params[6].value, &dm->sc.server->config.mdnsInterfaceIP,
                              &UA_TYPES[UA_TYPES_STRING]);
         paramsSize++;
     }
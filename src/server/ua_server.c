@@ -435,6 +435,15 @@ UA_Server_delete(UA_Server *server) {
 
     lockServer(server);
 
+#if UA_MULTITHREADING >= 100
+    /* Drop queued requests. They pin their session. */
+    UA_Server_clearServiceJobs(server);
+
+    /* Cancel the handshake jobs. Waits for the jobs that are currently
+     * processed in a worker. */
+    UA_Server_clearHandshakeJobs(server);
+#endif
+
     session_list_entry *current, *temp;
     LIST_FOREACH_SAFE(current, &server->sessions, pointers, temp) {
         UA_Server_removeSession(server, current, UA_SHUTDOWNREASON_CLOSE);
@@ -464,6 +473,7 @@ UA_Server_delete(UA_Server *server) {
     server->adminSubscription = NULL;
     UA_assert(server->monitoredItemsSize == 0);
     UA_assert(server->subscriptionsSize == 0);
+    UA_assert(LIST_EMPTY(&server->samplingGroups));
 #endif
 
     /* Remove all server components (all stopped by now) */
@@ -482,6 +492,9 @@ UA_Server_delete(UA_Server *server) {
 
 #if UA_MULTITHREADING >= 100
     UA_LOCK_DESTROY(&server->serviceMutex);
+    UA_RWLOCK_DESTROY(&server->serviceRWLock);
+    UA_LOCK_DESTROY(&server->serviceJobsLock);
+    UA_LOCK_DESTROY(&server->handshakeJobsLock);
 #endif
 
     UA_GDSManager_clear(&server->gdsManager);
@@ -528,6 +541,13 @@ UA_Server_init(UA_Server *server) {
 #endif
 
     UA_LOCK_INIT(&server->serviceMutex);
+#if UA_MULTITHREADING >= 100
+    UA_RWLOCK_INIT(&server->serviceRWLock);
+    UA_LOCK_INIT(&server->serviceJobsLock);
+    TAILQ_INIT(&server->serviceJobs);
+    UA_LOCK_INIT(&server->handshakeJobsLock);
+    TAILQ_INIT(&server->handshakeJobs);
+#endif
     lockServer(server);
 
     /* Initialize the adminSession */
@@ -555,6 +575,8 @@ UA_Server_init(UA_Server *server) {
 
     /* Initialize Session Management */
     LIST_INIT(&server->sessions);
+    ZIP_INIT(&server->sessionsById);
+    ZIP_INIT(&server->sessionsByToken);
     server->sessionCount = 0;
 
     /* Initialize SecureChannel */
@@ -568,6 +590,9 @@ UA_Server_init(UA_Server *server) {
 #endif
 
     /* Initialize namespace 0*/
+#ifdef UA_ENABLE_NODESET_INJECTOR
+    UA_Boolean preloaded = isNS0Preloaded(server);
+#endif
     res = initNS0(server);
     UA_CHECK_STATUS(res, goto cleanup);
 
@@ -577,8 +602,11 @@ UA_Server_init(UA_Server *server) {
 #endif
 
 #ifdef UA_ENABLE_NODESET_INJECTOR
-    res = UA_Server_injectNodesets(server);
-    UA_CHECK_STATUS(res, goto cleanup);
+    /* A preloaded nodestore already contains the injected nodesets */
+    if(!preloaded) {
+        res = UA_Server_injectNodesets(server);
+        UA_CHECK_STATUS(res, goto cleanup);
+    }
 #endif
 
     /* Initialize the binay protocol support */
@@ -1358,14 +1386,93 @@ UA_Server_run(UA_Server *server, const volatile UA_Boolean *running) {
     return UA_Server_run_shutdown(server);
 }
 
+#if UA_MULTITHREADING >= 100
+/* The RWLock is not reentrant. Track the shared lock of the current thread. */
+static UA_THREAD_LOCAL UA_Server *sharedLockServer = NULL;
+static UA_THREAD_LOCAL size_t sharedLockDepth = 0;
+
+/* Shared lock released for lockServer. Taken again with the last unlock. */
+static UA_THREAD_LOCAL UA_Server *suspendedLockServer = NULL;
+static UA_THREAD_LOCAL size_t suspendedLockDepth = 0;
+
+static void
+acquireSharedLock(UA_Server *server) {
+    UA_RWLOCK_RDLOCK(&server->serviceRWLock);
+}
+
+static void
+releaseSharedLock(UA_Server *server) {
+    UA_RWLOCK_RDUNLOCK(&server->serviceRWLock);
+}
+
+UA_Boolean
+isServerLockedShared(const UA_Server *server) {
+    return (sharedLockServer == server);
+}
+
+void lockServerShared(UA_Server *server) {
+    if(sharedLockServer == server) {
+        sharedLockDepth++;
+        return;
+    }
+    UA_assert(sharedLockServer == NULL);
+    acquireSharedLock(server);
+    sharedLockServer = server;
+    sharedLockDepth = 1;
+}
+
+void unlockServerShared(UA_Server *server) {
+    UA_assert(sharedLockServer == server && sharedLockDepth > 0);
+    sharedLockDepth--;
+    if(sharedLockDepth > 0)
+        return;
+    sharedLockServer = NULL;
+    releaseSharedLock(server);
+}
+#endif
+
 void lockServer(UA_Server *server) {
+#if UA_MULTITHREADING >= 100
+    /* Suspend the shared lock of the current thread. Otherwise we deadlock
+     * with ourselves (and with the EventLoop thread). */
+    if(sharedLockServer == server) {
+        UA_assert(suspendedLockServer == NULL);
+        suspendedLockServer = server;
+        suspendedLockDepth = sharedLockDepth;
+        sharedLockServer = NULL;
+        sharedLockDepth = 0;
+        releaseSharedLock(server);
+    }
+#endif
     if(UA_LIKELY(server->config.eventLoop && server->config.eventLoop->lock))
         server->config.eventLoop->lock(server->config.eventLoop);
     UA_LOCK(&server->serviceMutex);
+#if UA_MULTITHREADING >= 100
+    if(server->serviceLockDepth == 0)
+        UA_RWLOCK_WRLOCK(&server->serviceRWLock);
+    server->serviceLockDepth++;
+#endif
 }
 
 void unlockServer(UA_Server *server) {
+#if UA_MULTITHREADING >= 100
+    UA_assert(server->serviceLockDepth > 0);
+    server->serviceLockDepth--;
+    UA_Boolean last = (server->serviceLockDepth == 0);
+    if(last)
+        UA_RWLOCK_WRUNLOCK(&server->serviceRWLock);
+#endif
     if(UA_LIKELY(server->config.eventLoop && server->config.eventLoop->unlock))
         server->config.eventLoop->unlock(server->config.eventLoop);
     UA_UNLOCK(&server->serviceMutex);
+#if UA_MULTITHREADING >= 100
+    /* Resume the suspended shared lock */
+    if(last && suspendedLockServer == server) {
+        acquireSharedLock(server);
+        sharedLockServer = server;
+        sharedLockDepth = suspendedLockDepth;
+        suspendedLockServer = NULL;
+        suspendedLockDepth = 0;
+    }
+#endif
 }
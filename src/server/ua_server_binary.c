@@ -40,6 +40,9 @@ typedef struct {
     UA_ConnectionState state;
     uintptr_t connectionId;
     UA_ConnectionManager *connectionManager;
+#if UA_MULTITHREADING >= 100
+    UA_DelayedCallback closeDC; /* Closing in a shard EventLoop */
+#endif
 } UA_ServerConnection;
 
 /* Reverse connect */
@@ -90,6 +93,37 @@ UA_StatusCode attemptReverseConnect(UA_BinaryProtocolManager *bpm,
 UA_StatusCode setReverseConnectRetryCallback(UA_BinaryProtocolManager *bpm,
                                              UA_Boolean enabled);
 
+#if UA_MULTITHREADING >= 100
+/* SecureChannel of a connection accepted in a shard EventLoop (see
+ * UA_ConnectionManager_addShard_POSIX_TCP). The shard thread extracts and
+ * decrypts the MSG/CLO messages. Everything else is handed over to the server
+ * thread with delayed callbacks in the server EventLoop. */
+typedef struct {
+    UA_SecureChannel channel; /* Must be the first entry */
+    UA_BinaryProtocolManager *bpm;
+    UA_DelayedCallback openDC;
+    UA_DelayedCallback processDC;
+    UA_DelayedCallback blockedDC;
+    UA_DelayedCallback closeDC;
+
+    /* Only accessed with the lock of the shard EventLoop */
+    UA_Boolean handoff;  /* processDC is pending. The shard only buffers. */
+    UA_StatusCode error; /* Processing in the shard failed */
+    UA_Boolean sendBlocked;    /* Signaled by the connection */
+    UA_Boolean blockedPending; /* blockedDC is pending */
+    UA_Boolean closed;         /* The connection has closed */
+} UA_ShardChannel;
+
+/* Message decoded in the shard thread and processed in the server thread */
+typedef struct {
+    UA_DelayedCallback dc;
+    UA_SecureChannel *channel;
+    UA_MessageType messageType;
+    UA_UInt32 requestId;
+    UA_ByteString payload;
+} UA_ShardMessage;
+#endif
+
 /********************/
 /* Helper Functions */
 /********************/
@@ -104,6 +138,47 @@ setBinaryProtocolManagerState(UA_BinaryProtocolManager *bpm,
         bpm->sc.notifyState(&bpm->sc, state);
 }
 
+/* SecureChannels of connections in a shard EventLoop are also used by the
+ * shard thread. Take the lock of the shard EventLoop while the channel is
+ * changed or used for sending. The lock order is always server lock -> shard
+ * EventLoop. So the server lock cannot be taken while the channel is locked.
+ * Returns the locked EventLoop or NULL. */
+static UA_EventLoop *
+lockChannel(UA_Server *server, UA_SecureChannel *channel) {
+#if UA_MULTITHREADING >= 100
+    UA_ConnectionManager *cm = channel->connectionManager;
+    if(cm && cm->eventSource.eventLoop &&
+       cm->eventSource.eventLoop != server->config.eventLoop) {
+        UA_EventLoop *el = cm->eventSource.eventLoop;
+        el->lock(el);
+        /* The connection has closed in the shard. Don't send with the
+         * connectionId, it can get reused. */
+        if(((UA_ShardChannel*)channel)->closed)
+            channel->state = UA_SECURECHANNELSTATE_CLOSED;
+        return el;
+    }
+#endif
+    return NULL;
+}
+
+static void
+unlockChannel(UA_EventLoop *el) {
+    if(el)
+        el->unlock(el);
+}
+
+static void
+checkStopped(UA_BinaryProtocolManager *bpm) {
+    /* Set BinaryProtocolManager to STOPPED if it is STOPPING and the last
+     * socket just closed */
+    if(bpm->sc.state == UA_LIFECYCLESTATE_STOPPING &&
+       bpm->serverConnectionsSize == 0 &&
+       LIST_EMPTY(&bpm->reverseConnects) &&
+       TAILQ_EMPTY(&bpm->channels)) {
+        setBinaryProtocolManagerState(bpm, UA_LIFECYCLESTATE_STOPPED);
+    }
+}
+
 static void
 deleteServerSecureChannel(UA_BinaryProtocolManager *bpm,
                           UA_SecureChannel *channel) {
@@ -112,9 +187,20 @@ deleteServerSecureChannel(UA_BinaryProtocolManager *bpm,
      *
      * First detach all Sessions from the SecureChannel. This also removes
      * outstanding Publish requests whose RequestId is valid only for the
-     * SecureChannel. */
+     * SecureChannel. Take the server lock, as the sessions can be used in
+     * parallel by the service workers. */
+    UA_Server *server = bpm->sc.server;
+#if UA_MULTITHREADING >= 100
+    /* Cancel the handshake job. Waits if it is processed by a worker. */
+    if(channel->handshakeJob) {
+        UA_Server_cancelHandshakeJob(server, (UA_HandshakeJob*)channel->handshakeJob);
+        channel->handshakeJob = NULL;
+    }
+#endif
+    lockServer(server);
     while(channel->sessions)
         UA_Session_detachFromSecureChannel(channel->sessions);
+    unlockServer(server);
 
     /* Detach the channel from the server list */
     TAILQ_REMOVE(&bpm->sc.server->channels, channel, serverEntry);
@@ -176,9 +262,13 @@ sendServiceFault(UA_Server *server, UA_SecureChannel *channel,
 
     /* Send error message. Message type is MSG and not ERR, since we are on a
      * SecureChannel! */
-    return UA_SecureChannel_sendSymmetricMessage(channel, requestId,
-                                                 UA_MESSAGETYPE_MSG, &response,
-                                                 &UA_TYPES[UA_TYPES_SERVICEFAULT]);
+    UA_EventLoop *channelEl = lockChannel(server, channel);
+    UA_StatusCode res =
+        UA_SecureChannel_sendSymmetricMessage(channel, requestId,
+                                              UA_MESSAGETYPE_MSG, &response,
+                                              &UA_TYPES[UA_TYPES_SERVICEFAULT]);
+    unlockChannel(channelEl);
+    return res;
 }
 
 /* This is not an ERR message, the connection is not closed afterwards */
@@ -274,6 +364,80 @@ processHEL(UA_Server *server, UA_SecureChannel *channel, const UA_ByteString *ms
     return retval;
 }
 
+#if UA_MULTITHREADING >= 100
+
+/* Handshake workers
+ * -----------------
+ * The first OPN message of a secured channel is decrypted and verified by a
+ * handshake worker. Then the OPN service runs in the server thread and the
+ * response is signed and encrypted by a worker again. The channel does not
+ * process further messages until the response is sent. Renewals of the
+ * SecurityToken remain in the server thread. */
+typedef struct {
+    UA_HandshakeJob job;
+    UA_BinaryProtocolManager *bpm;
+    UA_SecureChannel *channel;
+    UA_Boolean respond; /* false: decrypt the request, true: sign the response */
+    UA_StatusCode res;
+
+    /* The request */
+    UA_ByteString chunk;
+    UA_ByteString payload; /* Points into the chunk after decryption */
+    UA_UInt32 requestId;
+    UA_UInt32 sequenceNumber;
+
+    /* The response */
+    UA_AsymmetricMessage msg;
+} UA_OPNJob;
+
+/* Worker thread */
+static void
+processOPNJob(UA_HandshakeJob *hj) {
+    UA_OPNJob *job = (UA_OPNJob*)hj;
+    if(!job->respond) {
+        job->payload = job->chunk;
+        job->res = UA_SecureChannel_decryptOPN(job->channel, &job->payload,
+                                               &job->requestId, &job->sequenceNumber);
+    } else {
+        job->res = UA_SecureChannel_signAndEncryptAsymmetricOPNMessage(job->channel,
+                                                                       &job->msg);
+    }
+}
+
+static void
+freeOPNJob(UA_HandshakeJob *hj) {
+    UA_OPNJob *job = (UA_OPNJob*)hj;
+    UA_ByteString_clear(&job->chunk);
+    UA_ByteString_clear(&job->msg.buf);
+    UA_HandshakeJob_clear(&job->job);
+    UA_free(job);
+}
+
+#endif /* UA_MULTITHREADING >= 100 */
+
+static UA_StatusCode
+sendOPNResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
+                const UA_OpenSecureChannelResponse *response) {
+    const UA_DataType *responseType = &UA_TYPES[UA_TYPES_OPENSECURECHANNELRESPONSE];
+#if UA_MULTITHREADING >= 100
+    /* Encode in the server thread, sign and encrypt in the handshake worker */
+    UA_OPNJob *job = (UA_OPNJob*)channel->handshakeJob;
+    if(job) {
+        UA_StatusCode res =
+            UA_ByteString_allocBuffer(&job->msg.buf, channel->config.sendBufferSize);
+        UA_CHECK_STATUS(res, return res);
+        res = UA_SecureChannel_encodeAsymmetricOPNMessage(channel, requestId, response,
+                                                          responseType, &job->msg);
+        UA_CHECK_STATUS(res, return res);
+        job->respond = true;
+        UA_Server_submitHandshakeJob(server, &job->job);
+        return UA_STATUSCODE_GOOD;
+    }
+#endif
+    return UA_SecureChannel_sendAsymmetricOPNMessage(channel, requestId,
+                                                     response, responseType);
+}
+
 /* OPN -> Open up/renew the securechannel */
 static UA_StatusCode
 processOPN(UA_Server *server, UA_SecureChannel *channel,
@@ -325,8 +489,7 @@ processOPN(UA_Server *server, UA_SecureChannel *channel,
     }
 
     /* Send the response */
-    retval = UA_SecureChannel_sendAsymmetricOPNMessage(channel, requestId, &openScResponse,
-                                                       &UA_TYPES[UA_TYPES_OPENSECURECHANNELRESPONSE]);
+    retval = sendOPNResponse(server, channel, requestId, &openScResponse);
     UA_OpenSecureChannelResponse_clear(&openScResponse);
     if(retval != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
@@ -356,10 +519,11 @@ sendResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
     response->responseHeader.timestamp = el->dateTime_now(el);
 
     /* Start the message context */
+    UA_EventLoop *channelEl = lockChannel(server, channel);
     UA_MessageContext mc;
     UA_StatusCode retval = UA_MessageContext_begin(&mc, channel, requestId, UA_MESSAGETYPE_MSG);
     if(retval != UA_STATUSCODE_GOOD)
-        return retval;
+        goto out;
 
     /* Assert's required for clang-analyzer */
     UA_assert(mc.buf_pos == &mc.messageBuffer.data[UA_SECURECHANNEL_SYMMETRIC_HEADER_TOTALLENGTH]);
@@ -369,15 +533,19 @@ sendResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
     retval = UA_MessageContext_encode(&mc, &responseType->binaryEncodingId,
                                       &UA_TYPES[UA_TYPES_NODEID]);
     if(retval != UA_STATUSCODE_GOOD)
-        return retval;
+        goto out;
 
     /* Encode the response */
     retval = UA_MessageContext_encode(&mc, response, responseType);
     if(retval != UA_STATUSCODE_GOOD)
-        return retval;
+        goto out;
 
     /* Finish / send out */
-    return UA_MessageContext_finish(&mc);
+    retval = UA_MessageContext_finish(&mc);
+
+ out:
+    unlockChannel(channelEl);
+    return retval;
 }
 
 /* A Session is "bound" to a SecureChannel if it was created by the
@@ -451,14 +619,39 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
                                             requestId, UA_STATUSCODE_BADSERVICEUNSUPPORTED);
     }
 
+#if UA_MULTITHREADING >= 100
+    /* Queue read-only requests for the service workers. And all requests of
+     * sessions that have queued requests, so that they are processed in
+     * order. */
+    if(server->config.serviceWorkers) {
+        lockServer(server);
+        UA_Boolean queued =
+            UA_Server_queueRequest(server, channel, requestId, sd, msg, offset);
+        unlockServer(server);
+        if(queued)
+            return UA_STATUSCODE_GOOD;
+    }
+#endif
+
     /* Decode the request */
     UA_Request request;
     size_t requestPos = offset; /* Store the offset (for sendServiceFault) */
     UA_DecodeBinaryOptions opt;
     memset(&opt, 0, sizeof(UA_DecodeBinaryOptions));
     opt.customTypes = server->config.customDataTypes;
+
+    /* Decode into the arena of the SecureChannel (if configured). The arena is
+     * reset in one step after the request was processed. */
+    UA_Boolean useArena = (channel->requestArena.blockSize > 0);
+    if(useArena) {
+        opt.calloc = UA_Arena_calloc;
+        opt.callocContext = &channel->requestArena;
+    }
+
     retval = UA_decodeBinaryInternal(msg, &offset, &request, sd->requestType, &opt);
     if(retval != UA_STATUSCODE_GOOD) {
+        if(useArena)
+            UA_Arena_reset(&channel->requestArena);
         UA_LOG_DEBUG_CHANNEL(server->config.logging, channel,
                              "Could not decode the request with StatusCode %s",
                              UA_StatusCode_name(retval));
@@ -483,7 +676,10 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
     }
 
     /* Clean up */
-    UA_clear(&request, sd->requestType);
+    if(useArena)
+        UA_Arena_reset(&channel->requestArena);
+    else
+        UA_clear(&request, sd->requestType);
     UA_clear(&response, sd->responseType);
     return retval;
 }
@@ -527,6 +723,7 @@ processSecureChannelMessage(UA_Server *server, UA_SecureChannel *channel,
         UA_LOG_INFO_CHANNEL(server->config.logging, channel,
                             "Processing the message failed with StatusCode %s. "
                             "Closing the channel.", UA_StatusCode_name(retval));
+        UA_EventLoop *channelEl = lockChannel(server, channel);
         UA_TcpErrorMessage errMsg;
         UA_TcpErrorMessage_init(&errMsg);
         errMsg.error = retval;
@@ -546,6 +743,7 @@ processSecureChannelMessage(UA_Server *server, UA_SecureChannel *channel,
             break;
         }
         UA_SecureChannel_shutdown(channel, reason);
+        unlockChannel(channelEl);
     }
 
     return retval;
@@ -561,7 +759,9 @@ purgeFirstChannelWithoutSession(UA_BinaryProtocolManager *bpm) {
         UA_LOG_INFO_CHANNEL(bpm->logging, channel,
                             "Channel was purged since maxSecureChannels was "
                             "reached and channel had no session attached");
+        UA_EventLoop *channelEl = lockChannel(bpm->sc.server, channel);
         UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_PURGE);
+        unlockChannel(channelEl);
         return true;
     }
     return false;
@@ -607,24 +807,14 @@ configServerSecureChannel(void *application, UA_SecureChannel *channel,
     return UA_SecureChannel_setSecurityPolicy(channel, securityPolicy, &appInstCert);
 }
 
-static UA_StatusCode
-createServerSecureChannel(UA_BinaryProtocolManager *bpm, UA_ConnectionManager *cm,
-                          uintptr_t connectionId, UA_SecureChannel **outChannel) {
+/* Set up the configuration of a new SecureChannel. The channel is not yet
+ * known to the server. */
+static void
+initServerSecureChannel(UA_BinaryProtocolManager *bpm, UA_SecureChannel *channel,
+                        UA_ConnectionManager *cm, uintptr_t connectionId) {
     UA_Server *server = bpm->sc.server;
     UA_ServerConfig *config = &server->config;
 
-    /* Check if we have space for another SC, otherwise try to find an SC
-     * without a session and purge it */
-    UA_SecureChannelStatistics *scs = &server->secureChannelStatistics;
-    if(scs->currentChannelCount >= config->maxSecureChannels &&
-       !purgeFirstChannelWithoutSession(bpm))
-        return UA_STATUSCODE_BADOUTOFMEMORY;
-
-    /* Allocate memory for the SecureChannel */
-    UA_SecureChannel *channel = (UA_SecureChannel*)UA_calloc(1, sizeof(UA_SecureChannel));
-    if(!channel)
-        return UA_STATUSCODE_BADOUTOFMEMORY;
-
     /* Set up the initial connection config */
     UA_ConnectionConfig connConfig;
     connConfig.protocolVersion = 0;
@@ -646,8 +836,15 @@ createServerSecureChannel(UA_BinaryProtocolManager *bpm, UA_ConnectionManager *c
     channel->certificateVerification = &config->secureChannelPKI;
     channel->processOPNHeader = configServerSecureChannel;
     channel->processOPNHeaderApplication = server;
+    UA_Arena_init(&channel->requestArena, config->requestArenaSize);
     channel->connectionManager = cm;
     channel->connectionId = connectionId;
+}
+
+/* Register the SecureChannel in the server */
+static void
+addServerSecureChannel(UA_BinaryProtocolManager *bpm, UA_SecureChannel *channel) {
+    UA_Server *server = bpm->sc.server;
 
     /* Set the SecureChannel identifier already here. So we get the right
      * identifier for logging right away. The rest of the SecurityToken is set
@@ -671,6 +868,28 @@ createServerSecureChannel(UA_BinaryProtocolManager *bpm, UA_ConnectionManager *c
     /* Update the statistics */
     server->secureChannelStatistics.currentChannelCount++;
     server->secureChannelStatistics.cumulatedChannelCount++;
+}
+
+static UA_StatusCode
+createServerSecureChannel(UA_BinaryProtocolManager *bpm, UA_ConnectionManager *cm,
+                          uintptr_t connectionId, UA_SecureChannel **outChannel) {
+    UA_Server *server = bpm->sc.server;
+    UA_ServerConfig *config = &server->config;
+
+    /* Check if we have space for another SC, otherwise try to find an SC
+     * without a session and purge it */
+    UA_SecureChannelStatistics *scs = &server->secureChannelStatistics;
+    if(scs->currentChannelCount >= config->maxSecureChannels &&
+       !purgeFirstChannelWithoutSession(bpm))
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Allocate memory for the SecureChannel */
+    UA_SecureChannel *channel = (UA_SecureChannel*)UA_calloc(1, sizeof(UA_SecureChannel));
+    if(!channel)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    initServerSecureChannel(bpm, channel, cm, connectionId);
+    addServerSecureChannel(bpm, channel);
 
     *outChannel = channel;
     return UA_STATUSCODE_GOOD;
@@ -704,6 +923,453 @@ addDiscoveryUrl(UA_Server *server, const UA_String hostname, UA_UInt16 port) {
     }
 }
 
+#if UA_MULTITHREADING >= 100
+
+static void
+processChannelBuffer(UA_BinaryProtocolManager *bpm, UA_SecureChannel *channel,
+                     UA_ByteString msg);
+
+/* Server thread: The handshake worker is done */
+static void
+completeOPNJob(UA_Server *server, UA_HandshakeJob *hj) {
+    UA_OPNJob *job = (UA_OPNJob*)hj;
+    UA_SecureChannel *channel = job->channel;
+
+    /* Processing the buffered messages takes the server lock. Take it before
+     * the channel lock. */
+    lockServer(server);
+    UA_EventLoop *channelEl = lockChannel(server, channel);
+
+    if(!job->respond) {
+        /* The request was decrypted */
+        if(job->res != UA_STATUSCODE_GOOD) {
+            UA_LOG_WARNING_CHANNEL(job->bpm->logging, channel,
+                                   "Processing the message failed with error %s",
+                                   UA_StatusCode_name(job->res));
+            UA_TcpErrorMessage error;
+            error.error = job->res;
+            error.reason = UA_STRING_NULL;
+            UA_SecureChannel_sendError(channel, &error);
+            UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_ABORT);
+            goto done;
+        }
+
+        /* Process the request. The job is resubmitted to sign the response. */
+        channel->receiveSequenceNumber = job->sequenceNumber;
+        UA_StatusCode res =
+            processSecureChannelMessage(server, channel, UA_MESSAGETYPE_OPN,
+                                        job->requestId, &job->payload);
+        if(res == UA_STATUSCODE_GOOD && job->respond) {
+            unlockChannel(channelEl);
+            unlockServer(server);
+            return;
+        }
+        goto done;
+    }
+
+    /* Send the signed and encrypted response */
+    UA_StatusCode res = job->res;
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_SecureChannel_sendAsymmetricMessage(channel, &job->msg);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
+                               "Could not send the OPN answer with error code %s",
+                               UA_StatusCode_name(res));
+        UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_REJECT);
+    }
+
+ done:
+    /* Continue with the messages that arrived in the meantime */
+    channel->handshakeJob = NULL;
+    UA_BinaryProtocolManager *bpm = job->bpm;
+    freeOPNJob(hj);
+    if(UA_SecureChannel_isConnected(channel))
+        processChannelBuffer(bpm, channel, UA_BYTESTRING_NULL);
+    unlockChannel(channelEl);
+    unlockServer(server);
+}
+
+/* Hand the encrypted OPN chunk over to the handshake workers */
+static UA_StatusCode
+submitOPNJob(UA_BinaryProtocolManager *bpm, UA_SecureChannel *channel,
+             const UA_ByteString *chunk) {
+    UA_OPNJob *job = (UA_OPNJob*)UA_calloc(1, sizeof(UA_OPNJob));
+    if(!job)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    if(UA_ByteString_copy(chunk, &job->chunk) != UA_STATUSCODE_GOOD) {
+        UA_free(job);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    UA_HandshakeJob_init(&job->job, UA_HANDSHAKEJOBTYPE_OPN);
+    job->job.process = processOPNJob;
+    job->job.complete = completeOPNJob;
+    job->job.free = freeOPNJob;
+    job->bpm = bpm;
+    job->channel = channel;
+    channel->handshakeJob = job;
+    UA_Server_submitHandshakeJob(bpm->sc.server, &job->job);
+    return UA_STATUSCODE_GOOD;
+}
+
+#endif /* UA_MULTITHREADING >= 100 */
+
+/* Process all complete messages in the buffer of the SecureChannel. The new
+ * message is appended to the buffer first. */
+static void
+processChannelBuffer(UA_BinaryProtocolManager *bpm, UA_SecureChannel *channel,
+                     UA_ByteString msg) {
+    UA_EventLoop *el = bpm->sc.server->config.eventLoop;
+    UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
+
+    /* Process all complete messages */
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    if(msg.length > 0)
+        retval = UA_SecureChannel_loadBuffer(channel, msg);
+    while(UA_LIKELY(retval == UA_STATUSCODE_GOOD)) {
+#if UA_MULTITHREADING >= 100
+        /* Wait until the handshake worker is done */
+        if(channel->handshakeJob)
+            break;
+        channel->deferOPN = (channel->state == UA_SECURECHANNELSTATE_ACK_SENT &&
+                             UA_Server_useHandshakeWorkers(bpm->sc.server));
+#endif
+        UA_MessageType messageType;
+        UA_UInt32 requestId = 0;
+        UA_ByteString payload = UA_BYTESTRING_NULL;
+        UA_Boolean copied = false;
+        retval = UA_SecureChannel_getCompleteMessage(channel, &messageType, &requestId,
+                                                     &payload, &copied, nowMonotonic);
+#if UA_MULTITHREADING >= 100
+        /* The OPN chunk is decrypted in a handshake worker */
+        if(retval == UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY) {
+            retval = submitOPNJob(bpm, channel, &payload);
+            if(copied)
+                UA_ByteString_clear(&payload);
+            continue;
+        }
+#endif
+        if(retval != UA_STATUSCODE_GOOD || payload.length == 0)
+            break;
+        retval = processSecureChannelMessage(bpm->sc.server, channel,
+                                             messageType, requestId, &payload);
+        if(copied)
+            UA_ByteString_clear(&payload);
+    }
+    retval |= UA_SecureChannel_persistBuffer(channel);
+
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING_CHANNEL(bpm->logging, channel,
+                               "Processing the message failed with error %s",
+                               UA_StatusCode_name(retval));
+
+        /* Send an ERR message and close the connection */
+        UA_TcpErrorMessage error;
+        error.error = retval;
+        error.reason = UA_STRING_NULL;
+        UA_SecureChannel_sendError(channel, &error);
+        UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_ABORT);
+    }
+}
+
+#if UA_MULTITHREADING >= 100
+
+/* Connections in shard EventLoops
+ * -------------------------------
+ * The callbacks of connections accepted in a shard EventLoop are made by the
+ * thread running the shard, with the lock of the shard EventLoop held. The
+ * shard thread never takes the server lock. It only decrypts and assembles the
+ * symmetric MSG/CLO messages. All other work is posted to the server thread as
+ * delayed callbacks of the server EventLoop. The server thread takes the lock
+ * of the shard EventLoop while it changes the SecureChannel or sends on it
+ * (lockChannel). Processing received messages takes the server lock first.
+ * The shard thread never changes the SecureChannel of a connection that is
+ * open. Closing and the send-blocked state are handed over as well. The
+ * HEL/OPN handshake and the asymmetric cryptography remain in the server
+ * thread, as the SecurityPolicy and the certificate verification are shared
+ * between all channels. */
+
+/* The mbedTLS SecurityPolicies share the HMAC context between all channels.
+ * Then only unsecured channels are decoded in the shard thread. */
+static UA_Boolean
+shardCanDecode(const UA_SecureChannel *channel) {
+#ifdef UA_ENABLE_ENCRYPTION_MBEDTLS
+    return (channel->securityMode == UA_MESSAGESECURITYMODE_NONE);
+#else
+    (void)channel;
+    return true;
+#endif
+}
+
+static void
+postToServer(UA_BinaryProtocolManager *bpm, UA_DelayedCallback *dc) {
+    UA_EventLoop *el = bpm->sc.server->config.eventLoop;
+    el->addDelayedCallback(el, dc);
+    el->cancel(el); /* Wake up the server thread */
+}
+
+/* Server thread: The new channel is registered in the server */
+static void
+shardOpenCallback(void *application, void *context) {
+    UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)application;
+    UA_SecureChannel *channel = &((UA_ShardChannel*)context)->channel;
+    UA_Server *server = bpm->sc.server;
+
+    /* Check if we have space for another SC, otherwise try to find an SC
+     * without a session and purge it */
+    UA_SecureChannelStatistics *scs = &server->secureChannelStatistics;
+    UA_Boolean reject = (bpm->sc.state != UA_LIFECYCLESTATE_STARTED ||
+                         (scs->currentChannelCount >= server->config.maxSecureChannels &&
+                          !purgeFirstChannelWithoutSession(bpm)));
+
+    /* The channel is always added. The connection is already open and the
+     * channel is removed in the CLOSING callback. */
+    addServerSecureChannel(bpm, channel);
+    if(!reject) {
+        UA_LOG_INFO_CHANNEL(bpm->logging, channel, "SecureChannel created");
+        return;
+    }
+
+    UA_LOG_WARNING_CHANNEL(bpm->logging, channel, "Could not accept the connection");
+    UA_EventLoop *channelEl = lockChannel(server, channel);
+    UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_REJECT);
+    unlockChannel(channelEl);
+}
+
+/* Server thread: Process the buffered messages that the shard handed over */
+static void
+shardProcessCallback(void *application, void *context) {
+    UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)application;
+    UA_ShardChannel *sch = (UA_ShardChannel*)context;
+    UA_SecureChannel *channel = &sch->channel;
+    UA_Server *server = bpm->sc.server;
+
+    lockServer(server);
+    UA_EventLoop *channelEl = lockChannel(server, channel);
+    sch->handoff = false;
+    if(sch->error != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING_CHANNEL(bpm->logging, channel,
+                               "Processing the message failed with error %s",
+                               UA_StatusCode_name(sch->error));
+        UA_TcpErrorMessage error;
+        error.error = sch->error;
+        error.reason = UA_STRING_NULL;
+        UA_SecureChannel_sendError(channel, &error);
+        UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_ABORT);
+        sch->error = UA_STATUSCODE_GOOD;
+    } else if(UA_SecureChannel_isConnected(channel)) {
+        processChannelBuffer(bpm, channel, UA_BYTESTRING_NULL);
+    }
+    unlockChannel(channelEl);
+    unlockServer(server);
+}
+
+/* Server thread: The send queue of the connection crossed the high (or low)
+ * watermark */
+static void
+shardBlockedCallback(void *application, void *context) {
+    UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)application;
+    UA_ShardChannel *sch = (UA_ShardChannel*)context;
+    UA_Server *server = bpm->sc.server;
+
+    lockServer(server);
+    UA_EventLoop *channelEl = lockChannel(server, &sch->channel);
+    sch->blockedPending = false;
+    sch->channel.sendBlocked = sch->sendBlocked;
+    unlockChannel(channelEl);
+    unlockServer(server);
+}
+
+/* Server thread: Process a message decoded in the shard */
+static void
+shardMessageCallback(void *application, void *context) {
+    UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)application;
+    UA_ShardMessage *sm = (UA_ShardMessage*)context;
+    UA_Server *server = bpm->sc.server;
+
+    /* Services lock the channel only for sending the response */
+    if(sm->messageType == UA_MESSAGETYPE_MSG) {
+        processSecureChannelMessage(server, sm->channel, sm->messageType,
+                                    sm->requestId, &sm->payload);
+    } else {
+        lockServer(server);
+        UA_EventLoop *channelEl = lockChannel(server, sm->channel);
+        processSecureChannelMessage(server, sm->channel, sm->messageType,
+                                    sm->requestId, &sm->payload);
+        unlockChannel(channelEl);
+        unlockServer(server);
+    }
+
+    UA_ByteString_clear(&sm->payload);
+    UA_free(sm);
+}
+
+/* Server thread: The connection of the channel has closed. This is the last
+ * callback for the channel. */
+static void
+shardCloseCallback(void *application, void *context) {
+    UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)application;
+    UA_SecureChannel *channel = &((UA_ShardChannel*)context)->channel;
+    channel->state = UA_SECURECHANNELSTATE_CLOSED;
+    deleteServerSecureChannel(bpm, channel);
+    checkStopped(bpm);
+}
+
+/* Server thread: A listen socket of a shard has closed */
+static void
+shardCloseListenCallback(void *application, void *context) {
+    UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)application;
+    UA_ServerConnection *sc = (UA_ServerConnection*)context;
+    sc->state = UA_CONNECTIONSTATE_CLOSED;
+    sc->connectionId = 0;
+    bpm->serverConnectionsSize--;
+    checkStopped(bpm);
+}
+
+/* Shard thread: Post a decoded message to the server thread. Takes ownership
+ * of the payload if it was copied. */
+static UA_StatusCode
+postShardMessage(UA_ShardChannel *sch, UA_MessageType messageType,
+                 UA_UInt32 requestId, UA_ByteString *payload, UA_Boolean copied) {
+    UA_ShardMessage *sm = (UA_ShardMessage*)UA_malloc(sizeof(UA_ShardMessage));
+    if(!sm) {
+        if(copied)
+            UA_ByteString_clear(payload);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    if(copied) {
+        sm->payload = *payload;
+    } else if(UA_ByteString_copy(payload, &sm->payload) != UA_STATUSCODE_GOOD) {
+        UA_free(sm);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    sm->dc.callback = shardMessageCallback;
+    sm->dc.application = sch->bpm;
+    sm->dc.context = sm;
+    sm->channel = &sch->channel;
+    sm->messageType = messageType;
+    sm->requestId = requestId;
+    postToServer(sch->bpm, &sm->dc);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Shard thread: Callback for the listen sockets and connections of a shard */
+static void
+shardNetworkCallback(UA_BinaryProtocolManager *bpm, UA_ConnectionManager *cm,
+                     uintptr_t connectionId, void **connectionContext,
+                     UA_ConnectionState state, const UA_KeyValueMap *params,
+                     UA_ByteString msg, UA_Boolean serverSocket) {
+    UA_ServerConnection *sc = (UA_ServerConnection*)*connectionContext;
+    UA_ShardChannel *sch = (UA_ShardChannel*)*connectionContext;
+
+    /* The connection is closing. This is the last callback for it. */
+    if(state == UA_CONNECTIONSTATE_CLOSING) {
+        if(serverSocket) {
+            sc->closeDC.callback = shardCloseListenCallback;
+            sc->closeDC.application = bpm;
+            sc->closeDC.context = sc;
+            postToServer(bpm, &sc->closeDC);
+        } else {
+            /* No more sending from the server thread (see lockChannel) */
+            sch->closed = true;
+            postToServer(bpm, &sch->closeDC);
+        }
+        return;
+    }
+
+    /* The send queue of the connection crossed the high (or low) watermark */
+    const UA_Boolean *sendBlocked = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params, UA_QUALIFIEDNAME(0, "send-blocked"),
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if(sendBlocked && !serverSocket) {
+        sch->sendBlocked = *sendBlocked;
+        if(!sch->blockedPending) {
+            sch->blockedPending = true;
+            postToServer(bpm, &sch->blockedDC);
+        }
+        return;
+    }
+
+    /* A new connection is opening. The channel is registered in the server
+     * thread. */
+    if(serverSocket) {
+        sch = (UA_ShardChannel*)UA_calloc(1, sizeof(UA_ShardChannel));
+        if(!sch) {
+            UA_LOG_WARNING(bpm->logging, UA_LOGCATEGORY_SERVER,
+                           "TCP %lu\t| Could not accept the connection with status %s",
+                           (unsigned long)connectionId,
+                           UA_StatusCode_name(UA_STATUSCODE_BADOUTOFMEMORY));
+            *connectionContext = NULL;
+            cm->closeConnection(cm, connectionId);
+            return;
+        }
+        initServerSecureChannel(bpm, &sch->channel, cm, connectionId);
+        sch->channel.state = UA_SECURECHANNELSTATE_CONNECTED;
+        sch->bpm = bpm;
+        sch->openDC.callback = shardOpenCallback;
+        sch->openDC.application = bpm;
+        sch->openDC.context = sch;
+        sch->processDC.callback = shardProcessCallback;
+        sch->processDC.application = bpm;
+        sch->processDC.context = sch;
+        sch->blockedDC.callback = shardBlockedCallback;
+        sch->blockedDC.application = bpm;
+        sch->blockedDC.context = sch;
+        sch->closeDC.callback = shardCloseCallback;
+        sch->closeDC.application = bpm;
+        sch->closeDC.context = sch;
+        *connectionContext = (void*)sch;
+        postToServer(bpm, &sch->openDC);
+    }
+
+    if(msg.length == 0)
+        return;
+
+    /* Decode the symmetric messages in the shard thread once the channel is
+     * open. Stop in front of other message types and hand them over. */
+    UA_SecureChannel *channel = &sch->channel;
+    UA_Boolean decode = (!sch->handoff && !sch->error &&
+                         channel->state == UA_SECURECHANNELSTATE_OPEN &&
+                         !channel->handshakeJob && shardCanDecode(channel));
+    UA_StatusCode res = UA_SecureChannel_loadBuffer(channel, msg);
+    if(decode) {
+        /* The SecurityToken timestamps are taken from the server clock */
+        UA_EventLoop *el = bpm->sc.server->config.eventLoop;
+        UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
+        channel->symmetricOnly = true;
+        while(UA_LIKELY(res == UA_STATUSCODE_GOOD)) {
+            UA_MessageType messageType;
+            UA_UInt32 requestId = 0;
+            UA_ByteString payload = UA_BYTESTRING_NULL;
+            UA_Boolean copied = false;
+            res = UA_SecureChannel_getCompleteMessage(channel, &messageType, &requestId,
+                                                      &payload, &copied, nowMonotonic);
+            if(res != UA_STATUSCODE_GOOD || payload.length == 0)
+                break;
+            res = postShardMessage(sch, messageType, requestId, &payload, copied);
+        }
+        channel->symmetricOnly = false;
+    }
+    UA_StatusCode persistRes = UA_SecureChannel_persistBuffer(channel);
+    if(res == UA_STATUSCODE_GOOD)
+        res = persistRes;
+
+    /* All messages were decoded */
+    if(decode && res == UA_STATUSCODE_GOOD)
+        return;
+
+    /* Hand the channel over to the server thread */
+    if(res != UA_STATUSCODE_GOOD && res != UA_STATUSCODE_GOODCALLAGAIN)
+        sch->error = res;
+    if(sch->handoff)
+        return;
+    sch->handoff = true;
+    postToServer(bpm, &sch->processDC);
+}
+
+#endif /* UA_MULTITHREADING >= 100 */
+
 /* Callback of a TCP socket (server socket or an active connection) */
 void
 serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
@@ -759,6 +1425,15 @@ serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
     UA_Boolean serverSocket = (sc >= bpm->serverConnections &&
                                sc < &bpm->serverConnections[UA_MAXSERVERCONNECTIONS]);
 
+#if UA_MULTITHREADING >= 100
+    /* The connection belongs to a shard EventLoop */
+    if(cm->eventSource.eventLoop != bpm->sc.server->config.eventLoop) {
+        shardNetworkCallback(bpm, cm, connectionId, connectionContext,
+                             state, params, msg, serverSocket);
+        return;
+    }
+#endif
+
     /* The connection is closing. This is the last callback for it. */
     if(state == UA_CONNECTIONSTATE_CLOSING) {
         if(serverSocket) {
@@ -771,15 +1446,18 @@ serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
              * only place where deleteSecureChannel must be used. */
             deleteServerSecureChannel(bpm, channel);
         }
+        checkStopped(bpm);
+        return;
+    }
 
-        /* Set BinaryProtocolManager to STOPPED if it is STOPPING and the last
-         * socket just closed */
-        if(bpm->sc.state == UA_LIFECYCLESTATE_STOPPING &&
-           bpm->serverConnectionsSize == 0 &&
-           LIST_EMPTY(&bpm->reverseConnects) &&
-           TAILQ_EMPTY(&bpm->channels)) {
-           setBinaryProtocolManagerState(bpm, UA_LIFECYCLESTATE_STOPPED);
-        }
+    /* The send queue of the connection crossed the high (or low) watermark */
+    const UA_Boolean *sendBlocked = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params, UA_QUALIFIEDNAME(0, "send-blocked"),
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if(sendBlocked && !serverSocket) {
+        UA_LOG_DEBUG_CHANNEL(bpm->logging, channel, "Sending is %s",
+                             (*sendBlocked) ? "blocked" : "unblocked");
+        channel->sendBlocked = *sendBlocked;
         return;
     }
 
@@ -814,39 +1492,7 @@ serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
     UA_debug_dumpCompleteChunk(server, channel->connection, message);
 #endif
 
-    UA_EventLoop *el = bpm->sc.server->config.eventLoop;
-    UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
-
-    /* Process all complete messages */
-    retval = UA_SecureChannel_loadBuffer(channel, msg);
-    while(UA_LIKELY(retval == UA_STATUSCODE_GOOD)) {
-        UA_MessageType messageType;
-        UA_UInt32 requestId = 0;
-        UA_ByteString payload = UA_BYTESTRING_NULL;
-        UA_Boolean copied = false;
-        retval = UA_SecureChannel_getCompleteMessage(channel, &messageType, &requestId,
-                                                     &payload, &copied, nowMonotonic);
-        if(retval != UA_STATUSCODE_GOOD || payload.length == 0)
-            break;
-        retval = processSecureChannelMessage(bpm->sc.server, channel,
-                                             messageType, requestId, &payload);
-        if(copied)
-            UA_ByteString_clear(&payload);
-    }
-    retval |= UA_SecureChannel_persistBuffer(channel);
-
-    if(retval != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_CHANNEL(bpm->logging, channel,
-                               "Processing the message failed with error %s",
-                               UA_StatusCode_name(retval));
-
-        /* Send an ERR message and close the connection */
-        UA_TcpErrorMessage error;
-        error.error = retval;
-        error.reason = UA_STRING_NULL;
-        UA_SecureChannel_sendError(channel, &error);
-        UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_ABORT);
-    }
+    processChannelBuffer(bpm, channel, msg);
 }
 
 static UA_StatusCode
@@ -920,11 +1566,13 @@ secureChannelHouseKeeping(UA_Server *server, void *context) {
 
     UA_SecureChannel *channel;
     TAILQ_FOREACH(channel, &bpm->channels, componentEntry) {
+        UA_EventLoop *channelEl = lockChannel(server, channel);
         UA_Boolean timeout = UA_SecureChannel_checkTimeout(channel, nowMonotonic);
         if(timeout) {
             UA_LOG_INFO_CHANNEL(bpm->logging, channel, "SecureChannel has timed out");
             UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_TIMEOUT);
         }
+        unlockChannel(channelEl);
     }
     unlockServer(server);
 }
@@ -1418,7 +2066,9 @@ UA_BinaryProtocolManager_stop(UA_ServerComponent *comp) {
     /* Stop all SecureChannels */
     UA_SecureChannel *channel;
     TAILQ_FOREACH(channel, &bpm->channels, componentEntry) {
+        UA_EventLoop *channelEl = lockChannel(bpm->sc.server, channel);
         UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_CLOSE);
+        unlockChannel(channelEl);
     }
 
     /* Stop all server sockets */
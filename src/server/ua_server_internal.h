@@ -185,9 +185,74 @@ getServerComponentByName(UA_Server *server, UA_String name);
 typedef struct session_list_entry {
     UA_DelayedCallback cleanupCallback;
     LIST_ENTRY(session_list_entry) pointers;
+    ZIP_ENTRY(session_list_entry) idTreeEntry;    /* Lookup by sessionId */
+    ZIP_ENTRY(session_list_entry) tokenTreeEntry; /* Lookup by authenticationToken */
     UA_Session session;
 } session_list_entry;
 
+enum ZIP_CMP
+cmpSessionNodeId(const UA_NodeId *a, const UA_NodeId *b);
+
+typedef ZIP_HEAD(UA_SessionIdTree, session_list_entry) UA_SessionIdTree;
+ZIP_FUNCTIONS(UA_SessionIdTree, session_list_entry, idTreeEntry,
+              UA_NodeId, session.sessionId, cmpSessionNodeId)
+
+typedef ZIP_HEAD(UA_SessionTokenTree, session_list_entry) UA_SessionTokenTree;
+ZIP_FUNCTIONS(UA_SessionTokenTree, session_list_entry, tokenTreeEntry,
+              UA_NodeId, session.authenticationToken, cmpSessionNodeId)
+
+#if UA_MULTITHREADING >= 100
+/* A request that is processed by a service worker. Requests for the read-only
+ * services are processed with the shared server lock. Other requests are only
+ * queued behind earlier requests of the same session and are processed with
+ * the exclusive server lock. */
+typedef struct UA_ServiceJob {
+    TAILQ_ENTRY(UA_ServiceJob) pointers;
+    UA_ServiceDescription *sd;
+    UA_Boolean exclusive;
+    UA_Session *session; /* The session is not freed while it has jobs */
+    UA_UInt32 channelId;
+    UA_UInt32 requestId;
+    UA_UInt32 requestHandle;
+    UA_ByteString msg; /* Encoded request without the leading type NodeId */
+} UA_ServiceJob;
+
+/* The asymmetric cryptography of a handshake that is processed by a handshake
+ * worker. The job is prepared in the server thread, processed by the worker
+ * without holding a lock and completed in the server thread. The concrete job
+ * types embed the UA_HandshakeJob as their first member. */
+typedef enum {
+    UA_HANDSHAKEJOBSTATE_PENDING,    /* Waits for a slot (maxParallelHandshakes) */
+    UA_HANDSHAKEJOBSTATE_QUEUED,     /* Waits for a worker */
+    UA_HANDSHAKEJOBSTATE_PROCESSING, /* Processed by a worker */
+    UA_HANDSHAKEJOBSTATE_DONE        /* Completion posted to the server thread */
+} UA_HandshakeJobState;
+
+typedef enum {
+    UA_HANDSHAKEJOBTYPE_OPN,            /* Decrypt the request, sign the response */
+    UA_HANDSHAKEJOBTYPE_CREATESESSION,  /* Sign the server nonce */
+    UA_HANDSHAKEJOBTYPE_ACTIVATESESSION /* Verify the client and the UserToken */
+} UA_HandshakeJobType;
+#define UA_HANDSHAKEJOBTYPES 3
+
+typedef struct UA_HandshakeJob UA_HandshakeJob;
+struct UA_HandshakeJob {
+    TAILQ_ENTRY(UA_HandshakeJob) pointers;
+    UA_DelayedCallback dc; /* Completion in the server thread */
+    UA_HandshakeJobType type;
+    UA_HandshakeJobState state;
+    UA_Boolean canceled;
+    UA_Lock processLock;   /* Held by the worker during processing */
+
+    /* Worker thread: The asymmetric cryptography */
+    void (*process)(UA_HandshakeJob *job);
+    /* Server thread: Continue the handshake. Takes ownership of the job. */
+    void (*complete)(UA_Server *server, UA_HandshakeJob *job);
+    /* Free the job (canceled or completed) */
+    void (*free)(UA_HandshakeJob *job);
+};
+#endif
+
 struct UA_Server {
     /* Config */
     UA_ServerConfig config;
@@ -209,6 +274,8 @@ struct UA_Server {
 
     /* Session Management */
     LIST_HEAD(session_list, session_list_entry) sessions;
+    UA_SessionIdTree sessionsById;
+    UA_SessionTokenTree sessionsByToken;
     UA_UInt32 sessionCount;
     UA_UInt32 activeSessionCount;
 
@@ -243,6 +310,9 @@ struct UA_Server {
                                                  * from a session. */
     UA_UInt32 lastSubscriptionId; /* To generate unique SubscriptionIds */
 
+    /* MonitoredItems with the same sampling interval share a timer */
+    LIST_HEAD(, UA_SamplingGroup) samplingGroups;
+
 # ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
     LIST_HEAD(, UA_ConditionSource) conditionSources;
     UA_NodeId refreshEvents[2];
@@ -251,6 +321,24 @@ struct UA_Server {
 
 #if UA_MULTITHREADING >= 100
     UA_Lock serviceMutex;
+    UA_RWLock serviceRWLock; /* Taken as a writer in lockServer and as a reader
+                              * in lockServerShared */
+    size_t serviceLockDepth; /* Nesting of lockServer. Only modified with the
+                              * serviceMutex held. */
+
+    /* Requests queued for the service workers. Take the serviceJobsLock either
+     * free-standing or after the serviceMutex. */
+    UA_Lock serviceJobsLock;
+    TAILQ_HEAD(, UA_ServiceJob) serviceJobs;
+    size_t serviceJobsSize;
+    size_t serviceJobsProcessed; /* By the workers */
+
+    /* Jobs for the handshake workers in the order they were submitted. Only
+     * the jobs in the PENDING and QUEUED state can be taken from the list. */
+    UA_Lock handshakeJobsLock;
+    TAILQ_HEAD(, UA_HandshakeJob) handshakeJobs;
+    size_t handshakeJobsActive; /* Released to the workers */
+    size_t handshakeJobsProcessed[UA_HANDSHAKEJOBTYPES]; /* By the workers */
 #endif
 
     /* Statistics */
@@ -432,6 +520,41 @@ UA_StatusCode
 sendResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
              UA_Response *response, const UA_DataType *responseType);
 
+#if UA_MULTITHREADING >= 100
+/* Queue the request for the service workers. The message starts at the offset
+ * after the request type NodeId. Returns false if the request cannot be queued.
+ * Then it has to be processed right away. */
+UA_Boolean
+UA_Server_queueRequest(UA_Server *server, UA_SecureChannel *channel,
+                       UA_UInt32 requestId, UA_ServiceDescription *sd,
+                       const UA_ByteString *msg, size_t offset);
+
+/* Remove all queued requests without processing them */
+void
+UA_Server_clearServiceJobs(UA_Server *server);
+
+/* Are the handshake workers enabled and usable? */
+UA_Boolean
+UA_Server_useHandshakeWorkers(const UA_Server *server);
+
+void UA_HandshakeJob_init(UA_HandshakeJob *job, UA_HandshakeJobType type);
+void UA_HandshakeJob_clear(UA_HandshakeJob *job);
+
+/* Hand the job over to the handshake workers. Also used to resubmit a job from
+ * its complete callback. */
+void
+UA_Server_submitHandshakeJob(UA_Server *server, UA_HandshakeJob *job);
+
+/* The job is freed right away or, if it was taken by a worker, after the worker
+ * is done. Waits until the worker no longer uses the job. */
+void
+UA_Server_cancelHandshakeJob(UA_Server *server, UA_HandshakeJob *job);
+
+/* Cancel all handshake jobs */
+void
+UA_Server_clearHandshakeJobs(UA_Server *server);
+#endif
+
 /* Many services come as an array of operations. This function generalizes the
  * processing of the operations. */
 typedef void (*UA_ServiceOperation)(UA_Server *server, UA_Session *session,
@@ -459,6 +582,28 @@ UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
 void lockServer(UA_Server *server);
 void unlockServer(UA_Server *server);
 
+#if UA_MULTITHREADING >= 100
+/* The shared lock is used for the read-only services. Several threads can hold
+ * the shared lock at the same time, but not together with lockServer. The
+ * shared lock does not take the EventLoop mutex. If lockServer is called while
+ * the current thread holds the shared lock (e.g. from a user-defined callback),
+ * then the shared lock is released first and taken again in the matching
+ * unlockServer. */
+void lockServerShared(UA_Server *server);
+void unlockServerShared(UA_Server *server);
+
+/* Does the current thread hold the shared lock? */
+UA_Boolean isServerLockedShared(const UA_Server *server);
+
+/* Assert that the server state can be read. That is, the current thread holds
+ * either the server lock or the shared lock. */
+# define UA_LOCK_ASSERT_SHARED(server)                                \
+    UA_assert((server)->serviceMutex.count > 0 ||                    \
+              isServerLockedShared(server))
+#else
+# define UA_LOCK_ASSERT_SHARED(server)
+#endif
+
 /******************************************/
 /* Internal function calls, without locks */
 /******************************************/
@@ -812,6 +957,10 @@ addNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId);
 
 UA_StatusCode initNS0(UA_Server *server);
 
+/* The Nodestore already contains the namespace zero (e.g. loaded from an
+ * image). Then the nodes are not generated during the initialization. */
+UA_Boolean isNS0Preloaded(UA_Server *server);
+
 #ifdef UA_ENABLE_GDS_PUSHMANAGEMENT
 UA_StatusCode
 initNS0PushManagement(UA_Server *server);
@@ -725,7 +725,7 @@ readMonitoredItems(UA_Server *server, const UA_NodeId *sessionId, void *sessionC
     /* Count the MonitoredItems */
     UA_UInt32 sizeOfOutput = 0;
     UA_MonitoredItem* monitoredItem;
-    LIST_FOREACH(monitoredItem, &subscription->monitoredItems, listEntry) {
+    TAILQ_FOREACH(monitoredItem, &subscription->monitoredItems, listEntry) {
         ++sizeOfOutput;
     }
     if(sizeOfOutput == 0) {
@@ -750,7 +750,7 @@ readMonitoredItems(UA_Server *server, const UA_NodeId *sessionId, void *sessionC
 
     /* Fill the array */
     UA_UInt32 i = 0;
-    LIST_FOREACH(monitoredItem, &subscription->monitoredItems, listEntry) {
+    TAILQ_FOREACH(monitoredItem, &subscription->monitoredItems, listEntry) {
         clientHandles[i] = monitoredItem->parameters.clientHandle;
         serverHandles[i] = monitoredItem->monitoredItemId;
         ++i;
@@ -902,6 +902,16 @@ addModellingRules(UA_Server *server) {
 
 #endif
 
+UA_Boolean
+isNS0Preloaded(UA_Server *server) {
+    UA_NodeId serverId = UA_NS0ID(SERVER);
+    const UA_Node *serverNode = UA_NODESTORE_GET(server, &serverId);
+    if(!serverNode)
+        return false;
+    UA_NODESTORE_RELEASE(server, serverNode);
+    return true;
+}
+
 /* Initialize the nodeset 0 by using the generated code of the nodeset compiler.
  * This also initialized the data sources for various variables, such as for
  * example server time. */
@@ -909,20 +919,30 @@ UA_StatusCode
 initNS0(UA_Server *server) {
     UA_LOCK_ASSERT(&server->serviceMutex);
 
-    /* Initialize base nodes which are always required an cannot be created
-     * through the NS compiler */
-    server->bootstrapNS0 = true;
-    UA_StatusCode retVal = createNS0_base(server);
+    /* The Nodestore can be preloaded with the namespace zero (e.g. from a
+     * nodestore image). Then only the callbacks and the configuration below
+     * are attached. */
+    UA_StatusCode retVal = UA_STATUSCODE_GOOD;
+    if(isNS0Preloaded(server)) {
+        UA_LOG_INFO(server->config.logging, UA_LOGCATEGORY_SERVER,
+                    "Namespace 0 is already present in the Nodestore. "
+                    "Skip the generation of Namespace 0.");
+    } else {
+        /* Initialize base nodes which are always required an cannot be
+         * created through the NS compiler */
+        server->bootstrapNS0 = true;
+        retVal = createNS0_base(server);
 
 #ifdef UA_GENERATED_NAMESPACE_ZERO
-    /* Load nodes and references generated from the XML ns0 definition */
-    retVal |= namespace0_generated(server);
+        /* Load nodes and references generated from the XML ns0 definition */
+        retVal |= namespace0_generated(server);
 #else
-    /* Create a minimal server object */
-    retVal |= minimalServerObject(server);
+        /* Create a minimal server object */
+        retVal |= minimalServerObject(server);
 #endif
 
-    server->bootstrapNS0 = false;
+        server->bootstrapNS0 = false;
+    }
 
     if(retVal != UA_STATUSCODE_GOOD) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
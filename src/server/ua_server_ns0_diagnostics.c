@@ -61,7 +61,7 @@ fillSubscriptionDiagnostics(UA_Subscription *sub,
 
     /* Count the disabled MonitoredItems */
     UA_MonitoredItem *mon;
-    LIST_FOREACH(mon, &sub->monitoredItems, listEntry) {
+    TAILQ_FOREACH(mon, &sub->monitoredItems, listEntry) {
         if(mon->monitoringMode == UA_MONITORINGMODE_DISABLED)
             diag->disabledMonitoredItemCount++;
     }
@@ -42,122 +42,122 @@ UA_NodeId unsafe_fuzz_authenticationToken = {0, UA_NODEIDTYPE_NUMERIC, {0}};
 UA_ServiceDescription serviceDescriptions[] = {
     {UA_NS0ID_GETENDPOINTSREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET_NONE(false), (UA_Service)Service_GetEndpoints,
-     &UA_TYPES[UA_TYPES_GETENDPOINTSREQUEST], &UA_TYPES[UA_TYPES_GETENDPOINTSRESPONSE]},
+     &UA_TYPES[UA_TYPES_GETENDPOINTSREQUEST], &UA_TYPES[UA_TYPES_GETENDPOINTSRESPONSE], false},
     {UA_NS0ID_FINDSERVERSREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET_NONE(false), (UA_Service)Service_FindServers,
-     &UA_TYPES[UA_TYPES_FINDSERVERSREQUEST], &UA_TYPES[UA_TYPES_FINDSERVERSRESPONSE]},
+     &UA_TYPES[UA_TYPES_FINDSERVERSREQUEST], &UA_TYPES[UA_TYPES_FINDSERVERSRESPONSE], false},
 #ifdef UA_ENABLE_DISCOVERY
     {UA_NS0ID_REGISTERSERVERREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET_NONE(false), (UA_Service)Service_RegisterServer,
-     &UA_TYPES[UA_TYPES_REGISTERSERVERREQUEST], &UA_TYPES[UA_TYPES_REGISTERSERVERRESPONSE]},
+     &UA_TYPES[UA_TYPES_REGISTERSERVERREQUEST], &UA_TYPES[UA_TYPES_REGISTERSERVERRESPONSE], false},
     {UA_NS0ID_REGISTERSERVER2REQUEST_ENCODING_DEFAULTBINARY,
     UA_SERVICECOUNTER_OFFSET_NONE(false), (UA_Service)Service_RegisterServer2,
-    &UA_TYPES[UA_TYPES_REGISTERSERVER2REQUEST], &UA_TYPES[UA_TYPES_REGISTERSERVER2RESPONSE]},
+    &UA_TYPES[UA_TYPES_REGISTERSERVER2REQUEST], &UA_TYPES[UA_TYPES_REGISTERSERVER2RESPONSE], false},
 # ifdef UA_ENABLE_DISCOVERY_MULTICAST
     {UA_NS0ID_FINDSERVERSONNETWORKREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET_NONE(false), (UA_Service)Service_FindServersOnNetwork,
-     &UA_TYPES[UA_TYPES_FINDSERVERSONNETWORKREQUEST], &UA_TYPES[UA_TYPES_FINDSERVERSONNETWORKRESPONSE]},
+     &UA_TYPES[UA_TYPES_FINDSERVERSONNETWORKREQUEST], &UA_TYPES[UA_TYPES_FINDSERVERSONNETWORKRESPONSE], false},
 # endif
 #endif
     {UA_NS0ID_CREATESESSIONREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET_NONE(false), (UA_Service)Service_CreateSession,
-     &UA_TYPES[UA_TYPES_CREATESESSIONREQUEST], &UA_TYPES[UA_TYPES_CREATESESSIONRESPONSE]},
+     &UA_TYPES[UA_TYPES_CREATESESSIONREQUEST], &UA_TYPES[UA_TYPES_CREATESESSIONRESPONSE], false},
     {UA_NS0ID_ACTIVATESESSIONREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET_NONE(false), (UA_Service)Service_ActivateSession,
-     &UA_TYPES[UA_TYPES_ACTIVATESESSIONREQUEST],  &UA_TYPES[UA_TYPES_ACTIVATESESSIONRESPONSE]},
+     &UA_TYPES[UA_TYPES_ACTIVATESESSIONREQUEST],  &UA_TYPES[UA_TYPES_ACTIVATESESSIONRESPONSE], false},
     {UA_NS0ID_CLOSESESSIONREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET_NONE(true), (UA_Service)Service_CloseSession,
-     &UA_TYPES[UA_TYPES_CLOSESESSIONREQUEST], &UA_TYPES[UA_TYPES_CLOSESESSIONRESPONSE]},
+     &UA_TYPES[UA_TYPES_CLOSESESSIONREQUEST], &UA_TYPES[UA_TYPES_CLOSESESSIONRESPONSE], false},
     {UA_NS0ID_CANCELREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET_NONE(true), (UA_Service)Service_Cancel,
-     &UA_TYPES[UA_TYPES_CANCELREQUEST], &UA_TYPES[UA_TYPES_CANCELRESPONSE]},
+     &UA_TYPES[UA_TYPES_CANCELREQUEST], &UA_TYPES[UA_TYPES_CANCELRESPONSE], false},
     {UA_NS0ID_READREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(readCount, true), (UA_Service)Service_Read,
-     &UA_TYPES[UA_TYPES_READREQUEST], &UA_TYPES[UA_TYPES_READRESPONSE]},
+     &UA_TYPES[UA_TYPES_READREQUEST], &UA_TYPES[UA_TYPES_READRESPONSE], true},
     {UA_NS0ID_WRITEREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(writeCount, true), (UA_Service)Service_Write,
-     &UA_TYPES[UA_TYPES_WRITEREQUEST], &UA_TYPES[UA_TYPES_WRITERESPONSE]},
+     &UA_TYPES[UA_TYPES_WRITEREQUEST], &UA_TYPES[UA_TYPES_WRITERESPONSE], false},
     {UA_NS0ID_BROWSEREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(browseCount, true), (UA_Service)Service_Browse,
-     &UA_TYPES[UA_TYPES_BROWSEREQUEST], &UA_TYPES[UA_TYPES_BROWSERESPONSE]},
+     &UA_TYPES[UA_TYPES_BROWSEREQUEST], &UA_TYPES[UA_TYPES_BROWSERESPONSE], true},
     {UA_NS0ID_BROWSENEXTREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(browseNextCount, true), (UA_Service)Service_BrowseNext,
-     &UA_TYPES[UA_TYPES_BROWSENEXTREQUEST], &UA_TYPES[UA_TYPES_BROWSENEXTRESPONSE]},
+     &UA_TYPES[UA_TYPES_BROWSENEXTREQUEST], &UA_TYPES[UA_TYPES_BROWSENEXTRESPONSE], true},
     {UA_NS0ID_REGISTERNODESREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(registerNodesCount, true), (UA_Service)Service_RegisterNodes,
-     &UA_TYPES[UA_TYPES_REGISTERNODESREQUEST], &UA_TYPES[UA_TYPES_REGISTERNODESRESPONSE]},
+     &UA_TYPES[UA_TYPES_REGISTERNODESREQUEST], &UA_TYPES[UA_TYPES_REGISTERNODESRESPONSE], false},
     {UA_NS0ID_UNREGISTERNODESREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(unregisterNodesCount, true), (UA_Service)Service_UnregisterNodes,
-     &UA_TYPES[UA_TYPES_UNREGISTERNODESREQUEST], &UA_TYPES[UA_TYPES_UNREGISTERNODESRESPONSE]},
+     &UA_TYPES[UA_TYPES_UNREGISTERNODESREQUEST], &UA_TYPES[UA_TYPES_UNREGISTERNODESRESPONSE], false},
     {UA_NS0ID_TRANSLATEBROWSEPATHSTONODEIDSREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(translateBrowsePathsToNodeIdsCount, true), (UA_Service)Service_TranslateBrowsePathsToNodeIds,
-     &UA_TYPES[UA_TYPES_TRANSLATEBROWSEPATHSTONODEIDSREQUEST], &UA_TYPES[UA_TYPES_TRANSLATEBROWSEPATHSTONODEIDSRESPONSE]},
+     &UA_TYPES[UA_TYPES_TRANSLATEBROWSEPATHSTONODEIDSREQUEST], &UA_TYPES[UA_TYPES_TRANSLATEBROWSEPATHSTONODEIDSRESPONSE], true},
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     {UA_NS0ID_CREATESUBSCRIPTIONREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(createSubscriptionCount, true), (UA_Service)Service_CreateSubscription,
-     &UA_TYPES[UA_TYPES_CREATESUBSCRIPTIONREQUEST], &UA_TYPES[UA_TYPES_CREATESUBSCRIPTIONRESPONSE]},
+     &UA_TYPES[UA_TYPES_CREATESUBSCRIPTIONREQUEST], &UA_TYPES[UA_TYPES_CREATESUBSCRIPTIONRESPONSE], false},
     {UA_NS0ID_PUBLISHREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(publishCount, true), NULL,
-     &UA_TYPES[UA_TYPES_PUBLISHREQUEST], &UA_TYPES[UA_TYPES_PUBLISHRESPONSE]},
+     &UA_TYPES[UA_TYPES_PUBLISHREQUEST], &UA_TYPES[UA_TYPES_PUBLISHRESPONSE], false},
     {UA_NS0ID_REPUBLISHREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(republishCount, true), (UA_Service)Service_Republish,
-     &UA_TYPES[UA_TYPES_REPUBLISHREQUEST], &UA_TYPES[UA_TYPES_REPUBLISHRESPONSE]},
+     &UA_TYPES[UA_TYPES_REPUBLISHREQUEST], &UA_TYPES[UA_TYPES_REPUBLISHRESPONSE], false},
     {UA_NS0ID_MODIFYSUBSCRIPTIONREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(modifySubscriptionCount, true), (UA_Service)Service_ModifySubscription,
-     &UA_TYPES[UA_TYPES_MODIFYSUBSCRIPTIONREQUEST], &UA_TYPES[UA_TYPES_MODIFYSUBSCRIPTIONRESPONSE]},
+     &UA_TYPES[UA_TYPES_MODIFYSUBSCRIPTIONREQUEST], &UA_TYPES[UA_TYPES_MODIFYSUBSCRIPTIONRESPONSE], false},
     {UA_NS0ID_SETPUBLISHINGMODEREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(setPublishingModeCount, true), (UA_Service)Service_SetPublishingMode,
-     &UA_TYPES[UA_TYPES_SETPUBLISHINGMODEREQUEST], &UA_TYPES[UA_TYPES_SETPUBLISHINGMODERESPONSE]},
+     &UA_TYPES[UA_TYPES_SETPUBLISHINGMODEREQUEST], &UA_TYPES[UA_TYPES_SETPUBLISHINGMODERESPONSE], false},
     {UA_NS0ID_DELETESUBSCRIPTIONSREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(deleteSubscriptionsCount, true), (UA_Service)Service_DeleteSubscriptions,
-     &UA_TYPES[UA_TYPES_DELETESUBSCRIPTIONSREQUEST], &UA_TYPES[UA_TYPES_DELETESUBSCRIPTIONSRESPONSE]},
+     &UA_TYPES[UA_TYPES_DELETESUBSCRIPTIONSREQUEST], &UA_TYPES[UA_TYPES_DELETESUBSCRIPTIONSRESPONSE], false},
     {UA_NS0ID_TRANSFERSUBSCRIPTIONSREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(transferSubscriptionsCount, true), (UA_Service)Service_TransferSubscriptions,
-     &UA_TYPES[UA_TYPES_TRANSFERSUBSCRIPTIONSREQUEST], &UA_TYPES[UA_TYPES_TRANSFERSUBSCRIPTIONSRESPONSE]},
+     &UA_TYPES[UA_TYPES_TRANSFERSUBSCRIPTIONSREQUEST], &UA_TYPES[UA_TYPES_TRANSFERSUBSCRIPTIONSRESPONSE], false},
     {UA_NS0ID_CREATEMONITOREDITEMSREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(createMonitoredItemsCount, true), (UA_Service)Service_CreateMonitoredItems,
-     &UA_TYPES[UA_TYPES_CREATEMONITOREDITEMSREQUEST], &UA_TYPES[UA_TYPES_CREATEMONITOREDITEMSRESPONSE]},
+     &UA_TYPES[UA_TYPES_CREATEMONITOREDITEMSREQUEST], &UA_TYPES[UA_TYPES_CREATEMONITOREDITEMSRESPONSE], false},
     {UA_NS0ID_DELETEMONITOREDITEMSREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(deleteMonitoredItemsCount, true), (UA_Service)Service_DeleteMonitoredItems,
-     &UA_TYPES[UA_TYPES_DELETEMONITOREDITEMSREQUEST], &UA_TYPES[UA_TYPES_DELETEMONITOREDITEMSRESPONSE]},
+     &UA_TYPES[UA_TYPES_DELETEMONITOREDITEMSREQUEST], &UA_TYPES[UA_TYPES_DELETEMONITOREDITEMSRESPONSE], false},
     {UA_NS0ID_MODIFYMONITOREDITEMSREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(modifyMonitoredItemsCount, true), (UA_Service)Service_ModifyMonitoredItems,
-     &UA_TYPES[UA_TYPES_MODIFYMONITOREDITEMSREQUEST], &UA_TYPES[UA_TYPES_MODIFYMONITOREDITEMSRESPONSE]},
+     &UA_TYPES[UA_TYPES_MODIFYMONITOREDITEMSREQUEST], &UA_TYPES[UA_TYPES_MODIFYMONITOREDITEMSRESPONSE], false},
     {UA_NS0ID_SETMONITORINGMODEREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(setMonitoringModeCount, true), (UA_Service)Service_SetMonitoringMode,
-     &UA_TYPES[UA_TYPES_SETMONITORINGMODEREQUEST], &UA_TYPES[UA_TYPES_SETMONITORINGMODERESPONSE]},
+     &UA_TYPES[UA_TYPES_SETMONITORINGMODEREQUEST], &UA_TYPES[UA_TYPES_SETMONITORINGMODERESPONSE], false},
     {UA_NS0ID_SETTRIGGERINGREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(setTriggeringCount, true), (UA_Service)Service_SetTriggering,
-     &UA_TYPES[UA_TYPES_SETTRIGGERINGREQUEST], &UA_TYPES[UA_TYPES_SETTRIGGERINGRESPONSE]},
+     &UA_TYPES[UA_TYPES_SETTRIGGERINGREQUEST], &UA_TYPES[UA_TYPES_SETTRIGGERINGRESPONSE], false},
 #endif
 #ifdef UA_ENABLE_HISTORIZING
     {UA_NS0ID_HISTORYREADREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(historyReadCount, true), (UA_Service)Service_HistoryRead,
-     &UA_TYPES[UA_TYPES_HISTORYREADREQUEST], &UA_TYPES[UA_TYPES_HISTORYREADRESPONSE]},
+     &UA_TYPES[UA_TYPES_HISTORYREADREQUEST], &UA_TYPES[UA_TYPES_HISTORYREADRESPONSE], true},
     {UA_NS0ID_HISTORYUPDATEREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(historyUpdateCount, true), (UA_Service)Service_HistoryUpdate,
-     &UA_TYPES[UA_TYPES_HISTORYUPDATEREQUEST], &UA_TYPES[UA_TYPES_HISTORYUPDATERESPONSE]},
+     &UA_TYPES[UA_TYPES_HISTORYUPDATEREQUEST], &UA_TYPES[UA_TYPES_HISTORYUPDATERESPONSE], false},
 #endif
 #ifdef UA_ENABLE_METHODCALLS
     {UA_NS0ID_CALLREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(callCount, true), (UA_Service)Service_Call,
-     &UA_TYPES[UA_TYPES_CALLREQUEST], &UA_TYPES[UA_TYPES_CALLRESPONSE]},
+     &UA_TYPES[UA_TYPES_CALLREQUEST], &UA_TYPES[UA_TYPES_CALLRESPONSE], false},
 #endif
 #ifdef UA_ENABLE_NODEMANAGEMENT
     {UA_NS0ID_ADDNODESREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(addNodesCount, true), (UA_Service)Service_AddNodes,
-     &UA_TYPES[UA_TYPES_ADDNODESREQUEST], &UA_TYPES[UA_TYPES_ADDNODESRESPONSE]},
+     &UA_TYPES[UA_TYPES_ADDNODESREQUEST], &UA_TYPES[UA_TYPES_ADDNODESRESPONSE], false},
     {UA_NS0ID_ADDREFERENCESREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(addReferencesCount, true), (UA_Service)Service_AddReferences,
-     &UA_TYPES[UA_TYPES_ADDREFERENCESREQUEST], &UA_TYPES[UA_TYPES_ADDREFERENCESRESPONSE]},
+     &UA_TYPES[UA_TYPES_ADDREFERENCESREQUEST], &UA_TYPES[UA_TYPES_ADDREFERENCESRESPONSE], false},
     {UA_NS0ID_DELETENODESREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(deleteNodesCount, true), (UA_Service)Service_DeleteNodes,
-     &UA_TYPES[UA_TYPES_DELETENODESREQUEST], &UA_TYPES[UA_TYPES_DELETENODESRESPONSE]},
+     &UA_TYPES[UA_TYPES_DELETENODESREQUEST], &UA_TYPES[UA_TYPES_DELETENODESRESPONSE], false},
     {UA_NS0ID_DELETEREFERENCESREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(deleteReferencesCount, true), (UA_Service)Service_DeleteReferences,
-     &UA_TYPES[UA_TYPES_DELETEREFERENCESREQUEST], &UA_TYPES[UA_TYPES_DELETEREFERENCESRESPONSE]},
+     &UA_TYPES[UA_TYPES_DELETEREFERENCESREQUEST], &UA_TYPES[UA_TYPES_DELETEREFERENCESRESPONSE], false},
 #endif
-    {0, UA_SERVICECOUNTER_OFFSET_NONE(false), NULL, NULL, NULL}
+    {0, UA_SERVICECOUNTER_OFFSET_NONE(false), NULL, NULL, NULL, false}
 };
 
 UA_ServiceDescription *
@@ -207,6 +207,25 @@ processServiceInternal(UA_Server *server, UA_SecureChannel *channel, UA_Session
     if(sd->requestType == &UA_TYPES[UA_TYPES_CREATESESSIONREQUEST] ||
        sd->requestType == &UA_TYPES[UA_TYPES_ACTIVATESESSIONREQUEST] ||
        sd->requestType == &UA_TYPES[UA_TYPES_CLOSESESSIONREQUEST]) {
+#if UA_MULTITHREADING >= 100
+        /* The asymmetric cryptography is done by the handshake workers */
+        if(UA_Server_useHandshakeWorkers(server)) {
+            UA_Boolean finished = true;
+            if(sd->requestType == &UA_TYPES[UA_TYPES_CREATESESSIONREQUEST]) {
+                Service_CreateSessionAsync(server, channel, requestId,
+                                           &request->createSessionRequest,
+                                           &response->createSessionResponse, &finished);
+                return !finished;
+            }
+            if(sd->requestType == &UA_TYPES[UA_TYPES_ACTIVATESESSIONREQUEST]) {
+                Service_ActivateSessionAsync(server, channel, requestId,
+                                             &request->activateSessionRequest,
+                                             &response->activateSessionResponse,
+                                             &finished);
+                return !finished;
+            }
+        }
+#endif
         ((UA_ChannelService)sd->serviceCallback)(server, channel, request, response);
         /* Store the authentication token created during CreateSession to help
          * fuzzing cover more lines */
@@ -277,6 +296,24 @@ processServiceInternal(UA_Server *server, UA_SecureChannel *channel, UA_Session
     return false;
 }
 
+/* Update the service statistics */
+static void
+updateServiceDiagnostics(UA_Session *session, UA_ServiceDescription *sd,
+                         const UA_Response *response) {
+#ifdef UA_ENABLE_DIAGNOSTICS
+    session->diagnostics.totalRequestCount.totalCount++;
+    if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+        session->diagnostics.totalRequestCount.errorCount++;
+    if(sd->counterOffset != 0) {
+        UA_ServiceCounterDataType *serviceCounter = (UA_ServiceCounterDataType*)
+            (((uintptr_t)&session->diagnostics) + sd->counterOffset);
+        serviceCounter->totalCount++;
+        if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+            serviceCounter->errorCount++;
+    }
+#endif
+}
+
 UA_Boolean
 UA_Server_processRequest(UA_Server *server, UA_SecureChannel *channel,
                          UA_UInt32 requestId, UA_ServiceDescription *sd,
@@ -310,20 +347,401 @@ UA_Server_processRequest(UA_Server *server, UA_SecureChannel *channel,
         processServiceInternal(server, channel, session, requestId, sd, request, response);
 
     /* Update the service statistics */
-#ifdef UA_ENABLE_DIAGNOSTICS
-    if(session) {
-        session->diagnostics.totalRequestCount.totalCount++;
-        if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
-            session->diagnostics.totalRequestCount.errorCount++;
-        if(sd->counterOffset != 0) {
-            UA_ServiceCounterDataType *serviceCounter = (UA_ServiceCounterDataType*)
-                (((uintptr_t)&session->diagnostics) + sd->counterOffset);
-            serviceCounter->totalCount++;
-            if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
-                serviceCounter->errorCount++;
+    if(session)
+        updateServiceDiagnostics(session, sd, response);
+
+    return async;
+}
+
+#if UA_MULTITHREADING >= 100
+
+/* The checks and the session lifetime update are made in the server thread.
+ * Only the regular cases are queued. Everything else is processed right away
+ * to generate the correct error response. But if the session has queued
+ * requests, then every request of the session is queued behind them. Otherwise
+ * it would overtake the queued requests. Such requests are processed with the
+ * exclusive server lock. */
+UA_Boolean
+UA_Server_queueRequest(UA_Server *server, UA_SecureChannel *channel,
+                       UA_UInt32 requestId, UA_ServiceDescription *sd,
+                       const UA_ByteString *msg, size_t offset) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    /* Decode only the RequestHeader. All requests begin with it. */
+    UA_RequestHeader requestHeader;
+    UA_DecodeBinaryOptions opt;
+    memset(&opt, 0, sizeof(UA_DecodeBinaryOptions));
+    opt.customTypes = server->config.customDataTypes;
+    size_t headerOffset = offset;
+    UA_StatusCode res =
+        UA_decodeBinaryInternal(msg, &headerOffset, &requestHeader,
+                                &UA_TYPES[UA_TYPES_REQUESTHEADER], &opt);
+    if(res != UA_STATUSCODE_GOOD)
+        return false;
+
+    UA_Boolean queued = false;
+    UA_Boolean pending, shared;
+    UA_ServiceJob *job = NULL;
+    UA_Session *session = channel->sessions;
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
+
+    /* Get the session bound to the SecureChannel */
+    for(; session; session = session->next) {
+        if(UA_NodeId_equal(&requestHeader.authenticationToken,
+                           &session->authenticationToken))
+            break;
+    }
+    if(!session)
+        goto cleanup;
+
+    /* Does the session have queued requests? */
+    UA_LOCK(&server->serviceJobsLock);
+    pending = (session->serviceJobs > 0);
+    UA_UNLOCK(&server->serviceJobsLock);
+
+    /* Can the request be processed with the shared server lock? */
+    shared = (sd->readOnly && sd->sessionRequired &&
+              session->activated && session->validTill >= nowMonotonic);
+    if(requestHeader.timestamp == 0 &&
+       server->config.verifyRequestTimestamp <= UA_RULEHANDLING_WARN)
+        shared = false;
+    if(server->config.securityPolicyNoneDiscoveryOnly &&
+       UA_String_equal(&channel->securityPolicy->policyUri, &securityPolicyNone))
+        shared = false;
+    if(server->config.maxServiceWorkerQueueSize != 0 &&
+       server->serviceJobsSize >= server->config.maxServiceWorkerQueueSize)
+        shared = false;
+    if(!shared && !pending)
+        goto cleanup;
+
+    /* Create the job with a copy of the message */
+    job = (UA_ServiceJob*)UA_calloc(1, sizeof(UA_ServiceJob));
+    if(!job)
+        goto cleanup;
+    res = UA_ByteString_allocBuffer(&job->msg, msg->length - offset);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(job);
+        goto cleanup;
+    }
+    memcpy(job->msg.data, &msg->data[offset], msg->length - offset);
+    job->sd = sd;
+    job->exclusive = !shared;
+    job->session = session;
+    job->channelId = channel->securityToken.channelId;
+    job->requestId = requestId;
+    job->requestHandle = requestHeader.requestHandle;
+
+    /* Update the session lifetime. For exclusive jobs this is done when the
+     * request is processed. */
+    if(shared)
+        UA_Session_updateLifetime(session, el->dateTime_now(el), nowMonotonic);
+
+    /* Enqueue */
+    UA_LOCK(&server->serviceJobsLock);
+    TAILQ_INSERT_TAIL(&server->serviceJobs, job, pointers);
+    server->serviceJobsSize++;
+    session->serviceJobs++;
+    UA_UNLOCK(&server->serviceJobsLock);
+    queued = true;
+
+    if(server->config.serviceWorkerNotifyCallback)
+        server->config.serviceWorkerNotifyCallback(server);
+
+ cleanup:
+    UA_RequestHeader_clear(&requestHeader);
+    return queued;
+}
+
+static void
+releaseServiceJob(UA_Server *server, UA_ServiceJob *job) {
+    UA_LOCK(&server->serviceJobsLock);
+    job->session->serviceJobActive = false;
+    job->session->serviceJobs--;
+    server->serviceJobsProcessed++;
+    UA_UNLOCK(&server->serviceJobsLock);
+}
+
+/* Get the SecureChannel of the job if it is still open. The SecureChannels are
+ * protected by the EventLoop mutex. */
+static UA_SecureChannel *
+getServiceJobChannel(UA_Server *server, const UA_ServiceJob *job) {
+    UA_SecureChannel *channel;
+    TAILQ_FOREACH(channel, &server->channels, serverEntry) {
+        if(channel->securityToken.channelId == job->channelId)
+            break;
+    }
+    if(!channel || channel->state != UA_SECURECHANNELSTATE_OPEN)
+        return NULL;
+    return channel;
+}
+
+/* Process the request like in the server thread. The response is not sent if
+ * the SecureChannel was closed in the meantime. */
+static void
+processExclusiveServiceJob(UA_Server *server, UA_ServiceJob *job,
+                           const UA_Request *request, UA_Response *response) {
+    UA_ServiceDescription *sd = job->sd;
+    lockServer(server);
+    UA_SecureChannel *channel = getServiceJobChannel(server, job);
+    if(channel) {
+        UA_Boolean async = UA_Server_processRequest(server, channel, job->requestId,
+                                                    sd, request, response);
+        if(!async) {
+            UA_StatusCode res = sendResponse(server, channel, job->requestId,
+                                             response, sd->responseType);
+            if(res != UA_STATUSCODE_GOOD)
+                UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
+                                       "Could not send the response with "
+                                       "StatusCode %s", UA_StatusCode_name(res));
+        }
+    }
+    unlockServer(server);
+}
+
+UA_Boolean
+UA_Server_processQueuedRequest(UA_Server *server) {
+    /* Take the first job whose session is not processed in another thread.
+     * This keeps the order of requests within the session and protects the
+     * session state (e.g. continuation points). */
+    UA_LOCK(&server->serviceJobsLock);
+    UA_ServiceJob *job;
+    TAILQ_FOREACH(job, &server->serviceJobs, pointers) {
+        if(!job->session->serviceJobActive)
+            break;
+    }
+    if(job) {
+        TAILQ_REMOVE(&server->serviceJobs, job, pointers);
+        server->serviceJobsSize--;
+        job->session->serviceJobActive = true;
+    }
+    UA_UNLOCK(&server->serviceJobsLock);
+    if(!job)
+        return false;
+
+    /* Decode the request without holding a lock */
+    UA_ServiceDescription *sd = job->sd;
+    UA_Response response;
+    UA_init(&response, sd->responseType);
+    response.responseHeader.requestHandle = job->requestHandle;
+    UA_Request request;
+    UA_DecodeBinaryOptions opt;
+    memset(&opt, 0, sizeof(UA_DecodeBinaryOptions));
+    opt.customTypes = server->config.customDataTypes;
+    size_t offset = 0;
+    UA_StatusCode res = UA_decodeBinaryInternal(&job->msg, &offset, &request,
+                                                sd->requestType, &opt);
+    if(res != UA_STATUSCODE_GOOD) {
+        response.responseHeader.serviceResult = res;
+    } else if(job->exclusive) {
+        /* Processed and sent with the exclusive lock */
+        processExclusiveServiceJob(server, job, &request, &response);
+        UA_clear(&request, sd->requestType);
+    } else {
+        /* Execute the service with the shared lock. The session might have
+         * been closed in the meantime. */
+        lockServerShared(server);
+        if(job->session->activated)
+            sd->serviceCallback(server, job->session, &request, &response);
+        else
+            response.responseHeader.serviceResult = UA_STATUSCODE_BADSESSIONCLOSED;
+        updateServiceDiagnostics(job->session, sd, &response);
+        unlockServerShared(server);
+        UA_clear(&request, sd->requestType);
+    }
+
+    /* The session is no longer used */
+    releaseServiceJob(server, job);
+
+    /* Send the response if the SecureChannel is still open */
+    if(res != UA_STATUSCODE_GOOD || !job->exclusive) {
+        UA_EventLoop *el = server->config.eventLoop;
+        el->lock(el);
+        UA_SecureChannel *channel = getServiceJobChannel(server, job);
+        if(channel) {
+            res = sendResponse(server, channel, job->requestId,
+                               &response, sd->responseType);
+            if(res != UA_STATUSCODE_GOOD)
+                UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
+                                       "Could not send the response with "
+                                       "StatusCode %s", UA_StatusCode_name(res));
         }
+        el->unlock(el);
     }
+
+    /* Clean up */
+    UA_clear(&response, sd->responseType);
+    UA_ByteString_clear(&job->msg);
+    UA_free(job);
+    return true;
+}
+
+void
+UA_Server_clearServiceJobs(UA_Server *server) {
+    UA_ServiceJob *job, *job_tmp;
+    UA_LOCK(&server->serviceJobsLock);
+    TAILQ_FOREACH_SAFE(job, &server->serviceJobs, pointers, job_tmp) {
+        TAILQ_REMOVE(&server->serviceJobs, job, pointers);
+        server->serviceJobsSize--;
+        job->session->serviceJobs--;
+        UA_ByteString_clear(&job->msg);
+        UA_free(job);
+    }
+    UA_UNLOCK(&server->serviceJobsLock);
+}
+
+/* The mbedTLS SecurityPolicies share the random number generator (and the HMAC
+ * context) between all channels. Then the handshakes remain in the server
+ * thread. */
+UA_Boolean
+UA_Server_useHandshakeWorkers(const UA_Server *server) {
+#ifdef UA_ENABLE_ENCRYPTION_MBEDTLS
+    (void)server;
+    return false;
+#else
+    return server->config.handshakeWorkers;
 #endif
+}
 
-    return async;
+void
+UA_HandshakeJob_init(UA_HandshakeJob *job, UA_HandshakeJobType type) {
+    job->type = type;
+    job->state = UA_HANDSHAKEJOBSTATE_PENDING;
+    job->canceled = false;
+    UA_LOCK_INIT(&job->processLock);
+}
+
+void
+UA_HandshakeJob_clear(UA_HandshakeJob *job) {
+    UA_LOCK_DESTROY(&job->processLock);
+}
+
+/* Release pending jobs to the workers while below the maxParallelHandshakes
+ * limit. Returns whether a job was released. */
+static UA_Boolean
+releaseHandshakeJobs(UA_Server *server) {
+    UA_LOCK_ASSERT(&server->handshakeJobsLock);
+    size_t max = server->config.maxParallelHandshakes;
+    UA_Boolean released = false;
+    UA_HandshakeJob *job;
+    TAILQ_FOREACH(job, &server->handshakeJobs, pointers) {
+        if(max != 0 && server->handshakeJobsActive >= max)
+            break;
+        if(job->state != UA_HANDSHAKEJOBSTATE_PENDING)
+            continue;
+        job->state = UA_HANDSHAKEJOBSTATE_QUEUED;
+        server->handshakeJobsActive++;
+        released = true;
+    }
+    return released;
+}
+
+static void
+notifyHandshakeWorkers(UA_Server *server, UA_Boolean released) {
+    if(released && server->config.handshakeWorkerNotifyCallback)
+        server->config.handshakeWorkerNotifyCallback(server);
 }
+
+/* Server thread: The worker is done */
+static void
+handshakeJobCallback(void *application, void *context) {
+    /* Canceled while the worker processed it. The server might be gone. */
+    UA_HandshakeJob *job = (UA_HandshakeJob*)context;
+    if(job->canceled) {
+        job->free(job);
+        return;
+    }
+
+    /* Release the slot */
+    UA_Server *server = (UA_Server*)application;
+    UA_LOCK(&server->handshakeJobsLock);
+    TAILQ_REMOVE(&server->handshakeJobs, job, pointers);
+    server->handshakeJobsActive--;
+    UA_Boolean released = releaseHandshakeJobs(server);
+    UA_UNLOCK(&server->handshakeJobsLock);
+    notifyHandshakeWorkers(server, released);
+
+    job->complete(server, job);
+}
+
+void
+UA_Server_submitHandshakeJob(UA_Server *server, UA_HandshakeJob *job) {
+    job->state = UA_HANDSHAKEJOBSTATE_PENDING;
+    job->dc.callback = handshakeJobCallback;
+    job->dc.application = server;
+    job->dc.context = job;
+    UA_LOCK(&server->handshakeJobsLock);
+    TAILQ_INSERT_TAIL(&server->handshakeJobs, job, pointers);
+    UA_Boolean released = releaseHandshakeJobs(server);
+    UA_UNLOCK(&server->handshakeJobsLock);
+    notifyHandshakeWorkers(server, released);
+}
+
+void
+UA_Server_cancelHandshakeJob(UA_Server *server, UA_HandshakeJob *job) {
+    UA_LOCK(&server->handshakeJobsLock);
+    UA_HandshakeJobState state = job->state;
+    TAILQ_REMOVE(&server->handshakeJobs, job, pointers);
+    if(state != UA_HANDSHAKEJOBSTATE_PENDING)
+        server->handshakeJobsActive--;
+    job->canceled = true;
+    UA_Boolean released = releaseHandshakeJobs(server);
+    UA_UNLOCK(&server->handshakeJobsLock);
+    notifyHandshakeWorkers(server, released);
+
+    /* Not yet taken by a worker */
+    if(state == UA_HANDSHAKEJOBSTATE_PENDING ||
+       state == UA_HANDSHAKEJOBSTATE_QUEUED) {
+        job->free(job);
+        return;
+    }
+
+    /* Wait until the worker is done. The completion callback frees the job. */
+    if(state == UA_HANDSHAKEJOBSTATE_PROCESSING) {
+        UA_LOCK(&job->processLock);
+        UA_UNLOCK(&job->processLock);
+    }
+}
+
+void
+UA_Server_clearHandshakeJobs(UA_Server *server) {
+    UA_HandshakeJob *job;
+    while((job = TAILQ_FIRST(&server->handshakeJobs)))
+        UA_Server_cancelHandshakeJob(server, job);
+}
+
+UA_Boolean
+UA_Server_processHandshakeJob(UA_Server *server) {
+    /* Take the first job released to the workers. Hold the processLock until
+     * the job is done. */
+    UA_LOCK(&server->handshakeJobsLock);
+    UA_HandshakeJob *job;
+    TAILQ_FOREACH(job, &server->handshakeJobs, pointers) {
+        if(job->state == UA_HANDSHAKEJOBSTATE_QUEUED)
+            break;
+    }
+    if(job) {
+        job->state = UA_HANDSHAKEJOBSTATE_PROCESSING;
+        UA_LOCK(&job->processLock);
+    }
+    UA_UNLOCK(&server->handshakeJobsLock);
+    if(!job)
+        return false;
+
+    /* Process without holding a lock */
+    job->process(job);
+
+    UA_LOCK(&server->handshakeJobsLock);
+    job->state = UA_HANDSHAKEJOBSTATE_DONE;
+    server->handshakeJobsProcessed[job->type]++;
+    UA_UNLOCK(&job->processLock);
+    UA_UNLOCK(&server->handshakeJobsLock);
+
+    /* Continue in the server thread. The job must not be used afterwards. */
+    UA_EventLoop *el = server->config.eventLoop;
+    el->addDelayedCallback(el, &job->dc);
+    el->cancel(el); /* Wake up the server thread */
+    return true;
+}
+
+#endif /* UA_MULTITHREADING >= 100 */
@@ -35,6 +35,7 @@ typedef struct {
     UA_Service serviceCallback;
     const UA_DataType *requestType;
     const UA_DataType *responseType;
+    UA_Boolean readOnly; /* Can be executed with the shared server lock */
 } UA_ServiceDescription;
 
 /* Returns NULL if none found */
@@ -85,6 +86,22 @@ void Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
                              const UA_ActivateSessionRequest *request,
                              UA_ActivateSessionResponse *response);
 
+#if UA_MULTITHREADING >= 100
+/* The asymmetric cryptography is done by the handshake workers. The response
+ * is sent when the job completes if finished is set to false. */
+void Service_CreateSessionAsync(UA_Server *server, UA_SecureChannel *channel,
+                                UA_UInt32 requestId,
+                                const UA_CreateSessionRequest *request,
+                                UA_CreateSessionResponse *response,
+                                UA_Boolean *finished);
+
+void Service_ActivateSessionAsync(UA_Server *server, UA_SecureChannel *channel,
+                                  UA_UInt32 requestId,
+                                  const UA_ActivateSessionRequest *request,
+                                  UA_ActivateSessionResponse *response,
+                                  UA_Boolean *finished);
+#endif
+
 void Service_CloseSession(UA_Server *server, UA_SecureChannel *channel,
                           const UA_CloseSessionRequest *request,
                           UA_CloseSessionResponse *response);
@@ -19,6 +19,19 @@
 /* Delayed callback to free the session memory */
 static void
 removeSessionCallback(UA_Server *server, session_list_entry *entry) {
+#if UA_MULTITHREADING >= 100
+    /* Requests for the session are still with the service workers. Try again
+     * in the next iteration of the EventLoop. */
+    UA_LOCK(&server->serviceJobsLock);
+    size_t serviceJobs = entry->session.serviceJobs;
+    UA_UNLOCK(&server->serviceJobsLock);
+    if(serviceJobs > 0) {
+        UA_EventLoop *el = server->config.eventLoop;
+        el->addDelayedCallback(el, &entry->cleanupCallback);
+        return;
+    }
+#endif
+
     lockServer(server);
     UA_Session_clear(&entry->session, server);
     unlockServer(server);
@@ -65,6 +78,8 @@ UA_Server_removeSession(UA_Server *server, session_list_entry *sentry,
     /* Detach the session from the session manager and make the capacity
      * available */
     LIST_REMOVE(sentry, pointers);
+    ZIP_REMOVE(UA_SessionIdTree, &server->sessionsById, sentry);
+    ZIP_REMOVE(UA_SessionTokenTree, &server->sessionsByToken, sentry);
     server->sessionCount--;
 
     switch(shutdownReason) {
@@ -101,14 +116,12 @@ UA_StatusCode
 UA_Server_removeSessionByToken(UA_Server *server, const UA_NodeId *token,
                                UA_ShutdownReason shutdownReason) {
     UA_LOCK_ASSERT(&server->serviceMutex);
-    session_list_entry *entry;
-    LIST_FOREACH(entry, &server->sessions, pointers) {
-        if(UA_NodeId_equal(&entry->session.authenticationToken, token)) {
-            UA_Server_removeSession(server, entry, shutdownReason);
-            return UA_STATUSCODE_GOOD;
-        }
-    }
-    return UA_STATUSCODE_BADSESSIONIDINVALID;
+    session_list_entry *entry =
+        ZIP_FIND(UA_SessionTokenTree, &server->sessionsByToken, token);
+    if(!entry)
+        return UA_STATUSCODE_BADSESSIONIDINVALID;
+    UA_Server_removeSession(server, entry, shutdownReason);
+    return UA_STATUSCODE_GOOD;
 }
 
 void
@@ -129,52 +142,44 @@ UA_Server_cleanupSessions(UA_Server *server, UA_DateTime nowMonotonic) {
 /* Services */
 /************/
 
-UA_Session *
-getSessionByToken(UA_Server *server, const UA_NodeId *token) {
-    UA_LOCK_ASSERT(&server->serviceMutex);
-
-    session_list_entry *current = NULL;
-    LIST_FOREACH(current, &server->sessions, pointers) {
-        /* Token does not match */
-        if(!UA_NodeId_equal(&current->session.authenticationToken, token))
-            continue;
+enum ZIP_CMP
+cmpSessionNodeId(const UA_NodeId *a, const UA_NodeId *b) {
+    return (enum ZIP_CMP)UA_NodeId_order(a, b);
+}
 
-        /* Session has timed out */
-        UA_EventLoop *el = server->config.eventLoop;
-        UA_DateTime now = el->dateTime_nowMonotonic(el);
-        if(now > current->session.validTill) {
-            UA_LOG_INFO_SESSION(server->config.logging, &current->session,
-                                "Client tries to use a session that has timed out");
-            return NULL;
-        }
+static UA_Session *
+checkSessionTimeout(UA_Server *server, session_list_entry *entry) {
+    if(!entry)
+        return NULL;
 
-        return &current->session;
+    /* Session has timed out */
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    if(now > entry->session.validTill) {
+        UA_LOG_INFO_SESSION(server->config.logging, &entry->session,
+                            "Client tries to use a session that has timed out");
+        return NULL;
     }
 
-    return NULL;
+    return &entry->session;
 }
 
 UA_Session *
-getSessionById(UA_Server *server, const UA_NodeId *sessionId) {
+getSessionByToken(UA_Server *server, const UA_NodeId *token) {
     UA_LOCK_ASSERT(&server->serviceMutex);
+    session_list_entry *entry =
+        ZIP_FIND(UA_SessionTokenTree, &server->sessionsByToken, token);
+    return checkSessionTimeout(server, entry);
+}
 
-    session_list_entry *current = NULL;
-    LIST_FOREACH(current, &server->sessions, pointers) {
-        /* Token does not match */
-        if(!UA_NodeId_equal(&current->session.sessionId, sessionId))
-            continue;
-
-        /* Session has timed out */
-        UA_EventLoop *el = server->config.eventLoop;
-        UA_DateTime now = el->dateTime_nowMonotonic(el);
-        if(now > current->session.validTill) {
-            UA_LOG_INFO_SESSION(server->config.logging, &current->session,
-                                "Client tries to use a session that has timed out");
-            return NULL;
-        }
+UA_Session *
+getSessionById(UA_Server *server, const UA_NodeId *sessionId) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
 
-        return &current->session;
-    }
+    session_list_entry *entry =
+        ZIP_FIND(UA_SessionIdTree, &server->sessionsById, sessionId);
+    if(entry)
+        return checkSessionTimeout(server, entry);
 
     if(UA_NodeId_equal(sessionId, &server->adminSession.sessionId))
         return &server->adminSession;
@@ -182,47 +187,52 @@ getSessionById(UA_Server *server, const UA_NodeId *sessionId) {
     return NULL;
 }
 
+/* Sign the client certificate and nonce. Uses neither the Session nor the
+ * SecureChannel. So this can be done in a handshake worker. */
 static UA_StatusCode
-signCreateSessionResponse(UA_Server *server, UA_SecureChannel *channel,
-                          const UA_CreateSessionRequest *request,
-                          UA_CreateSessionResponse *response) {
-    if(channel->securityMode != UA_MESSAGESECURITYMODE_SIGN &&
-       channel->securityMode != UA_MESSAGESECURITYMODE_SIGNANDENCRYPT)
-        return UA_STATUSCODE_GOOD;
-
-    const UA_SecurityPolicy *securityPolicy = channel->securityPolicy;
-    UA_SignatureData *signatureData = &response->serverSignature;
-
+signCreateSession(const UA_SecurityPolicy *securityPolicy, void *channelContext,
+                  const UA_ByteString *clientCertificate,
+                  const UA_ByteString *clientNonce,
+                  UA_SignatureData *signatureData) {
     /* Prepare the signature */
     const UA_SecurityPolicySignatureAlgorithm *signAlg =
         &securityPolicy->asymmetricModule.cryptoModule.signatureAlgorithm;
-    size_t signatureSize = signAlg->getLocalSignatureSize(channel->channelContext);
+    size_t signatureSize = signAlg->getLocalSignatureSize(channelContext);
     UA_StatusCode retval = UA_String_copy(&signAlg->uri, &signatureData->algorithm);
     retval |= UA_ByteString_allocBuffer(&signatureData->signature, signatureSize);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
     /* Allocate a temp buffer */
-    size_t dataToSignSize =
-        request->clientCertificate.length + request->clientNonce.length;
+    size_t dataToSignSize = clientCertificate->length + clientNonce->length;
     UA_ByteString dataToSign;
     retval = UA_ByteString_allocBuffer(&dataToSign, dataToSignSize);
     if(retval != UA_STATUSCODE_GOOD)
         return retval; /* signatureData->signature is cleaned up with the response */
 
     /* Sign the signature */
-    memcpy(dataToSign.data, request->clientCertificate.data,
-           request->clientCertificate.length);
-    memcpy(dataToSign.data + request->clientCertificate.length,
-           request->clientNonce.data, request->clientNonce.length);
-    retval = securityPolicy->asymmetricModule.cryptoModule.signatureAlgorithm.
-        sign(channel->channelContext, &dataToSign, &signatureData->signature);
+    memcpy(dataToSign.data, clientCertificate->data, clientCertificate->length);
+    memcpy(dataToSign.data + clientCertificate->length,
+           clientNonce->data, clientNonce->length);
+    retval = signAlg->sign(channelContext, &dataToSign, &signatureData->signature);
 
     /* Clean up */
     UA_ByteString_clear(&dataToSign);
     return retval;
 }
 
+static UA_StatusCode
+signCreateSessionResponse(UA_SecureChannel *channel,
+                          const UA_CreateSessionRequest *request,
+                          UA_CreateSessionResponse *response) {
+    if(channel->securityMode != UA_MESSAGESECURITYMODE_SIGN &&
+       channel->securityMode != UA_MESSAGESECURITYMODE_SIGNANDENCRYPT)
+        return UA_STATUSCODE_GOOD;
+    return signCreateSession(channel->securityPolicy, channel->channelContext,
+                             &request->clientCertificate, &request->clientNonce,
+                             &response->serverSignature);
+}
+
 /* Creates and adds a session. But it is not yet attached to a secure channel. */
 UA_StatusCode
 UA_Server_createSession(UA_Server *server, UA_SecureChannel *channel,
@@ -261,16 +271,20 @@ UA_Server_createSession(UA_Server *server, UA_SecureChannel *channel,
 
     /* Add to the server */
     LIST_INSERT_HEAD(&server->sessions, newentry, pointers);
+    ZIP_INSERT(UA_SessionIdTree, &server->sessionsById, newentry);
+    ZIP_INSERT(UA_SessionTokenTree, &server->sessionsByToken, newentry);
     server->sessionCount++;
 
     *session = &newentry->session;
     return UA_STATUSCODE_GOOD;
 }
 
-void
-Service_CreateSession(UA_Server *server, UA_SecureChannel *channel,
-                      const UA_CreateSessionRequest *request,
-                      UA_CreateSessionResponse *response) {
+/* Without the signature, the CreateSessionResponse is signed by a handshake
+ * worker afterwards */
+static void
+createSession(UA_Server *server, UA_SecureChannel *channel,
+              const UA_CreateSessionRequest *request,
+              UA_CreateSessionResponse *response, UA_Boolean sign) {
     UA_LOCK_ASSERT(&server->serviceMutex);
     UA_LOG_DEBUG_CHANNEL(server->config.logging, channel, "Trying to create session");
 
@@ -379,8 +393,9 @@ Service_CreateSession(UA_Server *server, UA_SecureChannel *channel,
             UA_ByteString_copy(&sp->localCertificate, &response->serverCertificate);
 
     /* Sign the signature */
-    response->responseHeader.serviceResult |=
-       signCreateSessionResponse(server, channel, request, response);
+    if(sign)
+        response->responseHeader.serviceResult |=
+            signCreateSessionResponse(channel, request, response);
 
     /* Failure -> remove the session */
     if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
@@ -402,8 +417,156 @@ Service_CreateSession(UA_Server *server, UA_SecureChannel *channel,
     UA_LOG_INFO_SESSION(server->config.logging, newSession, "Session created");
 }
 
+void
+Service_CreateSession(UA_Server *server, UA_SecureChannel *channel,
+                      const UA_CreateSessionRequest *request,
+                      UA_CreateSessionResponse *response) {
+    createSession(server, channel, request, response, true);
+}
+
+#if UA_MULTITHREADING >= 100
+
+/* Get the SecureChannel of a handshake job. Returns NULL if the channel was
+ * closed in the meantime. */
+static UA_SecureChannel *
+getOpenChannel(UA_Server *server, UA_UInt32 channelId) {
+    UA_SecureChannel *channel;
+    TAILQ_FOREACH(channel, &server->channels, serverEntry) {
+        if(channel->securityToken.channelId != channelId)
+            continue;
+        if(channel->state != UA_SECURECHANNELSTATE_OPEN)
+            return NULL;
+        return channel;
+    }
+    return NULL;
+}
+
+/* The CreateSessionResponse is signed by a handshake worker. The job is
+ * self-contained and uses a temporary channel context for the signature. */
+typedef struct {
+    UA_HandshakeJob job;
+    const UA_SecurityPolicy *sp;
+    UA_ByteString clientCertificate;
+    UA_ByteString clientNonce;
+    UA_UInt32 channelId;
+    UA_UInt32 requestId;
+    UA_StatusCode res;
+    UA_CreateSessionResponse response;
+} UA_CreateSessionJob;
+
+static void
+processCreateSessionJob(UA_HandshakeJob *hj) {
+    UA_CreateSessionJob *job = (UA_CreateSessionJob*)hj;
+    const UA_SecurityPolicy *sp = job->sp;
+    void *tempChannelContext = NULL;
+    job->res = sp->channelModule.newContext(sp, &sp->localCertificate,
+                                            &tempChannelContext);
+    if(job->res != UA_STATUSCODE_GOOD)
+        return;
+    job->res = signCreateSession(sp, tempChannelContext, &job->clientCertificate,
+                                 &job->clientNonce, &job->response.serverSignature);
+    sp->channelModule.deleteContext(tempChannelContext);
+}
+
+static void
+freeCreateSessionJob(UA_HandshakeJob *hj) {
+    UA_CreateSessionJob *job = (UA_CreateSessionJob*)hj;
+    UA_ByteString_clear(&job->clientCertificate);
+    UA_ByteString_clear(&job->clientNonce);
+    UA_CreateSessionResponse_clear(&job->response);
+    UA_HandshakeJob_clear(&job->job);
+    UA_free(job);
+}
+
+static void
+completeCreateSessionJob(UA_Server *server, UA_HandshakeJob *hj) {
+    UA_CreateSessionJob *job = (UA_CreateSessionJob*)hj;
+    UA_CreateSessionResponse *response = &job->response;
+
+    /* Failure or the channel was closed -> remove the session */
+    lockServer(server);
+    UA_SecureChannel *channel = getOpenChannel(server, job->channelId);
+    if(job->res != UA_STATUSCODE_GOOD || !channel) {
+        UA_Server_removeSessionByToken(server, &response->authenticationToken,
+                                       UA_SHUTDOWNREASON_REJECT);
+        response->responseHeader.serviceResult = (job->res != UA_STATUSCODE_GOOD) ?
+            job->res : UA_STATUSCODE_BADSECURECHANNELCLOSED;
+    }
+    unlockServer(server);
+
+    /* Send the response */
+    if(channel) {
+        UA_StatusCode res =
+            sendResponse(server, channel, job->requestId, (UA_Response*)response,
+                         &UA_TYPES[UA_TYPES_CREATESESSIONRESPONSE]);
+        if(res != UA_STATUSCODE_GOOD)
+            UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
+                                   "Could not send the response with "
+                                   "StatusCode %s", UA_StatusCode_name(res));
+    }
+
+    freeCreateSessionJob(hj);
+}
+
+void
+Service_CreateSessionAsync(UA_Server *server, UA_SecureChannel *channel,
+                           UA_UInt32 requestId, const UA_CreateSessionRequest *request,
+                           UA_CreateSessionResponse *response, UA_Boolean *finished) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    *finished = true;
+
+    /* Nothing to sign */
+    if(channel->securityMode != UA_MESSAGESECURITYMODE_SIGN &&
+       channel->securityMode != UA_MESSAGESECURITYMODE_SIGNANDENCRYPT) {
+        createSession(server, channel, request, response, true);
+        return;
+    }
+
+    createSession(server, channel, request, response, false);
+    if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+        return;
+
+    /* Prepare the job. Sign right away if that fails. */
+    UA_CreateSessionJob *job = (UA_CreateSessionJob*)
+        UA_calloc(1, sizeof(UA_CreateSessionJob));
+    UA_StatusCode res = UA_STATUSCODE_BADOUTOFMEMORY;
+    if(job) {
+        res = UA_ByteString_copy(&request->clientCertificate, &job->clientCertificate);
+        res |= UA_ByteString_copy(&request->clientNonce, &job->clientNonce);
+    }
+    if(res != UA_STATUSCODE_GOOD) {
+        if(job) {
+            UA_ByteString_clear(&job->clientCertificate);
+            UA_ByteString_clear(&job->clientNonce);
+            UA_free(job);
+        }
+        res = signCreateSessionResponse(channel, request, response);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_Server_removeSessionByToken(server, &response->authenticationToken,
+                                           UA_SHUTDOWNREASON_REJECT);
+            response->responseHeader.serviceResult = res;
+        }
+        return;
+    }
+
+    /* Move the response into the job */
+    UA_HandshakeJob_init(&job->job, UA_HANDSHAKEJOBTYPE_CREATESESSION);
+    job->job.process = processCreateSessionJob;
+    job->job.complete = completeCreateSessionJob;
+    job->job.free = freeCreateSessionJob;
+    job->sp = channel->securityPolicy;
+    job->channelId = channel->securityToken.channelId;
+    job->requestId = requestId;
+    job->response = *response;
+    UA_CreateSessionResponse_init(response);
+    UA_Server_submitHandshakeJob(server, &job->job);
+    *finished = false;
+}
+
+#endif /* UA_MULTITHREADING >= 100 */
+
 static UA_StatusCode
-checkCertificateSignature(const UA_Server *server, const UA_SecurityPolicy *securityPolicy,
+checkCertificateSignature(const UA_SecurityPolicy *securityPolicy,
                           void *channelContext, const UA_ByteString *serverNonce,
                           const UA_SignatureData *signature,
                           const bool isUserTokenSignature) {
@@ -558,22 +721,12 @@ selectEndpointAndTokenPolicy(UA_Server *server, UA_SecureChannel *channel,
     }
 }
 
+/* Decrypt the secret of an encrypted UserToken (not for the None
+ * SecurityPolicy). Uses neither the Session nor the SecureChannel. So this can
+ * be done in a handshake worker. */
 static UA_StatusCode
-decryptUserToken(UA_Server *server, UA_Session *session,
-                 UA_SecureChannel *channel, const UA_SecurityPolicy *sp,
-                 const UA_String encryptionAlgorithm, UA_ByteString *encrypted) {
-    /* If SecurityPolicy is None there shall be no EncryptionAlgorithm  */
-    if(UA_String_equal(&sp->policyUri, &UA_SECURITY_POLICY_NONE_URI)) {
-        if(encryptionAlgorithm.length > 0)
-            return UA_STATUSCODE_BADIDENTITYTOKENINVALID;
-        if(channel->securityMode == UA_MESSAGESECURITYMODE_NONE) {
-            UA_LOG_WARNING_SESSION(server->config.logging, session, "ActivateSession: "
-                                   "Received an unencrypted UserToken. "
-                                   "Is the server misconfigured to allow that?");
-        }
-        return UA_STATUSCODE_GOOD;
-    }
-
+decryptUserTokenSecret(const UA_SecurityPolicy *sp, const UA_ByteString *sn,
+                       const UA_String encryptionAlgorithm, UA_ByteString *encrypted) {
     /* Test if the correct encryption algorithm is used */
     if(!UA_String_equal(&encryptionAlgorithm,
                         &sp->asymmetricModule.cryptoModule.encryptionAlgorithm.uri))
@@ -584,18 +737,13 @@ decryptUserToken(UA_Server *server, UA_Session *session,
      * decryption where the remote certificate is not used. */
     void *tempChannelContext = NULL;
     UA_StatusCode res = sp->channelModule.newContext(sp, &sp->localCertificate, &tempChannelContext);
-    if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_SESSION(server->config.logging, session,
-                               "ActivateSession: Failed to create a context for "
-                               "the SecurityPolicy %S", sp->policyUri);
+    if(res != UA_STATUSCODE_GOOD)
         return res;
-    }
 
     UA_UInt32 secretLen = 0;
     UA_ByteString secret, tokenNonce;
     size_t tokenpos = 0;
     size_t offset = 0;
-    UA_ByteString *sn = &session->serverNonce;
     const UA_SecurityPolicyEncryptionAlgorithm *asymEnc =
         &sp->asymmetricModule.cryptoModule.encryptionAlgorithm;
 
@@ -647,7 +795,27 @@ decryptUserToken(UA_Server *server, UA_Session *session,
 
     /* Remove the temporary channel context */
     sp->channelModule.deleteContext(tempChannelContext);
+    return res;
+}
+
+static UA_StatusCode
+decryptUserToken(UA_Server *server, UA_Session *session,
+                 UA_SecureChannel *channel, const UA_SecurityPolicy *sp,
+                 const UA_String encryptionAlgorithm, UA_ByteString *encrypted) {
+    /* If SecurityPolicy is None there shall be no EncryptionAlgorithm  */
+    if(UA_String_equal(&sp->policyUri, &UA_SECURITY_POLICY_NONE_URI)) {
+        if(encryptionAlgorithm.length > 0)
+            return UA_STATUSCODE_BADIDENTITYTOKENINVALID;
+        if(channel->securityMode == UA_MESSAGESECURITYMODE_NONE) {
+            UA_LOG_WARNING_SESSION(server->config.logging, session, "ActivateSession: "
+                                   "Received an unencrypted UserToken. "
+                                   "Is the server misconfigured to allow that?");
+        }
+        return UA_STATUSCODE_GOOD;
+    }
 
+    UA_StatusCode res = decryptUserTokenSecret(sp, &session->serverNonce,
+                                               encryptionAlgorithm, encrypted);
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_SESSION(server->config.logging, session,
                                "ActivateSession: Failed to decrypt the "
@@ -657,10 +825,12 @@ decryptUserToken(UA_Server *server, UA_Session *session,
     return res;
 }
 
+/* Check the signature of a X509IdentityToken. Uses neither the Session nor the
+ * SecureChannel. So this can be done in a handshake worker. */
 static UA_StatusCode
-checkActivateSessionX509(UA_Server *server, UA_Session *session,
-                         const UA_SecurityPolicy *sp, UA_X509IdentityToken* token,
-                         const UA_SignatureData *tokenSignature) {
+checkUserTokenSignature(const UA_SecurityPolicy *sp, const UA_ByteString *serverNonce,
+                        const UA_X509IdentityToken *token,
+                        const UA_SignatureData *tokenSignature) {
     /* The SecurityPolicy must not be None for the signature */
     if(UA_String_equal(&sp->policyUri, &UA_SECURITY_POLICY_NONE_URI))
         return UA_STATUSCODE_BADIDENTITYTOKENINVALID;
@@ -668,28 +838,43 @@ checkActivateSessionX509(UA_Server *server, UA_Session *session,
     /* We need a channel context with the user certificate in order to reuse
      * the signature checking code. */
     void *tempChannelContext;
-    UA_StatusCode res = sp->channelModule. newContext(sp, &token->certificateData, &tempChannelContext);
-    if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_SESSION(server->config.logging, session,
-                               "ActivateSession: Failed to create a context "
-                               "for the SecurityPolicy %S", sp->policyUri);
+    UA_StatusCode res = sp->channelModule.newContext(sp, &token->certificateData,
+                                                     &tempChannelContext);
+    if(res != UA_STATUSCODE_GOOD)
         return res;
-    }
 
     /* Check the user token signature */
-    res = checkCertificateSignature(server, sp, tempChannelContext,
-                                    &session->serverNonce, tokenSignature, true);
+    res = checkCertificateSignature(sp, tempChannelContext, serverNonce,
+                                    tokenSignature, true);
+
+    /* Delete the temporary channel context */
+    sp->channelModule.deleteContext(tempChannelContext);
+    return res;
+}
+
+static UA_StatusCode
+checkActivateSessionX509(UA_Server *server, UA_Session *session,
+                         const UA_SecurityPolicy *sp, UA_X509IdentityToken* token,
+                         const UA_SignatureData *tokenSignature) {
+    UA_StatusCode res = checkUserTokenSignature(sp, &session->serverNonce,
+                                                token, tokenSignature);
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_SESSION(server->config.logging, session,
                                "ActivateSession: User token signature check "
                                "failed with StatusCode %s", UA_StatusCode_name(res));
     }
-
-    /* Delete the temporary channel context */
-    sp->channelModule.deleteContext(tempChannelContext);
     return res;
 }
 
+/* The asymmetric cryptography of ActivateSession was done by a handshake
+ * worker */
+typedef struct {
+    UA_Boolean clientSignatureChecked;
+    UA_StatusCode clientSignatureResult;
+    UA_Boolean userTokenChecked; /* The token in the request is decrypted */
+    UA_StatusCode userTokenResult;
+} UA_ActivateSessionCrypto;
+
 /* TODO: Check all of the following: The Server shall verify that the
  * Certificate the Client used to create the new SecureChannel is the same as
  * the Certificate used to create the original SecureChannel. In addition, the
@@ -698,10 +883,11 @@ checkActivateSessionX509(UA_Server *server, UA_Session *session,
  * accepts the new SecureChannel it shall reject requests sent via the old
  * SecureChannel. */
 
-void
-Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
-                        const UA_ActivateSessionRequest *req,
-                        UA_ActivateSessionResponse *resp) {
+static void
+activateSession(UA_Server *server, UA_SecureChannel *channel,
+                const UA_ActivateSessionRequest *req,
+                UA_ActivateSessionResponse *resp,
+                const UA_ActivateSessionCrypto *crypto) {
     UA_LOCK_ASSERT(&server->serviceMutex);
     const UA_EndpointDescription *ed = NULL;
     const UA_UserTokenPolicy *utp = NULL;
@@ -744,7 +930,8 @@ Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
     if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGN ||
        channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT) {
         resp->responseHeader.serviceResult =
-            checkCertificateSignature(server, channel->securityPolicy,
+            (crypto && crypto->clientSignatureChecked) ? crypto->clientSignatureResult :
+            checkCertificateSignature(channel->securityPolicy,
                                       channel->channelContext,
                                       &session->serverNonce,
                                       &req->clientSignature, false);
@@ -768,7 +955,15 @@ Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
 
     /* Decrypt (or validate the signature) of the UserToken. The DataType of the
      * UserToken was already checked in selectEndpointAndTokenPolicy */
-    if(utp->tokenType == UA_USERTOKENTYPE_USERNAME) {
+    if(crypto && crypto->userTokenChecked) {
+        /* The token was already decrypted in the request */
+        resp->responseHeader.serviceResult = crypto->userTokenResult;
+        if(crypto->userTokenResult != UA_STATUSCODE_GOOD)
+            UA_LOG_WARNING_SESSION(server->config.logging, session,
+                                   "ActivateSession: The UserToken could not be "
+                                   "validated with the StatusCode %s",
+                                   UA_StatusCode_name(crypto->userTokenResult));
+    } else if(utp->tokenType == UA_USERTOKENTYPE_USERNAME) {
         /* If it is a UserNameIdentityToken, the password may be encrypted */
        UA_UserNameIdentityToken *userToken = (UA_UserNameIdentityToken *)
            req->userIdentityToken.content.decoded.data;
@@ -917,6 +1112,204 @@ rejected:
     server->serverDiagnosticsSummary.rejectedSessionCount++;
 }
 
+void
+Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
+                        const UA_ActivateSessionRequest *req,
+                        UA_ActivateSessionResponse *resp) {
+    activateSession(server, channel, req, resp, NULL);
+}
+
+#if UA_MULTITHREADING >= 100
+
+/* The client signature and the UserToken are checked by a handshake worker.
+ * The job works on a copy of the request and uses temporary channel contexts.
+ * Everything else is done in the server thread when the job completes. */
+typedef struct {
+    UA_HandshakeJob job;
+    const UA_SecurityPolicy *sp;      /* NULL if the channel does not sign */
+    const UA_SecurityPolicy *tokenSp; /* NULL if the token is not secured */
+    UA_UserTokenType tokenType;
+    UA_ByteString remoteCertificate;
+    UA_ByteString serverNonce;
+    UA_UInt32 channelId;
+    UA_UInt32 requestId;
+    UA_ActivateSessionRequest request;
+    UA_ActivateSessionCrypto crypto;
+} UA_ActivateSessionJob;
+
+static void
+processActivateSessionJob(UA_HandshakeJob *hj) {
+    UA_ActivateSessionJob *job = (UA_ActivateSessionJob*)hj;
+
+    /* Check the client signature */
+    if(job->sp) {
+        const UA_SecurityPolicy *sp = job->sp;
+        void *tempChannelContext = NULL;
+        UA_StatusCode res = sp->channelModule.newContext(sp, &job->remoteCertificate,
+                                                         &tempChannelContext);
+        if(res == UA_STATUSCODE_GOOD) {
+            res = checkCertificateSignature(sp, tempChannelContext, &job->serverNonce,
+                                            &job->request.clientSignature, false);
+            sp->channelModule.deleteContext(tempChannelContext);
+        }
+        job->crypto.clientSignatureChecked = true;
+        job->crypto.clientSignatureResult = res;
+        if(res != UA_STATUSCODE_GOOD)
+            return;
+    }
+
+    /* Decrypt the UserToken in the request or check its signature */
+    if(!job->tokenSp)
+        return;
+    void *token = job->request.userIdentityToken.content.decoded.data;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(job->tokenType == UA_USERTOKENTYPE_USERNAME) {
+        UA_UserNameIdentityToken *userToken = (UA_UserNameIdentityToken*)token;
+        res = decryptUserTokenSecret(job->tokenSp, &job->serverNonce,
+                                     userToken->encryptionAlgorithm,
+                                     &userToken->password);
+    } else if(job->tokenType == UA_USERTOKENTYPE_CERTIFICATE) {
+        res = checkUserTokenSignature(job->tokenSp, &job->serverNonce,
+                                      (UA_X509IdentityToken*)token,
+                                      &job->request.userTokenSignature);
+    } else if(job->tokenType == UA_USERTOKENTYPE_ISSUEDTOKEN) {
+        UA_IssuedIdentityToken *issuedToken = (UA_IssuedIdentityToken*)token;
+        res = decryptUserTokenSecret(job->tokenSp, &job->serverNonce,
+                                     issuedToken->encryptionAlgorithm,
+                                     &issuedToken->tokenData);
+    }
+    job->crypto.userTokenChecked = true;
+    job->crypto.userTokenResult = res;
+}
+
+static void
+freeActivateSessionJob(UA_HandshakeJob *hj) {
+    UA_ActivateSessionJob *job = (UA_ActivateSessionJob*)hj;
+    UA_ByteString_clear(&job->remoteCertificate);
+    UA_ByteString_clear(&job->serverNonce);
+    UA_ActivateSessionRequest_clear(&job->request);
+    UA_HandshakeJob_clear(&job->job);
+    UA_free(job);
+}
+
+static void
+completeActivateSessionJob(UA_Server *server, UA_HandshakeJob *hj) {
+    UA_ActivateSessionJob *job = (UA_ActivateSessionJob*)hj;
+    UA_ActivateSessionResponse response;
+    UA_ActivateSessionResponse_init(&response);
+    response.responseHeader.requestHandle = job->request.requestHeader.requestHandle;
+
+    /* The channel was closed in the meantime */
+    lockServer(server);
+    UA_SecureChannel *channel = getOpenChannel(server, job->channelId);
+    if(!channel) {
+        unlockServer(server);
+        freeActivateSessionJob(hj);
+        return;
+    }
+
+    /* The checks were made against an outdated server nonce */
+    UA_Session *session =
+        getSessionByToken(server, &job->request.requestHeader.authenticationToken);
+    if(session && !UA_ByteString_equal(&session->serverNonce, &job->serverNonce)) {
+        job->crypto.clientSignatureResult =
+            UA_STATUSCODE_BADAPPLICATIONSIGNATUREINVALID;
+        job->crypto.userTokenResult =
+            (job->tokenType == UA_USERTOKENTYPE_CERTIFICATE) ?
+            UA_STATUSCODE_BADUSERSIGNATUREINVALID :
+            UA_STATUSCODE_BADIDENTITYTOKENINVALID;
+    }
+
+    /* Continue the service in the server thread */
+    activateSession(server, channel, &job->request, &response, &job->crypto);
+    unlockServer(server);
+
+    /* Send the response */
+    UA_StatusCode res =
+        sendResponse(server, channel, job->requestId, (UA_Response*)&response,
+                     &UA_TYPES[UA_TYPES_ACTIVATESESSIONRESPONSE]);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
+                               "Could not send the response with "
+                               "StatusCode %s", UA_StatusCode_name(res));
+
+    UA_ActivateSessionResponse_clear(&response);
+    freeActivateSessionJob(hj);
+}
+
+void
+Service_ActivateSessionAsync(UA_Server *server, UA_SecureChannel *channel,
+                             UA_UInt32 requestId, const UA_ActivateSessionRequest *req,
+                             UA_ActivateSessionResponse *resp, UA_Boolean *finished) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+    *finished = true;
+
+    /* Only the regular cases are handed to the workers. Everything else is
+     * processed right away to generate the correct error response. */
+    const UA_EndpointDescription *ed = NULL;
+    const UA_UserTokenPolicy *utp = NULL;
+    const UA_SecurityPolicy *tokenSp = NULL;
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_Session *session = getSessionByToken(server, &req->requestHeader.authenticationToken);
+    if(session && (session->activated || session->channel == channel) &&
+       session->validTill >= el->dateTime_nowMonotonic(el))
+        selectEndpointAndTokenPolicy(server, channel, &req->userIdentityToken,
+                                     &ed, &utp, &tokenSp);
+    if(!ed || !tokenSp) {
+        activateSession(server, channel, req, resp, NULL);
+        return;
+    }
+
+    /* Is there asymmetric cryptography to do? */
+    UA_Boolean checkSignature =
+        (channel->securityMode == UA_MESSAGESECURITYMODE_SIGN ||
+         channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT);
+    UA_Boolean checkToken =
+        (utp->tokenType == UA_USERTOKENTYPE_CERTIFICATE ||
+         ((utp->tokenType == UA_USERTOKENTYPE_USERNAME ||
+           utp->tokenType == UA_USERTOKENTYPE_ISSUEDTOKEN) &&
+          !UA_String_equal(&tokenSp->policyUri, &UA_SECURITY_POLICY_NONE_URI)));
+    if(!checkSignature && !checkToken) {
+        activateSession(server, channel, req, resp, NULL);
+        return;
+    }
+
+    /* Prepare the job. Process right away if that fails. */
+    UA_ActivateSessionJob *job = (UA_ActivateSessionJob*)
+        UA_calloc(1, sizeof(UA_ActivateSessionJob));
+    if(!job) {
+        activateSession(server, channel, req, resp, NULL);
+        return;
+    }
+    UA_StatusCode res =
+        UA_ActivateSessionRequest_copy(req, &job->request);
+    res |= UA_ByteString_copy(&session->serverNonce, &job->serverNonce);
+    if(checkSignature)
+        res |= UA_ByteString_copy(&channel->remoteCertificate, &job->remoteCertificate);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ActivateSessionRequest_clear(&job->request);
+        UA_ByteString_clear(&job->serverNonce);
+        UA_ByteString_clear(&job->remoteCertificate);
+        UA_free(job);
+        activateSession(server, channel, req, resp, NULL);
+        return;
+    }
+
+    UA_HandshakeJob_init(&job->job, UA_HANDSHAKEJOBTYPE_ACTIVATESESSION);
+    job->job.process = processActivateSessionJob;
+    job->job.complete = completeActivateSessionJob;
+    job->job.free = freeActivateSessionJob;
+    job->sp = (checkSignature) ? channel->securityPolicy : NULL;
+    job->tokenSp = (checkToken) ? tokenSp : NULL;
+    job->tokenType = utp->tokenType;
+    job->channelId = channel->securityToken.channelId;
+    job->requestId = requestId;
+    UA_Server_submitHandshakeJob(server, &job->job);
+    *finished = false;
+}
+
+#endif /* UA_MULTITHREADING >= 100 */
+
 void
 Service_CloseSession(UA_Server *server, UA_SecureChannel *channel,
                      const UA_CloseSessionRequest *request,
@@ -165,7 +165,7 @@ Service_ModifySubscription(UA_Server *server, UA_Session *session,
          * publish interval. This ensures that we have less cyclic callbacks
          * registered and that the notifications are fresh. */
         UA_MonitoredItem *mon;
-        LIST_FOREACH(mon, &sub->monitoredItems, listEntry) {
+        TAILQ_FOREACH(mon, &sub->monitoredItems, listEntry) {
             if(mon->parameters.samplingInterval == sub->publishingInterval ||
                mon->parameters.samplingInterval == oldPublishingInterval) {
                 UA_MonitoredItem_unregisterSampling(server, mon);
@@ -529,13 +529,14 @@ Operation_TransferSubscription(UA_Server *server, UA_Session *session,
     /* <-- The point of no return --> */
 
     /* Move over the MonitoredItems and adjust the backpointers */
-    LIST_INIT(&newSub->monitoredItems);
+    TAILQ_INIT(&newSub->monitoredItems);
     UA_MonitoredItem *mon, *mon_tmp;
-    LIST_FOREACH_SAFE(mon, &sub->monitoredItems, listEntry, mon_tmp) {
-        LIST_REMOVE(mon, listEntry);
+    TAILQ_FOREACH_SAFE(mon, &sub->monitoredItems, listEntry, mon_tmp) {
+        TAILQ_REMOVE(&sub->monitoredItems, mon, listEntry);
         mon->subscription = newSub;
-        LIST_INSERT_HEAD(&newSub->monitoredItems, mon, listEntry);
+        TAILQ_INSERT_TAIL(&newSub->monitoredItems, mon, listEntry);
     }
+    ZIP_INIT(&sub->monitoredItemsById); /* Moved over with the memcpy */
     sub->monitoredItemsSize = 0;
 
     /* Move over the notification queue */
@@ -548,6 +549,8 @@ Operation_TransferSubscription(UA_Server *server, UA_Session *session,
     sub->notificationQueueSize = 0;
     sub->dataChangeNotifications = 0;
     sub->eventNotifications = 0;
+    sub->notificationPool = NULL; /* Moved over with the memcpy */
+    sub->notificationPoolSize = 0;
 
     TAILQ_INIT(&newSub->retransmissionQueue);
     UA_NotificationMessageEntry *nme, *nme_tmp;
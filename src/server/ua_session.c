@@ -248,14 +248,12 @@ UA_Session_queuePublishReq(UA_Session *session, UA_PublishResponseEntry* entry,
 UA_StatusCode
 UA_Server_closeSession(UA_Server *server, const UA_NodeId *sessionId) {
     lockServer(server);
-    session_list_entry *entry;
     UA_StatusCode res = UA_STATUSCODE_BADSESSIONIDINVALID;
-    LIST_FOREACH(entry, &server->sessions, pointers) {
-        if(UA_NodeId_equal(&entry->session.sessionId, sessionId)) {
-            UA_Server_removeSession(server, entry, UA_SHUTDOWNREASON_CLOSE);
-            res = UA_STATUSCODE_GOOD;
-            break;
-        }
+    session_list_entry *entry =
+        ZIP_FIND(UA_SessionIdTree, &server->sessionsById, sessionId);
+    if(entry) {
+        UA_Server_removeSession(server, entry, UA_SHUTDOWNREASON_CLOSE);
+        res = UA_STATUSCODE_GOOD;
     }
     unlockServer(server);
     return res;
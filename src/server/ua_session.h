@@ -86,6 +86,14 @@ struct UA_Session {
     UA_SessionSecurityDiagnosticsDataType securityDiagnostics;
     UA_SessionDiagnosticsDataType diagnostics;
 #endif
+
+#if UA_MULTITHREADING >= 100
+    /* Requests of the session queued for the service workers. The session is
+     * not freed while jobs remain. At most one job of the session is processed
+     * at a time. Both fields are protected by server->serviceJobsLock. */
+    size_t serviceJobs;
+    UA_Boolean serviceJobActive;
+#endif
 };
 
 /**
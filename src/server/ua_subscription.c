@@ -35,14 +35,25 @@ static void UA_Notification_dequeueMon(UA_Notification *n);
 static void UA_Notification_enqueueSub(UA_Notification *n);
 static void UA_Notification_dequeueSub(UA_Notification *n);
 
+/* Maximum number of deleted notifications kept for reuse per Subscription */
+#define UA_NOTIFICATION_POOL_MAX 256
+
 UA_Notification *
-UA_Notification_new(void) {
-    UA_Notification *n = (UA_Notification*)UA_calloc(1, sizeof(UA_Notification));
+UA_Notification_new(UA_Subscription *sub) {
+    UA_Notification *n = sub->notificationPool;
     if(n) {
-        /* Set the sentinel for a notification that is not enqueued a
-         * subscription */
-        TAILQ_NEXT(n, subEntry) = UA_SUBSCRIPTION_QUEUE_SENTINEL;
+        sub->notificationPool = TAILQ_NEXT(n, monEntry);
+        sub->notificationPoolSize--;
+        memset(n, 0, sizeof(UA_Notification));
+    } else {
+        n = (UA_Notification*)UA_calloc(1, sizeof(UA_Notification));
+        if(!n)
+            return NULL;
     }
+
+    /* Set the sentinel for a notification that is not enqueued a
+     * subscription */
+    TAILQ_NEXT(n, subEntry) = UA_SUBSCRIPTION_QUEUE_SENTINEL;
     return n;
 }
 
@@ -63,6 +74,15 @@ UA_Notification_delete(UA_Notification *n) {
         UA_MonitoredItemNotification_clear(&n->data.dataChange);
         break;
     }
+
+    /* Return to the pool of the Subscription */
+    UA_Subscription *sub = n->mon->subscription;
+    if(sub && sub->notificationPoolSize < UA_NOTIFICATION_POOL_MAX) {
+        TAILQ_NEXT(n, monEntry) = sub->notificationPool;
+        sub->notificationPool = n;
+        sub->notificationPoolSize++;
+        return;
+    }
     UA_free(n);
 }
 
@@ -268,6 +288,8 @@ UA_Subscription_new(void) {
 
     TAILQ_INIT(&newSub->retransmissionQueue);
     TAILQ_INIT(&newSub->notificationQueue);
+    TAILQ_INIT(&newSub->monitoredItems);
+    ZIP_INIT(&newSub->monitoredItemsById);
     return newSub;
 }
 
@@ -315,7 +337,7 @@ UA_Subscription_delete(UA_Server *server, UA_Subscription *sub) {
     /* Delete monitored Items */
     UA_assert(server->monitoredItemsSize >= sub->monitoredItemsSize);
     UA_MonitoredItem *mon, *tmp_mon;
-    LIST_FOREACH_SAFE(mon, &sub->monitoredItems, listEntry, tmp_mon) {
+    TAILQ_FOREACH_SAFE(mon, &sub->monitoredItems, listEntry, tmp_mon) {
         UA_MonitoredItem_delete(server, mon);
     }
     UA_assert(sub->monitoredItemsSize == 0);
@@ -332,6 +354,14 @@ UA_Subscription_delete(UA_Server *server, UA_Subscription *sub) {
     }
     UA_assert(sub->retransmissionQueueSize == 0);
 
+    /* Free the notification pool */
+    UA_Notification *n;
+    while((n = sub->notificationPool)) {
+        sub->notificationPool = TAILQ_NEXT(n, monEntry);
+        UA_free(n);
+    }
+    sub->notificationPoolSize = 0;
+
     /* Pointers to the subscription may still exist upwards in the call stack.
      * Add a delayed callback to remove the Subscription when the current jobs
      * have completed. */
@@ -346,14 +376,16 @@ Subscription_resetLifetime(UA_Subscription *sub) {
     sub->currentLifetimeCount = 0;
 }
 
+enum ZIP_CMP
+cmpMonitoredItemId(const UA_UInt32 *a, const UA_UInt32 *b) {
+    if(*a == *b)
+        return ZIP_CMP_EQ;
+    return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
 UA_MonitoredItem *
 UA_Subscription_getMonitoredItem(UA_Subscription *sub, UA_UInt32 monitoredItemId) {
-    UA_MonitoredItem *mon;
-    LIST_FOREACH(mon, &sub->monitoredItems, listEntry) {
-        if(mon->monitoredItemId == monitoredItemId)
-            break;
-    }
-    return mon;
+    return ZIP_FIND(UA_MonitoredItemIdTree, &sub->monitoredItemsById, &monitoredItemId);
 }
 
 static void
@@ -719,6 +751,18 @@ void
 UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
     UA_EventLoop *el = server->config.eventLoop;
 
+    /* The connection cannot keep up with sending. Pause publishing until the
+     * send queue has drained. The notifications remain queued in the
+     * MonitoredItems (with the usual overflow handling). */
+    if(sub->session && sub->session->channel &&
+       sub->session->channel->sendBlocked &&
+       sub->statusChange == UA_STATUSCODE_GOOD) {
+        UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, sub,
+                                  "Publishing paused, the SecureChannel "
+                                  "is blocked for sending");
+        return;
+    }
+
     /* Get a response */
     UA_PublishResponseEntry *pre = NULL;
     if(sub->session) {
@@ -951,7 +995,7 @@ UA_Subscription_resendData(UA_Server *server, UA_Subscription *sub) {
      * the Publish response. If no value is queued for a data MonitoredItem, the
      * last value sent is repeated in the Publish response. */
     UA_MonitoredItem *mon;
-    LIST_FOREACH(mon, &sub->monitoredItems, listEntry) {
+    TAILQ_FOREACH(mon, &sub->monitoredItems, listEntry) {
         /* Create only DataChange notifications */
         if(mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER)
             continue;
@@ -1101,7 +1145,7 @@ createEventOverflowNotification(UA_Server *server, UA_Subscription *sub,
     efl.eventFieldsSize = 1;
 
     /* Allocate the notification */
-    UA_Notification *overflowNotification = UA_Notification_new();
+    UA_Notification *overflowNotification = UA_Notification_new(sub);
     if(!overflowNotification) {
         UA_Variant_delete(efl.eventFields);
         return UA_STATUSCODE_BADOUTOFMEMORY;
@@ -1264,7 +1308,8 @@ UA_Server_registerMonitoredItem(UA_Server *server, UA_MonitoredItem *mon) {
     UA_Subscription *sub = mon->subscription;
     mon->monitoredItemId = ++sub->lastMonitoredItemId;
     mon->subscription = sub;
-    LIST_INSERT_HEAD(&sub->monitoredItems, mon, listEntry);
+    TAILQ_INSERT_TAIL(&sub->monitoredItems, mon, listEntry);
+    ZIP_INSERT(UA_MonitoredItemIdTree, &sub->monitoredItemsById, mon);
     sub->monitoredItemsSize++;
     server->monitoredItemsSize++;
 
@@ -1310,7 +1355,8 @@ UA_Server_unregisterMonitoredItem(UA_Server *server, UA_MonitoredItem *mon) {
 
     /* Deregister in Subscription and server */
     sub->monitoredItemsSize--;
-    LIST_REMOVE(mon, listEntry);
+    TAILQ_REMOVE(&sub->monitoredItems, mon, listEntry);
+    ZIP_REMOVE(UA_MonitoredItemIdTree, &sub->monitoredItemsById, mon);
     server->monitoredItemsSize--;
 }
 
@@ -1543,13 +1589,146 @@ UA_MonitoredItem_ensureQueueSpace(UA_Server *server, UA_MonitoredItem *mon) {
     }
 }
 
+/******************/
+/* Sampling Group */
+/******************/
+
+/* Sort the MonitoredItems by the sampled value. So the MonitoredItems reading
+ * the same value are next to each other and can share the read. */
+static int
+cmpSampledItem(const void *a, const void *b) {
+    const UA_MonitoredItem *ma = *(UA_MonitoredItem* const*)a;
+    const UA_MonitoredItem *mb = *(UA_MonitoredItem* const*)b;
+    UA_Order o = UA_NodeId_order(&ma->itemToMonitor.nodeId,
+                                 &mb->itemToMonitor.nodeId);
+    if(o != UA_ORDER_EQ)
+        return (int)o;
+    if(ma->itemToMonitor.attributeId != mb->itemToMonitor.attributeId)
+        return (ma->itemToMonitor.attributeId < mb->itemToMonitor.attributeId) ? -1 : 1;
+    uintptr_t sa = (ma->subscription) ? (uintptr_t)ma->subscription->session : 0;
+    uintptr_t sb = (mb->subscription) ? (uintptr_t)mb->subscription->session : 0;
+    if(sa != sb)
+        return (sa < sb) ? -1 : 1;
+    return 0;
+}
+
+/* Remove the empty slots and sort */
 static void
-UA_MonitoredItem_lockAndSample(UA_Server *server, UA_MonitoredItem *mon) {
+UA_SamplingGroup_sort(UA_SamplingGroup *sg) {
+    size_t j = 0;
+    for(size_t i = 0; i < sg->itemsSize; i++) {
+        if(sg->items[i])
+            sg->items[j++] = sg->items[i];
+    }
+    sg->itemsSize = j;
+    UA_assert(sg->itemsSize == sg->itemsCount);
+    qsort(sg->items, sg->itemsSize, sizeof(UA_MonitoredItem*), cmpSampledItem);
+    for(size_t i = 0; i < sg->itemsSize; i++)
+        sg->items[i]->sampling.cyclic.index = i;
+    sg->sorted = true;
+}
+
+static void
+UA_SamplingGroup_sample(UA_Server *server, UA_SamplingGroup *sg) {
     lockServer(server);
-    UA_MonitoredItem_sample(server, mon);
+    if(!sg->sorted)
+        UA_SamplingGroup_sort(sg);
+    sg->sampling = true;
+    UA_MonitoredItem_sampleGroup(server, sg);
+    sg->sampling = false;
     unlockServer(server);
 }
 
+static void
+delayedFreeSamplingGroup(void *app, void *context) {
+    UA_SamplingGroup *sg = (UA_SamplingGroup*)context;
+    UA_free(sg->items);
+    UA_free(sg);
+}
+
+static UA_StatusCode
+UA_SamplingGroup_add(UA_Server *server, UA_MonitoredItem *mon) {
+    /* Find the group with the same sampling interval */
+    UA_SamplingGroup *sg;
+    LIST_FOREACH(sg, &server->samplingGroups, listEntry) {
+        if(sg->samplingInterval == mon->parameters.samplingInterval)
+            break;
+    }
+
+    /* Create a new group with its own repeated callback */
+    if(!sg) {
+        sg = (UA_SamplingGroup*)UA_calloc(1, sizeof(UA_SamplingGroup));
+        if(!sg)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        sg->samplingInterval = mon->parameters.samplingInterval;
+        sg->sorted = true;
+        UA_StatusCode res =
+            addRepeatedCallback(server, (UA_ServerCallback)UA_SamplingGroup_sample,
+                                sg, sg->samplingInterval, &sg->callbackId);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(sg);
+            return res;
+        }
+        LIST_INSERT_HEAD(&server->samplingGroups, sg, listEntry);
+    }
+
+    /* Reuse the empty slots */
+    if(sg->itemsSize == sg->itemsCapacity && sg->itemsCount < sg->itemsSize &&
+       !sg->sampling)
+        UA_SamplingGroup_sort(sg);
+
+    /* Grow the array */
+    if(sg->itemsSize == sg->itemsCapacity) {
+        size_t newCapacity = (sg->itemsCapacity == 0) ? 8 : sg->itemsCapacity * 2;
+        UA_MonitoredItem **newItems = (UA_MonitoredItem**)
+            UA_realloc(sg->items, newCapacity * sizeof(UA_MonitoredItem*));
+        if(!newItems) {
+            if(sg->itemsSize == 0) {
+                removeCallback(server, sg->callbackId);
+                LIST_REMOVE(sg, listEntry);
+                UA_free(sg->items);
+                UA_free(sg);
+            }
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        sg->items = newItems;
+        sg->itemsCapacity = newCapacity;
+    }
+
+    /* Append. The array is sorted before the next sampling. */
+    mon->sampling.cyclic.group = sg;
+    mon->sampling.cyclic.index = sg->itemsSize;
+    sg->items[sg->itemsSize++] = mon;
+    sg->itemsCount++;
+    sg->sorted = false;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+UA_SamplingGroup_remove(UA_Server *server, UA_MonitoredItem *mon) {
+    UA_SamplingGroup *sg = mon->sampling.cyclic.group;
+    UA_assert(sg->items[mon->sampling.cyclic.index] == mon);
+
+    /* Leave an empty slot. The group might be currently sampling. So the
+     * array is only compacted before the next sampling. */
+    sg->items[mon->sampling.cyclic.index] = NULL;
+    sg->itemsCount--;
+    sg->sorted = false;
+    if(sg->itemsCount > 0)
+        return;
+
+    /* Remove the empty group. The memory is freed in a delayed callback, as
+     * the group might be currently sampling. */
+    removeCallback(server, sg->callbackId);
+    LIST_REMOVE(sg, listEntry);
+    sg->itemsSize = 0;
+    UA_EventLoop *el = server->config.eventLoop;
+    sg->delayedFree.callback = delayedFreeSamplingGroup;
+    sg->delayedFree.application = NULL;
+    sg->delayedFree.context = sg;
+    el->addDelayedCallback(el, &sg->delayedFree);
+}
+
 UA_StatusCode
 UA_MonitoredItem_registerSampling(UA_Server *server, UA_MonitoredItem *mon) {
     UA_LOCK_ASSERT(&server->serviceMutex);
@@ -1578,13 +1757,10 @@ UA_MonitoredItem_registerSampling(UA_Server *server, UA_MonitoredItem *mon) {
                          sampling.subscriptionSampling);
         mon->samplingType = UA_MONITOREDITEMSAMPLINGTYPE_PUBLISH;
     } else {
-        /* DataChange MonitoredItems with a positive sampling interval have a
-         * repeated callback. Other MonitoredItems are attached to the Node in a
-         * linked list of backpointers. */
-        res = addRepeatedCallback(server,
-                                  (UA_ServerCallback)UA_MonitoredItem_lockAndSample,
-                                  mon, mon->parameters.samplingInterval,
-                                  &mon->sampling.callbackId);
+        /* DataChange MonitoredItems with a positive sampling interval are
+         * added to the SamplingGroup for the interval. The group has a
+         * repeated callback that samples all of its MonitoredItems. */
+        res = UA_SamplingGroup_add(server, mon);
         if(res == UA_STATUSCODE_GOOD)
             mon->samplingType = UA_MONITOREDITEMSAMPLINGTYPE_CYCLIC;
     }
@@ -1598,8 +1774,8 @@ UA_MonitoredItem_unregisterSampling(UA_Server *server, UA_MonitoredItem *mon) {
 
     switch(mon->samplingType) {
     case UA_MONITOREDITEMSAMPLINGTYPE_CYCLIC:
-        /* Remove repeated callback */
-        removeCallback(server, mon->sampling.callbackId);
+        /* Remove from the SamplingGroup */
+        UA_SamplingGroup_remove(server, mon);
         break;
 
     case UA_MONITOREDITEMSAMPLINGTYPE_EVENT: {
@@ -24,6 +24,7 @@
 
 #include "ua_session.h"
 #include "../util/ua_util_internal.h"
+#include "ziptree.h"
 
 _UA_BEGIN_DECLS
 
@@ -71,8 +72,9 @@ typedef struct UA_Notification {
 } UA_Notification;
 
 /* Initializes and sets the sentinel pointers. Only create a notification if it
- * is also going to be immediately enqueued to a MonitoredItem (see below). */
-UA_Notification * UA_Notification_new(void);
+ * is also going to be immediately enqueued to a MonitoredItem (see below).
+ * Deleted notifications are kept in a pool of the Subscription for reuse. */
+UA_Notification * UA_Notification_new(UA_Subscription *sub);
 
 /* Notifications are always added to the queue of a MonitoredItem. That queue
  * can overflow. If Notifications are reported, they are also added to the queue
@@ -108,16 +110,34 @@ typedef TAILQ_HEAD(NotificationMessageQueue, UA_NotificationMessageEntry)
  * <0: Attached to the subscription. Triggered just before every "publish". */
 typedef enum {
     UA_MONITOREDITEMSAMPLINGTYPE_NONE = 0,
-    UA_MONITOREDITEMSAMPLINGTYPE_CYCLIC, /* Cyclic callback */
+    UA_MONITOREDITEMSAMPLINGTYPE_CYCLIC, /* Cyclic callback of a SamplingGroup */
     UA_MONITOREDITEMSAMPLINGTYPE_EVENT,  /* Attached to the node. Can be a "write
                                           * event" for DataChange MonitoredItems
                                           * with a zero sampling interval .*/
     UA_MONITOREDITEMSAMPLINGTYPE_PUBLISH /* Attached to the subscription */
 } UA_MonitoredItemSamplingType;
 
+/* MonitoredItems with the same cyclic sampling interval share one timer
+ * callback. The callback samples all MonitoredItems of the group in one pass.
+ * The array is sorted by the monitored node before sampling, so that values
+ * of the same node are read only once and the nodes are visited in order. */
+typedef struct UA_SamplingGroup {
+    LIST_ENTRY(UA_SamplingGroup) listEntry;
+    UA_Double samplingInterval;
+    UA_UInt64 callbackId;
+    UA_MonitoredItem **items; /* Removed MonitoredItems leave a NULL slot */
+    size_t itemsSize;         /* Including the empty slots */
+    size_t itemsCapacity;
+    size_t itemsCount;        /* Without the empty slots */
+    UA_Boolean sorted;
+    UA_Boolean sampling;      /* Don't compact during the sampling */
+    UA_DelayedCallback delayedFree;
+} UA_SamplingGroup;
+
 struct UA_MonitoredItem {
     UA_DelayedCallback delayedFreePointers;
-    LIST_ENTRY(UA_MonitoredItem) listEntry; /* Linked list in the Subscription */
+    TAILQ_ENTRY(UA_MonitoredItem) listEntry; /* Ordered list in the Subscription */
+    ZIP_ENTRY(UA_MonitoredItem) idTreeEntry; /* Lookup by monitoredItemId */
     UA_Subscription *subscription;          /* Always non-NULL */
     UA_UInt32 monitoredItemId;
 
@@ -151,12 +171,18 @@ struct UA_MonitoredItem {
     /* Sampling */
     UA_MonitoredItemSamplingType samplingType;
     union {
-        UA_UInt64 callbackId;
+        struct {
+            UA_SamplingGroup *group;
+            size_t index; /* Position in the group */
+        } cyclic;
         UA_MonitoredItem *nodeListNext; /* Event-Based: Attached to Node */
         LIST_ENTRY(UA_MonitoredItem) subscriptionSampling; /* Linked to publish
                                                             * interval */
     } sampling;
+    /* Builtin numeric scalars are stored inline in lastScalar. Then the
+     * variant in lastValue points there and has storageType NODELETE. */
     UA_DataValue lastValue;
+    UA_UInt64 lastScalar;
 
     /* Triggering Links */
     size_t triggeringLinksSize;
@@ -170,6 +196,13 @@ struct UA_MonitoredItem {
                             * the queue size */
 };
 
+enum ZIP_CMP
+cmpMonitoredItemId(const UA_UInt32 *a, const UA_UInt32 *b);
+
+typedef ZIP_HEAD(UA_MonitoredItemIdTree, UA_MonitoredItem) UA_MonitoredItemIdTree;
+ZIP_FUNCTIONS(UA_MonitoredItemIdTree, UA_MonitoredItem, idTreeEntry,
+              UA_UInt32, monitoredItemId, cmpMonitoredItemId)
+
 void UA_MonitoredItem_init(UA_MonitoredItem *mon);
 void UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *mon);
 void UA_MonitoredItem_removeOverflowInfoBits(UA_MonitoredItem *mon);
@@ -190,6 +223,11 @@ UA_MonitoredItem_setMonitoringMode(UA_Server *server, UA_MonitoredItem *mon,
 void
 UA_MonitoredItem_sample(UA_Server *server, UA_MonitoredItem *mon);
 
+/* Sample the MonitoredItems of a SamplingGroup. Consecutive MonitoredItems
+ * that read the same value with the same Session share the read. */
+void
+UA_MonitoredItem_sampleGroup(UA_Server *server, UA_SamplingGroup *sg);
+
 /* Do not use the value after calling this. It will be moved to mon or freed. */
 void
 UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
@@ -263,7 +301,8 @@ struct UA_Subscription {
 
     /* MonitoredItems */
     UA_UInt32 lastMonitoredItemId; /* increase the identifiers */
-    LIST_HEAD(, UA_MonitoredItem) monitoredItems;
+    TAILQ_HEAD(, UA_MonitoredItem) monitoredItems; /* In the order of creation */
+    UA_MonitoredItemIdTree monitoredItemsById;
     UA_UInt32 monitoredItemsSize;
 
     /* MonitoredItems that are sampled in every publish callback (with the
@@ -276,6 +315,10 @@ struct UA_Subscription {
     UA_UInt32 dataChangeNotifications;
     UA_UInt32 eventNotifications;
 
+    /* Deleted notifications for reuse. Linked via monEntry. */
+    UA_Notification *notificationPool;
+    UA_UInt32 notificationPoolSize;
+
     /* Retransmission Queue */
     NotificationMessageQueue retransmissionQueue;
     size_t retransmissionQueueSize;
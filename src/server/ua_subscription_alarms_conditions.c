@@ -1899,7 +1899,7 @@ refreshMethodCallback(UA_Server *server, const UA_NodeId *sessionId,
      * in the subscription */
     //TODO when there are a lot of monitoreditems (not only events)?
     UA_MonitoredItem *monitoredItem = NULL;
-    LIST_FOREACH(monitoredItem, &subscription->monitoredItems, listEntry) {
+    TAILQ_FOREACH(monitoredItem, &subscription->monitoredItems, listEntry) {
         retval = refreshLogic(server, &server->refreshEvents[REFRESHEVENT_START_IDX],
                               &server->refreshEvents[REFRESHEVENT_END_IDX], monitoredItem);
         CONDITION_ASSERT_RETURN_RETVAL(retval, "Could not refresh Condition",
@@ -74,6 +74,45 @@ detectVariantDeadband(const UA_Variant *value, const UA_Variant *oldValue,
     return false;
 }
 
+/* Builtin numeric scalars are compared with a typed switch and stored inline
+ * in the MonitoredItem */
+static UA_Boolean
+isNumericScalar(const UA_Variant *v) {
+    return (v->type && v->type->typeKind <= UA_DATATYPEKIND_DOUBLE &&
+            v->type->memSize <= sizeof(UA_UInt64) &&
+            UA_Variant_isScalar(v) && v->arrayDimensionsSize == 0);
+}
+
+#define UA_SCALAR_CHANGED(TYPE)                                 \
+    return (*(const TYPE*)data1 != *(const TYPE*)data2);
+
+/* NaN is equal to NaN (same as in UA_order) */
+#define UA_FLOAT_CHANGED(TYPE) do {                             \
+    TYPE v1 = *(const TYPE*)data1;                              \
+    TYPE v2 = *(const TYPE*)data2;                              \
+    return (v1 != v2 && (v1 == v1 || v2 == v2));                \
+} while(false);
+
+static UA_Boolean
+detectScalarChange(const void *data1, const void *data2,
+                   const UA_DataType *type) {
+    switch(type->typeKind) {
+    case UA_DATATYPEKIND_BOOLEAN: UA_SCALAR_CHANGED(UA_Boolean);
+    case UA_DATATYPEKIND_SBYTE:   UA_SCALAR_CHANGED(UA_SByte);
+    case UA_DATATYPEKIND_BYTE:    UA_SCALAR_CHANGED(UA_Byte);
+    case UA_DATATYPEKIND_INT16:   UA_SCALAR_CHANGED(UA_Int16);
+    case UA_DATATYPEKIND_UINT16:  UA_SCALAR_CHANGED(UA_UInt16);
+    case UA_DATATYPEKIND_INT32:   UA_SCALAR_CHANGED(UA_Int32);
+    case UA_DATATYPEKIND_UINT32:  UA_SCALAR_CHANGED(UA_UInt32);
+    case UA_DATATYPEKIND_INT64:   UA_SCALAR_CHANGED(UA_Int64);
+    case UA_DATATYPEKIND_UINT64:  UA_SCALAR_CHANGED(UA_UInt64);
+    case UA_DATATYPEKIND_FLOAT:   UA_FLOAT_CHANGED(UA_Float);
+    case UA_DATATYPEKIND_DOUBLE:  UA_FLOAT_CHANGED(UA_Double);
+    default:
+        return !UA_equal(data1, data2, type);
+    }
+}
+
 static UA_Boolean
 detectValueChange(UA_Server *server, UA_MonitoredItem *mon, const UA_DataValue *dv) {
     UA_LOCK_ASSERT(&server->serviceMutex);
@@ -104,9 +143,14 @@ detectValueChange(UA_Server *server, UA_MonitoredItem *mon, const UA_DataValue *
 
     /* Test absolute deadband */
     if(dcf && dcf->deadbandType == UA_DEADBANDTYPE_ABSOLUTE &&
-       dv->value.type != NULL && UA_DataType_isNumeric(dv->value.type))
+       dv->value.type != NULL && UA_DataType_isNumeric(dv->value.type)) {
+        if(dv->value.type == mon->lastValue.value.type &&
+           isNumericScalar(&dv->value) && isNumericScalar(&mon->lastValue.value))
+            return detectScalarDeadBand(dv->value.data, mon->lastValue.value.data,
+                                        dv->value.type, dcf->deadbandValue);
         return detectVariantDeadband(&dv->value, &mon->lastValue.value,
                                      dcf->deadbandValue);
+    }
 
     /* Compare the source timestamp if the trigger requires that */
     if(trigger == UA_DATACHANGETRIGGER_STATUSVALUETIMESTAMP) {
@@ -120,10 +164,30 @@ detectValueChange(UA_Server *server, UA_MonitoredItem *mon, const UA_DataValue *
     /* Has the value changed? */
     if(dv->hasValue != mon->lastValue.hasValue)
         return true;
+    if(dv->value.type == mon->lastValue.value.type &&
+       isNumericScalar(&dv->value) && isNumericScalar(&mon->lastValue.value))
+        return detectScalarChange(dv->value.data, mon->lastValue.value.data,
+                                  dv->value.type);
     return !UA_equal(&dv->value, &mon->lastValue.value,
                      &UA_TYPES[UA_TYPES_VARIANT]);
 }
 
+/* Takes ownership of the value (also if an error is returned) */
+static UA_StatusCode
+enqueueDataChangeNotification(UA_Server *server, UA_MonitoredItem *mon,
+                              UA_DataValue *value) {
+    UA_Notification *n = UA_Notification_new(mon->subscription);
+    if(!n) {
+        UA_DataValue_clear(value);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    n->mon = mon;
+    n->data.dataChange.value = *value;
+    n->data.dataChange.clientHandle = mon->parameters.clientHandle;
+    UA_Notification_enqueueAndTrigger(server, n);
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_MonitoredItem_createDataChangeNotification(UA_Server *server, UA_MonitoredItem *mon,
                                               const UA_DataValue *dv) {
@@ -133,19 +197,8 @@ UA_MonitoredItem_createDataChangeNotification(UA_Server *server, UA_MonitoredIte
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
-    /* Allocate a new notification */
-    UA_Notification *n = UA_Notification_new();
-    if(!n) {
-        UA_DataValue_clear(&valueCopy);
-        return UA_STATUSCODE_BADOUTOFMEMORY;
-    }
-
     /* Prepare and enqueue the notification */
-    n->mon = mon;
-    n->data.dataChange.value = valueCopy;
-    n->data.dataChange.clientHandle = mon->parameters.clientHandle;
-    UA_Notification_enqueueAndTrigger(server, n);
-    return UA_STATUSCODE_GOOD;
+    return enqueueDataChangeNotification(server, mon, &valueCopy);
 }
 
 void
@@ -164,21 +217,42 @@ UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
         return;
     }
 
-    /* Prepare a notification and enqueue it */
-    UA_StatusCode res =
-        UA_MonitoredItem_createDataChangeNotification(server, mon, value);
-    if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, mon->subscription,
-                                    "MonitoredItem %" PRIi32 " | "
-                                    "Processing the sample returned the statuscode %s",
-                                    mon->monitoredItemId, UA_StatusCode_name(res));
-        UA_DataValue_clear(value);
-        return;
-    }
+    /* Fast path for numeric scalars. The sampled value is moved into the
+     * notification without a copy. The last value is stored inline. */
+    if(isNumericScalar(&value->value)) {
+        UA_DataValue last = *value;
+        UA_UInt64 lastScalar = 0;
+        memcpy(&lastScalar, value->value.data, value->value.type->memSize);
+        UA_StatusCode res = enqueueDataChangeNotification(server, mon, value);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, mon->subscription,
+                                        "MonitoredItem %" PRIi32 " | "
+                                        "Processing the sample returned the statuscode %s",
+                                        mon->monitoredItemId, UA_StatusCode_name(res));
+            return;
+        }
+        UA_DataValue_clear(&mon->lastValue);
+        mon->lastScalar = lastScalar;
+        mon->lastValue = last;
+        mon->lastValue.value.data = &mon->lastScalar;
+        mon->lastValue.value.storageType = UA_VARIANT_DATA_NODELETE;
+    } else {
+        /* Prepare a notification and enqueue it */
+        UA_StatusCode res =
+            UA_MonitoredItem_createDataChangeNotification(server, mon, value);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, mon->subscription,
+                                        "MonitoredItem %" PRIi32 " | "
+                                        "Processing the sample returned the statuscode %s",
+                                        mon->monitoredItemId, UA_StatusCode_name(res));
+            UA_DataValue_clear(value);
+            return;
+        }
 
-    /* Move/store the value for filter comparison and TransferSubscription */
-    UA_DataValue_clear(&mon->lastValue);
-    mon->lastValue = *value;
+        /* Move/store the value for filter comparison and TransferSubscription */
+        UA_DataValue_clear(&mon->lastValue);
+        mon->lastValue = *value;
+    }
 
     /* Call the local callback if the MonitoredItem is not attached to a
      * subscription. Do this at the very end. Because the callback might delete
@@ -214,4 +288,66 @@ UA_MonitoredItem_sample(UA_Server *server, UA_MonitoredItem *mon) {
     UA_MonitoredItem_processSampledValue(server, mon, &dv);
 }
 
+static UA_Session *
+getSamplingSession(UA_Server *server, UA_MonitoredItem *mon) {
+    return (mon->subscription) ? mon->subscription->session : &server->adminSession;
+}
+
+/* Both MonitoredItems sample the same value */
+static UA_Boolean
+sameSample(UA_Server *server, UA_MonitoredItem *a, UA_MonitoredItem *b) {
+    return (getSamplingSession(server, a) == getSamplingSession(server, b) &&
+            a->timestampsToReturn == b->timestampsToReturn &&
+            UA_equal(&a->itemToMonitor, &b->itemToMonitor,
+                     &UA_TYPES[UA_TYPES_READVALUEID]));
+}
+
+void
+UA_MonitoredItem_sampleGroup(UA_Server *server, UA_SamplingGroup *sg) {
+    UA_LOCK_ASSERT(&server->serviceMutex);
+
+    UA_DataValue shared;
+    UA_DataValue_init(&shared);
+    UA_MonitoredItem *sharedFor = NULL;
+
+    /* The MonitoredItems are sorted by the sampled node. Processing a sample
+     * can add and remove MonitoredItems of the group. So the size is checked
+     * in every iteration. Removed MonitoredItems leave a NULL slot. */
+    for(size_t i = 0; i < sg->itemsSize; i++) {
+        UA_MonitoredItem *mon = sg->items[i];
+        if(!mon)
+            continue;
+        UA_assert(mon->itemToMonitor.attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER);
+        UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, mon->subscription,
+                                  "MonitoredItem %" PRIi32 " | Sample callback "
+                                  "called", mon->monitoredItemId);
+
+        /* Take the value read for the previous MonitoredItem or sample the
+         * current value */
+        UA_DataValue dv;
+        if(mon == sharedFor) {
+            dv = shared;
+            UA_DataValue_init(&shared);
+        } else {
+            UA_DataValue_clear(&shared);
+            dv = readWithSession(server, getSamplingSession(server, mon),
+                                 &mon->itemToMonitor, mon->timestampsToReturn);
+        }
+
+        /* Keep a copy for the next MonitoredItem if it samples the same value.
+         * This is checked before the processing, which can remove the current
+         * MonitoredItem. */
+        sharedFor = NULL;
+        UA_MonitoredItem *next = (i + 1 < sg->itemsSize) ? sg->items[i+1] : NULL;
+        if(next && sameSample(server, mon, next) &&
+           UA_DataValue_copy(&dv, &shared) == UA_STATUSCODE_GOOD)
+            sharedFor = next;
+
+        /* Process the sample. This always clears the value. */
+        UA_MonitoredItem_processSampledValue(server, mon, &dv);
+    }
+
+    UA_DataValue_clear(&shared);
+}
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
@@ -209,7 +209,7 @@ UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
     }
 
     /* Allocate memory for the notification */
-    UA_Notification *notification = UA_Notification_new();
+    UA_Notification *notification = UA_Notification_new(sub);
     if(!notification) {
         UA_EventFieldList_clear(&values);
         return UA_STATUSCODE_BADOUTOFMEMORY;
@@ -138,6 +138,10 @@ deleteChunks(UA_SecureChannel *channel) {
     }
     channel->chunksCount = 0;
     channel->chunksLength = 0;
+
+    UA_ByteString_clear(&channel->reassembly);
+    channel->reassemblyCapacity = 0;
+    channel->reassemblyChunks = 0;
 }
 
 void
@@ -145,6 +149,7 @@ UA_SecureChannel_deleteBuffered(UA_SecureChannel *channel) {
     deleteChunks(channel);
     if(channel->unprocessedCopied)
         UA_ByteString_clear(&channel->unprocessed);
+    UA_ByteString_init(&channel->unprocessedNext);
 }
 
 void
@@ -185,6 +190,7 @@ UA_SecureChannel_clear(UA_SecureChannel *channel) {
     /* The EventLoop connection is no longer valid */
     channel->connectionId = 0;
     channel->connectionManager = NULL;
+    channel->sendBlocked = false;
 
     /* Clean up the SecurityToken */
     UA_ChannelSecurityToken_clear(&channel->securityToken);
@@ -201,6 +207,9 @@ UA_SecureChannel_clear(UA_SecureChannel *channel) {
     /* Delete remaining chunks */
     UA_SecureChannel_deleteBuffered(channel);
 
+    /* Release the memory of the request arena */
+    UA_Arena_clear(&channel->requestArena);
+
     /* Clean up namespace mapping */
     UA_NamespaceMapping_delete(channel->namespaceMapping);
     channel->namespaceMapping = NULL;
@@ -246,80 +255,112 @@ UA_SecureChannel_processHELACK(UA_SecureChannel *channel,
     return UA_STATUSCODE_GOOD;
 }
 
-/* Sends an OPN message using asymmetric encryption if defined */
 UA_StatusCode
-UA_SecureChannel_sendAsymmetricOPNMessage(UA_SecureChannel *channel,
-                                          UA_UInt32 requestId, const void *content,
-                                          const UA_DataType *contentType) {
+UA_SecureChannel_encodeAsymmetricOPNMessage(UA_SecureChannel *channel,
+                                            UA_UInt32 requestId, const void *content,
+                                            const UA_DataType *contentType,
+                                            UA_AsymmetricMessage *msg) {
     UA_CHECK(channel->securityMode != UA_MESSAGESECURITYMODE_INVALID,
              return UA_STATUSCODE_BADSECURITYMODEREJECTED);
 
-    /* Can we use the connection manager? */
-    UA_ConnectionManager *cm = channel->connectionManager;
-    if(!UA_SecureChannel_isConnected(channel))
-        return UA_STATUSCODE_BADCONNECTIONCLOSED;
-
     const UA_SecurityPolicy *sp = channel->securityPolicy;
     UA_CHECK_MEM(sp, return UA_STATUSCODE_BADINTERNALERROR);
 
-    /* Allocate the message buffer */
-    UA_ByteString buf = UA_BYTESTRING_NULL;
-    UA_StatusCode res = cm->allocNetworkBuffer(cm, channel->connectionId, &buf,
-                                               channel->config.sendBufferSize);
-    UA_CHECK_STATUS(res, return res);
-
     /* Restrict buffer to the available space for the payload */
-    UA_Byte *buf_pos = buf.data;
-    const UA_Byte *buf_end = &buf.data[buf.length];
+    UA_ByteString *buf = &msg->buf;
+    UA_Byte *buf_pos = buf->data;
+    const UA_Byte *buf_end = &buf->data[buf->length];
     hideBytesAsym(channel, &buf_pos, &buf_end);
 
-    /* Define variables here to pacify some compilers wrt goto */
-    size_t securityHeaderLength, pre_sig_length, total_length, encryptedLength;
-
     /* Encode the message type and content */
     UA_EncodeBinaryOptions encOpts;
     memset(&encOpts, 0, sizeof(UA_EncodeBinaryOptions));
     encOpts.namespaceMapping = channel->namespaceMapping;
-    res |= UA_NodeId_encodeBinary(&contentType->binaryEncodingId, &buf_pos, buf_end);
+    UA_StatusCode res =
+        UA_NodeId_encodeBinary(&contentType->binaryEncodingId, &buf_pos, buf_end);
     res |= UA_encodeBinaryInternal(content, contentType, &buf_pos, &buf_end,
                                    &encOpts, NULL, NULL);
-    UA_CHECK_STATUS(res, goto error);
+    UA_CHECK_STATUS(res, return res);
 
     /* Compute the header length */
-    securityHeaderLength = calculateAsymAlgSecurityHeaderLength(channel);
+    msg->securityHeaderLength = calculateAsymAlgSecurityHeaderLength(channel);
 
     /* Add padding to the chunk. Also pad if the securityMode is SIGN_ONLY,
      * since we are using asymmetric communication to exchange keys and thus
      * need to encrypt. */
     if(channel->securityMode != UA_MESSAGESECURITYMODE_NONE)
         padChunk(channel, &channel->securityPolicy->asymmetricModule.cryptoModule,
-                 &buf.data[UA_SECURECHANNEL_CHANNELHEADER_LENGTH + securityHeaderLength],
-                 &buf_pos);
+                 &buf->data[UA_SECURECHANNEL_CHANNELHEADER_LENGTH +
+                            msg->securityHeaderLength], &buf_pos);
 
     /* The total message length */
-    pre_sig_length = (uintptr_t)buf_pos - (uintptr_t)buf.data;
-    total_length = pre_sig_length;
+    msg->preSigLength = (uintptr_t)buf_pos - (uintptr_t)buf->data;
+    msg->totalLength = msg->preSigLength;
     if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGN ||
        channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT)
-        total_length += sp->asymmetricModule.cryptoModule.signatureAlgorithm.
+        msg->totalLength += sp->asymmetricModule.cryptoModule.signatureAlgorithm.
             getLocalSignatureSize(channel->channelContext);
 
     /* The total message length is known here which is why we encode the headers
      * at this step and not earlier. */
-    res = prependHeadersAsym(channel, buf.data, buf_end, total_length,
-                             securityHeaderLength, requestId, &encryptedLength);
-    UA_CHECK_STATUS(res, goto error);
+    return prependHeadersAsym(channel, buf->data, buf_end, msg->totalLength,
+                              msg->securityHeaderLength, requestId,
+                              &msg->encryptedLength);
+}
+
+UA_StatusCode
+UA_SecureChannel_signAndEncryptAsymmetricOPNMessage(UA_SecureChannel *channel,
+                                                    UA_AsymmetricMessage *msg) {
+    return signAndEncryptAsym(channel, msg->preSigLength, &msg->buf,
+                              msg->securityHeaderLength, msg->totalLength);
+}
+
+UA_StatusCode
+UA_SecureChannel_sendAsymmetricMessage(UA_SecureChannel *channel,
+                                       const UA_AsymmetricMessage *msg) {
+    UA_ConnectionManager *cm = channel->connectionManager;
+    if(!UA_SecureChannel_isConnected(channel))
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
 
-    res = signAndEncryptAsym(channel, pre_sig_length, &buf,
-                             securityHeaderLength, total_length);
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    UA_StatusCode res = cm->allocNetworkBuffer(cm, channel->connectionId, &buf,
+                                               msg->encryptedLength);
+    UA_CHECK_STATUS(res, return res);
+    memcpy(buf.data, msg->buf.data, msg->encryptedLength);
+    return cm->sendWithConnection(cm, channel->connectionId, &UA_KEYVALUEMAP_NULL, &buf);
+}
+
+/* Sends an OPN message using asymmetric encryption if defined */
+UA_StatusCode
+UA_SecureChannel_sendAsymmetricOPNMessage(UA_SecureChannel *channel,
+                                          UA_UInt32 requestId, const void *content,
+                                          const UA_DataType *contentType) {
+    /* Can we use the connection manager? */
+    UA_ConnectionManager *cm = channel->connectionManager;
+    if(!UA_SecureChannel_isConnected(channel))
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+
+    /* Allocate the message buffer */
+    UA_AsymmetricMessage msg;
+    memset(&msg, 0, sizeof(UA_AsymmetricMessage));
+    UA_StatusCode res = cm->allocNetworkBuffer(cm, channel->connectionId, &msg.buf,
+                                               channel->config.sendBufferSize);
+    UA_CHECK_STATUS(res, return res);
+
+    /* Encode, sign and encrypt directly in the network buffer */
+    res = UA_SecureChannel_encodeAsymmetricOPNMessage(channel, requestId, content,
+                                                      contentType, &msg);
+    UA_CHECK_STATUS(res, goto error);
+    res = UA_SecureChannel_signAndEncryptAsymmetricOPNMessage(channel, &msg);
     UA_CHECK_STATUS(res, goto error);
 
     /* Send the message, the buffer is freed in the network layer */
-    buf.length = encryptedLength;
-    return cm->sendWithConnection(cm, channel->connectionId, &UA_KEYVALUEMAP_NULL, &buf);
+    msg.buf.length = msg.encryptedLength;
+    return cm->sendWithConnection(cm, channel->connectionId,
+                                  &UA_KEYVALUEMAP_NULL, &msg.buf);
 
  error:
-    cm->freeNetworkBuffer(cm, channel->connectionId, &buf);
+    cm->freeNetworkBuffer(cm, channel->connectionId, &msg.buf);
     return res;
 }
 
@@ -436,9 +477,21 @@ sendSymmetricChunk(UA_MessageContext *mc) {
 
     /* Send the chunk. The buffer is freed in the network layer. If sending goes
      * wrong, the connection is removed in the next iteration of the
-     * SecureChannel. Set the SecureChannel to closing already. */
+     * SecureChannel. Set the SecureChannel to closing already.
+     *
+     * Non-final chunks are flagged with "more". Then the ConnectionManager can
+     * send all chunks of the message with a single (gathering) syscall. */
+    UA_KeyValuePair morePair;
+    UA_KeyValueMap sendParams = UA_KEYVALUEMAP_NULL;
+    UA_Boolean more = !mc->final;
+    if(more) {
+        morePair.key = UA_QUALIFIEDNAME(0, "more");
+        UA_Variant_setScalar(&morePair.value, &more, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        sendParams.map = &morePair;
+        sendParams.mapSize = 1;
+    }
     res = cm->sendWithConnection(cm, channel->connectionId,
-                                 &UA_KEYVALUEMAP_NULL, &mc->messageBuffer);
+                                 &sendParams, &mc->messageBuffer);
     if(res != UA_STATUSCODE_GOOD && UA_SecureChannel_isConnected(channel))
         channel->state = UA_SECURECHANNELSTATE_CLOSING;
     return res;
@@ -641,6 +694,12 @@ unpackPayloadOPN(UA_SecureChannel *channel, UA_Chunk *chunk) {
     UA_AsymmetricAlgorithmSecurityHeader_clear(&asymHeader);
     UA_CHECK_STATUS(res, return res);
 
+    /* Leave the decryption to the caller (see UA_SecureChannel_decryptOPN) */
+    if(channel->deferOPN &&
+       !UA_String_equal(&channel->securityPolicy->policyUri,
+                        &UA_SECURITY_POLICY_NONE_URI))
+        return UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY;
+
     /* Decrypt the chunk payload */
     res = decryptAndVerifyChunk(channel,
                                 &channel->securityPolicy->asymmetricModule.cryptoModule,
@@ -716,8 +775,46 @@ unpackPayloadMSG(UA_SecureChannel *channel, UA_Chunk *chunk,
     return UA_STATUSCODE_GOOD;
 }
 
+/* Copy the queued chunks that still point into the unprocessed buffer */
+static UA_StatusCode
+persistChunks(UA_SecureChannel *channel) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_Chunk *chunk;
+    TAILQ_FOREACH(chunk, &channel->chunks, pointers) {
+        if(chunk->copied)
+            continue;
+        UA_ByteString tmp = UA_BYTESTRING_NULL;
+        res |= UA_ByteString_copy(&chunk->bytes, &tmp);
+        chunk->bytes = tmp;
+        chunk->copied = true;
+    }
+    return res;
+}
+
+/* The copied unprocessed buffer is exhausted. Continue with the remaining
+ * network buffer. */
+static UA_StatusCode
+switchToNextBuffer(UA_SecureChannel *channel) {
+    UA_assert(channel->unprocessedCopied);
+    UA_StatusCode res = persistChunks(channel);
+    UA_CHECK_STATUS(res, return res);
+    UA_ByteString_clear(&channel->unprocessed);
+    channel->unprocessed = channel->unprocessedNext;
+    channel->unprocessedOffset = 0;
+    channel->unprocessedCopied = false;
+    UA_ByteString_init(&channel->unprocessedNext);
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 extractCompleteChunk(UA_SecureChannel *channel, UA_Chunk *chunk, UA_DateTime nowMonotonic) {
+    /* Continue with the network buffer */
+    if(channel->unprocessedOffset == channel->unprocessed.length &&
+       channel->unprocessedNext.length > 0) {
+        UA_StatusCode res = switchToNextBuffer(channel);
+        UA_CHECK_STATUS(res, return res);
+    }
+
     /* At least 8 byte needed for the header */
     size_t offset = channel->unprocessedOffset;
     size_t remaining = channel->unprocessed.length - offset;
@@ -736,6 +833,11 @@ extractCompleteChunk(UA_SecureChannel *channel, UA_Chunk *chunk, UA_DateTime now
     UA_ChunkType chunkType = (UA_ChunkType)
         (hdr.messageTypeAndChunkType & UA_BITMASK_CHUNKTYPE);
 
+    /* Leave the chunk in the buffer for the caller to process differently */
+    if(channel->symmetricOnly && msgType != UA_MESSAGETYPE_MSG &&
+       msgType != UA_MESSAGETYPE_CLO)
+        return UA_STATUSCODE_GOODCALLAGAIN;
+
     /* The message size is not allowed */
     if(hdr.messageSize < UA_SECURECHANNEL_MESSAGE_MIN_LENGTH)
         return UA_STATUSCODE_BADTCPMESSAGETYPEINVALID;
@@ -798,21 +900,71 @@ extractCompleteChunk(UA_SecureChannel *channel, UA_Chunk *chunk, UA_DateTime now
     return res;
 }
 
+/* Returns the number of bytes from the next buffer that are missing to
+ * complete the last chunk in the unprocessed buffer. The unprocessed buffer can
+ * also contain complete chunks that were left for later processing. */
+static size_t
+missingChunkBytes(const UA_SecureChannel *channel, const UA_ByteString *next) {
+    const UA_ByteString *buf = &channel->unprocessed;
+    size_t pos = channel->unprocessedOffset;
+    while(pos < buf->length) {
+        /* Take everything if even the header is incomplete */
+        size_t have = buf->length - pos;
+        if(have + next->length < UA_SECURECHANNEL_MESSAGEHEADER_LENGTH)
+            return next->length;
+
+        /* Decode the message size. The header can be split between the
+         * buffers. */
+        UA_Byte hdr[UA_SECURECHANNEL_MESSAGEHEADER_LENGTH];
+        for(size_t i = 0; i < UA_SECURECHANNEL_MESSAGEHEADER_LENGTH; i++)
+            hdr[i] = (i < have) ? buf->data[pos + i] : next->data[i - have];
+        UA_ByteString hdrBuf = {UA_SECURECHANNEL_MESSAGEHEADER_LENGTH, hdr};
+        size_t offset = 4;
+        UA_UInt32 messageSize = 0;
+        UA_StatusCode res =
+            UA_decodeBinaryInternal(&hdrBuf, &offset, &messageSize,
+                                    &UA_TYPES[UA_TYPES_UINT32], NULL);
+        UA_assert(res == UA_STATUSCODE_GOOD);
+        (void)res; /* pacify compilers if assert is ignored */
+
+        /* Invalid message size. Take everything, extracting the chunk fails
+         * later on. */
+        if(messageSize < UA_SECURECHANNEL_MESSAGEHEADER_LENGTH)
+            return next->length;
+
+        /* The chunk is incomplete */
+        if(messageSize > have) {
+            size_t missing = messageSize - have;
+            return (missing < next->length) ? missing : next->length;
+        }
+        pos += messageSize;
+    }
+    return 0;
+}
+
 UA_StatusCode
 UA_SecureChannel_loadBuffer(UA_SecureChannel *channel, const UA_ByteString buffer) {
-    /* Append to the previous unprocessed buffer */
+    /* Append to the previous unprocessed buffer. But only up to the end of the
+     * incomplete chunk. The remaining chunks are extracted from the network
+     * buffer directly (without a copy). */
     if(channel->unprocessed.length > 0) {
         UA_assert(channel->unprocessedCopied == true);
+        UA_assert(channel->unprocessedNext.length == 0);
+
+        size_t append = missingChunkBytes(channel, &buffer);
+        if(append > 0) {
+            UA_Byte *t = (UA_Byte*)
+                UA_realloc(channel->unprocessed.data,
+                           channel->unprocessed.length + append);
+            if(!t)
+                return UA_STATUSCODE_BADOUTOFMEMORY;
+            memcpy(t + channel->unprocessed.length, buffer.data, append);
+            channel->unprocessed.data = t;
+            channel->unprocessed.length += append;
+        }
 
-        UA_Byte *t = (UA_Byte*)
-            UA_realloc(channel->unprocessed.data,
-                       channel->unprocessed.length + buffer.length);
-        if(!t)
-            return UA_STATUSCODE_BADOUTOFMEMORY;
-
-        memcpy(t + channel->unprocessed.length, buffer.data, buffer.length);
-        channel->unprocessed.data = t;
-        channel->unprocessed.length += buffer.length;
+        channel->unprocessedNext.data = buffer.data + append;
+        channel->unprocessedNext.length = buffer.length - append;
         return UA_STATUSCODE_GOOD;
     }
 
@@ -822,6 +974,35 @@ UA_SecureChannel_loadBuffer(UA_SecureChannel *channel, const UA_ByteString buffe
     return UA_STATUSCODE_GOOD;
 }
 
+/* Append the chunk payload to the reassembly buffer. The buffer grows
+ * geometrically to amortize the reallocations. */
+static UA_StatusCode
+appendReassembly(UA_SecureChannel *channel, const UA_ByteString *bytes) {
+    size_t needed = channel->reassembly.length + bytes->length;
+    if(needed > channel->reassemblyCapacity || !channel->reassembly.data) {
+        size_t capacity = channel->reassemblyCapacity * 2;
+        if(capacity < needed)
+            capacity = needed;
+        if(capacity < 64)
+            capacity = 64;
+        /* Don't overallocate beyond the message size limit */
+        if(channel->config.localMaxMessageSize != 0 &&
+           capacity > channel->config.localMaxMessageSize &&
+           needed <= channel->config.localMaxMessageSize)
+            capacity = channel->config.localMaxMessageSize;
+        UA_Byte *data = (UA_Byte*)UA_realloc(channel->reassembly.data, capacity);
+        if(!data)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        channel->reassembly.data = data;
+        channel->reassemblyCapacity = capacity;
+    }
+    memcpy(channel->reassembly.data + channel->reassembly.length,
+           bytes->data, bytes->length);
+    channel->reassembly.length = needed;
+    channel->reassemblyChunks++;
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_SecureChannel_getCompleteMessage(UA_SecureChannel *channel,
                                     UA_MessageType *messageType, UA_UInt32 *requestId,
@@ -834,6 +1015,16 @@ UA_SecureChannel_getCompleteMessage(UA_SecureChannel *channel,
     /* Extract+decode the next chunk from the buffer */
     memset(&chunk, 0, sizeof(UA_Chunk));
     res = extractCompleteChunk(channel, &chunk, nowMonotonic);
+
+    /* Return the OPN chunk without decryption (see deferOPN) */
+    if(res == UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY) {
+        *requestId = 0;
+        *messageType = chunk.messageType;
+        *payload = chunk.bytes;
+        *copied = chunk.copied;
+        return res;
+    }
+
     if(chunk.bytes.length == 0 || res != UA_STATUSCODE_GOOD)
         return res; /* Error or no complete chunk could be extracted */
 
@@ -849,14 +1040,32 @@ UA_SecureChannel_getCompleteMessage(UA_SecureChannel *channel,
     case UA_CHUNKTYPE_INTERMEDIATE:
         /* Validate the resource limits */
         if((channel->config.localMaxChunkCount != 0 &&
-            channel->chunksCount >= channel->config.localMaxChunkCount) ||
+            channel->chunksCount + channel->reassemblyChunks >=
+            channel->config.localMaxChunkCount) ||
            (channel->config.localMaxMessageSize != 0 &&
-            channel->chunksLength + chunk.bytes.length > channel->config.localMaxMessageSize)) {
+            channel->chunksLength + channel->reassembly.length +
+            chunk.bytes.length > channel->config.localMaxMessageSize)) {
             if(chunk.copied)
                 UA_ByteString_clear(&chunk.bytes);
             return UA_STATUSCODE_BADTCPMESSAGETOOLARGE;
         }
 
+        /* Append to the reassembly buffer if the chunk continues the ongoing
+         * reassembly. Or start a new reassembly if no chunks are queued. Then
+         * continue extracting more chunks. */
+        if((channel->reassembly.data &&
+            channel->reassemblyRequestId == chunk.requestId &&
+            channel->reassemblyMessageType == chunk.messageType) ||
+           (!channel->reassembly.data && TAILQ_EMPTY(&channel->chunks))) {
+            channel->reassemblyRequestId = chunk.requestId;
+            channel->reassemblyMessageType = chunk.messageType;
+            res = appendReassembly(channel, &chunk.bytes);
+            if(chunk.copied)
+                UA_ByteString_clear(&chunk.bytes);
+            UA_CHECK_STATUS(res, return res);
+            goto extract_chunk;
+        }
+
         /* Add the chunk to the queue. Then continue extracting more chunks. */
         pchunk = (UA_Chunk*)UA_malloc(sizeof(UA_Chunk));
         if(!pchunk) {
@@ -876,6 +1085,31 @@ UA_SecureChannel_getCompleteMessage(UA_SecureChannel *channel,
         break; /* A final chunk was received -- assemble the message */
     }
 
+    /* Complete the message in the reassembly buffer */
+    if(channel->reassembly.data && channel->reassemblyRequestId == chunk.requestId) {
+        if(channel->reassemblyMessageType != chunk.messageType)
+            res = UA_STATUSCODE_BADTCPMESSAGETYPEINVALID;
+        else if(channel->config.localMaxMessageSize != 0 &&
+                channel->reassembly.length + chunk.bytes.length >
+                channel->config.localMaxMessageSize)
+            res = UA_STATUSCODE_BADTCPMESSAGETOOLARGE;
+        else
+            res = appendReassembly(channel, &chunk.bytes);
+        if(chunk.copied)
+            UA_ByteString_clear(&chunk.bytes);
+        UA_CHECK_STATUS(res, return res);
+
+        /* Hand out the reassembly buffer */
+        *requestId = chunk.requestId;
+        *messageType = chunk.messageType;
+        *payload = channel->reassembly;
+        *copied = true;
+        UA_ByteString_init(&channel->reassembly);
+        channel->reassemblyCapacity = 0;
+        channel->reassemblyChunks = 0;
+        return UA_STATUSCODE_GOOD;
+    }
+
     /* Compute the message size */
     size_t messageSize = chunk.bytes.length;
     UA_Chunk *first = NULL;
@@ -965,23 +1199,56 @@ UA_SecureChannel_getCompleteMessage(UA_SecureChannel *channel,
 }
 
 UA_StatusCode
-UA_SecureChannel_persistBuffer(UA_SecureChannel *channel) {
-    UA_StatusCode res = UA_STATUSCODE_GOOD;
+UA_SecureChannel_decryptOPN(const UA_SecureChannel *channel, UA_ByteString *chunk,
+                            UA_UInt32 *requestId, UA_UInt32 *sequenceNumber) {
+    UA_CHECK_MEM(channel->securityPolicy, return UA_STATUSCODE_BADINTERNALERROR);
+
+    /* Skip the headers. They were already checked in unpackPayloadOPN. */
+    size_t offset = UA_SECURECHANNEL_CHANNELHEADER_LENGTH;
+    UA_AsymmetricAlgorithmSecurityHeader asymHeader;
+    UA_StatusCode res =
+        UA_decodeBinaryInternal(chunk, &offset, &asymHeader,
+             &UA_TRANSPORT[UA_TRANSPORT_ASYMMETRICALGORITHMSECURITYHEADER], NULL);
+    UA_AsymmetricAlgorithmSecurityHeader_clear(&asymHeader);
+    UA_CHECK_STATUS(res, return res);
+
+    /* Decrypt the chunk payload */
+    res = decryptAndVerifyChunk(channel,
+                                &channel->securityPolicy->asymmetricModule.cryptoModule,
+                                UA_MESSAGETYPE_OPN, chunk, offset);
+    UA_CHECK_STATUS(res, return res);
+
+    /* Decode the SequenceHeader */
+    UA_SequenceHeader sequenceHeader;
+    res = UA_decodeBinaryInternal(chunk, &offset, &sequenceHeader,
+                                  &UA_TRANSPORT[UA_TRANSPORT_SEQUENCEHEADER], NULL);
+    UA_CHECK_STATUS(res, return res);
+    *requestId = sequenceHeader.requestId;
+    *sequenceNumber = sequenceHeader.sequenceNumber;
+
+    /* Use only the payload */
+    chunk->data += offset;
+    chunk->length -= offset;
+    return UA_STATUSCODE_GOOD;
+}
 
+UA_Boolean
+UA_SecureChannel_hasUnprocessed(const UA_SecureChannel *channel) {
+    return (channel->unprocessed.length > channel->unprocessedOffset ||
+            channel->unprocessedNext.length > 0);
+}
+
+UA_StatusCode
+UA_SecureChannel_persistBuffer(UA_SecureChannel *channel) {
     /* Persist the chunks */
-    UA_Chunk *chunk;
-    TAILQ_FOREACH(chunk, &channel->chunks, pointers) {
-        if(chunk->copied)
-            continue;
-        UA_ByteString tmp = UA_BYTESTRING_NULL;
-        res |= UA_ByteString_copy(&chunk->bytes, &tmp);
-        chunk->bytes = tmp;
-        chunk->copied = true;
-    }
+    UA_StatusCode res = persistChunks(channel);
 
     /* No unprocessed bytes remaining */
     UA_assert(channel->unprocessed.length >= channel->unprocessedOffset);
-    if(channel->unprocessed.length == channel->unprocessedOffset) {
+    UA_ByteString next = channel->unprocessedNext;
+    UA_ByteString_init(&channel->unprocessedNext);
+    if(channel->unprocessed.length == channel->unprocessedOffset &&
+       next.length == 0) {
         if(channel->unprocessedCopied)
             UA_ByteString_clear(&channel->unprocessed);
         else
@@ -990,13 +1257,21 @@ UA_SecureChannel_persistBuffer(UA_SecureChannel *channel) {
         return res;
     }
 
-    /* Allocate a new unprocessed ByteString.
-     * tmp is the empty string if malloc fails. */
+    /* Allocate a new unprocessed ByteString with the remaining bytes from
+     * both buffers. tmp is the empty string if malloc fails. */
     UA_ByteString tmp = UA_BYTESTRING_NULL;
     UA_ByteString remaining = channel->unprocessed;
     remaining.data += channel->unprocessedOffset;
     remaining.length -= channel->unprocessedOffset;
-    res |= UA_ByteString_copy(&remaining, &tmp);
+    UA_StatusCode allocRes =
+        UA_ByteString_allocBuffer(&tmp, remaining.length + next.length);
+    if(allocRes == UA_STATUSCODE_GOOD) {
+        if(remaining.length > 0)
+            memcpy(tmp.data, remaining.data, remaining.length);
+        if(next.length > 0)
+            memcpy(tmp.data + remaining.length, next.data, next.length);
+    }
+    res |= allocRes;
     if(channel->unprocessedCopied)
         UA_ByteString_clear(&channel->unprocessed);
     channel->unprocessed = tmp;
@@ -103,6 +103,7 @@ struct UA_SecureChannel {
     /* Connection handling in the EventLoop */
     UA_ConnectionManager *connectionManager;
     uintptr_t connectionId;
+    UA_Boolean sendBlocked; /* The send queue of the connection is full */
 
     /* The namespace mapping translates namespace indices of NodeIds during
      * de/encoding (client only) */
@@ -152,12 +153,47 @@ struct UA_SecureChannel {
     size_t chunksCount;
     size_t chunksLength;
 
+    /* Reassembly buffer for a message that is received in several chunks. The
+     * decrypted payload of each intermediate chunk is appended in place. With
+     * the final chunk the buffer is handed out as the complete message.
+     * Chunks of other messages received in between are put in the queue. The
+     * buffer data is NULL if no reassembly is ongoing. */
+    UA_ByteString reassembly;
+    size_t reassemblyCapacity;
+    size_t reassemblyChunks;
+    UA_UInt32 reassemblyRequestId;
+    UA_MessageType reassemblyMessageType;
+
+    /* Arena for the decoding of requests. Reset after each request has been
+     * processed (only used in the server) */
+    UA_Arena requestArena;
+
     /* Received buffer from which no chunks have been extracted so far */
     UA_ByteString unprocessed;
     size_t unprocessedOffset;
     UA_Boolean unprocessedCopied;
     UA_DelayedCallback unprocessedDelayed;
 
+    /* Part of the network buffer that was not appended to the copied
+     * unprocessed buffer. Only the bytes to complete the last chunk are
+     * appended. The remaining chunks are extracted from the network buffer
+     * directly once the unprocessed buffer is exhausted. */
+    UA_ByteString unprocessedNext;
+
+    /* Only extract MSG and CLO chunks. If another message type is next in the
+     * buffer, getCompleteMessage returns GoodCallAgain without consuming it. */
+    UA_Boolean symmetricOnly;
+
+    /* Stop before the asymmetric decryption of a secured OPN chunk. Then
+     * getCompleteMessage returns GoodCompletesAsynchronously with the (still
+     * encrypted) chunk. It is decrypted with UA_SecureChannel_decryptOPN. */
+    UA_Boolean deferOPN;
+
+    /* The asymmetric cryptography of the OPN handshake is processed in a
+     * worker thread. No further messages are processed until it is done (only
+     * used in the server). */
+    void *handshakeJob;
+
     UA_CertificateGroup *certificateVerification;
     void *processOPNHeaderApplication;
     UA_StatusCode (*processOPNHeader)(void *application, UA_SecureChannel *channel,
@@ -226,6 +262,36 @@ UA_StatusCode
 UA_SecureChannel_sendAsymmetricOPNMessage(UA_SecureChannel *channel, UA_UInt32 requestId,
                                           const void *content, const UA_DataType *contentType);
 
+/* The OPN message can also be sent in three steps. Then the signature and
+ * encryption (the expensive part) can be made in a worker thread:
+ *
+ * 1. encodeAsymmetricOPNMessage: Encode into the buffer that was allocated by
+ *    the caller with the sendBufferSize of the channel.
+ * 2. signAndEncryptAsymmetricOPNMessage: Does not modify the channel.
+ * 3. sendAsymmetricMessage: Copy into a network buffer and send. The message
+ *    buffer remains with the caller. */
+typedef struct {
+    UA_ByteString buf;
+    size_t securityHeaderLength;
+    size_t preSigLength;
+    size_t totalLength;
+    size_t encryptedLength;
+} UA_AsymmetricMessage;
+
+UA_StatusCode
+UA_SecureChannel_encodeAsymmetricOPNMessage(UA_SecureChannel *channel,
+                                            UA_UInt32 requestId, const void *content,
+                                            const UA_DataType *contentType,
+                                            UA_AsymmetricMessage *msg);
+
+UA_StatusCode
+UA_SecureChannel_signAndEncryptAsymmetricOPNMessage(UA_SecureChannel *channel,
+                                                    UA_AsymmetricMessage *msg);
+
+UA_StatusCode
+UA_SecureChannel_sendAsymmetricMessage(UA_SecureChannel *channel,
+                                       const UA_AsymmetricMessage *msg);
+
 UA_StatusCode
 UA_SecureChannel_sendSymmetricMessage(UA_SecureChannel *channel, UA_UInt32 requestId,
                                       UA_MessageType messageType, void *payload,
@@ -279,14 +345,17 @@ UA_MessageContext_abort(UA_MessageContext *mc);
 /* Process a received buffer. This always has these three steps:
  *
  * 1. loadBuffer: The chunks in the SecureChannel are cut into chunks.
- *    The chunks can still point to the buffer.
+ *    The chunks can still point to the buffer. If an incomplete chunk remains
+ *    from the previous buffer, only its missing bytes are copied.
  * 2. getCompleteMessage: Assemble chunks into a complete message. This is
  *    repeated until an error occours or an empty message is returned.
  * 3. persistBuffer: Make a copy of the remaining unpprocessed bytestring. So
  *    that the NetworkManager can reuse or free the packet memory.
  *
  * Note that only MSG and CLO messages are decrypted. HEL/ACK/OPN/... are
- * forwarded verbatim to the application. */
+ * forwarded verbatim to the application. With symmetricOnly set,
+ * getCompleteMessage stops with GoodCallAgain in front of a chunk that is not
+ * MSG or CLO. */
 UA_StatusCode
 UA_SecureChannel_loadBuffer(UA_SecureChannel *channel, const UA_ByteString buffer);
 
@@ -299,6 +368,19 @@ UA_SecureChannel_getCompleteMessage(UA_SecureChannel *channel,
 UA_StatusCode
 UA_SecureChannel_persistBuffer(UA_SecureChannel *channel);
 
+/* Are there received bytes that were not yet extracted into chunks? */
+UA_Boolean
+UA_SecureChannel_hasUnprocessed(const UA_SecureChannel *channel);
+
+/* Decrypt and verify an OPN chunk that was returned by getCompleteMessage with
+ * deferOPN set. The headers were already checked at that point. The chunk is
+ * decrypted in-place and reduced to the payload. Does not modify the channel,
+ * so this can run in a worker thread. The caller has to set the
+ * receiveSequenceNumber of the channel afterwards. */
+UA_StatusCode
+UA_SecureChannel_decryptOPN(const UA_SecureChannel *channel, UA_ByteString *chunk,
+                            UA_UInt32 *requestId, UA_UInt32 *sequenceNumber);
+
 /* Internal methods in ua_securechannel_crypto.h */
 
 void
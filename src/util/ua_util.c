@@ -964,6 +964,92 @@ UA_ReadValueId_print(const UA_ReadValueId *rvi, UA_String *out) {
 
 #endif
 
+/*******************/
+/* Arena Allocator */
+/*******************/
+
+/* Alignment of the memory returned from the arena */
+#define UA_ARENA_ALIGN 8
+#define UA_ARENA_ALIGNED(x) (((x) + (UA_ARENA_ALIGN - 1)) & ~(size_t)(UA_ARENA_ALIGN - 1))
+#define UA_ARENA_HEADER UA_ARENA_ALIGNED(sizeof(UA_ArenaBlock))
+
+void
+UA_Arena_init(UA_Arena *arena, size_t blockSize) {
+    arena->blocks = NULL;
+    arena->blockSize = blockSize;
+}
+
+static UA_ArenaBlock *
+UA_Arena_addBlock(UA_Arena *arena, size_t minSize) {
+    size_t size = (minSize > arena->blockSize) ? minSize : arena->blockSize;
+    if(size > SIZE_MAX - UA_ARENA_HEADER)
+        return NULL;
+    UA_ArenaBlock *block = (UA_ArenaBlock*)UA_malloc(UA_ARENA_HEADER + size);
+    if(!block)
+        return NULL;
+    block->size = size;
+    block->pos = 0;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    return block;
+}
+
+void *
+UA_Arena_calloc(void *a, size_t nelem, size_t elsize) {
+    UA_Arena *arena = (UA_Arena*)a;
+    if(elsize > 0 && nelem > (SIZE_MAX - UA_ARENA_ALIGN) / elsize)
+        return NULL; /* Overflow */
+    size_t size = UA_ARENA_ALIGNED(nelem * elsize);
+    if(size == 0)
+        size = UA_ARENA_ALIGN;
+
+    /* Allocate from the current block or add a new block */
+    UA_ArenaBlock *block = arena->blocks;
+    if(!block || block->size - block->pos < size) {
+        block = UA_Arena_addBlock(arena, size);
+        if(!block)
+            return NULL;
+    }
+
+    void *p = (UA_Byte*)block + UA_ARENA_HEADER + block->pos;
+    block->pos += size;
+    memset(p, 0, size);
+    return p;
+}
+
+void
+UA_Arena_reset(UA_Arena *arena) {
+    UA_ArenaBlock *block = arena->blocks;
+    if(!block)
+        return;
+    /* Free all but the first (oldest) block */
+    while(block->next) {
+        UA_ArenaBlock *next = block->next;
+        UA_free(block);
+        block = next;
+    }
+    /* Retain the first block only if it has the regular size. It might be
+     * larger if the first allocation exceeded the block size. */
+    if(block->size != arena->blockSize) {
+        UA_free(block);
+        block = NULL;
+    } else {
+        block->pos = 0;
+    }
+    arena->blocks = block;
+}
+
+void
+UA_Arena_clear(UA_Arena *arena) {
+    UA_ArenaBlock *block = arena->blocks;
+    while(block) {
+        UA_ArenaBlock *next = block->next;
+        UA_free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+}
+
 /************************/
 /* Cryptography Helpers */
 /************************/
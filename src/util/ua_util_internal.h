@@ -220,6 +220,38 @@ UA_dump_hex_pkg(UA_Byte* buffer, size_t bufferLen);
  * certificates */
 UA_ByteString getLeafCertificate(UA_ByteString chain);
 
+/* Arena (bump) allocator. Memory is taken from a retained block by advancing
+ * a position. If the block is exhausted, additional blocks are allocated on
+ * the heap. All memory is released at once with _reset. The additional blocks
+ * are freed, the first block is retained for reuse. The arena is used as the
+ * calloc replacement in UA_DecodeBinaryOptions. Then the decoded structure
+ * must not be _clear'ed but the arena _reset instead. */
+typedef struct UA_ArenaBlock {
+    struct UA_ArenaBlock *next;
+    size_t size; /* Usable size (after the header) */
+    size_t pos;
+} UA_ArenaBlock;
+
+typedef struct {
+    UA_ArenaBlock *blocks; /* Last block is the retained first block */
+    size_t blockSize;      /* 0 -> the arena is disabled */
+} UA_Arena;
+
+void
+UA_Arena_init(UA_Arena *arena, size_t blockSize);
+
+/* Signature matches the calloc override in UA_DecodeBinaryOptions */
+void *
+UA_Arena_calloc(void *arena, size_t nelem, size_t elsize);
+
+/* Release all allocated memory but keep the first block */
+void
+UA_Arena_reset(UA_Arena *arena);
+
+/* Release all memory including the first block */
+void
+UA_Arena_clear(UA_Arena *arena);
+
 /* Unions that represent any of the supported request or response message */
 typedef union {
     UA_RequestHeader requestHeader;
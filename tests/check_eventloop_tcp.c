@@ -12,6 +12,13 @@
 #include <stdlib.h>
 #include <check.h>
 
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
 static UA_EventLoop *el;
 static unsigned connCount;
 static char *testMsg = "open62541";
@@ -180,11 +187,215 @@ START_TEST(connectTCP) {
     el = NULL;
 } END_TEST
 
+#ifndef _WIN32
+
+static uintptr_t acceptedId;
+static int blockedSignals;
+static int unblockedSignals;
+
+static void
+sendQueueCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                  void *application, void **connectionContext,
+                  UA_ConnectionState status, const UA_KeyValueMap *params,
+                  UA_ByteString msg) {
+    if(status != UA_CONNECTIONSTATE_ESTABLISHED)
+        return;
+    const UA_Boolean *blocked = (const UA_Boolean*)
+        UA_KeyValueMap_getScalar(params, UA_QUALIFIEDNAME(0, "send-blocked"),
+                                 &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if(blocked) {
+        ck_assert_uint_eq(connectionId, acceptedId);
+        if(*blocked)
+            blockedSignals++;
+        else
+            unblockedSignals++;
+        return;
+    }
+    if(UA_KeyValueMap_contains(params, UA_QUALIFIEDNAME(0, "listen-port")))
+        return; /* The listen socket */
+    acceptedId = connectionId;
+}
+
+/* Listen on the port and connect with a plain socket that does not read. The
+ * EventLoop is started. Returns the socket of the remote side. */
+static int
+connectRawSocket(UA_ConnectionManager *cm, UA_UInt16 port) {
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+
+    UA_Boolean listen = true;
+    UA_Boolean reuse = true;
+    UA_String host = UA_STRING("127.0.0.1");
+    UA_KeyValuePair params[4];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+    params[3].key = UA_QUALIFIEDNAME(0, "reuse");
+    UA_Variant_setScalar(&params[3].value, &reuse, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_KeyValueMap paramsMap = {4, params};
+    UA_StatusCode retval =
+        cm->openConnection(cm, &paramsMap, NULL, NULL, sendQueueCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    ck_assert(sock >= 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    ck_assert_int_eq(connect(sock, (struct sockaddr*)&addr, sizeof(addr)), 0);
+
+    acceptedId = 0;
+    blockedSignals = 0;
+    unblockedSignals = 0;
+    for(size_t i = 0; i < 5 && acceptedId == 0; i++)
+        el->run(el, 1);
+    ck_assert(acceptedId != 0);
+    return sock;
+}
+
+static void
+stopEventLoop(void) {
+    int max_stop_iteration_count = 10;
+    int iteration = 0;
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED &&
+          iteration < max_stop_iteration_count) {
+        el->run(el, 1);
+        iteration++;
+    }
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    el->free(el);
+    el = NULL;
+}
+
+#define SENDQUEUE_CHUNK (1 << 16)
+#define SENDQUEUE_CHUNKS 64
+
+/* The remote side does not read. Sending does not block. The data is queued
+ * and sent once the remote side reads again. */
+START_TEST(sendQueueTCP) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    UA_UInt32 high = 4 * SENDQUEUE_CHUNK;
+    UA_UInt32 low = SENDQUEUE_CHUNK;
+    UA_KeyValueMap_setScalar(&cm->eventSource.params,
+                             UA_QUALIFIEDNAME(0, "send-queue-high"),
+                             &high, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_KeyValueMap_setScalar(&cm->eventSource.params,
+                             UA_QUALIFIEDNAME(0, "send-queue-low"),
+                             &low, &UA_TYPES[UA_TYPES_UINT32]);
+    int sock = connectRawSocket(cm, 4841);
+    UA_StatusCode retval;
+
+    /* Send more than fits into the socket buffers */
+    size_t sent = 0;
+    for(size_t i = 0; i < SENDQUEUE_CHUNKS; i++) {
+        UA_ByteString snd;
+        retval = cm->allocNetworkBuffer(cm, acceptedId, &snd, SENDQUEUE_CHUNK);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        memset(snd.data, (int)i, snd.length);
+        retval = cm->sendWithConnection(cm, acceptedId, NULL, &snd);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        sent += SENDQUEUE_CHUNK;
+    }
+
+    /* The blocked state is signaled from the EventLoop */
+    ck_assert_int_eq(blockedSignals, 0);
+    el->run(el, 1);
+    ck_assert_int_eq(blockedSignals, 1);
+    ck_assert_int_eq(unblockedSignals, 0);
+
+    /* Read everything on the remote side. The content arrives in order. */
+    size_t received = 0;
+    UA_Byte buf[SENDQUEUE_CHUNK];
+    for(size_t i = 0; i < 100000 && received < sent; i++) {
+        el->run(el, 1);
+        ssize_t n = recv(sock, buf, sizeof(buf), MSG_DONTWAIT);
+        if(n <= 0)
+            continue;
+        for(ssize_t j = 0; j < n; j++)
+            ck_assert_uint_eq(buf[j], (UA_Byte)((received + (size_t)j) / SENDQUEUE_CHUNK));
+        received += (size_t)n;
+    }
+    ck_assert_uint_eq(received, sent);
+    ck_assert_int_eq(blockedSignals, 1);
+    ck_assert_int_eq(unblockedSignals, 1);
+
+    close(sock);
+    stopEventLoop();
+} END_TEST
+
+#define GATHER_CHUNK 1000
+#define GATHER_CHUNKS 32
+
+/* Buffers sent with the "more" parameter are held back and sent with a single
+ * syscall together with the final buffer */
+START_TEST(gatherSendTCP) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    int sock = connectRawSocket(cm, 4842);
+
+    UA_TCPStatistics before = UA_ConnectionManager_getStatistics_POSIX_TCP(cm);
+    UA_Boolean more = true;
+    UA_KeyValuePair morePair;
+    morePair.key = UA_QUALIFIEDNAME(0, "more");
+    UA_Variant_setScalar(&morePair.value, &more, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_KeyValueMap moreParams = {1, &morePair};
+    for(size_t i = 0; i < GATHER_CHUNKS; i++) {
+        UA_ByteString snd;
+        UA_StatusCode retval =
+            cm->allocNetworkBuffer(cm, acceptedId, &snd, GATHER_CHUNK);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        memset(snd.data, (int)i, snd.length);
+        retval = cm->sendWithConnection(cm, acceptedId,
+                                        (i < GATHER_CHUNKS - 1) ? &moreParams : NULL,
+                                        &snd);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        UA_TCPStatistics stats = UA_ConnectionManager_getStatistics_POSIX_TCP(cm);
+        ck_assert_uint_eq(stats.sendBuffers, before.sendBuffers + i + 1);
+        if(i < GATHER_CHUNKS - 1)
+            ck_assert_uint_eq(stats.sendCalls, before.sendCalls); /* Held back */
+    }
+
+    /* All buffers are sent with one syscall */
+    UA_TCPStatistics after = UA_ConnectionManager_getStatistics_POSIX_TCP(cm);
+    ck_assert_uint_eq(after.sendCalls, before.sendCalls + 1);
+    ck_assert_uint_eq(after.sendBytes, before.sendBytes + GATHER_CHUNK * GATHER_CHUNKS);
+
+    /* The content arrives in order */
+    size_t received = 0;
+    UA_Byte buf[GATHER_CHUNK];
+    for(size_t i = 0; i < 1000 && received < GATHER_CHUNK * GATHER_CHUNKS; i++) {
+        ssize_t n = recv(sock, buf, sizeof(buf), MSG_DONTWAIT);
+        if(n <= 0) {
+            el->run(el, 1);
+            continue;
+        }
+        for(ssize_t j = 0; j < n; j++)
+            ck_assert_uint_eq(buf[j], (UA_Byte)((received + (size_t)j) / GATHER_CHUNK));
+        received += (size_t)n;
+    }
+    ck_assert_uint_eq(received, GATHER_CHUNK * GATHER_CHUNKS);
+
+    close(sock);
+    stopEventLoop();
+} END_TEST
+
+#endif
+
 int main(void) {
     Suite *s  = suite_create("Test TCP EventLoop");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, listenTCP);
     tcase_add_test(tc, connectTCP);
+#ifndef _WIN32
+    tcase_add_test(tc, sendQueueTCP);
+    tcase_add_test(tc, gatherSendTCP);
+#endif
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
@@ -394,6 +394,141 @@ START_TEST(udpTalkerAndListener) {
     ck_assert_uint_eq(testContext.connCount, 0);
 } END_TEST
 
+static size_t batchReceived;
+static UA_Boolean batchRemote;
+
+static void
+batchCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+              void *application, void **connectionContext,
+              UA_ConnectionState status,
+              const UA_KeyValueMap *params,
+              UA_ByteString msg) {
+    if(msg.length == 0)
+        return;
+    UA_ByteString rcv = UA_BYTESTRING(testMsg);
+    ck_assert(UA_String_equal(&msg, &rcv));
+    if(UA_KeyValueMap_getScalar(params, UA_QUALIFIEDNAME(0, "remote-address"),
+                                &UA_TYPES[UA_TYPES_STRING]))
+        batchRemote = true;
+    batchReceived++;
+}
+
+#define BATCH_MESSAGES 16
+
+START_TEST(udpBatchedSendAndReceive) {
+    UA_EventLoop *elListener = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_ConnectionManager *cmListener = UA_ConnectionManager_new_POSIX_UDP(UA_STRING("udpCM"));
+    elListener->registerEventSource(elListener, &cmListener->eventSource);
+    elListener->start(elListener);
+
+    UA_EventLoop *elTalker = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_ConnectionManager *cmTalker = UA_ConnectionManager_new_POSIX_UDP(UA_STRING("udpCM"));
+    elTalker->registerEventSource(elTalker, &cmTalker->eventSource);
+    elTalker->start(elTalker);
+
+    /* Open a listener connection */
+    UA_UInt16 port = 30001;
+    UA_Boolean listen = true;
+
+    UA_KeyValuePair params[3];
+    UA_KeyValueMap paramsMap = {2, params};
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+
+    UA_StatusCode retval =
+        cmListener->openConnection(cmListener, &paramsMap, NULL, NULL, batchCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Open a talker connection */
+    TestContext testContext;
+    testContext.connCount = 0;
+    clientId = 0;
+    listen = false;
+    UA_String targetHost = UA_STRING("localhost");
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &targetHost, &UA_TYPES[UA_TYPES_STRING]);
+    paramsMap.mapSize = 3;
+    retval = cmTalker->openConnection(cmTalker, &paramsMap, NULL, &testContext,
+                                      connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = elTalker->run(elTalker, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_ne(clientId, 0);
+
+    /* Send messages with the "more" flag. They are held back. */
+    batchReceived = 0;
+    batchRemote = false;
+    UA_Boolean more = true;
+    UA_KeyValuePair sendParam;
+    sendParam.key = UA_QUALIFIEDNAME(0, "more");
+    UA_Variant_setScalar(&sendParam.value, &more, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_KeyValueMap sendParams = {1, &sendParam};
+    for(size_t i = 0; i < BATCH_MESSAGES; i++) {
+        if(i == BATCH_MESSAGES - 1)
+            sendParams.mapSize = 0; /* The last message releases the batch */
+        UA_ByteString snd;
+        retval = cmTalker->allocNetworkBuffer(cmTalker, clientId, &snd, strlen(testMsg));
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        memcpy(snd.data, testMsg, strlen(testMsg));
+        retval = cmTalker->sendWithConnection(cmTalker, clientId, &sendParams, &snd);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+#ifdef __linux__
+        if(i == 0) {
+            elListener->run(elListener, 1);
+            ck_assert_uint_eq(batchReceived, 0);
+        }
+#endif
+    }
+
+    /* Several datagrams are received per EventLoop iteration */
+    for(size_t i = 0; i < 4; i++) {
+        UA_DateTime next = elListener->run(elListener, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+#ifdef __linux__
+    ck_assert_uint_eq(batchReceived, BATCH_MESSAGES);
+#endif
+    ck_assert(batchReceived > 0);
+
+    /* The source is only reported with the report-remote parameter */
+    ck_assert(!batchRemote);
+
+    /* An empty buffer without the flag releases the held-back messages */
+    batchReceived = 0;
+    sendParams.mapSize = 1;
+    for(size_t i = 0; i < 3; i++) {
+        UA_ByteString snd;
+        size_t len = (i < 2) ? strlen(testMsg) : 0;
+        if(i == 2)
+            sendParams.mapSize = 0;
+        retval = cmTalker->allocNetworkBuffer(cmTalker, clientId, &snd, len);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        if(len > 0)
+            memcpy(snd.data, testMsg, len);
+        retval = cmTalker->sendWithConnection(cmTalker, clientId, &sendParams, &snd);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = elListener->run(elListener, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_eq(batchReceived, 2);
+
+    elTalker->stop(elTalker);
+    while(elTalker->state != UA_EVENTLOOPSTATE_STOPPED)
+        elTalker->run(elTalker, 1);
+    elTalker->free(elTalker);
+
+    elListener->stop(elListener);
+    while(elListener->state != UA_EVENTLOOPSTATE_STOPPED)
+        elListener->run(elListener, 1);
+    elListener->free(elListener);
+} END_TEST
+
 START_TEST(udpTalkerAndListenerDifferentDestination) {
     /* create listener eventloop */
     UA_EventLoop *elListener = UA_EventLoop_new_POSIX(UA_Log_Stdout);
@@ -526,6 +661,7 @@ int main(void) {
     tcase_add_test(tc, connectUDPValidationSucceeds);
     tcase_add_test(tc, udpTalkerAndListener);
     tcase_add_test(tc, udpTalkerAndListenerDifferentDestination);
+    tcase_add_test(tc, udpBatchedSendAndReceive);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
@@ -526,6 +526,91 @@ START_TEST(SecureChannel_assemblePartialChunks) {
 } END_TEST
 
 
+/* Encode a MSG chunk with the sequence number and request id */
+static size_t
+encodeMsgChunk(UA_Byte *pos, UA_ChunkType chunkType, UA_UInt32 sequenceNumber,
+               UA_UInt32 requestId, UA_Byte content, size_t contentLength) {
+    size_t length = UA_SECURECHANNEL_MESSAGE_MIN_LENGTH + 8 + contentLength;
+    UA_Byte *bufPos = pos;
+    const UA_Byte *bufEnd = &pos[length];
+    UA_TcpMessageHeader header;
+    header.messageTypeAndChunkType = (UA_UInt32)UA_MESSAGETYPE_MSG + chunkType;
+    header.messageSize = (UA_UInt32)length;
+    UA_UInt32 channelId = testChannel.securityToken.channelId;
+    UA_UInt32 tokenId = testChannel.securityToken.tokenId;
+    UA_StatusCode res =
+        UA_encodeBinaryInternal(&header, &UA_TRANSPORT[UA_TRANSPORT_TCPMESSAGEHEADER],
+                                &bufPos, &bufEnd, NULL, NULL, NULL);
+    res |= UA_UInt32_encodeBinary(&channelId, &bufPos, bufEnd);
+    res |= UA_UInt32_encodeBinary(&tokenId, &bufPos, bufEnd);
+    res |= UA_UInt32_encodeBinary(&sequenceNumber, &bufPos, bufEnd);
+    res |= UA_UInt32_encodeBinary(&requestId, &bufPos, bufEnd);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    memset(bufPos, content, contentLength);
+    return length;
+}
+
+START_TEST(SecureChannel_reassembleSplitMessage) {
+    testChannel.securityToken.createdAt = UA_DateTime_nowMonotonic();
+    testChannel.securityToken.revisedLifetime = 600000;
+
+    /* Three chunks of one message followed by a single-chunk message */
+    UA_Byte data[1024];
+    size_t length = 0;
+    length += encodeMsgChunk(&data[length], UA_CHUNKTYPE_INTERMEDIATE, 1, 7, 'a', 100);
+    length += encodeMsgChunk(&data[length], UA_CHUNKTYPE_INTERMEDIATE, 2, 7, 'b', 100);
+    length += encodeMsgChunk(&data[length], UA_CHUNKTYPE_FINAL, 3, 7, 'c', 100);
+    length += encodeMsgChunk(&data[length], UA_CHUNKTYPE_FINAL, 4, 8, 'd', 50);
+
+    /* Receive the chunks in network buffers with cuts inside the headers and
+     * the payload */
+    const size_t cuts[] = {5, 130, 131, 260, length};
+    UA_ByteString messages[2];
+    UA_UInt32 requestIds[2];
+    size_t received = 0;
+    size_t pos = 0;
+    for(size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); i++) {
+        UA_ByteString buffer = {cuts[i] - pos, &data[pos]};
+        pos = cuts[i];
+        UA_StatusCode res = UA_SecureChannel_loadBuffer(&testChannel, buffer);
+        while(res == UA_STATUSCODE_GOOD) {
+            UA_MessageType messageType;
+            UA_UInt32 requestId = 0;
+            UA_ByteString payload = UA_BYTESTRING_NULL;
+            UA_Boolean copied = false;
+            res = UA_SecureChannel_getCompleteMessage(&testChannel, &messageType,
+                                                      &requestId, &payload, &copied,
+                                                      UA_DateTime_nowMonotonic());
+            if(res != UA_STATUSCODE_GOOD || payload.length == 0)
+                break;
+            ck_assert_uint_lt(received, 2);
+            ck_assert_int_eq(messageType, UA_MESSAGETYPE_MSG);
+            requestIds[received] = requestId;
+            ck_assert_uint_eq(UA_ByteString_copy(&payload, &messages[received]),
+                              UA_STATUSCODE_GOOD);
+            received++;
+            if(copied)
+                UA_ByteString_clear(&payload);
+        }
+        /* The network buffer is not accessed after persisting */
+        res |= UA_SecureChannel_persistBuffer(&testChannel);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        memset(buffer.data, 0, buffer.length);
+    }
+
+    /* Check the reassembled messages */
+    ck_assert_uint_eq(received, 2);
+    ck_assert_uint_eq(requestIds[0], 7);
+    ck_assert_uint_eq(messages[0].length, 300);
+    for(size_t i = 0; i < 300; i++)
+        ck_assert_int_eq(messages[0].data[i], 'a' + (int)(i / 100));
+    ck_assert_uint_eq(requestIds[1], 8);
+    ck_assert_uint_eq(messages[1].length, 50);
+    ck_assert_int_eq(messages[1].data[0], 'd');
+    UA_ByteString_clear(&messages[0]);
+    UA_ByteString_clear(&messages[1]);
+} END_TEST
+
 static Suite *
 testSuite_SecureChannel(void) {
     Suite *s = suite_create("SecureChannel");
@@ -566,6 +651,7 @@ testSuite_SecureChannel(void) {
     tcase_add_checked_fixture(tc_processBuffer, setup_key_sizes, teardown_key_sizes);
     tcase_add_checked_fixture(tc_processBuffer, setup_secureChannel, teardown_secureChannel);
     tcase_add_test(tc_processBuffer, SecureChannel_assemblePartialChunks);
+    tcase_add_test(tc_processBuffer, SecureChannel_reassembleSplitMessage);
     suite_add_tcase(s, tc_processBuffer);
 
     return s;
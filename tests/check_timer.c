@@ -53,10 +53,96 @@ START_TEST(benchmarkTimer) {
     UA_Timer_clear(&timer);
 } END_TEST
 
+/* Run the same random sequence of add/modify/remove/process on both timer
+ * implementations. The next execution times and the number of executions per
+ * callback must be identical. */
+
+#define N_COMPARE 1000
+
+static size_t compareCount[2][N_COMPARE];
+static UA_UInt64 compareIds[2][N_COMPARE];
+static UA_Timer *compareTimer;
+static size_t compareImpl;
+
+static void
+compareCallback(void *application, void *data) {
+    size_t i = (size_t)(uintptr_t)data;
+    compareCount[compareImpl][i]++;
+    /* Modify the entry from within its own callback */
+    if(i % 97 == 0)
+        UA_Timer_modify(compareTimer, compareIds[compareImpl][i],
+                        (UA_Double)(i % 50 + 1), 0, NULL,
+                        UA_TIMERPOLICY_CURRENTTIME);
+}
+
+START_TEST(compareWheelZipTree) {
+    UA_Timer timers[2];
+    UA_Timer_initZipTree(&timers[0]);
+    UA_Timer_initWheel(&timers[1]);
+    ck_assert_ptr_ne(timers[1].wheel, NULL);
+    memset(compareCount, 0, sizeof(compareCount));
+    memset(compareIds, 0, sizeof(compareIds));
+
+    UA_DateTime now = 123456789;
+    UA_UInt32 rnd = 42;
+    for(size_t step = 0; step < 10000; step++) {
+        rnd = rnd * 1103515245 + 12345;
+        UA_UInt32 r = rnd >> 1;
+        size_t i = r % N_COMPARE;
+        UA_UInt32 op = (r >> 10) % 10;
+        UA_Double interval = (UA_Double)((r >> 14) % 5000) / 7.0 + 0.01;
+        UA_TimerPolicy policy = (r & 1) ?
+            UA_TIMERPOLICY_CURRENTTIME : UA_TIMERPOLICY_BASETIME;
+        if((r >> 3) % 50 == 0)
+            policy = UA_TIMERPOLICY_ONCE;
+        UA_DateTime baseTime = now - (UA_DateTime)((r >> 5) % 100000);
+        UA_DateTime *bt = (r & 2) ? &baseTime : NULL;
+
+        for(compareImpl = 0; compareImpl < 2; compareImpl++) {
+            compareTimer = &timers[compareImpl];
+            UA_UInt64 *id = &compareIds[compareImpl][i];
+            if(op < 3) {
+                if(*id)
+                    UA_Timer_remove(compareTimer, *id);
+                UA_StatusCode res =
+                    UA_Timer_add(compareTimer, compareCallback, NULL,
+                                 (void*)(uintptr_t)i, interval, now, bt,
+                                 policy, id);
+                ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+            } else if(op == 3 && *id) {
+                UA_Timer_modify(compareTimer, *id, interval, now, bt, policy);
+            } else if(op == 4 && *id) {
+                UA_Timer_remove(compareTimer, *id);
+                *id = 0;
+            }
+        }
+        ck_assert_int_eq(UA_Timer_next(&timers[0]), UA_Timer_next(&timers[1]));
+
+        /* Sometimes jump far ahead */
+        now += (UA_DateTime)((r >> 8) % 30000);
+        if(r % 1000 == 0)
+            now += 1000 * UA_DATETIME_SEC;
+
+        UA_DateTime next[2];
+        for(compareImpl = 0; compareImpl < 2; compareImpl++) {
+            compareTimer = &timers[compareImpl];
+            next[compareImpl] = UA_Timer_process(compareTimer, now);
+        }
+        ck_assert_int_eq(next[0], next[1]);
+    }
+
+    for(size_t i = 0; i < N_COMPARE; i++)
+        ck_assert_uint_eq(compareCount[0][i], compareCount[1][i]);
+
+    UA_Timer_clear(&timers[0]);
+    UA_Timer_clear(&timers[1]);
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test Event Timer");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, benchmarkTimer);
+    tcase_add_test(tc, compareWheelZipTree);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
@@ -0,0 +1,77 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Compare the timing wheel and the ZipTree implementation of UA_Timer with a
+ * growing number of timers. */
+
+#include "../arch/common/timer.h"
+
+#include <check.h>
+#include <stdlib.h>
+#include <time.h>
+#include <stdio.h>
+
+static size_t count = 0;
+
+static void
+timerCallback(void *application, void *data) {
+    count++;
+}
+
+/* Add n timers with intervals between 10ms and 1s. Then process every
+ * millisecond for 300ms. */
+static void
+benchmarkImplementation(UA_Boolean wheel, size_t n) {
+    UA_Timer timer;
+    if(wheel)
+        UA_Timer_initWheel(&timer);
+    else
+        UA_Timer_initZipTree(&timer);
+    count = 0;
+
+    clock_t begin = clock();
+    for(size_t i = 0; i < n; i++) {
+        UA_Double interval = (UA_Double)((i % 100) + 1) * 10.0;
+        UA_StatusCode retval =
+            UA_Timer_add(&timer, timerCallback, NULL, NULL, interval, 0, NULL,
+                         UA_TIMERPOLICY_CURRENTTIME, NULL);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    clock_t added = clock();
+
+    for(UA_DateTime now = 0; now <= 300 * UA_DATETIME_MSEC; now += UA_DATETIME_MSEC)
+        UA_Timer_process(&timer, now);
+    clock_t finish = clock();
+
+    printf("%s with %lu timers: add %f s, process %f s, %lu callbacks\n",
+           (wheel) ? "Timing wheel" : "ZipTree", (unsigned long)n,
+           (double)(added - begin) / CLOCKS_PER_SEC,
+           (double)(finish - added) / CLOCKS_PER_SEC, (unsigned long)count);
+
+    UA_Timer_clear(&timer);
+}
+
+START_TEST(benchmarkWheelZipTree) {
+    const size_t sizes[3] = {1000, 100000, 1000000};
+    for(size_t i = 0; i < 3; i++) {
+        benchmarkImplementation(true, sizes[i]);
+        benchmarkImplementation(false, sizes[i]);
+    }
+} END_TEST
+
+int main(void) {
+    Suite *s  = suite_create("Test Event Timer Speed");
+    TCase *tc = tcase_create("test cases");
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, benchmarkWheelZipTree);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all (sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
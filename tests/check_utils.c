@@ -761,6 +761,78 @@ START_TEST(qualifiedNameNsIndex) {
     UA_String_clear(&str);
 } END_TEST
 
+START_TEST(arenaDecode) {
+    char longId[201];
+    memset(longId, 'a', 200);
+    longId[200] = 0;
+    UA_ReadValueId rvi[4];
+    for(size_t i = 0; i < 4; i++) {
+        UA_ReadValueId_init(&rvi[i]);
+        rvi[i].nodeId = UA_NODEID_STRING(1, longId);
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    UA_ReadRequest req;
+    UA_ReadRequest_init(&req);
+    req.nodesToRead = rvi;
+    req.nodesToReadSize = 4;
+
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    UA_StatusCode res = UA_encodeBinary(&req, &UA_TYPES[UA_TYPES_READREQUEST], &buf, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Small blocks to force the allocation of additional blocks */
+    UA_Arena arena;
+    UA_Arena_init(&arena, 512);
+
+    UA_DecodeBinaryOptions opt;
+    memset(&opt, 0, sizeof(UA_DecodeBinaryOptions));
+    opt.calloc = UA_Arena_calloc;
+    opt.callocContext = &arena;
+
+    for(size_t j = 0; j < 3; j++) {
+        UA_ReadRequest out;
+        res = UA_decodeBinary(&buf, &out, &UA_TYPES[UA_TYPES_READREQUEST], &opt);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert(UA_equal(&req, &out, &UA_TYPES[UA_TYPES_READREQUEST]));
+        ck_assert(arena.blocks != NULL);
+        ck_assert(arena.blocks->next != NULL);
+
+        /* Reset keeps only the first block */
+        UA_Arena_reset(&arena);
+        ck_assert(arena.blocks != NULL);
+        ck_assert(arena.blocks->next == NULL);
+        ck_assert_uint_eq(arena.blocks->pos, 0);
+    }
+
+    UA_Arena_clear(&arena);
+    ck_assert(arena.blocks == NULL);
+    UA_ByteString_clear(&buf);
+} END_TEST
+
+START_TEST(arenaAlignment) {
+    UA_Arena arena;
+    UA_Arena_init(&arena, 128);
+    for(size_t i = 0; i < 100; i++) {
+        UA_Byte *p = (UA_Byte*)UA_Arena_calloc(&arena, 1, i % 13);
+        ck_assert(p != NULL);
+        ck_assert_uint_eq((uintptr_t)p % 8, 0);
+        for(size_t j = 0; j < i % 13; j++)
+            ck_assert_uint_eq(p[j], 0);
+        memset(p, 0xff, i % 13);
+    }
+
+    /* Overflow is detected */
+    ck_assert(UA_Arena_calloc(&arena, SIZE_MAX / 2, 4) == NULL);
+
+    /* Oversized allocations are not retained after the reset */
+    UA_Arena_reset(&arena);
+    UA_Arena_clear(&arena);
+    ck_assert(UA_Arena_calloc(&arena, 1, 1024) != NULL);
+    UA_Arena_reset(&arena);
+    ck_assert(arena.blocks == NULL);
+    UA_Arena_clear(&arena);
+} END_TEST
+
 static Suite* testSuite_Utils(void) {
     Suite *s = suite_create("Utils");
     TCase *tc_endpointUrl_split = tcase_create("EndpointUrl_split");
@@ -808,6 +880,11 @@ static Suite* testSuite_Utils(void) {
     tcase_add_test(tc5, qualifiedNameNsIndex);
     suite_add_tcase(s, tc5);
 
+    TCase *tc6 = tcase_create("test arena allocator");
+    tcase_add_test(tc6, arenaDecode);
+    tcase_add_test(tc6, arenaAlignment);
+    suite_add_tcase(s, tc6);
+
     return s;
 }
 
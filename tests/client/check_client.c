@@ -38,6 +38,7 @@ addVariable(size_t size) {
     attr.description = UA_LOCALIZEDTEXT("en-US", name);
     attr.displayName = UA_LOCALIZEDTEXT("en-US", name);
     attr.dataType = UA_TYPES[UA_TYPES_INT32].typeId;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
 
     /* Add the variable node to the information model */
     UA_NodeId myIntegerNodeId = UA_NODEID_STRING(1, name);
@@ -196,6 +197,43 @@ START_TEST(Client_read) {
 }
 END_TEST
 
+START_TEST(Client_write_requestArena) {
+    /* Decode requests into a small arena. The write request below exceeds the
+     * block size and uses additional heap blocks. */
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->requestArenaSize = 1024;
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Int32 *array = (UA_Int32*)UA_Array_new(VARLENGTH, &UA_TYPES[UA_TYPES_INT32]);
+    for(size_t i = 0; i < VARLENGTH; i++)
+        array[i] = (UA_Int32)(VARLENGTH - i);
+    UA_Variant val;
+    UA_Variant_setArray(&val, array, VARLENGTH, &UA_TYPES[UA_TYPES_INT32]);
+    UA_NodeId nodeId = UA_NODEID_STRING(1, "my.variable");
+    retval = UA_Client_writeValueAttribute(client, nodeId, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&val);
+
+    /* Read back multiple times to reuse the arena */
+    for(size_t j = 0; j < 3; j++) {
+        retval = UA_Client_readValueAttribute(client, nodeId, &val);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert(val.type == &UA_TYPES[UA_TYPES_INT32]);
+        ck_assert_uint_eq(val.arrayLength, VARLENGTH);
+        UA_Int32 *var = (UA_Int32*)val.data;
+        for(size_t i = 0; i < VARLENGTH; i++)
+            ck_assert_int_eq(var[i], (UA_Int32)(VARLENGTH - i));
+        UA_Variant_clear(&val);
+    }
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
 START_TEST(Client_renewSecureChannel) {
     UA_Client *client = UA_Client_newForUnitTest();
     UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
@@ -462,6 +500,7 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_client, Client_endpoints);
     tcase_add_test(tc_client, Client_endpoints_empty);
     tcase_add_test(tc_client, Client_read);
+    tcase_add_test(tc_client, Client_write_requestArena);
     tcase_add_test(tc_client, Client_closes_on_server_error);
     suite_add_tcase(s,tc_client);
     TCase *tc_client_reconnect = tcase_create("Client Reconnect");
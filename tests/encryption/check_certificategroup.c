@@ -332,6 +332,73 @@ START_TEST(get_rejectedlist) {
 }
 END_TEST
 
+START_TEST(verification_cache) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_CertificateGroup *certGroup = &config->secureChannelPKI;
+    ck_assert(certGroup->getStatistics != NULL);
+
+    UA_ByteString certificate;
+    certificate.length = APPLICATION_CERT_DER_LENGTH;
+    certificate.data = APPLICATION_CERT_DER_DATA;
+
+    /* Trust the root and intermediate CA of the application certificate */
+    UA_ByteString caList[2];
+    caList[0].length = INTERMEDIATE_CERT_DER_LENGTH;
+    caList[0].data = INTERMEDIATE_CERT_DER_DATA;
+    caList[1].length = ROOT_CERT_DER_LENGTH;
+    caList[1].data = ROOT_CERT_DER_DATA;
+
+    UA_ByteString crlList[2];
+    crlList[0].length = INTERMEDIATE_EMPTY_CRL_PEM_LENGTH;
+    crlList[0].data = INTERMEDIATE_EMPTY_CRL_PEM_DATA;
+    crlList[1].length = ROOT_EMPTY_CRL_PEM_LENGTH;
+    crlList[1].data = ROOT_EMPTY_CRL_PEM_DATA;
+
+    UA_TrustListDataType trustListTmp;
+    memset(&trustListTmp, 0, sizeof(UA_TrustListDataType));
+    trustListTmp.specifiedLists = UA_TRUSTLISTMASKS_ALL;
+    trustListTmp.trustedCertificates = caList;
+    trustListTmp.trustedCertificatesSize = 2;
+    trustListTmp.issuerCertificates = caList;
+    trustListTmp.issuerCertificatesSize = 2;
+    trustListTmp.trustedCrls = crlList;
+    trustListTmp.trustedCrlsSize = 2;
+    UA_StatusCode retval = certGroup->setTrustList(certGroup, &trustListTmp);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_CertificateGroupStatistics before;
+    retval = certGroup->getStatistics(certGroup, &before);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The first verification runs the full check, the second one is cached */
+    retval = certGroup->verifyCertificate(certGroup, &certificate);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = certGroup->verifyCertificate(certGroup, &certificate);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_CertificateGroupStatistics stats;
+    retval = certGroup->getStatistics(certGroup, &stats);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(stats.cacheSize, 1);
+    ck_assert_uint_eq(stats.cacheHits, before.cacheHits + 1);
+    ck_assert_uint_eq(stats.cacheMisses, before.cacheMisses + 1);
+
+    /* Changing the trust list invalidates the cached result */
+    trustListTmp.trustedCertificates = NULL;
+    trustListTmp.trustedCertificatesSize = 0;
+    retval = certGroup->setTrustList(certGroup, &trustListTmp);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = certGroup->verifyCertificate(certGroup, &certificate);
+    ck_assert_uint_ne(retval, UA_STATUSCODE_GOOD);
+
+    retval = certGroup->getStatistics(certGroup, &stats);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(stats.cacheSize, 0);
+    ck_assert_uint_eq(stats.cacheHits, before.cacheHits + 1);
+    ck_assert_uint_eq(stats.cacheMisses, before.cacheMisses + 2);
+}
+END_TEST
+
 static Suite* testSuite_encryption(void) {
     Suite *s = suite_create("CertificateGroup");
     TCase *tc_encryption_memorystore = tcase_create("CertificateGroup Memorystore");
@@ -342,6 +409,7 @@ static Suite* testSuite_encryption(void) {
     tcase_add_test(tc_encryption_memorystore, add_to_trustlist);
     tcase_add_test(tc_encryption_memorystore, remove_from_trustlist);
     tcase_add_test(tc_encryption_memorystore, get_rejectedlist);
+    tcase_add_test(tc_encryption_memorystore, verification_cache);
 #endif /* UA_ENABLE_ENCRYPTION */
     suite_add_tcase(s,tc_encryption_memorystore);
 
@@ -354,6 +422,7 @@ static Suite* testSuite_encryption(void) {
     tcase_add_test(tc_encryption_filestore, add_to_trustlist);
     tcase_add_test(tc_encryption_filestore, remove_from_trustlist);
     tcase_add_test(tc_encryption_filestore, get_rejectedlist);
+    tcase_add_test(tc_encryption_filestore, verification_cache);
     suite_add_tcase(s,tc_encryption_filestore);
 #endif /* UA_ENABLE_ENCRYPTION */
 #endif /* defined(__linux__) || defined(UA_ARCHITECTURE_WIN32) */
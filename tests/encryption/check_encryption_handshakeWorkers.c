@@ -0,0 +1,166 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Connect with Basic256Sha256 and check that the asymmetric cryptography of
+ * OpenSecureChannel, CreateSession and ActivateSession was done by the
+ * handshake workers. */
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/plugin/certificategroup_default.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "ua_server_internal.h"
+
+#include <stdlib.h>
+
+#include "test_helpers.h"
+#include "certificates.h"
+#include "check.h"
+#include "testing_clock.h"
+#include "thread_wrapper.h"
+
+#define NUMBER_OF_WORKERS 2
+#define CONNECTS 3
+
+static UA_Server *server;
+static size_t workers;
+static volatile UA_Boolean running;
+static volatile UA_Boolean workersRunning;
+static THREAD_HANDLE serverThread;
+static THREAD_HANDLE workerThreads[NUMBER_OF_WORKERS];
+
+THREAD_CALLBACK(serverLoop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+THREAD_CALLBACK(handshakeWorkerLoop) {
+    while(workersRunning) {
+        if(!UA_Server_processHandshakeJob(server))
+            UA_realSleep(1);
+    }
+    return 0;
+}
+
+static void
+startServer(size_t w) {
+    UA_ByteString certificate;
+    certificate.length = CERT_DER_LENGTH;
+    certificate.data = CERT_DER_DATA;
+    UA_ByteString privateKey;
+    privateKey.length = KEY_DER_LENGTH;
+    privateKey.data = KEY_DER_DATA;
+
+    server = UA_Server_newForUnitTestWithSecurityPolicies(4840, &certificate, &privateKey,
+                                                          NULL, 0, NULL, 0, NULL, 0);
+    ck_assert(server != NULL);
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_CertificateGroup_AcceptAll(&config->secureChannelPKI);
+    UA_CertificateGroup_AcceptAll(&config->sessionPKI);
+    UA_String_clear(&config->applicationDescription.applicationUri);
+    config->applicationDescription.applicationUri =
+        UA_STRING_ALLOC("urn:unconfigured:application");
+    config->handshakeWorkers = (w > 0);
+
+    workers = w;
+    running = true;
+    workersRunning = true;
+    UA_Server_run_startup(server);
+    THREAD_CREATE(serverThread, serverLoop);
+    for(size_t i = 0; i < workers; i++)
+        THREAD_CREATE(workerThreads[i], handshakeWorkerLoop);
+}
+
+static void
+stopServer(void) {
+    running = false;
+    THREAD_JOIN(serverThread);
+    UA_Server_run_shutdown(server);
+    workersRunning = false;
+    for(size_t i = 0; i < workers; i++)
+        THREAD_JOIN(workerThreads[i]);
+    UA_Server_delete(server);
+}
+
+static void
+connectAndRead(void) {
+    UA_ByteString certificate;
+    certificate.length = CERT_DER_LENGTH;
+    certificate.data = CERT_DER_DATA;
+    UA_ByteString privateKey;
+    privateKey.length = KEY_DER_LENGTH;
+    privateKey.data = KEY_DER_DATA;
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    ck_assert(client != NULL);
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    UA_ClientConfig_setDefaultEncryption(cc, certificate, privateKey,
+                                         NULL, 0, NULL, 0);
+    cc->certificateVerification.clear(&cc->certificateVerification);
+    UA_CertificateGroup_AcceptAll(&cc->certificateVerification);
+    cc->securityMode = UA_MESSAGESECURITYMODE_SIGNANDENCRYPT;
+    cc->securityPolicyUri =
+        UA_STRING_ALLOC("http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256");
+
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_Variant val;
+    UA_Variant_init(&val);
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+    res = UA_Client_readValueAttribute(client, nodeId, &val);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&val);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+
+START_TEST(handshakeJobsInWorkers) {
+    startServer(NUMBER_OF_WORKERS);
+    for(size_t i = 0; i < CONNECTS; i++)
+        connectAndRead();
+
+    /* The OPN job decrypts the request and then signs the response */
+    size_t *processed = server->handshakeJobsProcessed;
+    ck_assert_uint_eq(processed[UA_HANDSHAKEJOBTYPE_OPN], 2 * CONNECTS);
+    ck_assert_uint_eq(processed[UA_HANDSHAKEJOBTYPE_CREATESESSION], CONNECTS);
+    ck_assert_uint_eq(processed[UA_HANDSHAKEJOBTYPE_ACTIVATESESSION], CONNECTS);
+    stopServer();
+} END_TEST
+
+START_TEST(handshakeWithoutWorkers) {
+    startServer(0);
+    for(size_t i = 0; i < CONNECTS; i++)
+        connectAndRead();
+
+    size_t *processed = server->handshakeJobsProcessed;
+    ck_assert_uint_eq(processed[UA_HANDSHAKEJOBTYPE_OPN], 0);
+    ck_assert_uint_eq(processed[UA_HANDSHAKEJOBTYPE_CREATESESSION], 0);
+    ck_assert_uint_eq(processed[UA_HANDSHAKEJOBTYPE_ACTIVATESESSION], 0);
+    stopServer();
+} END_TEST
+
+static Suite* testSuite_handshakeWorkers(void) {
+    Suite *s = suite_create("Encryption");
+    TCase *tc = tcase_create("Handshake Workers");
+    tcase_add_test(tc, handshakeJobsInWorkers);
+    tcase_add_test(tc, handshakeWithoutWorkers);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_handshakeWorkers();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
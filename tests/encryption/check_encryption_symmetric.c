@@ -0,0 +1,81 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "symmetric_test.h"
+
+#include <stdlib.h>
+
+static void
+roundtrip(const char *uri) {
+    SymmetricTest t;
+    setupTest(&t, uri);
+    UA_SecurityPolicyCryptoModule *cm = &t.policy.symmetricModule.cryptoModule;
+
+    UA_ByteString plain, chunk, sig;
+    ck_assert_uint_eq(UA_ByteString_allocBuffer(&plain, CHUNK_SIZE), UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < CHUNK_SIZE; i++)
+        plain.data[i] = (UA_Byte)(i % 251);
+    ck_assert_uint_eq(UA_ByteString_copy(&plain, &chunk), UA_STATUSCODE_GOOD);
+    size_t sigLen = cm->signatureAlgorithm.getLocalSignatureSize(t.sender);
+    ck_assert_uint_eq(UA_ByteString_allocBuffer(&sig, sigLen), UA_STATUSCODE_GOOD);
+
+    /* Send and receive the same chunk several times. Every message starts with
+     * the IV of the channel. */
+    for(size_t round = 0; round < 3; round++) {
+        ck_assert_uint_eq(cm->signatureAlgorithm.sign(t.sender, &chunk, &sig),
+                          UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(cm->encryptionAlgorithm.encrypt(t.sender, &chunk),
+                          UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(chunk.length, CHUNK_SIZE);
+        ck_assert(memcmp(chunk.data, plain.data, CHUNK_SIZE) != 0);
+        ck_assert_uint_eq(cm->encryptionAlgorithm.decrypt(t.receiver, &chunk),
+                          UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(chunk.length, CHUNK_SIZE);
+        ck_assert(memcmp(chunk.data, plain.data, CHUNK_SIZE) == 0);
+        ck_assert_uint_eq(cm->signatureAlgorithm.verify(t.receiver, &chunk, &sig),
+                          UA_STATUSCODE_GOOD);
+    }
+
+    /* A modified message or signature is rejected */
+    chunk.data[17] ^= 0x01;
+    ck_assert_uint_ne(cm->signatureAlgorithm.verify(t.receiver, &chunk, &sig),
+                      UA_STATUSCODE_GOOD);
+    chunk.data[17] ^= 0x01;
+    sig.data[0] ^= 0x01;
+    ck_assert_uint_ne(cm->signatureAlgorithm.verify(t.receiver, &chunk, &sig),
+                      UA_STATUSCODE_GOOD);
+
+    /* The payload must be a multiple of the block size */
+    chunk.length = CHUNK_SIZE - 1;
+    ck_assert_uint_ne(cm->encryptionAlgorithm.encrypt(t.sender, &chunk),
+                      UA_STATUSCODE_GOOD);
+    chunk.length = CHUNK_SIZE;
+
+    UA_ByteString_clear(&plain);
+    UA_ByteString_clear(&chunk);
+    UA_ByteString_clear(&sig);
+    teardownTest(&t);
+}
+
+START_TEST(symmetricRoundtrip) {
+    roundtrip(policies[_i]);
+} END_TEST
+
+static Suite *testSuite_encryption_symmetric(void) {
+    Suite *s = suite_create("Encryption Symmetric");
+    TCase *tc = tcase_create("Symmetric");
+    tcase_add_loop_test(tc, symmetricRoundtrip, 0, (int)POLICIES_SIZE);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_encryption_symmetric();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
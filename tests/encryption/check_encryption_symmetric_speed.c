@@ -0,0 +1,87 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Measures the throughput of the symmetric operations of a SecureChannel
+ * for all SecurityPolicies */
+
+#include "symmetric_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCHMARK_BYTES (64 * 1024 * 1024)
+
+static void
+benchmark(const char *uri, size_t chunkSize) {
+    SymmetricTest t;
+    setupTest(&t, uri);
+    UA_SecurityPolicyCryptoModule *cm = &t.policy.symmetricModule.cryptoModule;
+
+    UA_ByteString chunk, sig;
+    ck_assert_uint_eq(UA_ByteString_allocBuffer(&chunk, chunkSize), UA_STATUSCODE_GOOD);
+    memset(chunk.data, 0x5a, chunkSize);
+    size_t sigLen = cm->signatureAlgorithm.getLocalSignatureSize(t.sender);
+    ck_assert_uint_eq(UA_ByteString_allocBuffer(&sig, sigLen), UA_STATUSCODE_GOOD);
+
+    size_t chunks = BENCHMARK_BYTES / chunkSize;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    clock_t begin = clock();
+    for(size_t i = 0; i < chunks; i++) {
+        res |= cm->signatureAlgorithm.sign(t.sender, &chunk, &sig);
+        res |= cm->encryptionAlgorithm.encrypt(t.sender, &chunk);
+    }
+    clock_t sent = clock();
+
+    /* Decrypt the last ciphertext over and over. The signature was computed
+     * over its plaintext. */
+    UA_ByteString cipher;
+    ck_assert_uint_eq(UA_ByteString_copy(&chunk, &cipher), UA_STATUSCODE_GOOD);
+    clock_t copied = clock();
+    for(size_t i = 0; i < chunks; i++) {
+        memcpy(chunk.data, cipher.data, chunkSize);
+        res |= cm->encryptionAlgorithm.decrypt(t.receiver, &chunk);
+        res |= cm->signatureAlgorithm.verify(t.receiver, &chunk, &sig);
+    }
+    clock_t received = clock();
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ByteString_clear(&cipher);
+
+    double mb = (double)(chunkSize * chunks) / (1024.0 * 1024.0);
+    double sendTime = (double)(sent - begin) / CLOCKS_PER_SEC;
+    double recvTime = (double)(received - copied) / CLOCKS_PER_SEC;
+    printf("%s with %lu byte chunks: sign+encrypt %.1f MB/s, "
+           "decrypt+verify %.1f MB/s\n", uri, (unsigned long)chunkSize,
+           mb / sendTime, mb / recvTime);
+
+    UA_ByteString_clear(&chunk);
+    UA_ByteString_clear(&sig);
+    teardownTest(&t);
+}
+
+/* Small chunks show the per-message overhead, large chunks the raw cipher and
+ * MAC throughput */
+START_TEST(symmetricThroughput) {
+    benchmark(policies[_i], 256);
+    benchmark(policies[_i], CHUNK_SIZE);
+} END_TEST
+
+static Suite *testSuite_encryption_symmetric_speed(void) {
+    Suite *s = suite_create("Encryption Symmetric Speed");
+    TCase *tc = tcase_create("Symmetric Speed");
+    tcase_add_loop_test(tc, symmetricThroughput, 0, (int)POLICIES_SIZE);
+    tcase_set_timeout(tc, 60);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_encryption_symmetric_speed();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,114 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef SYMMETRIC_TEST_H_
+#define SYMMETRIC_TEST_H_
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/plugin/securitypolicy.h>
+#include <open62541/plugin/securitypolicy_default.h>
+
+#include "certificates.h"
+#include "check.h"
+
+/* Runs the symmetric operations of a SecureChannel directly on the
+ * SecurityPolicy. One channel context sends, the other receives with the same
+ * keys. */
+
+#define CHUNK_SIZE 8192
+
+typedef struct {
+    UA_SecurityPolicy policy;
+    void *sender;
+    void *receiver;
+} SymmetricTest;
+
+static void
+setKeys(SymmetricTest *t) {
+    UA_SecurityPolicySymmetricModule *sm = &t->policy.symmetricModule;
+    size_t encKeyLen = sm->cryptoModule.encryptionAlgorithm.getLocalKeyLength(t->sender);
+    size_t sigKeyLen = sm->cryptoModule.signatureAlgorithm.getLocalKeyLength(t->sender);
+    size_t ivLen = sm->cryptoModule.encryptionAlgorithm.getRemoteBlockSize(t->sender);
+    ck_assert(encKeyLen > 0 && sigKeyLen > 0 && ivLen > 0);
+
+    UA_ByteString encKey, sigKey, iv;
+    ck_assert_uint_eq(UA_ByteString_allocBuffer(&encKey, encKeyLen), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(UA_ByteString_allocBuffer(&sigKey, sigKeyLen), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(UA_ByteString_allocBuffer(&iv, ivLen), UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < encKeyLen; i++)
+        encKey.data[i] = (UA_Byte)(i * 7 + 1);
+    for(size_t i = 0; i < sigKeyLen; i++)
+        sigKey.data[i] = (UA_Byte)(i * 13 + 3);
+    for(size_t i = 0; i < ivLen; i++)
+        iv.data[i] = (UA_Byte)(i * 5 + 11);
+
+    UA_SecurityPolicyChannelModule *chm = &t->policy.channelModule;
+    ck_assert_uint_eq(chm->setLocalSymSigningKey(t->sender, &sigKey), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(chm->setLocalSymEncryptingKey(t->sender, &encKey), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(chm->setLocalSymIv(t->sender, &iv), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(chm->setRemoteSymSigningKey(t->receiver, &sigKey), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(chm->setRemoteSymEncryptingKey(t->receiver, &encKey), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(chm->setRemoteSymIv(t->receiver, &iv), UA_STATUSCODE_GOOD);
+
+    UA_ByteString_clear(&encKey);
+    UA_ByteString_clear(&sigKey);
+    UA_ByteString_clear(&iv);
+}
+
+static void
+setupTest(SymmetricTest *t, const char *uri) {
+    UA_ByteString certificate = {CERT_DER_LENGTH, CERT_DER_DATA};
+    UA_ByteString privateKey = {KEY_DER_LENGTH, KEY_DER_DATA};
+    const UA_Logger *logger = UA_Log_Stdout;
+    UA_StatusCode res = UA_STATUSCODE_BADINTERNALERROR;
+    memset(t, 0, sizeof(SymmetricTest));
+    if(strcmp(uri, "Basic128Rsa15") == 0) {
+        res = UA_SecurityPolicy_Basic128Rsa15(&t->policy, certificate, privateKey, logger);
+    } else if(strcmp(uri, "Basic256") == 0) {
+        res = UA_SecurityPolicy_Basic256(&t->policy, certificate, privateKey, logger);
+    } else if(strcmp(uri, "Basic256Sha256") == 0) {
+        res = UA_SecurityPolicy_Basic256Sha256(&t->policy, certificate, privateKey, logger);
+    } else if(strcmp(uri, "Aes128_Sha256_RsaOaep") == 0) {
+        res = UA_SecurityPolicy_Aes128Sha256RsaOaep(&t->policy, certificate,
+                                                    privateKey, logger);
+    } else if(strcmp(uri, "Aes256_Sha256_RsaPss") == 0) {
+        res = UA_SecurityPolicy_Aes256Sha256RsaPss(&t->policy, certificate,
+                                                   privateKey, logger);
+#ifdef UA_ENABLE_ENCRYPTION_OPENSSL
+    } else if(strcmp(uri, "ECC_nistP256") == 0) {
+        certificate.length = CERT_P256_DER_LENGTH;
+        certificate.data = CERT_P256_DER_DATA;
+        privateKey.length = KEY_P256_DER_LENGTH;
+        privateKey.data = KEY_P256_DER_DATA;
+        res = UA_SecurityPolicy_EccNistP256(&t->policy, UA_APPLICATIONTYPE_SERVER,
+                                            certificate, privateKey, logger);
+#endif
+    }
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    res = t->policy.channelModule.newContext(&t->policy, &certificate, &t->sender);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = t->policy.channelModule.newContext(&t->policy, &certificate, &t->receiver);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    setKeys(t);
+}
+
+static void
+teardownTest(SymmetricTest *t) {
+    t->policy.channelModule.deleteContext(t->sender);
+    t->policy.channelModule.deleteContext(t->receiver);
+    t->policy.clear(&t->policy);
+}
+
+static const char *policies[] = {
+    "Basic128Rsa15", "Basic256", "Basic256Sha256",
+    "Aes128_Sha256_RsaOaep", "Aes256_Sha256_RsaPss",
+#ifdef UA_ENABLE_ENCRYPTION_OPENSSL
+    "ECC_nistP256"
+#endif
+};
+
+#define POLICIES_SIZE (sizeof(policies) / sizeof(policies[0]))
+
+#endif /* SYMMETRIC_TEST_H_ */
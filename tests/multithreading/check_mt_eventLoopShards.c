@@ -0,0 +1,322 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* The TCP ConnectionManager of the server accepts connections also in two
+ * shard EventLoops. Each shard is run by its own thread. The clients are
+ * distributed between the listen sockets by the kernel (SO_REUSEPORT). */
+
+#include <open62541/server_config_default.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+#include <open62541/plugin/log_stdout.h>
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <testing_clock.h>
+
+#include "test_helpers.h"
+#include "thread_wrapper.h"
+
+#define NUMBER_OF_SHARDS 2
+#define NUMBER_OF_CLIENTS 8
+#define READS_PER_CLIENT 20
+#define NUMBER_OF_WORKERS 2
+#define SESSIONS_PER_CLIENT 3
+
+static UA_Server *server;
+static UA_EventLoop *shards[NUMBER_OF_SHARDS];
+static UA_ConnectionManager *shardCMs[NUMBER_OF_SHARDS];
+static volatile UA_Boolean running;
+static volatile UA_Boolean shardsRunning;
+static volatile UA_Boolean apiRunning;
+static volatile size_t apiCalls;
+static UA_NodeId valueId = {1, UA_NODEIDTYPE_NUMERIC, {1001}};
+
+THREAD_CALLBACK(serverLoop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+THREAD_CALLBACK_PARAM(shardLoop, param) {
+    UA_EventLoop *el = *(UA_EventLoop**)param;
+    while(shardsRunning)
+        el->run(el, 100);
+    return 0;
+}
+
+THREAD_CALLBACK(clientLoop) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < READS_PER_CLIENT; i++) {
+        UA_Variant val;
+        UA_NodeId nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+        res = UA_Client_readValueAttribute(client, nodeId, &val);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert(UA_Variant_hasScalarType(&val, &UA_TYPES[UA_TYPES_INT32]));
+        UA_Variant_clear(&val);
+    }
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    return 0;
+}
+
+THREAD_CALLBACK(serviceWorkerLoop) {
+    while(running) {
+        if(!UA_Server_processQueuedRequest(server))
+            UA_realSleep(1);
+    }
+    return 0;
+}
+
+/* The application changes the value (with the server lock) while the shards
+ * receive and send */
+THREAD_CALLBACK(apiLoop) {
+    UA_Int32 value = 0;
+    while(apiRunning) {
+        UA_Variant var;
+        UA_Variant_setScalar(&var, &value, &UA_TYPES[UA_TYPES_INT32]);
+        UA_StatusCode res = UA_Server_writeValue(server, valueId, var);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        res = UA_Server_readValue(server, valueId, &var);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        UA_Variant_clear(&var);
+        value++;
+        apiCalls++;
+    }
+    return 0;
+}
+
+static void
+dataChangeHandler(UA_Client *client, UA_UInt32 subId, void *subContext,
+                  UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    (*(size_t*)monContext)++;
+}
+
+/* Reconnect several times. Every session has a Subscription that is published
+ * from the server thread. The reads are answered by the service workers and
+ * the writes by the server thread. */
+THREAD_CALLBACK(subscribeClientLoop) {
+    for(size_t s = 0; s < SESSIONS_PER_CLIENT; s++) {
+        UA_Client *client = UA_Client_newForUnitTest();
+        UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+        UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+        request.requestedPublishingInterval = 10.0;
+        UA_CreateSubscriptionResponse response =
+            UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+        ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+
+        size_t notifications = 0;
+        UA_MonitoredItemCreateRequest monRequest =
+            UA_MonitoredItemCreateRequest_default(valueId);
+        monRequest.requestedParameters.samplingInterval = 5.0;
+        UA_MonitoredItemCreateResult monResponse =
+            UA_Client_MonitoredItems_createDataChange(client, response.subscriptionId,
+                                                      UA_TIMESTAMPSTORETURN_BOTH,
+                                                      monRequest, &notifications,
+                                                      dataChangeHandler, NULL);
+        ck_assert_uint_eq(monResponse.statusCode, UA_STATUSCODE_GOOD);
+
+        for(size_t i = 0; i < READS_PER_CLIENT; i++) {
+            UA_Variant val;
+            res = UA_Client_readValueAttribute(client, valueId, &val);
+            ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+            ck_assert(UA_Variant_hasScalarType(&val, &UA_TYPES[UA_TYPES_INT32]));
+            res = UA_Client_writeValueAttribute(client, valueId, &val);
+            ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+            UA_Variant_clear(&val);
+            UA_Client_run_iterate(client, 5);
+        }
+
+        /* Wait for the notifications of the changing value */
+        for(size_t i = 0; i < 200 && notifications == 0; i++)
+            UA_Client_run_iterate(client, 10);
+        ck_assert_uint_gt(notifications, 0);
+
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+    }
+    return 0;
+}
+
+static UA_ConnectionManager *
+getTCPConnectionManager(UA_EventLoop *el) {
+    UA_String tcpString = UA_STRING("tcp");
+    for(UA_EventSource *es = el->eventSources; es; es = es->next) {
+        if(es->eventSourceType != UA_EVENTSOURCETYPE_CONNECTIONMANAGER)
+            continue;
+        UA_ConnectionManager *cm = (UA_ConnectionManager*)es;
+        if(UA_String_equal(&tcpString, &cm->protocol))
+            return cm;
+    }
+    return NULL;
+}
+
+START_TEST(shardedConnections) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ConnectionManager *cm = getTCPConnectionManager(config->eventLoop);
+    ck_assert(cm != NULL);
+
+    /* Start the shards and add them to the TCP ConnectionManager */
+    shardsRunning = true;
+    THREAD_HANDLE shardThreads[NUMBER_OF_SHARDS];
+    for(size_t i = 0; i < NUMBER_OF_SHARDS; i++) {
+        shards[i] = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+        ck_assert(shards[i] != NULL);
+        UA_StatusCode res = shards[i]->start(shards[i]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        shardCMs[i] = UA_ConnectionManager_addShard_POSIX_TCP(cm, shards[i]);
+        ck_assert(shardCMs[i] != NULL);
+        THREAD_CREATE_PARAM(shardThreads[i], shardLoop, shards[i]);
+    }
+
+    running = true;
+    UA_Server_run_startup(server);
+    THREAD_HANDLE serverThread;
+    THREAD_CREATE(serverThread, serverLoop);
+
+    THREAD_HANDLE clientThreads[NUMBER_OF_CLIENTS];
+    for(size_t i = 0; i < NUMBER_OF_CLIENTS; i++)
+        THREAD_CREATE(clientThreads[i], clientLoop);
+    for(size_t i = 0; i < NUMBER_OF_CLIENTS; i++)
+        THREAD_JOIN(clientThreads[i]);
+
+    /* Some connections were accepted and answered by the shards */
+    size_t shardSendCalls = 0;
+    for(size_t i = 0; i < NUMBER_OF_SHARDS; i++) {
+        UA_TCPStatistics stats = UA_ConnectionManager_getStatistics_POSIX_TCP(shardCMs[i]);
+        printf("Shard %lu: %lu send calls\n", (unsigned long)i,
+               (unsigned long)stats.sendCalls);
+        shardSendCalls += stats.sendCalls;
+    }
+    ck_assert_uint_gt(shardSendCalls, 0);
+
+    /* Stop the server while the shards are still running. They close their
+     * connections and listen sockets. */
+    running = false;
+    THREAD_JOIN(serverThread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+
+    shardsRunning = false;
+    for(size_t i = 0; i < NUMBER_OF_SHARDS; i++) {
+        THREAD_JOIN(shardThreads[i]);
+        shards[i]->stop(shards[i]);
+        while(shards[i]->state != UA_EVENTLOOPSTATE_STOPPED)
+            shards[i]->run(shards[i], 100);
+        shards[i]->free(shards[i]);
+    }
+} END_TEST
+
+/* Application calls with the server lock, service workers and subscriptions
+ * running concurrently with the sharded connections. Each of them sends on the
+ * SecureChannels of the shards. This deadlocks if the lock order between the
+ * server and the shard EventLoops is not kept. */
+START_TEST(shardedConnectionsWithApiCalls) {
+    /* Publishing the Subscriptions requires the real clock */
+    server = UA_Server_new();
+    ck_assert(server != NULL);
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->tcpReuseAddr = true;
+    config->serviceWorkers = true;
+    UA_ConnectionManager *cm = getTCPConnectionManager(config->eventLoop);
+    ck_assert(cm != NULL);
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 value = 0;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Value");
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, valueId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Value"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    shardsRunning = true;
+    THREAD_HANDLE shardThreads[NUMBER_OF_SHARDS];
+    for(size_t i = 0; i < NUMBER_OF_SHARDS; i++) {
+        shards[i] = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+        ck_assert(shards[i] != NULL);
+        res = shards[i]->start(shards[i]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        shardCMs[i] = UA_ConnectionManager_addShard_POSIX_TCP(cm, shards[i]);
+        ck_assert(shardCMs[i] != NULL);
+        THREAD_CREATE_PARAM(shardThreads[i], shardLoop, shards[i]);
+    }
+
+    running = true;
+    apiRunning = true;
+    apiCalls = 0;
+    UA_Server_run_startup(server);
+    THREAD_HANDLE serverThread;
+    THREAD_CREATE(serverThread, serverLoop);
+    THREAD_HANDLE workerThreads[NUMBER_OF_WORKERS];
+    for(size_t i = 0; i < NUMBER_OF_WORKERS; i++)
+        THREAD_CREATE(workerThreads[i], serviceWorkerLoop);
+    THREAD_HANDLE apiThread;
+    THREAD_CREATE(apiThread, apiLoop);
+
+    THREAD_HANDLE clientThreads[NUMBER_OF_CLIENTS];
+    for(size_t i = 0; i < NUMBER_OF_CLIENTS; i++)
+        THREAD_CREATE(clientThreads[i], subscribeClientLoop);
+    for(size_t i = 0; i < NUMBER_OF_CLIENTS; i++)
+        THREAD_JOIN(clientThreads[i]);
+
+    apiRunning = false;
+    THREAD_JOIN(apiThread);
+    ck_assert_uint_gt(apiCalls, 0);
+
+    size_t shardSendCalls = 0;
+    for(size_t i = 0; i < NUMBER_OF_SHARDS; i++) {
+        UA_TCPStatistics stats = UA_ConnectionManager_getStatistics_POSIX_TCP(shardCMs[i]);
+        shardSendCalls += stats.sendCalls;
+    }
+    ck_assert_uint_gt(shardSendCalls, 0);
+
+    running = false;
+    for(size_t i = 0; i < NUMBER_OF_WORKERS; i++)
+        THREAD_JOIN(workerThreads[i]);
+    THREAD_JOIN(serverThread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+
+    shardsRunning = false;
+    for(size_t i = 0; i < NUMBER_OF_SHARDS; i++) {
+        THREAD_JOIN(shardThreads[i]);
+        shards[i]->stop(shards[i]);
+        while(shards[i]->state != UA_EVENTLOOPSTATE_STOPPED)
+            shards[i]->run(shards[i], 100);
+        shards[i]->free(shards[i]);
+    }
+} END_TEST
+
+static Suite* testSuite_eventLoopShards(void) {
+    Suite *s = suite_create("Multithreading");
+    TCase *tc = tcase_create("EventLoop Shards");
+    tcase_add_test(tc, shardedConnections);
+    tcase_add_test(tc, shardedConnectionsWithApiCalls);
+    tcase_set_timeout(tc, 60);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_eventLoopShards();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,324 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Requests for the read-only services are processed by the service workers.
+ * Zero workers means the service workers are disabled and every request is
+ * processed in the server thread. The throughput is measured in
+ * check_mt_serviceWorkers_speed. */
+
+#include <open62541/server_config_default.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_highlevel_async.h>
+#include <check.h>
+#include <stdlib.h>
+#include <testing_clock.h>
+
+#include "server/ua_server_internal.h"
+#include "test_helpers.h"
+#include "thread_wrapper.h"
+
+#define NUMBER_OF_CLIENTS 4
+#define READS_PER_CLIENT 50
+
+static UA_Server *server;
+static volatile UA_Boolean running;
+static volatile UA_Boolean workersRunning;
+static UA_NodeId valueId = {1, UA_NODEIDTYPE_NUMERIC, {1001}};
+static UA_NodeId writeId = {1, UA_NODEIDTYPE_NUMERIC, {1002}};
+
+static UA_StatusCode
+readValue(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+          const UA_NodeId *nodeId, void *nodeContext,
+          UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
+          UA_DataValue *dataValue) {
+    UA_Int32 value = 42;
+    UA_Variant_setScalarCopy(&dataValue->value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+THREAD_CALLBACK(serverLoop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+THREAD_CALLBACK(serviceWorkerLoop) {
+    while(workersRunning) {
+        if(!UA_Server_processQueuedRequest(server))
+            UA_realSleep(1);
+    }
+    return 0;
+}
+
+THREAD_CALLBACK(clientLoop) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < READS_PER_CLIENT; i++) {
+        UA_Variant val;
+        res = UA_Client_readValueAttribute(client, valueId, &val);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert(UA_Variant_hasScalarType(&val, &UA_TYPES[UA_TYPES_INT32]));
+        ck_assert_int_eq(42, *(UA_Int32*)val.data);
+        UA_Variant_clear(&val);
+    }
+
+    /* Browse and TranslateBrowsePaths are processed by the workers as well */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    UA_BrowseRequest bReq;
+    UA_BrowseRequest_init(&bReq);
+    bReq.nodesToBrowse = &bd;
+    bReq.nodesToBrowseSize = 1;
+    UA_BrowseResponse bResp = UA_Client_Service_browse(client, bReq);
+    ck_assert_uint_eq(bResp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bResp.resultsSize, 1);
+    UA_Boolean found = false;
+    for(size_t i = 0; i < bResp.results[0].referencesSize; i++)
+        found |= UA_NodeId_equal(&bResp.results[0].references[i].nodeId.nodeId,
+                                 &valueId);
+    ck_assert(found);
+    UA_BrowseResponse_clear(&bResp);
+
+    UA_RelativePathElement rpe;
+    UA_RelativePathElement_init(&rpe);
+    rpe.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    rpe.targetName = UA_QUALIFIEDNAME(1, "Value");
+    UA_BrowsePath bp;
+    UA_BrowsePath_init(&bp);
+    bp.startingNode = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bp.relativePath.elements = &rpe;
+    bp.relativePath.elementsSize = 1;
+    UA_TranslateBrowsePathsToNodeIdsRequest tReq;
+    UA_TranslateBrowsePathsToNodeIdsRequest_init(&tReq);
+    tReq.browsePaths = &bp;
+    tReq.browsePathsSize = 1;
+    UA_TranslateBrowsePathsToNodeIdsResponse tResp =
+        UA_Client_Service_translateBrowsePathsToNodeIds(client, tReq);
+    ck_assert_uint_eq(tResp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(tResp.resultsSize, 1);
+    ck_assert_uint_eq(tResp.results[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(tResp.results[0].targetsSize, 1);
+    ck_assert(UA_NodeId_equal(&tResp.results[0].targets[0].targetId.nodeId,
+                              &valueId));
+    UA_TranslateBrowsePathsToNodeIdsResponse_clear(&tResp);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    return 0;
+}
+
+static void
+setup(void) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Value");
+    UA_DataSource ds;
+    ds.read = readValue;
+    ds.write = NULL;
+    UA_StatusCode res =
+        UA_Server_addDataSourceVariableNode(server, valueId,
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                            UA_QUALIFIEDNAME(1, "Value"),
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                            attr, ds, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_Int32 value = 1;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Written");
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    res = UA_Server_addVariableNode(server, writeId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                    UA_QUALIFIEDNAME(1, "Written"),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                    attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void
+teardown(void) {
+    UA_Server_delete(server);
+}
+
+static void
+runClients(size_t workers) {
+    UA_Server_getConfig(server)->serviceWorkers = (workers > 0);
+
+    running = true;
+    workersRunning = true;
+    UA_Server_run_startup(server);
+    THREAD_HANDLE serverThread;
+    THREAD_CREATE(serverThread, serverLoop);
+    THREAD_HANDLE workerThreads[4];
+    for(size_t i = 0; i < workers; i++)
+        THREAD_CREATE(workerThreads[i], serviceWorkerLoop);
+
+    THREAD_HANDLE clientThreads[NUMBER_OF_CLIENTS];
+    for(size_t i = 0; i < NUMBER_OF_CLIENTS; i++)
+        THREAD_CREATE(clientThreads[i], clientLoop);
+    for(size_t i = 0; i < NUMBER_OF_CLIENTS; i++)
+        THREAD_JOIN(clientThreads[i]);
+
+    workersRunning = false;
+    for(size_t i = 0; i < workers; i++)
+        THREAD_JOIN(workerThreads[i]);
+    running = false;
+    THREAD_JOIN(serverThread);
+    UA_Server_run_shutdown(server);
+}
+
+START_TEST(processWithoutWorkers) {
+    runClients(0);
+    ck_assert_uint_eq(server->serviceJobsProcessed, 0);
+} END_TEST
+
+/* Every Read, Browse and TranslateBrowsePathsToNodeIds request was processed by
+ * a worker. The client reads the namespace array after connecting. */
+START_TEST(processWithWorkers) {
+    runClients(2);
+    ck_assert_uint_eq(server->serviceJobsProcessed,
+                      NUMBER_OF_CLIENTS * (1 + READS_PER_CLIENT + 2));
+    ck_assert_uint_eq(server->serviceJobsSize, 0);
+} END_TEST
+
+static size_t responses;
+static UA_Int32 readResult;
+
+static void
+readCallback(UA_Client *client, void *userdata, UA_UInt32 requestId,
+             UA_StatusCode status, UA_DataValue *value) {
+    ck_assert_uint_eq(status, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(responses, 0);
+    ck_assert(UA_Variant_hasScalarType(&value->value, &UA_TYPES[UA_TYPES_INT32]));
+    readResult = *(UA_Int32*)value->value.data;
+    responses++;
+}
+
+static void
+writeCallback(UA_Client *client, void *userdata,
+              UA_UInt32 requestId, UA_WriteResponse *wr) {
+    ck_assert_uint_eq(wr->responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(wr->resultsSize, 1);
+    ck_assert_uint_eq(wr->results[0], UA_STATUSCODE_GOOD);
+    responses++;
+}
+
+static UA_Int32
+readWritten(void) {
+    UA_Variant val;
+    UA_StatusCode res = UA_Server_readValue(server, writeId, &val);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Int32 result = *(UA_Int32*)val.data;
+    UA_Variant_clear(&val);
+    return result;
+}
+
+/* A Write of the same session must not overtake a queued Read. The server and
+ * the client are iterated in this thread. The queued requests are processed
+ * here instead of in worker threads. */
+START_TEST(writeAfterQueuedRead) {
+    UA_Server_getConfig(server)->serviceWorkers = true;
+    UA_Server_run_startup(server);
+
+    /* Connect. The client reads the namespace array after the session was
+     * activated. */
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode res = UA_Client_connectAsync(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_SessionState ss = UA_SESSIONSTATE_CLOSED;
+    size_t rounds = 0;
+    for(size_t i = 0; i < 1000 && rounds < 10; i++) {
+        UA_Server_run_iterate(server, false);
+        while(UA_Server_processQueuedRequest(server)) {}
+        UA_Client_run_iterate(client, 0);
+        UA_Client_getState(client, NULL, &ss, NULL);
+        if(ss == UA_SESSIONSTATE_ACTIVATED)
+            rounds++;
+        UA_realSleep(1);
+    }
+    ck_assert_int_eq(ss, UA_SESSIONSTATE_ACTIVATED);
+    ck_assert_uint_eq(server->serviceJobsSize, 0);
+    size_t processed = server->serviceJobsProcessed;
+
+    responses = 0;
+    res = UA_Client_readValueAttribute_async(client, writeId, readCallback,
+                                             NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Int32 value = 2;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+    res = UA_Client_writeValueAttribute_async(client, writeId, &v,
+                                              writeCallback, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Both requests are queued. The Write is queued behind the Read and is
+     * processed with the exclusive lock. */
+    for(size_t i = 0; i < 1000 && server->serviceJobsSize < 2; i++) {
+        UA_Server_run_iterate(server, false);
+        UA_realSleep(1);
+    }
+    ck_assert_uint_eq(server->serviceJobsSize, 2);
+    UA_ServiceJob *job = TAILQ_FIRST(&server->serviceJobs);
+    ck_assert(!job->exclusive);
+    ck_assert(TAILQ_NEXT(job, pointers)->exclusive);
+    ck_assert_int_eq(readWritten(), 1);
+
+    ck_assert(UA_Server_processQueuedRequest(server));
+    ck_assert_int_eq(readWritten(), 1);
+    ck_assert(UA_Server_processQueuedRequest(server));
+    ck_assert_int_eq(readWritten(), 2);
+    ck_assert(!UA_Server_processQueuedRequest(server));
+    ck_assert_uint_eq(server->serviceJobsProcessed, processed + 2);
+
+    /* The Read returns the value before the Write */
+    for(size_t i = 0; i < 1000 && responses < 2; i++) {
+        UA_Server_run_iterate(server, false);
+        UA_Client_run_iterate(client, 1);
+    }
+    ck_assert_uint_eq(responses, 2);
+    ck_assert_int_eq(readResult, 1);
+
+    UA_Client_disconnectAsync(client);
+    UA_SecureChannelState cs = UA_SECURECHANNELSTATE_OPEN;
+    for(size_t i = 0; i < 1000 && cs != UA_SECURECHANNELSTATE_CLOSED; i++) {
+        UA_Server_run_iterate(server, false);
+        while(UA_Server_processQueuedRequest(server)) {}
+        UA_Client_run_iterate(client, 1);
+        UA_Client_getState(client, &cs, NULL, NULL);
+    }
+    ck_assert_int_eq(cs, UA_SECURECHANNELSTATE_CLOSED);
+    UA_Client_delete(client);
+    UA_Server_run_shutdown(server);
+} END_TEST
+
+static Suite* testSuite_serviceWorkers(void) {
+    Suite *s = suite_create("Multithreading");
+    TCase *tc = tcase_create("Service Workers");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, processWithoutWorkers);
+    tcase_add_test(tc, processWithWorkers);
+    tcase_add_test(tc, writeAfterQueuedRead);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_serviceWorkers();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
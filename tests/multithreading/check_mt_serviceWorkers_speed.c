@@ -0,0 +1,148 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* Measure the read throughput with a growing number of service workers. The
+ * value is provided by a DataSource that simulates an expensive computation.
+ * Zero workers means the service workers are disabled and every request is
+ * processed in the server thread. */
+
+#include <open62541/server_config_default.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <testing_clock.h>
+
+#include "test_helpers.h"
+#include "thread_wrapper.h"
+
+#define NUMBER_OF_CLIENTS 4
+#define READS_PER_CLIENT 50
+#define DATASOURCE_LOOPS 200000
+
+static UA_Server *server;
+static volatile UA_Boolean running;
+static volatile UA_Boolean workersRunning;
+static UA_NodeId valueId = {1, UA_NODEIDTYPE_NUMERIC, {1001}};
+
+static UA_StatusCode
+readExpensive(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+              const UA_NodeId *nodeId, void *nodeContext,
+              UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
+              UA_DataValue *dataValue) {
+    volatile UA_UInt32 acc = 0;
+    for(UA_UInt32 i = 0; i < DATASOURCE_LOOPS; i++)
+        acc += i;
+    UA_Int32 value = 42;
+    UA_Variant_setScalarCopy(&dataValue->value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+THREAD_CALLBACK(serverLoop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+THREAD_CALLBACK(serviceWorkerLoop) {
+    while(workersRunning) {
+        if(!UA_Server_processQueuedRequest(server))
+            UA_realSleep(1);
+    }
+    return 0;
+}
+
+THREAD_CALLBACK(clientLoop) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < READS_PER_CLIENT; i++) {
+        UA_Variant val;
+        res = UA_Client_readValueAttribute(client, valueId, &val);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        UA_Variant_clear(&val);
+    }
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    return 0;
+}
+
+static void
+runReads(size_t workers) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->serviceWorkers = (workers > 0);
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Expensive");
+    UA_DataSource ds;
+    ds.read = readExpensive;
+    ds.write = NULL;
+    UA_StatusCode res =
+        UA_Server_addDataSourceVariableNode(server, valueId,
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                            UA_QUALIFIEDNAME(1, "Expensive"),
+                                            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                            attr, ds, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    running = true;
+    workersRunning = true;
+    UA_Server_run_startup(server);
+    THREAD_HANDLE serverThread;
+    THREAD_CREATE(serverThread, serverLoop);
+    THREAD_HANDLE workerThreads[4];
+    for(size_t i = 0; i < workers; i++)
+        THREAD_CREATE(workerThreads[i], serviceWorkerLoop);
+
+    UA_DateTime begin = UA_DateTime_nowMonotonic();
+    THREAD_HANDLE clientThreads[NUMBER_OF_CLIENTS];
+    for(size_t i = 0; i < NUMBER_OF_CLIENTS; i++)
+        THREAD_CREATE(clientThreads[i], clientLoop);
+    for(size_t i = 0; i < NUMBER_OF_CLIENTS; i++)
+        THREAD_JOIN(clientThreads[i]);
+    UA_DateTime finish = UA_DateTime_nowMonotonic();
+
+    double duration = (double)(finish - begin) / UA_DATETIME_SEC;
+    printf("%lu service workers: %.0f reads/sec\n", (unsigned long)workers,
+           (double)(NUMBER_OF_CLIENTS * READS_PER_CLIENT) / duration);
+
+    workersRunning = false;
+    for(size_t i = 0; i < workers; i++)
+        THREAD_JOIN(workerThreads[i]);
+    running = false;
+    THREAD_JOIN(serverThread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+START_TEST(readThroughput) {
+    runReads(0);
+    runReads(1);
+    runReads(2);
+    runReads(4);
+} END_TEST
+
+static Suite* testSuite_serviceWorkersSpeed(void) {
+    Suite *s = suite_create("Multithreading");
+    TCase *tc = tcase_create("Service Workers Speed");
+    tcase_add_test(tc, readThroughput);
+    tcase_set_timeout(tc, 120);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_serviceWorkersSpeed();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
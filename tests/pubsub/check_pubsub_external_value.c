@@ -0,0 +1,272 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "pubsub_test.h"
+
+#include <stdlib.h>
+
+#include "ua_pubsub_internal.h"
+#include "ua_server_internal.h"
+
+#define MULTICAST_URL "opc.udp://224.0.0.22:4802/"
+
+/* Application-owned values. The published value is double-buffered. */
+UA_Int32 pubData[2];
+UA_DataValue pubBuffers[2];
+UA_DataValue *pubValue;
+UA_Int32 subData;
+UA_DataValue subBuffer;
+UA_DataValue *subValue;
+
+static void setup(void) {
+    setupPubSubTest(MULTICAST_URL);
+
+    /* Point the DataValues to the raw application memory */
+    memset(pubData, 0, sizeof(pubData));
+    subData = 0;
+    for(size_t i = 0; i < 2; i++) {
+        UA_DataValue_init(&pubBuffers[i]);
+        UA_Variant_setScalar(&pubBuffers[i].value, &pubData[i],
+                             &UA_TYPES[UA_TYPES_INT32]);
+        pubBuffers[i].value.storageType = UA_VARIANT_DATA_NODELETE;
+        pubBuffers[i].hasValue = true;
+    }
+    pubValue = &pubBuffers[0];
+    UA_DataValue_init(&subBuffer);
+    UA_Variant_setScalar(&subBuffer.value, &subData, &UA_TYPES[UA_TYPES_INT32]);
+    subBuffer.value.storageType = UA_VARIANT_DATA_NODELETE;
+    subBuffer.hasValue = true;
+    subValue = &subBuffer;
+}
+
+static void teardown(void) {
+    teardownPubSubTest();
+}
+
+static void
+addVariable(UA_UInt32 id, const UA_DataType *type, UA_DataValue **value) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Variable");
+    attr.dataType = type->typeId;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_StatusCode retVal =
+        UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, id),
+                                  UA_NS0ID(OBJECTSFOLDER), UA_NS0ID(ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Variable"),
+                                  UA_NS0ID(BASEDATAVARIABLETYPE), attr, NULL, NULL);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    if(!value)
+        return;
+    UA_ValueBackend backend;
+    memset(&backend, 0, sizeof(UA_ValueBackend));
+    backend.backendType = UA_VALUEBACKENDTYPE_EXTERNAL;
+    backend.backend.external.value = value;
+    retVal = UA_Server_setVariableNode_valueBackend(server, UA_NODEID_NUMERIC(1, id),
+                                                    backend);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+}
+
+static void
+addPublisher(UA_DataSetFieldContentMask fieldContentMask) {
+    UA_WriterGroupConfig wgConfig;
+    UA_UadpWriterGroupMessageDataType wgMessage;
+    initTestWriterGroupConfig(&wgConfig, &wgMessage);
+    UA_DataSetWriterConfig dswConfig;
+    initTestDataSetWriterConfig(&dswConfig);
+    dswConfig.dataSetFieldContentMask = fieldContentMask;
+    addTestPublisher(&wgConfig, &dswConfig, 1);
+}
+
+static void
+addSubscriber(void) {
+    addTestSubscriber(NULL, &UA_TYPES[UA_TYPES_INT32]);
+}
+
+/* Wait until the subscribed application memory has the expected value */
+static void
+waitForValue(UA_Int32 expected) {
+    for(size_t i = 0; i < 100; i++) {
+        UA_fakeSleep(PUBLISH_INTERVAL + 1);
+        UA_Server_run_iterate(server, false);
+        if(subData == expected)
+            return;
+    }
+    ck_assert_msg(false, "The published value was not received");
+}
+
+static void
+checkBound(void) {
+    UA_PubSubManager *psm = getPSM(server);
+    UA_PublishedDataSet *pds = TAILQ_FIRST(&psm->publishedDataSets);
+    ck_assert(pds != NULL);
+    UA_DataSetField *dsf = TAILQ_FIRST(&pds->fields);
+    ck_assert(dsf != NULL);
+    ck_assert_ptr_eq(dsf->externalValue.value, &pubValue);
+
+    UA_PubSubConnection *c = TAILQ_FIRST(&psm->connections);
+    UA_ReaderGroup *rg = LIST_FIRST(&c->readerGroups);
+    UA_DataSetReader *dsr = LIST_FIRST(&rg->readers);
+    ck_assert(dsr->externalValues != NULL);
+    ck_assert_ptr_eq(dsr->externalValues[0].value, &subValue);
+}
+
+static void
+runExternalValues(UA_DataSetFieldContentMask fieldContentMask) {
+    addVariable(PUBLISHVARIABLE_NODEID, &UA_TYPES[UA_TYPES_INT32], &pubValue);
+    addVariable(SUBSCRIBEVARIABLE_NODEID, &UA_TYPES[UA_TYPES_INT32], &subValue);
+    addPublisher(fieldContentMask);
+    addSubscriber();
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+    checkBound();
+
+    /* Write to the application memory directly */
+    for(UA_Int32 i = 1; i < 5; i++) {
+        pubData[0] = i;
+        waitForValue(i);
+    }
+
+    /* Switch to the second buffer */
+    pubData[1] = 100;
+    pubValue = &pubBuffers[1];
+    waitForValue(100);
+
+    /* The subscribed value was written in-place and is visible for Read */
+    ck_assert_ptr_eq(subValue, &subBuffer);
+    ck_assert_ptr_eq(subBuffer.value.data, &subData);
+    UA_Variant received;
+    UA_StatusCode retVal =
+        UA_Server_readValue(server, UA_NODEID_NUMERIC(1, SUBSCRIBEVARIABLE_NODEID),
+                            &received);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert(received.type == &UA_TYPES[UA_TYPES_INT32]);
+    ck_assert_int_eq(*(UA_Int32*)received.data, 100);
+    UA_Variant_clear(&received);
+}
+
+START_TEST(ExternalValueVariant) {
+    runExternalValues(UA_DATASETFIELDCONTENTMASK_NONE);
+} END_TEST
+
+START_TEST(ExternalValueDataValue) {
+    for(size_t i = 0; i < 2; i++) {
+        pubBuffers[i].hasSourceTimestamp = true;
+        pubBuffers[i].sourceTimestamp = UA_DATETIME_UNIX_EPOCH;
+    }
+    runExternalValues((UA_DataSetFieldContentMask)
+                      (UA_DATASETFIELDCONTENTMASK_STATUSCODE |
+                       UA_DATASETFIELDCONTENTMASK_SOURCETIMESTAMP));
+
+    /* The subscribed variable is dynamic and keeps the source timestamp */
+    ck_assert(subBuffer.hasSourceTimestamp);
+    ck_assert_int_eq(subBuffer.sourceTimestamp, UA_DATETIME_UNIX_EPOCH);
+} END_TEST
+
+START_TEST(ExternalValueRaw) {
+    runExternalValues(UA_DATASETFIELDCONTENTMASK_RAWDATA);
+} END_TEST
+
+/* Variables without an external value backend use the Read/Write service */
+START_TEST(ExternalValueNotBound) {
+    addVariable(PUBLISHVARIABLE_NODEID, &UA_TYPES[UA_TYPES_INT32], NULL);
+    addVariable(SUBSCRIBEVARIABLE_NODEID, &UA_TYPES[UA_TYPES_INT32], &subValue);
+    addPublisher(UA_DATASETFIELDCONTENTMASK_NONE);
+    addSubscriber();
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+
+    UA_PubSubManager *psm = getPSM(server);
+    UA_DataSetField *dsf = TAILQ_FIRST(&TAILQ_FIRST(&psm->publishedDataSets)->fields);
+    ck_assert(dsf->externalValue.value == NULL);
+
+    UA_Int32 value = 7;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+    UA_StatusCode retVal =
+        UA_Server_writeValue(server, UA_NODEID_NUMERIC(1, PUBLISHVARIABLE_NODEID), v);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    waitForValue(7);
+
+    /* Unbound after disabling */
+    UA_Server_disableAllPubSubComponents(server);
+    ck_assert(dsf->externalValue.value == NULL);
+    UA_PubSubConnection *c = TAILQ_FIRST(&psm->connections);
+    UA_DataSetReader *dsr = LIST_FIRST(&LIST_FIRST(&c->readerGroups)->readers);
+    ck_assert(dsr->externalValues == NULL);
+} END_TEST
+
+/* As with the Write-Service, the source timestamp is not kept for a variable
+ * that is not dynamic */
+START_TEST(ExternalValueNotDynamic) {
+    pubBuffers[0].hasSourceTimestamp = true;
+    pubBuffers[0].sourceTimestamp = UA_DATETIME_UNIX_EPOCH;
+    addVariable(PUBLISHVARIABLE_NODEID, &UA_TYPES[UA_TYPES_INT32], &pubValue);
+    addVariable(SUBSCRIBEVARIABLE_NODEID, &UA_TYPES[UA_TYPES_INT32], &subValue);
+    UA_StatusCode retVal =
+        UA_Server_setVariableNodeDynamic(server,
+                                         UA_NODEID_NUMERIC(1, SUBSCRIBEVARIABLE_NODEID),
+                                         false);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    addPublisher((UA_DataSetFieldContentMask)
+                 (UA_DATASETFIELDCONTENTMASK_STATUSCODE |
+                  UA_DATASETFIELDCONTENTMASK_SOURCETIMESTAMP));
+    addSubscriber();
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+    checkBound();
+
+    pubData[0] = 3;
+    waitForValue(3);
+    ck_assert(!subBuffer.hasSourceTimestamp);
+} END_TEST
+
+/* The received field does not match the DataType of the target node. The
+ * value is not bound and the Write-Service rejects it. The value of the
+ * application keeps its type. */
+START_TEST(ExternalValueTypeMismatch) {
+    UA_Double d = 1.5;
+    UA_DataValue_init(&subBuffer);
+    UA_Variant_setScalarCopy(&subBuffer.value, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+    subBuffer.hasValue = true;
+    addVariable(PUBLISHVARIABLE_NODEID, &UA_TYPES[UA_TYPES_INT32], &pubValue);
+    addVariable(SUBSCRIBEVARIABLE_NODEID, &UA_TYPES[UA_TYPES_DOUBLE], &subValue);
+    addPublisher(UA_DATASETFIELDCONTENTMASK_NONE);
+    addSubscriber();
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+
+    UA_PubSubManager *psm = getPSM(server);
+    UA_PubSubConnection *c = TAILQ_FIRST(&psm->connections);
+    UA_DataSetReader *dsr = LIST_FIRST(&LIST_FIRST(&c->readerGroups)->readers);
+    ck_assert(dsr->externalValues != NULL);
+    ck_assert(dsr->externalValues[0].value == NULL);
+
+    pubData[0] = 5;
+    for(size_t i = 0; i < 20; i++) {
+        UA_fakeSleep(PUBLISH_INTERVAL + 1);
+        UA_Server_run_iterate(server, false);
+    }
+    ck_assert_ptr_eq(subValue, &subBuffer);
+    ck_assert(subBuffer.value.type == &UA_TYPES[UA_TYPES_DOUBLE]);
+    ck_assert(*(UA_Double*)subBuffer.value.data == 1.5);
+    UA_DataValue_clear(&subBuffer);
+} END_TEST
+
+int main(void) {
+    TCase *tc_external = tcase_create("PubSub External Values");
+    tcase_add_checked_fixture(tc_external, setup, teardown);
+    tcase_add_test(tc_external, ExternalValueVariant);
+    tcase_add_test(tc_external, ExternalValueDataValue);
+    tcase_add_test(tc_external, ExternalValueRaw);
+    tcase_add_test(tc_external, ExternalValueNotBound);
+    tcase_add_test(tc_external, ExternalValueNotDynamic);
+    tcase_add_test(tc_external, ExternalValueTypeMismatch);
+
+    Suite *s = suite_create("PubSub External Values");
+    suite_add_tcase(s, tc_external);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr,CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,328 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "pubsub_test.h"
+
+#include <open62541/plugin/securitypolicy_default.h>
+#include <stdlib.h>
+
+#include "ua_pubsub_internal.h"
+#include "ua_server_internal.h"
+
+#define MULTICAST_URL "opc.udp://224.0.0.22:4801/"
+
+#define UA_AES128CTR_SIGNING_KEY_LENGTH 32
+#define UA_AES128CTR_KEY_LENGTH 16
+#define UA_AES128CTR_KEYNONCE_LENGTH 4
+
+/* Keys of the secured WriterGroup and ReaderGroup */
+UA_Byte signingKeyData[UA_AES128CTR_SIGNING_KEY_LENGTH] = {1, 2, 3};
+UA_Byte encryptingKeyData[UA_AES128CTR_KEY_LENGTH] = {4, 5, 6};
+UA_Byte keyNonceData[UA_AES128CTR_KEYNONCE_LENGTH] = {7, 8, 9};
+UA_ByteString signingKey = {UA_AES128CTR_SIGNING_KEY_LENGTH, signingKeyData};
+UA_ByteString encryptingKey = {UA_AES128CTR_KEY_LENGTH, encryptingKeyData};
+UA_ByteString keyNonce = {UA_AES128CTR_KEYNONCE_LENGTH, keyNonceData};
+
+static void setup(void) {
+    setupPubSubTest(MULTICAST_URL);
+}
+
+static void teardown(void) {
+    teardownPubSubTest();
+}
+
+/* Publish the variable with a frozen NetworkMessage */
+static void
+addPublisher(UA_DataSetFieldContentMask fieldContentMask,
+             UA_UInt16 maxDataSetMessages, size_t writers,
+             UA_MessageSecurityMode securityMode) {
+    UA_WriterGroupConfig wgConfig;
+    UA_UadpWriterGroupMessageDataType wgMessage;
+    initTestWriterGroupConfig(&wgConfig, &wgMessage);
+    wgConfig.maxEncapsulatedDataSetMessageCount = maxDataSetMessages;
+    wgConfig.frozenNetworkMessage = true;
+    wgConfig.securityMode = securityMode;
+    if(securityMode > UA_MESSAGESECURITYMODE_NONE)
+        wgConfig.securityPolicy = UA_Server_getConfig(server)->pubSubConfig.securityPolicies;
+
+    UA_DataSetWriterConfig dswConfig;
+    initTestDataSetWriterConfig(&dswConfig);
+    dswConfig.dataSetFieldContentMask = fieldContentMask;
+    UA_UadpDataSetWriterMessageDataType dswMessage;
+    UA_UadpDataSetWriterMessageDataType_init(&dswMessage);
+    dswMessage.dataSetMessageContentMask = (UA_UadpDataSetMessageContentMask)
+        (UA_UADPDATASETMESSAGECONTENTMASK_SEQUENCENUMBER |
+         UA_UADPDATASETMESSAGECONTENTMASK_TIMESTAMP);
+    UA_ExtensionObject_setValue(&dswConfig.messageSettings, &dswMessage,
+                                &UA_TYPES[UA_TYPES_UADPDATASETWRITERMESSAGEDATATYPE]);
+
+    addTestPublisher(&wgConfig, &dswConfig, writers);
+    if(securityMode > UA_MESSAGESECURITYMODE_NONE) {
+        UA_StatusCode retVal =
+            UA_Server_setWriterGroupEncryptionKeys(server, writerGroupId, 1,
+                                                   signingKey, encryptingKey,
+                                                   keyNonce);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    }
+}
+
+static void
+addSubscriber(const UA_DataType *type, UA_MessageSecurityMode securityMode) {
+    UA_ReaderGroupConfig rgConfig;
+    memset(&rgConfig, 0, sizeof(UA_ReaderGroupConfig));
+    rgConfig.name = UA_STRING("ReaderGroup Test");
+    rgConfig.securityMode = securityMode;
+    if(securityMode > UA_MESSAGESECURITYMODE_NONE)
+        rgConfig.securityPolicy = UA_Server_getConfig(server)->pubSubConfig.securityPolicies;
+    addTestSubscriber(&rgConfig, type);
+    if(securityMode > UA_MESSAGESECURITYMODE_NONE) {
+        UA_StatusCode retVal =
+            UA_Server_setReaderGroupEncryptionKeys(server, readerGroupId, 1,
+                                                   signingKey, encryptingKey,
+                                                   keyNonce);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    }
+}
+
+static UA_WriterGroup *
+getWriterGroup(void) {
+    UA_WriterGroup *wg = UA_WriterGroup_find(getPSM(server), writerGroupId);
+    ck_assert(wg != NULL);
+    return wg;
+}
+
+/* Record the sequence numbers of the sent NetworkMessages */
+#define MAX_SENT 64
+static UA_StatusCode
+(*udpSend)(UA_ConnectionManager *cm, uintptr_t connectionId,
+           const UA_KeyValueMap *params, UA_ByteString *buf);
+static UA_UInt16 sentSequenceNumbers[MAX_SENT];
+static size_t sentSize;
+
+static UA_StatusCode
+recordingSend(UA_ConnectionManager *cm, uintptr_t connectionId,
+              const UA_KeyValueMap *params, UA_ByteString *buf) {
+    UA_NetworkMessage nm;
+    if(sentSize < MAX_SENT &&
+       UA_NetworkMessage_decodeBinary(buf, &nm, NULL) == UA_STATUSCODE_GOOD) {
+        sentSequenceNumbers[sentSize++] = nm.groupHeader.sequenceNumber;
+        UA_NetworkMessage_clear(&nm);
+    }
+    return udpSend(cm, connectionId, params, buf);
+}
+
+static UA_ConnectionManager *
+recordSentMessages(void) {
+    UA_PubSubConnection *c = UA_PubSubConnection_find(getPSM(server), connectionId);
+    ck_assert(c != NULL && c->cm != NULL);
+    udpSend = c->cm->sendWithConnection;
+    c->cm->sendWithConnection = recordingSend;
+    sentSize = 0;
+    return c->cm;
+}
+
+/* Write the published variable and wait until the subscriber has received the
+ * value */
+static void
+publishAndCheck(const UA_Variant *value) {
+    UA_StatusCode retVal =
+        UA_Server_writeValue(server, UA_NODEID_NUMERIC(1, PUBLISHVARIABLE_NODEID),
+                             *value);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    for(size_t i = 0; i < 100; i++) {
+        UA_fakeSleep(PUBLISH_INTERVAL + 1);
+        UA_Server_run_iterate(server, false);
+
+        UA_Variant received;
+        retVal = UA_Server_readValue(server, UA_NODEID_NUMERIC(1, SUBSCRIBEVARIABLE_NODEID),
+                                     &received);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        UA_Boolean eq = (received.type == value->type &&
+                         UA_order(received.data, value->data, value->type) == UA_ORDER_EQ);
+        UA_Variant_clear(&received);
+        if(eq)
+            return;
+    }
+    ck_assert_msg(false, "The published value was not received");
+}
+
+START_TEST(FrozenPublishVariant) {
+    UA_Int32 value = 42;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+    addTestVariables(&v);
+    addPublisher(UA_DATASETFIELDCONTENTMASK_NONE, 0, 1, UA_MESSAGESECURITYMODE_NONE);
+    addSubscriber(&UA_TYPES[UA_TYPES_INT32], UA_MESSAGESECURITYMODE_NONE);
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+
+    /* Frozen once the writer is operational */
+    publishAndCheck(&v);
+    UA_WriterGroup *wg = getWriterGroup();
+    ck_assert_uint_ne(wg->frozen.message.length, 0);
+    UA_ByteString frozen = wg->frozen.message;
+
+    UA_ConnectionManager *cm = recordSentMessages();
+    for(value = 0; value < 5; value++)
+        publishAndCheck(&v);
+    cm->sendWithConnection = udpSend;
+
+    /* The layout did not change */
+    ck_assert(wg->frozen.message.data == frozen.data);
+    ck_assert(!wg->frozen.failed);
+
+    /* The sequence number advances with every NetworkMessage */
+    ck_assert_uint_ge(sentSize, 5);
+    for(size_t i = 1; i < sentSize; i++)
+        ck_assert_uint_eq(sentSequenceNumbers[i],
+                          (UA_UInt16)(sentSequenceNumbers[i-1] + 1));
+} END_TEST
+
+START_TEST(FrozenPublishDataValue) {
+    UA_Double value = 1.5;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+    addTestVariables(&v);
+    addPublisher(UA_DATASETFIELDCONTENTMASK_STATUSCODE, 0, 1,
+                 UA_MESSAGESECURITYMODE_NONE);
+    addSubscriber(&UA_TYPES[UA_TYPES_DOUBLE], UA_MESSAGESECURITYMODE_NONE);
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+
+    publishAndCheck(&v);
+    UA_WriterGroup *wg = getWriterGroup();
+    ck_assert_uint_ne(wg->frozen.message.length, 0);
+    for(; value < 6.0; value += 1.0)
+        publishAndCheck(&v);
+} END_TEST
+
+START_TEST(FrozenPublishRaw) {
+    UA_UInt32 value = 42;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_UINT32]);
+    addTestVariables(&v);
+    addPublisher(UA_DATASETFIELDCONTENTMASK_RAWDATA, 0, 1, UA_MESSAGESECURITYMODE_NONE);
+    addSubscriber(&UA_TYPES[UA_TYPES_UINT32], UA_MESSAGESECURITYMODE_NONE);
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+
+    publishAndCheck(&v);
+    UA_WriterGroup *wg = getWriterGroup();
+    ck_assert_uint_ne(wg->frozen.message.length, 0);
+    for(value = 1000; value < 1005; value++)
+        publishAndCheck(&v);
+} END_TEST
+
+START_TEST(FrozenPublishLayoutChange) {
+    UA_String value = UA_STRING("short");
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_STRING]);
+    addTestVariables(&v);
+    addPublisher(UA_DATASETFIELDCONTENTMASK_NONE, 0, 1, UA_MESSAGESECURITYMODE_NONE);
+    addSubscriber(&UA_TYPES[UA_TYPES_STRING], UA_MESSAGESECURITYMODE_NONE);
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+
+    publishAndCheck(&v);
+    UA_WriterGroup *wg = getWriterGroup();
+    size_t frozenLength = wg->frozen.message.length;
+    ck_assert_uint_ne(frozenLength, 0);
+
+    /* The longer string does not fit into the frozen layout. It is published
+     * with the regular path and the layout is frozen again. */
+    value = UA_STRING("a much longer string");
+    publishAndCheck(&v);
+    UA_fakeSleep(PUBLISH_INTERVAL + 1);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(wg->frozen.message.length, frozenLength + 15);
+    ck_assert(!wg->frozen.failed);
+} END_TEST
+
+START_TEST(FrozenPublishNotSupported) {
+    UA_Int32 value = 42;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+    addTestVariables(&v);
+
+    /* Two writers that don't fit into one NetworkMessage */
+    addPublisher(UA_DATASETFIELDCONTENTMASK_NONE, 1, 2, UA_MESSAGESECURITYMODE_NONE);
+    addSubscriber(&UA_TYPES[UA_TYPES_INT32], UA_MESSAGESECURITYMODE_NONE);
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+
+    /* The regular publish path is used */
+    for(value = 0; value < 3; value++)
+        publishAndCheck(&v);
+    UA_WriterGroup *wg = getWriterGroup();
+    ck_assert_uint_eq(wg->frozen.message.length, 0);
+    ck_assert(wg->frozen.failed);
+} END_TEST
+
+/* The PubSub SecurityPolicies are only implemented with mbedTLS. The secured
+ * cases are not built with other encryption backends. */
+#ifdef UA_ENABLE_ENCRYPTION_MBEDTLS
+
+/* The filled copy of the frozen NetworkMessage is signed (and encrypted) for
+ * every publish. The reader verifies (and decrypts) it. */
+static void
+frozenPublishSecured(UA_MessageSecurityMode securityMode) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->pubSubConfig.securityPolicies = (UA_PubSubSecurityPolicy*)
+        UA_malloc(sizeof(UA_PubSubSecurityPolicy));
+    ck_assert(config->pubSubConfig.securityPolicies != NULL);
+    config->pubSubConfig.securityPoliciesSize = 1;
+    UA_StatusCode retVal =
+        UA_PubSubSecurityPolicy_Aes128Ctr(config->pubSubConfig.securityPolicies,
+                                          config->logging);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_Int32 value = 42;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+    addTestVariables(&v);
+    addPublisher(UA_DATASETFIELDCONTENTMASK_NONE, 0, 1, securityMode);
+    addSubscriber(&UA_TYPES[UA_TYPES_INT32], securityMode);
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+
+    publishAndCheck(&v);
+    UA_WriterGroup *wg = getWriterGroup();
+    ck_assert_uint_ne(wg->frozen.message.length, 0);
+    UA_ByteString frozen = wg->frozen.message;
+
+    for(value = 0; value < 5; value++)
+        publishAndCheck(&v);
+
+    ck_assert(wg->frozen.message.data == frozen.data);
+    ck_assert(!wg->frozen.failed);
+}
+
+START_TEST(FrozenPublishSign) {
+    frozenPublishSecured(UA_MESSAGESECURITYMODE_SIGN);
+} END_TEST
+
+START_TEST(FrozenPublishSignAndEncrypt) {
+    frozenPublishSecured(UA_MESSAGESECURITYMODE_SIGNANDENCRYPT);
+} END_TEST
+
+#endif /* UA_ENABLE_ENCRYPTION_MBEDTLS */
+
+int main(void) {
+    TCase *tc_frozen = tcase_create("PubSub Frozen NetworkMessage");
+    tcase_add_checked_fixture(tc_frozen, setup, teardown);
+    tcase_add_test(tc_frozen, FrozenPublishVariant);
+    tcase_add_test(tc_frozen, FrozenPublishDataValue);
+    tcase_add_test(tc_frozen, FrozenPublishRaw);
+    tcase_add_test(tc_frozen, FrozenPublishLayoutChange);
+    tcase_add_test(tc_frozen, FrozenPublishNotSupported);
+#ifdef UA_ENABLE_ENCRYPTION_MBEDTLS
+    tcase_add_test(tc_frozen, FrozenPublishSign);
+    tcase_add_test(tc_frozen, FrozenPublishSignAndEncrypt);
+#endif
+
+    Suite *s = suite_create("PubSub Frozen NetworkMessage");
+    suite_add_tcase(s, tc_frozen);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr,CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,316 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "pubsub_test.h"
+
+#include <stdlib.h>
+
+#include "thread_wrapper.h"
+#include "ua_pubsub_internal.h"
+#include "ua_server_internal.h"
+
+#define MULTICAST_URL    "opc.udp://224.0.0.22:4804/"
+#define PUBLISHER_THREAD 1
+
+static volatile UA_Boolean running;
+
+static UA_DateTime
+realNow(UA_EventLoop *el) {
+    return UA_DateTime_now();
+}
+
+static UA_DateTime
+realNowMonotonic(UA_EventLoop *el) {
+    return UA_DateTime_nowMonotonic();
+}
+
+static void
+setupServer(UA_Boolean realClock) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+
+    /* The publisher thread reads the clock concurrently. The fake clock is
+     * only advanced in single-threaded tests. */
+    if(realClock) {
+        UA_EventLoop *el = UA_Server_getConfig(server)->eventLoop;
+        el->dateTime_now = realNow;
+        el->dateTime_nowMonotonic = realNowMonotonic;
+    }
+    UA_Server_run_startup(server);
+    addTestConnection(MULTICAST_URL);
+
+    UA_Int32 value = 0;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+    addTestVariables(&v);
+}
+
+static void setup(void) {
+    setupServer(false);
+}
+
+static void setupRealClock(void) {
+    setupServer(true);
+}
+
+static void teardown(void) {
+    teardownPubSubTest();
+}
+
+/* Publish the variable from the publisher thread */
+static void
+addPublisher(UA_Boolean frozen) {
+    UA_WriterGroupConfig wgConfig;
+    UA_UadpWriterGroupMessageDataType wgMessage;
+    initTestWriterGroupConfig(&wgConfig, &wgMessage);
+    wgConfig.frozenNetworkMessage = frozen;
+    wgConfig.publisherThread = PUBLISHER_THREAD;
+    UA_DataSetWriterConfig dswConfig;
+    initTestDataSetWriterConfig(&dswConfig);
+    addTestPublisher(&wgConfig, &dswConfig, 1);
+}
+
+static void
+addSubscriber(void) {
+    addTestSubscriber(NULL, &UA_TYPES[UA_TYPES_INT32]);
+}
+
+static UA_Boolean
+received(UA_Int32 value) {
+    UA_Variant v;
+    UA_StatusCode retVal =
+        UA_Server_readValue(server, UA_NODEID_NUMERIC(1, SUBSCRIBEVARIABLE_NODEID), &v);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    UA_Boolean eq = (v.type == &UA_TYPES[UA_TYPES_INT32] &&
+                     *(UA_Int32*)v.data == value);
+    UA_Variant_clear(&v);
+    return eq;
+}
+
+static void
+writeValue(UA_Int32 value) {
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+    UA_StatusCode retVal =
+        UA_Server_writeValue(server, UA_NODEID_NUMERIC(1, PUBLISHVARIABLE_NODEID), v);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+}
+
+static UA_WriterGroupPublishStatistics
+getStatistics(void) {
+    UA_WriterGroupPublishStatistics stats;
+    UA_StatusCode retVal =
+        UA_Server_getWriterGroupPublishStatistics(server, writerGroupId, &stats);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    return stats;
+}
+
+START_TEST(PublisherThreadSchedule) {
+    addPublisher(false);
+    addSubscriber();
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+    UA_Server_run_iterate(server, false);
+
+    /* Not scheduled in the EventLoop */
+    UA_WriterGroup *wg = UA_WriterGroup_find(getPSM(server), writerGroupId);
+    ck_assert(wg != NULL);
+    ck_assert_uint_eq(wg->publishCallbackId, 0);
+
+    /* Nothing is due yet. The next cycle is returned. */
+    UA_EventLoop *el = UA_Server_getConfig(server)->eventLoop;
+    UA_DateTime next = UA_Server_publishIterate(server, PUBLISHER_THREAD);
+    ck_assert_int_eq(next, el->dateTime_nowMonotonic(el) +
+                     PUBLISH_INTERVAL * UA_DATETIME_MSEC);
+    ck_assert_uint_eq(getStatistics().publishCycles, 0);
+
+    /* Other publisher threads don't publish the WriterGroup */
+    UA_fakeSleep(PUBLISH_INTERVAL);
+    UA_Server_publishIterate(server, PUBLISHER_THREAD + 1);
+    ck_assert_uint_eq(getStatistics().publishCycles, 0);
+
+    /* One cycle is due */
+    writeValue(42);
+    UA_Server_publishIterate(server, PUBLISHER_THREAD);
+    UA_WriterGroupPublishStatistics stats = getStatistics();
+    ck_assert_uint_eq(stats.publishCycles, 1);
+    ck_assert_uint_eq(stats.deadlineMisses, 0);
+    for(size_t i = 0; i < 100 && !received(42); i++)
+        UA_Server_run_iterate(server, false);
+    ck_assert(received(42));
+
+    /* Missed cycles are skipped and counted */
+    UA_fakeSleep(4 * PUBLISH_INTERVAL);
+    next = UA_Server_publishIterate(server, PUBLISHER_THREAD);
+    stats = getStatistics();
+    ck_assert_uint_eq(stats.publishCycles, 2);
+    ck_assert_uint_eq(stats.deadlineMisses, 4);
+    ck_assert(stats.maxJitter >= 3 * PUBLISH_INTERVAL);
+    ck_assert_int_eq(next, el->dateTime_nowMonotonic(el) +
+                     PUBLISH_INTERVAL * UA_DATETIME_MSEC);
+
+    /* Disabling removes the WriterGroup from the schedule */
+    UA_StatusCode retVal = UA_Server_disableWriterGroup(server, writerGroupId);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    UA_fakeSleep(PUBLISH_INTERVAL);
+    UA_Server_publishIterate(server, PUBLISHER_THREAD);
+    ck_assert_uint_eq(getStatistics().publishCycles, 2);
+} END_TEST
+
+/* Sleep until the next cycle is due */
+THREAD_CALLBACK(publisherLoop) {
+    UA_EventLoop *el = UA_Server_getConfig(server)->eventLoop;
+    while(running) {
+        UA_DateTime next = UA_Server_publishIterate(server, PUBLISHER_THREAD);
+        UA_DateTime wait = next - el->dateTime_nowMonotonic(el);
+        if(wait > 0)
+            UA_realSleep((UA_UInt32)((wait + UA_DATETIME_MSEC - 1) / UA_DATETIME_MSEC));
+    }
+    return 0;
+}
+
+static void
+publishFromThread(UA_Boolean frozen) {
+    addPublisher(frozen);
+    addSubscriber();
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+
+    running = true;
+    THREAD_HANDLE publisherThread;
+    THREAD_CREATE(publisherThread, publisherLoop);
+
+    /* The application writes and the server receives concurrently */
+    for(UA_Int32 value = 1; value <= 5; value++) {
+        writeValue(value);
+        for(size_t i = 0; i < 1000 && !received(value); i++) {
+            UA_Server_run_iterate(server, false);
+            UA_realSleep(1);
+        }
+        ck_assert(received(value));
+    }
+    ck_assert(getStatistics().publishCycles > 0);
+
+    /* Remove while the publisher thread is running */
+    UA_StatusCode retVal = UA_Server_removeWriterGroup(server, writerGroupId);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 10; i++) {
+        UA_Server_run_iterate(server, false);
+        UA_realSleep(PUBLISH_INTERVAL);
+    }
+
+    running = false;
+    THREAD_JOIN(publisherThread);
+
+    UA_WriterGroupPublishStatistics stats;
+    retVal = UA_Server_getWriterGroupPublishStatistics(server, writerGroupId, &stats);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_BADNOTFOUND);
+}
+
+START_TEST(PublisherThreadConcurrent) {
+    publishFromThread(false);
+} END_TEST
+
+START_TEST(PublisherThreadFrozen) {
+    publishFromThread(true);
+} END_TEST
+
+/* Hold the publisher thread in the middle of sending. Then fail as if the
+ * socket was closed in the meantime. */
+static UA_StatusCode
+(*udpSend)(UA_ConnectionManager *cm, uintptr_t connectionId,
+           const UA_KeyValueMap *params, UA_ByteString *buf);
+static volatile UA_Boolean sending;
+static volatile UA_Boolean holdSend;
+
+static UA_StatusCode
+heldSend(UA_ConnectionManager *cm, uintptr_t connectionId,
+         const UA_KeyValueMap *params, UA_ByteString *buf) {
+    if(!holdSend)
+        return udpSend(cm, connectionId, params, buf);
+    sending = true;
+    while(holdSend)
+        UA_realSleep(1);
+    cm->freeNetworkBuffer(cm, connectionId, buf);
+    return UA_STATUSCODE_BADCONNECTIONCLOSED;
+}
+
+START_TEST(PublisherThreadDisableWhileSending) {
+    addPublisher(false);
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+    UA_Server_run_iterate(server, false);
+
+    lockServer(server);
+    UA_PubSubConnection *c = UA_PubSubConnection_find(getPSM(server), connectionId);
+    ck_assert(c != NULL && c->cm != NULL);
+    UA_ConnectionManager *cm = c->cm;
+    udpSend = cm->sendWithConnection;
+    cm->sendWithConnection = heldSend;
+    unlockServer(server);
+
+    sending = false;
+    holdSend = true;
+    running = true;
+    THREAD_HANDLE publisherThread;
+    THREAD_CREATE(publisherThread, publisherLoop);
+    for(size_t i = 0; i < 1000 && !sending; i++)
+        UA_realSleep(1);
+    ck_assert(sending);
+
+    /* Disable the WriterGroup and remove the DataSetWriter while the
+     * publisher thread sends without the server lock. The socket is closed
+     * underneath. */
+    UA_StatusCode retVal = UA_Server_disableWriterGroup(server, writerGroupId);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    retVal = UA_Server_removeDataSetWriter(server, dataSetWriterId);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    /* The removal is completed after sending */
+    UA_DataSetWriterConfig dswConfig;
+    retVal = UA_Server_getDataSetWriterConfig(server, dataSetWriterId, &dswConfig);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    UA_DataSetWriterConfig_clear(&dswConfig);
+    holdSend = false;
+    for(size_t i = 0; i < 1000 && retVal == UA_STATUSCODE_GOOD; i++) {
+        UA_realSleep(1);
+        retVal = UA_Server_getDataSetWriterConfig(server, dataSetWriterId, &dswConfig);
+        if(retVal == UA_STATUSCODE_GOOD)
+            UA_DataSetWriterConfig_clear(&dswConfig);
+    }
+    ck_assert_int_eq(retVal, UA_STATUSCODE_BADNOTFOUND);
+
+    /* The WriterGroup and the connection keep their state */
+    UA_PubSubState state;
+    retVal = UA_Server_WriterGroup_getState(server, writerGroupId, &state);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(state, UA_PUBSUBSTATE_DISABLED);
+    lockServer(server);
+    ck_assert_int_eq(c->head.state, UA_PUBSUBSTATE_OPERATIONAL);
+    unlockServer(server);
+
+    running = false;
+    THREAD_JOIN(publisherThread);
+    cm->sendWithConnection = udpSend;
+} END_TEST
+
+int main(void) {
+    TCase *tc_schedule = tcase_create("PubSub Publisher Thread Schedule");
+    tcase_add_checked_fixture(tc_schedule, setup, teardown);
+    tcase_add_test(tc_schedule, PublisherThreadSchedule);
+
+    TCase *tc_thread = tcase_create("PubSub Publisher Thread");
+    tcase_add_checked_fixture(tc_thread, setupRealClock, teardown);
+    tcase_add_test(tc_thread, PublisherThreadConcurrent);
+    tcase_add_test(tc_thread, PublisherThreadFrozen);
+    tcase_add_test(tc_thread, PublisherThreadDisableWhileSending);
+
+    Suite *s = suite_create("PubSub Publisher Thread");
+    suite_add_tcase(s, tc_schedule);
+    suite_add_tcase(s, tc_thread);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr,CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -2444,6 +2444,115 @@ START_TEST(InvalidConfiguredSizPublishSubscribe) {
         UA_Server_run_iterate(server, false);
 } END_TEST
 
+/* Decode a RAW DataSetMessage with a scalar, a fixed-size array and a padded
+ * string directly in the DataSetReader */
+START_TEST(ProcessRawDataSetMessage) {
+        UA_StatusCode retVal;
+        UA_NodeId targetIds[3] = {UA_NODEID_NUMERIC(1, 60000),
+                                  UA_NODEID_NUMERIC(1, 60001),
+                                  UA_NODEID_NUMERIC(1, 60002)};
+        const UA_DataType *types[3] = {&UA_TYPES[UA_TYPES_INT32],
+                                       &UA_TYPES[UA_TYPES_UINT16],
+                                       &UA_TYPES[UA_TYPES_STRING]};
+        for(size_t i = 0; i < 3; i++) {
+            UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+            vAttr.displayName = UA_LOCALIZEDTEXT("en-US", "Raw Target");
+            vAttr.dataType = types[i]->typeId;
+            retVal = UA_Server_addVariableNode(server, targetIds[i], folderId,
+                                               UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                               UA_QUALIFIEDNAME(1, "Raw Target"),
+                                               UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                               vAttr, NULL, NULL);
+            ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        }
+
+        /* Reader Group */
+        UA_ReaderGroupConfig readerGroupConfig;
+        memset(&readerGroupConfig, 0, sizeof(UA_ReaderGroupConfig));
+        readerGroupConfig.name = UA_STRING("ReaderGroup Test");
+        retVal = UA_Server_addReaderGroup(server, connectionId, &readerGroupConfig, &readerGroupId);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+        /* Data Set Reader */
+        UA_UInt32 arrayDimensions[1] = {3};
+        UA_FieldMetaData fields[3];
+        for(size_t i = 0; i < 3; i++) {
+            UA_FieldMetaData_init(&fields[i]);
+            fields[i].dataType = types[i]->typeId;
+            fields[i].valueRank = -1; /* scalar */
+        }
+        fields[1].valueRank = 1;
+        fields[1].arrayDimensionsSize = 1;
+        fields[1].arrayDimensions = arrayDimensions;
+        fields[2].maxStringLength = 8;
+
+        UA_FieldTargetDataType targetVars[3];
+        for(size_t i = 0; i < 3; i++) {
+            UA_FieldTargetDataType_init(&targetVars[i]);
+            targetVars[i].attributeId = UA_ATTRIBUTEID_VALUE;
+            targetVars[i].targetNodeId = targetIds[i];
+        }
+
+        UA_NodeId readerIdentifier;
+        UA_DataSetReaderConfig readerConfig;
+        memset(&readerConfig, 0, sizeof(UA_DataSetReaderConfig));
+        readerConfig.name = UA_STRING("DataSetReader Test");
+        readerConfig.dataSetWriterId = DATASET_WRITER_ID;
+        readerConfig.dataSetMetaData.name = UA_STRING("DataSet Test");
+        readerConfig.dataSetMetaData.fieldsSize = 3;
+        readerConfig.dataSetMetaData.fields = fields;
+        readerConfig.subscribedDataSet.target.targetVariablesSize = 3;
+        readerConfig.subscribedDataSet.target.targetVariables = targetVars;
+        retVal = UA_Server_addDataSetReader(server, readerGroupId, &readerConfig, &readerIdentifier);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        ck_assert_int_eq(UA_STATUSCODE_GOOD, UA_Server_enableAllPubSubComponents(server));
+
+        /* Int32 -7, UInt16[3] {1,2,3}, String "hi" padded to 8 bytes */
+        UA_Byte raw[26] = {0xf9, 0xff, 0xff, 0xff,
+                           0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x02, 0x00, 0x03, 0x00,
+                           0x02, 0x00, 0x00, 0x00, 'h', 'i', 0, 0, 0, 0, 0, 0};
+        UA_DataSetMessage msg;
+        memset(&msg, 0, sizeof(UA_DataSetMessage));
+        msg.header.dataSetMessageValid = true;
+        msg.header.fieldEncoding = UA_FIELDENCODING_RAWDATA;
+        msg.header.dataSetMessageType = UA_DATASETMESSAGE_DATAKEYFRAME;
+        msg.data.keyFrameData.rawFields.data = raw;
+        msg.data.keyFrameData.rawFields.length = sizeof(raw);
+
+        UA_PubSubManager *psm = getPSM(server);
+        lockServer(server);
+        UA_DataSetReader *dsr = UA_DataSetReader_find(psm, readerIdentifier);
+        ck_assert(dsr != NULL);
+        UA_DataSetReader_process(psm, dsr, &msg);
+
+        /* A truncated message is discarded while decoding the string */
+        msg.data.keyFrameData.rawFields.length = 19;
+        UA_DataSetReader_process(psm, dsr, &msg);
+        unlockServer(server);
+
+        UA_Variant value;
+        retVal = UA_Server_readValue(server, targetIds[0], &value);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        ck_assert(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_INT32]));
+        ck_assert_int_eq(*(UA_Int32*)value.data, -7);
+        UA_Variant_clear(&value);
+
+        retVal = UA_Server_readValue(server, targetIds[1], &value);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        ck_assert(UA_Variant_hasArrayType(&value, &UA_TYPES[UA_TYPES_UINT16]));
+        ck_assert_uint_eq(value.arrayLength, 3);
+        ck_assert_uint_eq(((UA_UInt16*)value.data)[0], 1);
+        ck_assert_uint_eq(((UA_UInt16*)value.data)[2], 3);
+        UA_Variant_clear(&value);
+
+        retVal = UA_Server_readValue(server, targetIds[2], &value);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        ck_assert(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_STRING]));
+        UA_String hi = UA_STRING("hi");
+        ck_assert(UA_String_equal((UA_String*)value.data, &hi));
+        UA_Variant_clear(&value);
+} END_TEST
+
 int main(void) {
     TCase *tc_add_pubsub_readergroup = tcase_create("PubSub readerGroup items handling");
     tcase_add_checked_fixture(tc_add_pubsub_readergroup, setup, teardown);
@@ -2484,6 +2593,7 @@ int main(void) {
     tcase_add_test(tc_pubsub_publish_subscribe, SinglePublishSubscribeWithoutPayloadHeader);
     tcase_add_test(tc_pubsub_publish_subscribe, MultiPublishSubscribeInt32);
     tcase_add_test(tc_pubsub_publish_subscribe, SinglePublishOnDemand);
+    tcase_add_test(tc_pubsub_publish_subscribe, ProcessRawDataSetMessage);
 
     /*Test cases for the subscribed datasets */
     TCase *tc_pubsub_datasets = tcase_create("Subscriber using subscribed datasets");
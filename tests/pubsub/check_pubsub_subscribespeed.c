@@ -0,0 +1,221 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server_config_default.h>
+#include <open62541/server_pubsub.h>
+
+#include "test_helpers.h"
+#include "ua_pubsub_internal.h"
+#include "ua_server_internal.h"
+
+#include <check.h>
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+
+#define READERGROUPS        20
+#define READERS_PER_GROUP   100
+#define PUBLISHERS          (READERGROUPS * READERS_PER_GROUP)
+#define WRITER_GROUP_ID     100
+#define DATASET_WRITER_ID   62541
+#define TARGET_NODEID_START 10000
+#define ROUNDS              10
+
+UA_Server *server = NULL;
+UA_NodeId connectionId;
+
+static void setup(void) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_run_startup(server);
+
+    UA_PubSubConnectionConfig connectionConfig;
+    memset(&connectionConfig, 0, sizeof(UA_PubSubConnectionConfig));
+    connectionConfig.name = UA_STRING("UADP Connection");
+    UA_NetworkAddressUrlDataType networkAddressUrl =
+        {UA_STRING_NULL, UA_STRING("opc.udp://224.0.0.22:4803/")};
+    UA_Variant_setScalar(&connectionConfig.address, &networkAddressUrl,
+                         &UA_TYPES[UA_TYPES_NETWORKADDRESSURLDATATYPE]);
+    connectionConfig.transportProfileUri =
+        UA_STRING("http://opcfoundation.org/UA-Profile/Transport/pubsub-udp-uadp");
+    UA_StatusCode retVal =
+        UA_Server_addPubSubConnection(server, &connectionConfig, &connectionId);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+}
+
+static void teardown(void) {
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+/* One reader for every publisher. The PublisherId is the reader index. */
+static void
+addReaders(void) {
+    UA_FieldMetaData fmd;
+    UA_FieldMetaData_init(&fmd);
+    fmd.dataType = UA_TYPES[UA_TYPES_INT32].typeId;
+    fmd.builtInType = UA_NS0ID_INT32;
+    fmd.valueRank = -1; /* scalar */
+
+    UA_FieldTargetDataType targetVar;
+    UA_FieldTargetDataType_init(&targetVar);
+    targetVar.attributeId = UA_ATTRIBUTEID_VALUE;
+
+    UA_DataSetReaderConfig readerConfig;
+    memset(&readerConfig, 0, sizeof(UA_DataSetReaderConfig));
+    readerConfig.name = UA_STRING("DataSetReader");
+    readerConfig.publisherId.idType = UA_PUBLISHERIDTYPE_UINT16;
+    readerConfig.writerGroupId = WRITER_GROUP_ID;
+    readerConfig.dataSetWriterId = DATASET_WRITER_ID;
+    readerConfig.dataSetMetaData.name = UA_STRING("DataSet");
+    readerConfig.dataSetMetaData.fieldsSize = 1;
+    readerConfig.dataSetMetaData.fields = &fmd;
+    readerConfig.subscribedDataSet.target.targetVariablesSize = 1;
+    readerConfig.subscribedDataSet.target.targetVariables = &targetVar;
+
+    UA_Int32 zero = 0;
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Target");
+    attr.dataType = UA_TYPES[UA_TYPES_INT32].typeId;
+    UA_Variant_setScalar(&attr.value, &zero, &UA_TYPES[UA_TYPES_INT32]);
+
+    for(size_t g = 0; g < READERGROUPS; g++) {
+        UA_NodeId readerGroupId;
+        UA_ReaderGroupConfig rgConfig;
+        memset(&rgConfig, 0, sizeof(UA_ReaderGroupConfig));
+        rgConfig.name = UA_STRING("ReaderGroup");
+        UA_StatusCode retVal =
+            UA_Server_addReaderGroup(server, connectionId, &rgConfig, &readerGroupId);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+        for(size_t r = 0; r < READERS_PER_GROUP; r++) {
+            UA_UInt16 id = (UA_UInt16)(g * READERS_PER_GROUP + r);
+            targetVar.targetNodeId = UA_NODEID_NUMERIC(1, TARGET_NODEID_START + id);
+            retVal = UA_Server_addVariableNode(server, targetVar.targetNodeId,
+                                               UA_NS0ID(OBJECTSFOLDER),
+                                               UA_NS0ID(ORGANIZES),
+                                               UA_QUALIFIEDNAME(1, "Target"),
+                                               UA_NS0ID(BASEDATAVARIABLETYPE),
+                                               attr, NULL, NULL);
+            ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+            readerConfig.publisherId.id.uint16 = id;
+            retVal = UA_Server_addDataSetReader(server, readerGroupId,
+                                                &readerConfig, NULL);
+            ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        }
+    }
+}
+
+/* Encode the NetworkMessage of a publisher. The published value is the
+ * PublisherId plus the offset. */
+static void
+encodeMessage(UA_UInt16 publisherId, UA_Int32 offset, UA_ByteString *buffer) {
+    UA_Int32 value = (UA_Int32)publisherId + offset;
+    UA_DataValue field;
+    UA_DataValue_init(&field);
+    UA_Variant_setScalar(&field.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    field.hasValue = true;
+
+    UA_DataSetMessage dsm;
+    memset(&dsm, 0, sizeof(UA_DataSetMessage));
+    dsm.dataSetWriterId = DATASET_WRITER_ID;
+    dsm.header.dataSetMessageValid = true;
+    dsm.header.fieldEncoding = UA_FIELDENCODING_VARIANT;
+    dsm.header.dataSetMessageType = UA_DATASETMESSAGE_DATAKEYFRAME;
+    dsm.data.keyFrameData.fieldCount = 1;
+    dsm.data.keyFrameData.dataSetFields = &field;
+
+    UA_NetworkMessage nm;
+    memset(&nm, 0, sizeof(UA_NetworkMessage));
+    nm.version = 1;
+    nm.networkMessageType = UA_NETWORKMESSAGE_DATASET;
+    nm.publisherIdEnabled = true;
+    nm.publisherId.idType = UA_PUBLISHERIDTYPE_UINT16;
+    nm.publisherId.id.uint16 = publisherId;
+    nm.groupHeaderEnabled = true;
+    nm.groupHeader.writerGroupIdEnabled = true;
+    nm.groupHeader.writerGroupId = WRITER_GROUP_ID;
+    nm.payloadHeaderEnabled = true;
+    nm.payload.dataSetPayload.dataSetMessages = &dsm;
+    nm.payload.dataSetPayload.dataSetMessagesSize = 1;
+
+    UA_StatusCode retVal =
+        UA_ByteString_allocBuffer(buffer, UA_NetworkMessage_calcSizeBinary(&nm));
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    retVal = UA_NetworkMessage_encodeBinary(&nm, buffer);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+}
+
+static void
+checkTarget(UA_UInt16 id, UA_Int32 expected) {
+    UA_Variant value;
+    UA_StatusCode retVal =
+        UA_Server_readValue(server, UA_NODEID_NUMERIC(1, TARGET_NODEID_START + id),
+                            &value);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert(value.type == &UA_TYPES[UA_TYPES_INT32]);
+    ck_assert_int_eq(*(UA_Int32*)value.data, expected);
+    UA_Variant_clear(&value);
+}
+
+START_TEST(SubscribeSpeedTest) {
+    addReaders();
+    ck_assert_int_eq(UA_Server_enableAllPubSubComponents(server), UA_STATUSCODE_GOOD);
+
+    UA_PubSubManager *psm = getPSM(server);
+    UA_PubSubConnection *c = UA_PubSubConnection_find(psm, connectionId);
+    ck_assert(c != NULL);
+
+    UA_ByteString *buffers = (UA_ByteString*)
+        UA_calloc(PUBLISHERS, sizeof(UA_ByteString));
+    ck_assert(buffers != NULL);
+
+    printf("start processing %u messages for %u DataSetReaders\n",
+           (unsigned)(PUBLISHERS * ROUNDS), (unsigned)PUBLISHERS);
+
+    double time_spent = 0.0;
+    for(UA_Int32 round = 0; round < ROUNDS; round++) {
+        for(UA_UInt16 i = 0; i < PUBLISHERS; i++)
+            encodeMessage(i, round * PUBLISHERS, &buffers[i]);
+
+        clock_t begin = clock();
+        lockServer(server);
+        for(size_t i = 0; i < PUBLISHERS; i++)
+            UA_PubSubConnection_process(psm, c, buffers[i]);
+        unlockServer(server);
+        clock_t finish = clock();
+        time_spent += (double)(finish - begin) / CLOCKS_PER_SEC;
+
+        for(size_t i = 0; i < PUBLISHERS; i++)
+            UA_ByteString_clear(&buffers[i]);
+    }
+    printf("duration was %f s\n", time_spent);
+    UA_free(buffers);
+
+    /* The messages were dispatched with the reader index */
+    ck_assert(c->readerIndex.entries != NULL);
+
+    /* Every reader has received the value from its own publisher */
+    UA_Int32 offset = (ROUNDS - 1) * PUBLISHERS;
+    checkTarget(0, offset);
+    checkTarget(PUBLISHERS / 2 + 7, offset + PUBLISHERS / 2 + 7);
+    checkTarget(PUBLISHERS - 1, offset + PUBLISHERS - 1);
+} END_TEST
+
+int main(void) {
+    TCase *tc_subscribespeed = tcase_create("Speed of the subscriber");
+    tcase_add_checked_fixture(tc_subscribespeed, setup, teardown);
+    tcase_add_test(tc_subscribespeed, SubscribeSpeedTest);
+
+    Suite *s = suite_create("PubSub Subscribe Speed Test");
+    suite_add_tcase(s, tc_subscribespeed);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr,CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
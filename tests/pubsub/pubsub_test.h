@@ -0,0 +1,197 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef PUBSUB_TEST_H_
+#define PUBSUB_TEST_H_
+
+#include <open62541/server_config_default.h>
+#include <open62541/server_pubsub.h>
+
+#include "check.h"
+#include "test_helpers.h"
+#include "testing_clock.h"
+
+/* Publish a variable and subscribe to it in the same server. The WriterGroup
+ * and the ReaderGroup share one UDP multicast connection. Each test file uses
+ * its own multicast address. */
+
+#define PUBLISH_INTERVAL          5
+#define PUBLISHER_ID              2234
+#define WRITER_GROUP_ID           100
+#define DATASET_WRITER_ID         62541
+#define PUBLISHVARIABLE_NODEID    1000
+#define SUBSCRIBEVARIABLE_NODEID  1002
+
+static UA_Server *server = NULL;
+static UA_NodeId connectionId;
+static UA_NodeId writerGroupId;
+static UA_NodeId dataSetWriterId; /* The first DataSetWriter */
+static UA_NodeId readerGroupId;
+
+static UA_INLINE void
+addTestConnection(char *url) {
+    UA_PubSubConnectionConfig connectionConfig;
+    memset(&connectionConfig, 0, sizeof(UA_PubSubConnectionConfig));
+    connectionConfig.name = UA_STRING("UADP Test Connection");
+    UA_NetworkAddressUrlDataType networkAddressUrl =
+        {UA_STRING_NULL, UA_STRING(url)};
+    UA_Variant_setScalar(&connectionConfig.address, &networkAddressUrl,
+                         &UA_TYPES[UA_TYPES_NETWORKADDRESSURLDATATYPE]);
+    connectionConfig.transportProfileUri =
+        UA_STRING("http://opcfoundation.org/UA-Profile/Transport/pubsub-udp-uadp");
+    connectionConfig.publisherId.idType = UA_PUBLISHERIDTYPE_UINT16;
+    connectionConfig.publisherId.id.uint16 = PUBLISHER_ID;
+    UA_StatusCode retVal =
+        UA_Server_addPubSubConnection(server, &connectionConfig, &connectionId);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+}
+
+static UA_INLINE void
+setupPubSubTest(char *url) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_run_startup(server);
+    addTestConnection(url);
+}
+
+static UA_INLINE void
+teardownPubSubTest(void) {
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+/* Add the published and the subscribed variable with the initial value */
+static UA_INLINE void
+addTestVariables(const UA_Variant *value) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Published");
+    attr.dataType = value->type->typeId;
+    attr.value = *value;
+    UA_StatusCode retVal =
+        UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, PUBLISHVARIABLE_NODEID),
+                                  UA_NS0ID(OBJECTSFOLDER), UA_NS0ID(ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Published"),
+                                  UA_NS0ID(BASEDATAVARIABLETYPE), attr, NULL, NULL);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Subscribed");
+    retVal =
+        UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, SUBSCRIBEVARIABLE_NODEID),
+                                  UA_NS0ID(OBJECTSFOLDER), UA_NS0ID(ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Subscribed"),
+                                  UA_NS0ID(BASEDATAVARIABLETYPE), attr, NULL, NULL);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+}
+
+/* The message settings are set in the config. They point to wgMessage, which
+ * has to outlive the config. */
+static UA_INLINE void
+initTestWriterGroupConfig(UA_WriterGroupConfig *wgConfig,
+                          UA_UadpWriterGroupMessageDataType *wgMessage) {
+    memset(wgConfig, 0, sizeof(UA_WriterGroupConfig));
+    wgConfig->name = UA_STRING("WriterGroup Test");
+    wgConfig->publishingInterval = PUBLISH_INTERVAL;
+    wgConfig->writerGroupId = WRITER_GROUP_ID;
+    wgConfig->encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    UA_UadpWriterGroupMessageDataType_init(wgMessage);
+    wgMessage->networkMessageContentMask = (UA_UadpNetworkMessageContentMask)
+        (UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID |
+         UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
+         UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
+         UA_UADPNETWORKMESSAGECONTENTMASK_SEQUENCENUMBER |
+         UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER);
+    UA_ExtensionObject_setValue(&wgConfig->messageSettings, wgMessage,
+                                &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE]);
+}
+
+static UA_INLINE void
+initTestDataSetWriterConfig(UA_DataSetWriterConfig *dswConfig) {
+    memset(dswConfig, 0, sizeof(UA_DataSetWriterConfig));
+    dswConfig->name = UA_STRING("DataSetWriter Test");
+    dswConfig->dataSetWriterId = DATASET_WRITER_ID;
+    dswConfig->keyFrameCount = 10;
+}
+
+/* Publish the variable in a PublishedDataSet. Additional writers for the same
+ * PublishedDataSet use the following DataSetWriterIds. */
+static UA_INLINE void
+addTestPublisher(const UA_WriterGroupConfig *wgConfig,
+                 const UA_DataSetWriterConfig *dswConfig, size_t writers) {
+    UA_NodeId pdsId;
+    UA_PublishedDataSetConfig pdsConfig;
+    memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+    pdsConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+    pdsConfig.name = UA_STRING("PublishedDataSet Test");
+    UA_StatusCode retVal =
+        UA_Server_addPublishedDataSet(server, &pdsConfig, &pdsId).addResult;
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_DataSetFieldConfig dsfConfig;
+    memset(&dsfConfig, 0, sizeof(UA_DataSetFieldConfig));
+    dsfConfig.dataSetFieldType = UA_PUBSUB_DATASETFIELD_VARIABLE;
+    dsfConfig.field.variable.fieldNameAlias = UA_STRING("Published");
+    dsfConfig.field.variable.publishParameters.publishedVariable =
+        UA_NODEID_NUMERIC(1, PUBLISHVARIABLE_NODEID);
+    dsfConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    retVal = UA_Server_addDataSetField(server, pdsId, &dsfConfig, NULL).result;
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    retVal = UA_Server_addWriterGroup(server, connectionId, wgConfig, &writerGroupId);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_DataSetWriterConfig config = *dswConfig;
+    for(size_t i = 0; i < writers; i++) {
+        config.dataSetWriterId = (UA_UInt16)(dswConfig->dataSetWriterId + i);
+        UA_NodeId dswId;
+        retVal = UA_Server_addDataSetWriter(server, writerGroupId, pdsId,
+                                            &config, &dswId);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        if(i == 0)
+            dataSetWriterId = dswId;
+    }
+}
+
+/* Subscribe to the first DataSetWriter and write the field into the
+ * subscribed variable. The ReaderGroup config can be NULL. */
+static UA_INLINE void
+addTestSubscriber(const UA_ReaderGroupConfig *rgConfig, const UA_DataType *type) {
+    UA_ReaderGroupConfig defaultRgConfig;
+    if(!rgConfig) {
+        memset(&defaultRgConfig, 0, sizeof(UA_ReaderGroupConfig));
+        defaultRgConfig.name = UA_STRING("ReaderGroup Test");
+        rgConfig = &defaultRgConfig;
+    }
+    UA_StatusCode retVal =
+        UA_Server_addReaderGroup(server, connectionId, rgConfig, &readerGroupId);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_DataSetReaderConfig readerConfig;
+    memset(&readerConfig, 0, sizeof(UA_DataSetReaderConfig));
+    readerConfig.name = UA_STRING("DataSetReader Test");
+    readerConfig.publisherId.idType = UA_PUBLISHERIDTYPE_UINT16;
+    readerConfig.publisherId.id.uint16 = PUBLISHER_ID;
+    readerConfig.writerGroupId = WRITER_GROUP_ID;
+    readerConfig.dataSetWriterId = DATASET_WRITER_ID;
+
+    UA_FieldMetaData fmd;
+    UA_FieldMetaData_init(&fmd);
+    fmd.dataType = type->typeId;
+    fmd.builtInType = (UA_Byte)(type->typeKind + 1);
+    fmd.valueRank = -1; /* scalar */
+    readerConfig.dataSetMetaData.name = UA_STRING("DataSet Test");
+    readerConfig.dataSetMetaData.fieldsSize = 1;
+    readerConfig.dataSetMetaData.fields = &fmd;
+
+    UA_FieldTargetDataType targetVar;
+    UA_FieldTargetDataType_init(&targetVar);
+    targetVar.attributeId = UA_ATTRIBUTEID_VALUE;
+    targetVar.targetNodeId = UA_NODEID_NUMERIC(1, SUBSCRIBEVARIABLE_NODEID);
+    readerConfig.subscribedDataSet.target.targetVariablesSize = 1;
+    readerConfig.subscribedDataSet.target.targetVariables = &targetVar;
+
+    retVal = UA_Server_addDataSetReader(server, readerGroupId, &readerConfig, NULL);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+}
+
+#endif /* PUBSUB_TEST_H_ */
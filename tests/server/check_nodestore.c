@@ -5,15 +5,18 @@
 #include <open62541/types.h>
 #include <open62541/util.h>
 #include <open62541/plugin/nodestore_default.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
 #include "open62541/plugin/nodestore.h"
 #include "open62541/types_generated.h"
+#include "test_helpers.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include "check.h"
 
-#if UA_MULTITHREADING >= 200
+#if UA_MULTITHREADING >= 100
 #include <pthread.h>
 #endif
 
@@ -27,6 +30,15 @@ static void setupHashMap(void) {
     UA_Nodestore_HashMap(&ns);
 }
 
+static void setupSwissTable(void) {
+    UA_Nodestore_SwissTable(&ns);
+}
+
+static void setupFrozen(void) {
+    ns.context = NULL;
+    UA_Nodestore_Frozen(&ns);
+}
+
 static void teardown(void) {
     ns.clear(ns.context);
 }
@@ -191,6 +203,371 @@ START_TEST(failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries) {
 }
 END_TEST
 
+START_TEST(removeNodesAndFindRemaining) {
+    for(UA_UInt32 i = 0; i < 1000; i++)
+        ns.insertNode(ns.context, createNode(0, i + 1), NULL);
+    for(UA_UInt32 i = 0; i < 1000; i += 2) {
+        UA_NodeId id = UA_NODEID_NUMERIC(0, i + 1);
+        ck_assert_uint_eq(ns.removeNode(ns.context, &id), UA_STATUSCODE_GOOD);
+    }
+    for(UA_UInt32 i = 0; i < 1000; i++) {
+        UA_NodeId id = UA_NODEID_NUMERIC(0, i + 1);
+        const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                      UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+        ck_assert((i % 2 == 0) == (n == NULL));
+        ns.releaseNode(ns.context, n);
+    }
+    for(UA_UInt32 i = 0; i < 1000; i += 2) {
+        UA_StatusCode res = ns.insertNode(ns.context, createNode(0, i + 1), NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    zeroCnt = 0;
+    visitCnt = 0;
+    ns.iterate(ns.context, checkZeroVisitor, NULL);
+    ck_assert_int_eq(visitCnt, 1000);
+}
+END_TEST
+
+/*************************/
+/* Frozen Nodestore Tests */
+/*************************/
+
+#define FROZEN_NODES 100
+
+static UA_NodeId
+frozenTestId(UA_UInt32 i) {
+    if(i % 2 == 0)
+        return UA_NODEID_NUMERIC(1, i);
+    char buf[32];
+    snprintf(buf, sizeof(buf), "node-%u", (unsigned)i);
+    UA_NodeId id;
+    UA_NodeId_init(&id);
+    id.namespaceIndex = 1;
+    id.identifierType = UA_NODEIDTYPE_STRING;
+    id.identifier.string = UA_String_fromChars(buf);
+    return id;
+}
+
+/* Node 1 references all other nodes. That makes a reference tree. */
+static void
+insertFrozenTestNodes(void) {
+    for(UA_UInt32 i = 1; i <= FROZEN_NODES; i++) {
+        UA_Node *n = ns.newNode(ns.context, UA_NODECLASS_VARIABLE);
+        n->head.nodeId = frozenTestId(i);
+        n->head.browseName = UA_QUALIFIEDNAME_ALLOC(1, "browseName");
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        attr.displayName = UA_LOCALIZEDTEXT("en-US", "displayName");
+        attr.dataType = UA_TYPES[UA_TYPES_UINT32].typeId;
+        UA_Variant_setScalar(&attr.value, &i, &UA_TYPES[UA_TYPES_UINT32]);
+        UA_StatusCode res =
+            UA_Node_setAttributes(n, &attr, &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        for(UA_UInt32 j = 2; i == 1 && j <= FROZEN_NODES; j++) {
+            UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NULL;
+            target.nodeId = frozenTestId(j);
+            UA_Node_addReference(n, UA_REFERENCETYPEINDEX_HASCOMPONENT, true,
+                                 &target, j);
+            UA_ExpandedNodeId_clear(&target);
+        }
+        if(i > 1) {
+            UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NULL;
+            target.nodeId = frozenTestId(1);
+            UA_Node_addReference(n, UA_REFERENCETYPEINDEX_HASCOMPONENT, false,
+                                 &target, 1);
+            UA_ExpandedNodeId_clear(&target);
+        }
+        res = ns.insertNode(ns.context, n, NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    /* Not in the frozen namespace */
+    ns.insertNode(ns.context, createNode(0, 1), NULL);
+}
+
+static void
+checkFrozenTestNode(const UA_Node *n, UA_UInt32 i) {
+    UA_NodeId id = frozenTestId(i);
+    ck_assert(UA_NodeId_equal(&n->head.nodeId, &id));
+    UA_NodeId_clear(&id);
+    UA_QualifiedName bn = UA_QUALIFIEDNAME(1, "browseName");
+    ck_assert(UA_QualifiedName_equal(&n->head.browseName, &bn));
+    UA_String dn = UA_STRING("displayName");
+    ck_assert(UA_String_equal(&n->head.displayName->localizedText.text, &dn));
+    const UA_DataValue *dv = &n->variableNode.value.data.value;
+    ck_assert(UA_Variant_hasScalarType(&dv->value, &UA_TYPES[UA_TYPES_UINT32]));
+    ck_assert_uint_eq(*(UA_UInt32*)dv->value.data, i);
+    ck_assert_uint_eq(n->head.referencesSize, 1);
+    const UA_NodeReferenceKind *rk = &n->head.references[0];
+    for(UA_UInt32 j = 2; i == 1 && j <= FROZEN_NODES; j++) {
+        UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NULL;
+        target.nodeId = frozenTestId(j);
+        ck_assert(UA_NodeReferenceKind_findTarget(rk, &target) != NULL);
+        UA_ExpandedNodeId_clear(&target);
+    }
+    if(i == 1)
+        ck_assert_uint_eq(rk->targetsSize, FROZEN_NODES - 1);
+}
+
+START_TEST(freezeAndFind) {
+    insertFrozenTestNodes();
+    UA_StatusCode res = UA_Nodestore_Frozen_freeze(&ns, 1);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    for(UA_UInt32 i = 1; i <= FROZEN_NODES; i++) {
+        UA_NodeId id = frozenTestId(i);
+        const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                      UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+        ck_assert(n != NULL);
+        checkFrozenTestNode(n, i);
+        ns.releaseNode(ns.context, n);
+        UA_NodeId_clear(&id);
+    }
+
+    UA_NodeId id = UA_NODEID_NUMERIC(0, 1);
+    const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                  UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert(n != NULL);
+    ns.releaseNode(ns.context, n);
+
+    zeroCnt = 0;
+    visitCnt = 0;
+    ns.iterate(ns.context, checkZeroVisitor, NULL);
+    ck_assert_int_eq(zeroCnt, 0);
+    ck_assert_int_eq(visitCnt, FROZEN_NODES + 1);
+}
+END_TEST
+
+START_TEST(editFrozenNode) {
+    insertFrozenTestNodes();
+    UA_StatusCode res = UA_Nodestore_Frozen_freeze(&ns, 1);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_NodeId id = frozenTestId(1);
+    const UA_Node *frozen = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                       UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert(frozen != NULL);
+
+    /* Copy-on-write. The frozen version is unchanged. */
+    UA_Node *edit = ns.getEditNode(ns.context, &id, ~(UA_UInt32)0,
+                                   UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert(edit != NULL);
+    ck_assert(edit != frozen);
+    checkFrozenTestNode(edit, 1);
+    UA_QualifiedName_clear(&edit->head.browseName);
+    edit->head.browseName = UA_QUALIFIEDNAME_ALLOC(1, "edited");
+    ns.releaseNode(ns.context, edit);
+    checkFrozenTestNode(frozen, 1);
+    ns.releaseNode(ns.context, frozen);
+
+    const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                  UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    UA_QualifiedName bn = UA_QUALIFIEDNAME(1, "edited");
+    ck_assert(UA_QualifiedName_equal(&n->head.browseName, &bn));
+    ns.releaseNode(ns.context, n);
+
+    /* Replace a frozen node via a copy */
+    UA_NodeId id2 = frozenTestId(2);
+    UA_Node *copy = NULL;
+    res = ns.getNodeCopy(ns.context, &id2, &copy);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = ns.replaceNode(ns.context, copy);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Freeze again. The edited nodes are frozen as well. */
+    res = UA_Nodestore_Frozen_freeze(&ns, 1);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                   UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert(UA_QualifiedName_equal(&n->head.browseName, &bn));
+    ns.releaseNode(ns.context, n);
+
+    visitCnt = 0;
+    ns.iterate(ns.context, checkZeroVisitor, NULL);
+    ck_assert_int_eq(visitCnt, FROZEN_NODES + 1);
+    UA_NodeId_clear(&id);
+}
+END_TEST
+
+START_TEST(removeFrozenNode) {
+    insertFrozenTestNodes();
+    UA_StatusCode res = UA_Nodestore_Frozen_freeze(&ns, 1);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* A frozen NodeId cannot be inserted twice */
+    UA_Node *dup = createNode(1, 2);
+    res = ns.insertNode(ns.context, dup, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDEXISTS);
+
+    UA_NodeId id = UA_NODEID_NUMERIC(1, 2);
+    res = ns.removeNode(ns.context, &id);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                  UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert(n == NULL);
+    res = ns.removeNode(ns.context, &id);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    /* Insert again into the mutable nodestore */
+    res = ns.insertNode(ns.context, createNode(1, 2), NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                   UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert(n != NULL);
+    ns.releaseNode(ns.context, n);
+
+    visitCnt = 0;
+    ns.iterate(ns.context, checkZeroVisitor, NULL);
+    ck_assert_int_eq(visitCnt, FROZEN_NODES + 1);
+}
+END_TEST
+
+/* Freeze namespace zero of a server and compare browsing before and after */
+#define BROWSE_ROUNDS 2000
+
+static double
+browseServerObject(UA_Server *server, size_t *refs) {
+    clock_t begin = clock();
+    for(size_t i = 0; i < BROWSE_ROUNDS; i++) {
+        UA_BrowseDescription bd;
+        UA_BrowseDescription_init(&bd);
+        bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+        bd.browseDirection = UA_BROWSEDIRECTION_BOTH;
+        bd.resultMask = UA_BROWSERESULTMASK_ALL;
+        UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+        ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+        *refs = br.referencesSize;
+        UA_BrowseResult_clear(&br);
+    }
+    return (double)(clock() - begin) / CLOCKS_PER_SEC;
+}
+
+START_TEST(freezeServerNamespaceZero) {
+    UA_Server *server = UA_Server_newForUnitTest();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    size_t refsBefore = 0, refsAfter = 0;
+    double before = browseServerObject(server, &refsBefore);
+
+    UA_StatusCode res = UA_Nodestore_Frozen(&config->nodestore);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Nodestore_Frozen_freeze(&config->nodestore, 0);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    double after = browseServerObject(server, &refsAfter);
+    ck_assert_uint_eq(refsBefore, refsAfter);
+    printf("%d browse calls before freezing: %fs, after freezing: %fs\n",
+           BROWSE_ROUNDS, before, after);
+
+    /* Write to a frozen node */
+    UA_NodeId objects = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_LocalizedText lt;
+    res = UA_Server_readDisplayName(server, objects, &lt);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_String_clear(&lt.text);
+    lt.text = UA_STRING_ALLOC("Edited");
+    res = UA_Server_writeDisplayName(server, objects, lt);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_LocalizedText out;
+    res = UA_Server_readDisplayName(server, objects, &out);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_String_equal(&out.text, &lt.text));
+    UA_LocalizedText_clear(&out);
+    UA_LocalizedText_clear(&lt);
+
+    /* Add a node below a frozen node */
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    res = UA_Server_addObjectNode(server, UA_NODEID_NUMERIC(1, 1000), objects,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Object"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                  oAttr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_Server_delete(server);
+}
+END_TEST
+
+#define IMAGE_FILE "check_nodestore.img"
+
+START_TEST(loadServerImage) {
+    /* Build the namespace zero and write the image */
+    clock_t begin = clock();
+    UA_Server *server = UA_Server_newForUnitTest();
+    double generated = (double)(clock() - begin) / CLOCKS_PER_SEC;
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_StatusCode res = UA_Nodestore_Frozen(&config->nodestore);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Nodestore_Frozen_freeze(&config->nodestore, 0);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_String uris[2] = {UA_STRING_STATIC("http://opcfoundation.org/UA/"),
+                         UA_STRING_STATIC("urn:test")};
+    res = UA_Nodestore_Frozen_writeImage(&config->nodestore, IMAGE_FILE, uris, 2);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    size_t refsGenerated = 0;
+    browseServerObject(server, &refsGenerated);
+    UA_Server_delete(server);
+
+    /* Create a server from the image */
+    begin = clock();
+    UA_ServerConfig imageConfig;
+    memset(&imageConfig, 0, sizeof(UA_ServerConfig));
+    res = UA_Nodestore_Frozen(&imageConfig.nodestore);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_String *loadedUris = NULL;
+    size_t loadedUrisSize = 0;
+    res = UA_Nodestore_Frozen_loadImage(&imageConfig.nodestore, IMAGE_FILE,
+                                        &loadedUris, &loadedUrisSize);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ServerConfig_setDefault(&imageConfig);
+    server = UA_Server_newWithConfig(&imageConfig);
+    ck_assert(server != NULL);
+    double loaded = (double)(clock() - begin) / CLOCKS_PER_SEC;
+    printf("Server startup with generated namespace zero: %fs, "
+           "from the nodestore image: %fs\n", generated, loaded);
+    remove(IMAGE_FILE);
+
+    ck_assert_uint_eq(loadedUrisSize, 2);
+    ck_assert(UA_String_equal(&loadedUris[1], &uris[1]));
+    UA_Array_delete(loadedUris, loadedUrisSize, &UA_TYPES[UA_TYPES_STRING]);
+
+    /* Same references as the generated namespace zero */
+    size_t refsLoaded = 0;
+    browseServerObject(server, &refsLoaded);
+    ck_assert_uint_eq(refsGenerated, refsLoaded);
+
+    /* The DataSources are attached again */
+    UA_Variant value;
+    res = UA_Server_readValue(server, UA_NS0ID(SERVER_SERVERSTATUS_CURRENTTIME), &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_DATETIME]));
+    UA_Variant_clear(&value);
+
+    /* Values in the image */
+    res = UA_Server_readValue(server, UA_NS0ID(REDUNDANCYSUPPORT_ENUMSTRINGS), &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasArrayType(&value, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]));
+    ck_assert_uint_eq(value.arrayLength, 6);
+    UA_Variant_clear(&value);
+    res = UA_Server_readValue(server, UA_NS0ID(NAMINGRULETYPE_ENUMVALUES), &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasArrayType(&value, &UA_TYPES[UA_TYPES_ENUMVALUETYPE]));
+    UA_Variant_clear(&value);
+    UA_QualifiedName bn;
+    res = UA_Server_readBrowseName(server, UA_NS0ID(OBJECTSFOLDER), &bn);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_QualifiedName objects = UA_QUALIFIEDNAME(0, "Objects");
+    ck_assert(UA_QualifiedName_equal(&bn, &objects));
+    UA_QualifiedName_clear(&bn);
+
+    /* Add a node below a node from the image */
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    res = UA_Server_addObjectNode(server, UA_NODEID_NUMERIC(1, 1000),
+                                  UA_NS0ID(OBJECTSFOLDER), UA_NS0ID(ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Object"),
+                                  UA_NS0ID(BASEOBJECTTYPE), oAttr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_Server_delete(server);
+}
+END_TEST
+
 /************************************/
 /* Performance Profiling Test Cases */
 /************************************/
@@ -257,6 +634,116 @@ START_TEST(profileGetDelete) {
 }
 END_TEST
 
+/* Compare the nodestores for inserts, lookups (hits and misses) and iteration.
+ * The NodeIds are numeric and not sequential in the hash. */
+#define BENCH_NODES 100000
+#define BENCH_LOOKUPS 1000000
+
+static void countVisitor(void *context, const UA_Node *node) {
+    (*(size_t*)context)++;
+}
+
+START_TEST(profileInsertLookupIterate) {
+    clock_t begin = clock();
+    for(UA_UInt32 i = 0; i < BENCH_NODES; i++) {
+        UA_StatusCode res = ns.insertNode(ns.context, createNode(1, i * 7 + 1), NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    clock_t inserted = clock();
+
+    UA_NodeId id = UA_NODEID_NUMERIC(1, 0);
+    size_t found = 0;
+    for(UA_UInt32 i = 0; i < BENCH_LOOKUPS; i++) {
+        /* Every 8th lookup misses */
+        UA_UInt32 n = (i * 2654435761u) % BENCH_NODES;
+        id.identifier.numeric = (i % 8 == 0) ? n * 7 + 2 : n * 7 + 1;
+        const UA_Node *node = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                         UA_REFERENCETYPESET_ALL,
+                                         UA_BROWSEDIRECTION_BOTH);
+        if(node) {
+            found++;
+            ns.releaseNode(ns.context, node);
+        }
+    }
+    clock_t looked = clock();
+    ck_assert_uint_eq(found, BENCH_LOOKUPS - BENCH_LOOKUPS / 8);
+
+    size_t visited = 0;
+    for(size_t i = 0; i < 10; i++)
+        ns.iterate(ns.context, countVisitor, &visited);
+    clock_t iterated = clock();
+    ck_assert_uint_eq(visited, 10 * BENCH_NODES);
+
+    printf("%d inserts: %fs, %d lookups: %fs, 10 iterations: %fs\n",
+           BENCH_NODES, (double)(inserted - begin) / CLOCKS_PER_SEC,
+           BENCH_LOOKUPS, (double)(looked - inserted) / CLOCKS_PER_SEC,
+           (double)(iterated - looked) / CLOCKS_PER_SEC);
+}
+END_TEST
+
+#if UA_MULTITHREADING >= 100
+/* Lookups run in parallel to a writer that resizes the table, replaces and
+ * removes nodes. The stable nodes must be found at any time. */
+#define STABLE_NODES 100
+#define CHURN_NODES 5000
+
+static volatile UA_Boolean writerDone;
+
+static void *concurrentReadThread(void *arg) {
+    size_t *lookups = (size_t*)arg;
+    UA_NodeId id = UA_NODEID_NUMERIC(1, 0);
+    while(!writerDone) {
+        for(UA_UInt32 i = 0; i < STABLE_NODES; i++) {
+            id.identifier.numeric = i + 1;
+            const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                          UA_REFERENCETYPESET_ALL,
+                                          UA_BROWSEDIRECTION_BOTH);
+            ck_assert(n != NULL);
+            ck_assert(UA_NodeId_equal(&n->head.nodeId, &id));
+            ns.releaseNode(ns.context, n);
+            (*lookups)++;
+        }
+    }
+    return NULL;
+}
+
+START_TEST(concurrentGetDuringWrite) {
+    for(UA_UInt32 i = 0; i < STABLE_NODES; i++)
+        ns.insertNode(ns.context, createNode(1, i + 1), NULL);
+
+    writerDone = false;
+    pthread_t t[2];
+    size_t lookups[2] = {0, 0};
+    for(size_t i = 0; i < 2; i++)
+        pthread_create(&t[i], NULL, concurrentReadThread, &lookups[i]);
+
+    /* Grow and shrink the table, replace the stable nodes in between */
+    for(size_t round = 0; round < 5; round++) {
+        for(UA_UInt32 i = 0; i < CHURN_NODES; i++)
+            ns.insertNode(ns.context, createNode(2, i + 1), NULL);
+        for(UA_UInt32 i = 0; i < STABLE_NODES; i++) {
+            UA_NodeId id = UA_NODEID_NUMERIC(1, i + 1);
+            UA_Node *copy = NULL;
+            UA_StatusCode res = ns.getNodeCopy(ns.context, &id, &copy);
+            ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+            res = ns.replaceNode(ns.context, copy);
+            ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        }
+        for(UA_UInt32 i = 0; i < CHURN_NODES; i++) {
+            UA_NodeId id = UA_NODEID_NUMERIC(2, i + 1);
+            ck_assert_uint_eq(ns.removeNode(ns.context, &id), UA_STATUSCODE_GOOD);
+        }
+    }
+
+    writerDone = true;
+    for(size_t i = 0; i < 2; i++)
+        pthread_join(t[i], NULL);
+    printf("Concurrent lookups during writes: %lu\n",
+           (unsigned long)(lookups[0] + lookups[1]));
+}
+END_TEST
+#endif
+
 static Suite * namespace_suite (void) {
     Suite *s = suite_create ("UA_NodeStore");
 
@@ -267,6 +754,7 @@ static Suite * namespace_suite (void) {
     tcase_add_test (tc_find, findNodeInExpandedNamespace);
     tcase_add_test (tc_find, failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries);
     tcase_add_test (tc_find, failToFindNodeInOtherUA_NodeStore);
+    tcase_add_test (tc_find, removeNodesAndFindRemaining);
     suite_add_tcase (s, tc_find);
 
     TCase *tc_replace = tcase_create("Replace-ZipTree");
@@ -284,6 +772,7 @@ static Suite * namespace_suite (void) {
     TCase* tc_profile = tcase_create ("Profile-ZipTree");
     tcase_add_checked_fixture(tc_profile, setupZipTree, teardown);
     tcase_add_test (tc_profile, profileGetDelete);
+    tcase_add_test (tc_profile, profileInsertLookupIterate);
     suite_add_tcase (s, tc_profile);
 
     TCase* tc_find_hm = tcase_create ("Find-HashMap");
@@ -293,6 +782,7 @@ static Suite * namespace_suite (void) {
     tcase_add_test (tc_find_hm, findNodeInExpandedNamespace);
     tcase_add_test (tc_find_hm, failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries);
     tcase_add_test (tc_find_hm, failToFindNodeInOtherUA_NodeStore);
+    tcase_add_test (tc_find_hm, removeNodesAndFindRemaining);
     suite_add_tcase (s, tc_find_hm);
 
     TCase *tc_replace_hm = tcase_create("Replace-HashMap");
@@ -310,8 +800,66 @@ static Suite * namespace_suite (void) {
     TCase* tc_profile_hm = tcase_create ("Profile-HashMap");
     tcase_add_checked_fixture(tc_profile_hm, setupHashMap, teardown);
     tcase_add_test (tc_profile_hm, profileGetDelete);
+    tcase_add_test (tc_profile_hm, profileInsertLookupIterate);
     suite_add_tcase (s, tc_profile_hm);
 
+#if UA_MULTITHREADING >= 100
+    TCase* tc_concurrent_hm = tcase_create ("Concurrent-HashMap");
+    tcase_add_checked_fixture(tc_concurrent_hm, setupHashMap, teardown);
+    tcase_add_test (tc_concurrent_hm, concurrentGetDuringWrite);
+    suite_add_tcase (s, tc_concurrent_hm);
+#endif
+
+    TCase* tc_find_st = tcase_create ("Find-SwissTable");
+    tcase_add_checked_fixture(tc_find_st, setupSwissTable, teardown);
+    tcase_add_test (tc_find_st, findNodeInUA_NodeStoreWithSingleEntry);
+    tcase_add_test (tc_find_st, findNodeInUA_NodeStoreWithSeveralEntries);
+    tcase_add_test (tc_find_st, findNodeInExpandedNamespace);
+    tcase_add_test (tc_find_st, failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries);
+    tcase_add_test (tc_find_st, failToFindNodeInOtherUA_NodeStore);
+    tcase_add_test (tc_find_st, removeNodesAndFindRemaining);
+    suite_add_tcase (s, tc_find_st);
+
+    TCase *tc_replace_st = tcase_create("Replace-SwissTable");
+    tcase_add_checked_fixture(tc_replace_st, setupSwissTable, teardown);
+    tcase_add_test (tc_replace_st, replaceExistingNode);
+    tcase_add_test (tc_replace_st, replaceOldNode);
+    suite_add_tcase (s, tc_replace_st);
+
+    TCase* tc_iterate_st = tcase_create ("Iterate-SwissTable");
+    tcase_add_checked_fixture(tc_iterate_st, setupSwissTable, teardown);
+    tcase_add_test (tc_iterate_st, iterateOverUA_NodeStoreShallNotVisitEmptyNodes);
+    tcase_add_test (tc_iterate_st, iterateOverExpandedNamespaceShallNotVisitEmptyNodes);
+    suite_add_tcase (s, tc_iterate_st);
+
+    TCase* tc_profile_st = tcase_create ("Profile-SwissTable");
+    tcase_add_checked_fixture(tc_profile_st, setupSwissTable, teardown);
+    tcase_add_test (tc_profile_st, profileGetDelete);
+    tcase_add_test (tc_profile_st, profileInsertLookupIterate);
+    suite_add_tcase (s, tc_profile_st);
+
+    TCase* tc_find_fr = tcase_create ("Find-Frozen");
+    tcase_add_checked_fixture(tc_find_fr, setupFrozen, teardown);
+    tcase_add_test (tc_find_fr, findNodeInUA_NodeStoreWithSingleEntry);
+    tcase_add_test (tc_find_fr, findNodeInUA_NodeStoreWithSeveralEntries);
+    tcase_add_test (tc_find_fr, failToFindNodeInOtherUA_NodeStore);
+    tcase_add_test (tc_find_fr, removeNodesAndFindRemaining);
+    tcase_add_test (tc_find_fr, freezeAndFind);
+    suite_add_tcase (s, tc_find_fr);
+
+    TCase *tc_replace_fr = tcase_create("Replace-Frozen");
+    tcase_add_checked_fixture(tc_replace_fr, setupFrozen, teardown);
+    tcase_add_test (tc_replace_fr, replaceExistingNode);
+    tcase_add_test (tc_replace_fr, replaceOldNode);
+    tcase_add_test (tc_replace_fr, editFrozenNode);
+    tcase_add_test (tc_replace_fr, removeFrozenNode);
+    suite_add_tcase (s, tc_replace_fr);
+
+    TCase* tc_server_fr = tcase_create ("Server-Frozen");
+    tcase_add_test (tc_server_fr, freezeServerNamespaceZero);
+    tcase_add_test (tc_server_fr, loadServerImage);
+    suite_add_tcase (s, tc_server_fr);
+
     return s;
 }
 
@@ -8,7 +8,9 @@
 
 #include "server/ua_subscription.h"
 #include "ua_server_internal.h"
+#include "ua_services.h"
 #include "test_helpers.h"
+#include "testing_clock.h"
 
 #include <check.h>
 #include <stdlib.h>
@@ -62,7 +64,7 @@ START_TEST(monitorIntegerNoChanges) {
 
     callbackCount = 0;
 
-    UA_MonitoredItem *mon = LIST_FIRST(&server->adminSubscription->monitoredItems);
+    UA_MonitoredItem *mon = TAILQ_FIRST(&server->adminSubscription->monitoredItems);
 
     clock_t begin, finish;
     begin = clock();
@@ -83,14 +85,345 @@ START_TEST(monitorIntegerNoChanges) {
 }
 END_TEST
 
+#define BULK_ITEMS 20000
+
+static double
+secondsSince(clock_t begin) {
+    return (double)(clock() - begin) / CLOCKS_PER_SEC;
+}
+
+/* Create, modify and delete many MonitoredItems of a Subscription in bulk
+ * requests. Every operation looks up the MonitoredItem by its id. */
+START_TEST(bulkCreateModifyDelete) {
+    UA_Session *session = &server->adminSession;
+    UA_CreateSubscriptionRequest subRequest;
+    UA_CreateSubscriptionRequest_init(&subRequest);
+    subRequest.publishingEnabled = true;
+    subRequest.requestedPublishingInterval = 1000.0;
+    UA_CreateSubscriptionResponse subResponse;
+    UA_CreateSubscriptionResponse_init(&subResponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_CreateSubscription(server, session, &subRequest, &subResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(subResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_Subscription *sub =
+        UA_Session_getSubscriptionById(session, subResponse.subscriptionId);
+    ck_assert(sub != NULL);
+
+    UA_CreateMonitoredItemsRequest createRequest;
+    UA_CreateMonitoredItemsRequest_init(&createRequest);
+    createRequest.subscriptionId = sub->subscriptionId;
+    createRequest.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    createRequest.itemsToCreate = (UA_MonitoredItemCreateRequest*)
+        UA_Array_new(BULK_ITEMS, &UA_TYPES[UA_TYPES_MONITOREDITEMCREATEREQUEST]);
+    ck_assert(createRequest.itemsToCreate != NULL);
+    createRequest.itemsToCreateSize = BULK_ITEMS;
+    for(size_t i = 0; i < BULK_ITEMS; i++) {
+        UA_MonitoredItemCreateRequest *item = &createRequest.itemsToCreate[i];
+        item->itemToMonitor.nodeId =
+            UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+        item->itemToMonitor.attributeId = UA_ATTRIBUTEID_VALUE;
+        item->monitoringMode = UA_MONITORINGMODE_DISABLED;
+        item->requestedParameters.samplingInterval = 1000.0;
+        item->requestedParameters.queueSize = 1;
+    }
+
+    UA_CreateMonitoredItemsResponse createResponse;
+    UA_CreateMonitoredItemsResponse_init(&createResponse);
+    clock_t begin = clock();
+    UA_LOCK(&server->serviceMutex);
+    Service_CreateMonitoredItems(server, session, &createRequest, &createResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    double createTime = secondsSince(begin);
+    ck_assert_uint_eq(createResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(createResponse.resultsSize, BULK_ITEMS);
+    ck_assert_uint_eq(sub->monitoredItemsSize, BULK_ITEMS);
+
+    /* The MonitoredItems are kept in the order of creation */
+    size_t pos = 0;
+    UA_MonitoredItem *mon;
+    TAILQ_FOREACH(mon, &sub->monitoredItems, listEntry) {
+        ck_assert_uint_eq(mon->monitoredItemId,
+                          createResponse.results[pos].monitoredItemId);
+        pos++;
+    }
+    ck_assert_uint_eq(pos, BULK_ITEMS);
+
+    UA_ModifyMonitoredItemsRequest modifyRequest;
+    UA_ModifyMonitoredItemsRequest_init(&modifyRequest);
+    modifyRequest.subscriptionId = sub->subscriptionId;
+    modifyRequest.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    modifyRequest.itemsToModify = (UA_MonitoredItemModifyRequest*)
+        UA_Array_new(BULK_ITEMS, &UA_TYPES[UA_TYPES_MONITOREDITEMMODIFYREQUEST]);
+    ck_assert(modifyRequest.itemsToModify != NULL);
+    modifyRequest.itemsToModifySize = BULK_ITEMS;
+    for(size_t i = 0; i < BULK_ITEMS; i++) {
+        UA_MonitoredItemModifyRequest *item = &modifyRequest.itemsToModify[i];
+        item->monitoredItemId = createResponse.results[BULK_ITEMS - 1 - i].monitoredItemId;
+        item->requestedParameters.samplingInterval = 500.0;
+        item->requestedParameters.queueSize = 2;
+    }
+
+    UA_ModifyMonitoredItemsResponse modifyResponse;
+    UA_ModifyMonitoredItemsResponse_init(&modifyResponse);
+    begin = clock();
+    UA_LOCK(&server->serviceMutex);
+    Service_ModifyMonitoredItems(server, session, &modifyRequest, &modifyResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    double modifyTime = secondsSince(begin);
+    ck_assert_uint_eq(modifyResponse.resultsSize, BULK_ITEMS);
+    for(size_t i = 0; i < BULK_ITEMS; i++)
+        ck_assert_uint_eq(modifyResponse.results[i].statusCode, UA_STATUSCODE_GOOD);
+
+    UA_DeleteMonitoredItemsRequest deleteRequest;
+    UA_DeleteMonitoredItemsRequest_init(&deleteRequest);
+    deleteRequest.subscriptionId = sub->subscriptionId;
+    deleteRequest.monitoredItemIds = (UA_UInt32*)
+        UA_Array_new(BULK_ITEMS, &UA_TYPES[UA_TYPES_UINT32]);
+    ck_assert(deleteRequest.monitoredItemIds != NULL);
+    deleteRequest.monitoredItemIdsSize = BULK_ITEMS;
+    for(size_t i = 0; i < BULK_ITEMS; i++)
+        deleteRequest.monitoredItemIds[i] = createResponse.results[i].monitoredItemId;
+
+    UA_DeleteMonitoredItemsResponse deleteResponse;
+    UA_DeleteMonitoredItemsResponse_init(&deleteResponse);
+    begin = clock();
+    UA_LOCK(&server->serviceMutex);
+    Service_DeleteMonitoredItems(server, session, &deleteRequest, &deleteResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    double deleteTime = secondsSince(begin);
+    ck_assert_uint_eq(deleteResponse.resultsSize, BULK_ITEMS);
+    for(size_t i = 0; i < BULK_ITEMS; i++)
+        ck_assert_uint_eq(deleteResponse.results[i], UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(sub->monitoredItemsSize, 0);
+
+    printf("%d MonitoredItems: create %f s, modify %f s, delete %f s\n",
+           BULK_ITEMS, createTime, modifyTime, deleteTime);
+
+    UA_CreateMonitoredItemsRequest_clear(&createRequest);
+    UA_CreateMonitoredItemsResponse_clear(&createResponse);
+    UA_ModifyMonitoredItemsRequest_clear(&modifyRequest);
+    UA_ModifyMonitoredItemsResponse_clear(&modifyResponse);
+    UA_DeleteMonitoredItemsRequest_clear(&deleteRequest);
+    UA_DeleteMonitoredItemsResponse_clear(&deleteResponse);
+    UA_CreateSubscriptionResponse_clear(&subResponse);
+}
+END_TEST
+
+#define SAMPLED_NODES 100
+
+/* Sample many MonitoredItems with the same sampling interval. They share one
+ * SamplingGroup. The MonitoredItems of the same node share the read. */
+START_TEST(sampleManyItems) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 myInteger = 42;
+    UA_Variant_setScalar(&attr.value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+    for(UA_UInt32 i = 0; i < SAMPLED_NODES; i++) {
+        UA_StatusCode res =
+            UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, 50000 + i),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                      UA_QUALIFIEDNAME(1, "sampled"),
+                                      UA_NODEID_NULL, attr, NULL, NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+
+    UA_Session *session = &server->adminSession;
+    UA_CreateSubscriptionRequest subRequest;
+    UA_CreateSubscriptionRequest_init(&subRequest);
+    subRequest.publishingEnabled = true;
+    subRequest.requestedPublishingInterval = 1000.0;
+    subRequest.requestedLifetimeCount = 10000;
+    subRequest.requestedMaxKeepAliveCount = 1000;
+    UA_CreateSubscriptionResponse subResponse;
+    UA_CreateSubscriptionResponse_init(&subResponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_CreateSubscription(server, session, &subRequest, &subResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(subResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+
+    /* The items are created in the order of the nodes. So the SamplingGroup
+     * has to sort them before the reads can be shared. */
+    UA_CreateMonitoredItemsRequest createRequest;
+    UA_CreateMonitoredItemsRequest_init(&createRequest);
+    createRequest.subscriptionId = subResponse.subscriptionId;
+    createRequest.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    createRequest.itemsToCreate = (UA_MonitoredItemCreateRequest*)
+        UA_Array_new(BULK_ITEMS, &UA_TYPES[UA_TYPES_MONITOREDITEMCREATEREQUEST]);
+    ck_assert(createRequest.itemsToCreate != NULL);
+    createRequest.itemsToCreateSize = BULK_ITEMS;
+    for(size_t i = 0; i < BULK_ITEMS; i++) {
+        UA_MonitoredItemCreateRequest *item = &createRequest.itemsToCreate[i];
+        item->itemToMonitor.nodeId =
+            UA_NODEID_NUMERIC(1, 50000 + (UA_UInt32)(i % SAMPLED_NODES));
+        item->itemToMonitor.attributeId = UA_ATTRIBUTEID_VALUE;
+        item->monitoringMode = UA_MONITORINGMODE_REPORTING;
+        item->requestedParameters.samplingInterval = 100.0;
+        item->requestedParameters.queueSize = 1;
+    }
+
+    UA_CreateMonitoredItemsResponse createResponse;
+    UA_CreateMonitoredItemsResponse_init(&createResponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_CreateMonitoredItems(server, session, &createRequest, &createResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(createResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(createResponse.resultsSize, BULK_ITEMS);
+    for(size_t i = 0; i < BULK_ITEMS; i++)
+        ck_assert_uint_eq(createResponse.results[i].statusCode, UA_STATUSCODE_GOOD);
+
+    /* All MonitoredItems are in a single group */
+    UA_SamplingGroup *sg = LIST_FIRST(&server->samplingGroups);
+    ck_assert(sg != NULL);
+    ck_assert(LIST_NEXT(sg, listEntry) == NULL);
+    ck_assert_uint_eq(sg->itemsCount, BULK_ITEMS);
+
+    UA_Server_run_startup(server);
+
+    /* Sample with the timer */
+    clock_t begin = clock();
+    for(size_t i = 0; i < 10; i++) {
+        UA_fakeSleep(100);
+        UA_Server_run_iterate(server, false);
+    }
+    double groupTime = secondsSince(begin);
+    ck_assert(sg->sorted);
+
+    /* Every MonitoredItem got the value */
+    UA_Subscription *sub =
+        UA_Session_getSubscriptionById(session, subResponse.subscriptionId);
+    ck_assert(sub != NULL);
+    UA_MonitoredItem *mon;
+    TAILQ_FOREACH(mon, &sub->monitoredItems, listEntry) {
+        ck_assert(mon->lastValue.hasValue);
+        ck_assert(UA_Variant_hasScalarType(&mon->lastValue.value,
+                                           &UA_TYPES[UA_TYPES_INT32]));
+        ck_assert_int_eq(*(UA_Int32*)mon->lastValue.value.data, 42);
+    }
+
+    /* Sample every MonitoredItem individually for comparison */
+    begin = clock();
+    UA_LOCK(&server->serviceMutex);
+    for(size_t i = 0; i < 10; i++) {
+        TAILQ_FOREACH(mon, &sub->monitoredItems, listEntry)
+            UA_MonitoredItem_sample(server, mon);
+    }
+    UA_UNLOCK(&server->serviceMutex);
+    double singleTime = secondsSince(begin);
+
+    printf("10 samplings of %d MonitoredItems on %d nodes: "
+           "grouped %f s, individually %f s\n",
+           BULK_ITEMS, SAMPLED_NODES, groupTime, singleTime);
+
+    UA_Server_run_shutdown(server);
+
+    UA_CreateMonitoredItemsRequest_clear(&createRequest);
+    UA_CreateMonitoredItemsResponse_clear(&createResponse);
+    UA_CreateSubscriptionResponse_clear(&subResponse);
+}
+END_TEST
+
+#define SCALAR_SAMPLES 200000
+
+/* Process samples of a numeric scalar. Every sample changes the value and
+ * creates a notification. The queue of size one discards the previous
+ * notification. */
+START_TEST(processScalarSamples) {
+    UA_Session *session = &server->adminSession;
+    UA_CreateSubscriptionRequest subRequest;
+    UA_CreateSubscriptionRequest_init(&subRequest);
+    subRequest.publishingEnabled = true;
+    subRequest.requestedPublishingInterval = 1000.0;
+    UA_CreateSubscriptionResponse subResponse;
+    UA_CreateSubscriptionResponse_init(&subResponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_CreateSubscription(server, session, &subRequest, &subResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(subResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+
+    UA_CreateMonitoredItemsRequest createRequest;
+    UA_CreateMonitoredItemsRequest_init(&createRequest);
+    createRequest.subscriptionId = subResponse.subscriptionId;
+    createRequest.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_VALUE;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    item.requestedParameters.samplingInterval = 1.0;
+    item.requestedParameters.queueSize = 1;
+    createRequest.itemsToCreate = &item;
+    createRequest.itemsToCreateSize = 1;
+    UA_CreateMonitoredItemsResponse createResponse;
+    UA_CreateMonitoredItemsResponse_init(&createResponse);
+    UA_LOCK(&server->serviceMutex);
+    Service_CreateMonitoredItems(server, session, &createRequest, &createResponse);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(createResponse.resultsSize, 1);
+    ck_assert_uint_eq(createResponse.results[0].statusCode, UA_STATUSCODE_GOOD);
+
+    UA_Subscription *sub =
+        UA_Session_getSubscriptionById(session, subResponse.subscriptionId);
+    ck_assert(sub != NULL);
+    UA_MonitoredItem *mon = TAILQ_FIRST(&sub->monitoredItems);
+    ck_assert(mon != NULL);
+
+    /* Every sample is a new value (allocated as by the read service) */
+    UA_LOCK(&server->serviceMutex);
+    clock_t begin = clock();
+    for(size_t i = 0; i < SCALAR_SAMPLES; i++) {
+        UA_Double d = (UA_Double)i;
+        UA_DataValue dv;
+        UA_DataValue_init(&dv);
+        UA_Variant_setScalarCopy(&dv.value, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+        dv.hasValue = true;
+        UA_MonitoredItem_processSampledValue(server, mon, &dv);
+    }
+    double changedTime = secondsSince(begin);
+
+    /* The last value is stored inline */
+    ck_assert(mon->lastValue.value.data == &mon->lastScalar);
+    ck_assert(*(UA_Double*)mon->lastValue.value.data == (UA_Double)(SCALAR_SAMPLES - 1));
+    ck_assert_uint_eq(mon->queueSize, 1);
+    ck_assert(sub->notificationPoolSize > 0);
+
+    /* The same value is sampled again */
+    begin = clock();
+    for(size_t i = 0; i < SCALAR_SAMPLES; i++) {
+        UA_Double d = (UA_Double)(SCALAR_SAMPLES - 1);
+        UA_DataValue dv;
+        UA_DataValue_init(&dv);
+        UA_Variant_setScalarCopy(&dv.value, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+        dv.hasValue = true;
+        UA_MonitoredItem_processSampledValue(server, mon, &dv);
+    }
+    double unchangedTime = secondsSince(begin);
+    UA_UNLOCK(&server->serviceMutex);
+
+    printf("Scalar samples per second: %.0f changed, %.0f unchanged\n",
+           SCALAR_SAMPLES / changedTime, SCALAR_SAMPLES / unchangedTime);
+
+    UA_CreateMonitoredItemsResponse_clear(&createResponse);
+    UA_CreateSubscriptionResponse_clear(&subResponse);
+}
+END_TEST
+
 static Suite * monitoring_speed_suite (void) {
     Suite *s = suite_create ("Monitoring Speed");
 
     TCase* tc_datachange = tcase_create ("DataChange");
     tcase_add_checked_fixture(tc_datachange, setup, teardown);
     tcase_add_test (tc_datachange, monitorIntegerNoChanges);
+    tcase_add_test (tc_datachange, processScalarSamples);
     suite_add_tcase (s, tc_datachange);
 
+    TCase* tc_bulk = tcase_create ("Bulk");
+    tcase_add_checked_fixture(tc_bulk, setup, teardown);
+    tcase_add_test (tc_bulk, bulkCreateModifyDelete);
+    tcase_add_test (tc_bulk, sampleManyItems);
+    tcase_set_timeout(tc_bulk, 60);
+    suite_add_tcase (s, tc_bulk);
+
     return s;
 }
 
@@ -8,6 +8,7 @@
 #include <open62541/server_config_default.h>
 #include <open62541/types.h>
 
+#include "server/ua_server_internal.h"
 #include "server/ua_services.h"
 #include "client/ua_client_internal.h"
 #include "test_helpers.h"
@@ -158,6 +159,63 @@ START_TEST(Session_setSessionAttribute_ShallWork) {
 }
 END_TEST
 
+#define MANY_SESSIONS 100
+
+/* Create many sessions and look them up by their id and authentication token.
+ * The timing for a large number of sessions is in check_session_speed. */
+START_TEST(Session_manySessions) {
+    UA_Server *manyServer = UA_Server_newForUnitTest();
+    ck_assert(manyServer != NULL);
+    UA_Session *sessions[MANY_SESSIONS];
+
+    UA_LOCK(&manyServer->serviceMutex);
+    UA_CreateSessionRequest request;
+    UA_CreateSessionRequest_init(&request);
+    for(size_t i = 0; i < MANY_SESSIONS; i++) {
+        UA_StatusCode res =
+            UA_Server_createSession(manyServer, NULL, &request, &sessions[i]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    ck_assert_uint_eq(manyServer->sessionCount, MANY_SESSIONS);
+
+    for(size_t i = 0; i < MANY_SESSIONS; i++) {
+        ck_assert_ptr_eq(getSessionById(manyServer, &sessions[i]->sessionId),
+                         sessions[i]);
+        ck_assert_ptr_eq(getSessionByToken(manyServer,
+                                           &sessions[i]->authenticationToken),
+                         sessions[i]);
+    }
+
+    /* The sessionId is not a valid token and vice versa */
+    ck_assert_ptr_eq(getSessionByToken(manyServer, &sessions[0]->sessionId), NULL);
+    ck_assert_ptr_eq(getSessionById(manyServer, &sessions[0]->authenticationToken), NULL);
+
+    /* Remove every other session by its token */
+    for(size_t i = 0; i < MANY_SESSIONS; i += 2) {
+        UA_NodeId token = sessions[i]->authenticationToken;
+        UA_StatusCode res =
+            UA_Server_removeSessionByToken(manyServer, &token, UA_SHUTDOWNREASON_CLOSE);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert_ptr_eq(getSessionByToken(manyServer, &token), NULL);
+        sessions[i] = NULL;
+    }
+    ck_assert_uint_eq(manyServer->sessionCount, MANY_SESSIONS / 2);
+    for(size_t i = 1; i < MANY_SESSIONS; i += 2)
+        ck_assert_ptr_eq(getSessionById(manyServer, &sessions[i]->sessionId),
+                         sessions[i]);
+    UA_UNLOCK(&manyServer->serviceMutex);
+
+    /* Close the remaining sessions by their id */
+    for(size_t i = 1; i < MANY_SESSIONS; i += 2) {
+        UA_NodeId sessionId = sessions[i]->sessionId;
+        ck_assert_uint_eq(UA_Server_closeSession(manyServer, &sessionId),
+                          UA_STATUSCODE_GOOD);
+    }
+    ck_assert_uint_eq(manyServer->sessionCount, 0);
+
+    UA_Server_delete(manyServer);
+} END_TEST
+
 static Suite* testSuite_Session(void) {
     Suite *s = suite_create("Session");
     TCase *tc_session = tcase_create("Core");
@@ -167,6 +225,9 @@ static Suite* testSuite_Session(void) {
     tcase_add_test(tc_session, Session_updateLifetime_ShallWork);
     tcase_add_test(tc_session, Session_setSessionAttribute_ShallWork);
     suite_add_tcase(s,tc_session);
+    TCase *tc_many = tcase_create("ManySessions");
+    tcase_add_test(tc_many, Session_manySessions);
+    suite_add_tcase(s,tc_many);
     return s;
 }
 
@@ -0,0 +1,80 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+/* How fast sessions are created, looked up and removed when the server holds
+ * many of them. Every request looks up its session by the token. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "server/ua_server_internal.h"
+#include "server/ua_services.h"
+#include "test_helpers.h"
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#define SESSIONS 10000
+
+START_TEST(sessionSpeed) {
+    UA_Server *server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_getConfig(server)->maxSessions = SESSIONS;
+    UA_Session **sessions = (UA_Session**)UA_calloc(SESSIONS, sizeof(UA_Session*));
+    ck_assert(sessions != NULL);
+
+    UA_LOCK(&server->serviceMutex);
+    UA_CreateSessionRequest request;
+    UA_CreateSessionRequest_init(&request);
+    clock_t begin = clock();
+    for(size_t i = 0; i < SESSIONS; i++) {
+        UA_StatusCode res =
+            UA_Server_createSession(server, NULL, &request, &sessions[i]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    double createTime = (double)(clock() - begin) / CLOCKS_PER_SEC;
+
+    begin = clock();
+    for(size_t i = 0; i < SESSIONS; i++) {
+        getSessionById(server, &sessions[i]->sessionId);
+        getSessionByToken(server, &sessions[i]->authenticationToken);
+    }
+    double lookupTime = (double)(clock() - begin) / CLOCKS_PER_SEC;
+
+    begin = clock();
+    for(size_t i = 0; i < SESSIONS; i++) {
+        UA_NodeId token = sessions[i]->authenticationToken;
+        UA_Server_removeSessionByToken(server, &token, UA_SHUTDOWNREASON_CLOSE);
+    }
+    double removeTime = (double)(clock() - begin) / CLOCKS_PER_SEC;
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(server->sessionCount, 0);
+
+    printf("%d sessions: create %f s, lookup %f s, remove %f s\n",
+           SESSIONS, createTime, lookupTime, removeTime);
+
+    UA_free(sessions);
+    UA_Server_delete(server);
+} END_TEST
+
+static Suite * testSuite_sessionSpeed(void) {
+    Suite *s = suite_create("Session Speed");
+    TCase *tc = tcase_create("Core");
+    tcase_add_test(tc, sessionSpeed);
+    tcase_set_timeout(tc, 60);
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_sessionSpeed();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,78 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/plugin/nodestore_default.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static void
+usage(void) {
+    printf("Usage: nodestore_image [-o outputFile]\n"
+           "Writes the namespace zero and the nodesets that are injected with "
+           "UA_ENABLE_NODESET_INJECTOR into a nodestore image.\n"
+           "- outputFile: Output target (default: nodestore.img)\n");
+}
+
+int main(int argc, char **argv) {
+    const char *output_option = "nodestore.img";
+    for(int argpos = 1; argpos < argc; argpos++) {
+        if(strcmp(argv[argpos], "-o") == 0 && argpos + 1 < argc) {
+            argpos++;
+            output_option = argv[argpos];
+            continue;
+        }
+        usage();
+        return (strcmp(argv[argpos], "--help") == 0) ? 0 : -1;
+    }
+
+    /* Create the server with a Frozen Nodestore. The generated namespace zero
+     * and the injected nodesets are added during the initialization. */
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_StatusCode res = UA_Nodestore_Frozen(&config.nodestore);
+    if(res != UA_STATUSCODE_GOOD) {
+        fprintf(stderr, "Error: Could not create the nodestore\n");
+        return -1;
+    }
+    UA_ServerConfig_setDefault(&config);
+    UA_Server *server = UA_Server_newWithConfig(&config);
+    if(!server) {
+        fprintf(stderr, "Error: Could not create the server\n");
+        return -1;
+    }
+    UA_Nodestore *ns = &UA_Server_getConfig(server)->nodestore;
+
+    /* Read the namespace array */
+    UA_Variant namespaces;
+    res = UA_Server_readValue(server, UA_NS0ID(SERVER_NAMESPACEARRAY), &namespaces);
+    if(res != UA_STATUSCODE_GOOD ||
+       !UA_Variant_hasArrayType(&namespaces, &UA_TYPES[UA_TYPES_STRING])) {
+        fprintf(stderr, "Error: Could not read the namespace array\n");
+        UA_Server_delete(server);
+        return -1;
+    }
+
+    /* Freeze everything except for the application namespace */
+    for(size_t i = 0; i < namespaces.arrayLength && res == UA_STATUSCODE_GOOD; i++) {
+        if(i != 1)
+            res = UA_Nodestore_Frozen_freeze(ns, (UA_UInt16)i);
+    }
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_Nodestore_Frozen_writeImage(ns, output_option,
+                                             (UA_String*)namespaces.data,
+                                             namespaces.arrayLength);
+    if(res != UA_STATUSCODE_GOOD)
+        fprintf(stderr, "Error: Could not write the image (%s)\n",
+                UA_StatusCode_name(res));
+    else
+        printf("Wrote the nodestore image to %s\n", output_option);
+
+    UA_Variant_clear(&namespaces);
+    UA_Server_delete(server);
+    return (res == UA_STATUSCODE_GOOD) ? 0 : -1;
+}